@@ -0,0 +1,680 @@
+/***************************************************************************
+*      Copyright (C) 2008 by Norwegian Computing Center and Statoil        *
+***************************************************************************/
+
+//
+// Benchmarks for the CRAVA hot paths.
+//
+// A synthetic case is written to disk (see SyntheticCase), and a set of
+// microbenchmarks is run on grids of the same size. Each benchmark is
+// repeated and the best wall clock time is reported together with a
+// throughput, so that the numbers can be compared between versions and
+// machines. The synthetic case can also be inverted with cravarun.
+//
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#ifdef PARALLEL
+#include <omp.h>
+#endif
+
+#include "nrlib/iotools/fileio.hpp"
+#include "nrlib/iotools/logkit.hpp"
+#include "nrlib/iotools/stringtools.hpp"
+#include "nrlib/grid/grid.hpp"
+#include "nrlib/grid/grid2d.hpp"
+#include "nrlib/segy/segy.hpp"
+#include "nrlib/segy/segygeometry.hpp"
+#include "nrlib/segy/commonheaders.hpp"
+#include "nrlib/stormgrid/stormcontgrid.hpp"
+#include "nrlib/volume/volume.hpp"
+
+#include "lib/lib_matr.h"
+#include "lib/timekit.hpp"
+
+#include "src/definitions.h"
+#include "src/fftgrid.h"
+#include "src/simbox.h"
+#include "src/commondata.h"
+#include "src/posteriorelasticpdf3d.h"
+#include "src/kriging2d.h"
+#include "src/krigingdata2d.h"
+#include "src/covgrid2d.h"
+#include "src/vario.h"
+
+#include "bench/syntheticcase.h"
+
+namespace {
+
+struct BenchSettings
+{
+  SyntheticCase::Settings  model;
+  int                      repeat;
+  int                      threads;
+  std::string              directory;
+  bool                     generate_only;
+};
+
+void
+Report(const std::string & name,
+       const std::string & size,
+       double              seconds,
+       double              amount,
+       const std::string & unit)
+{
+  double throughput = (seconds > 0.0 ? amount/seconds : 0.0);
+  printf("  %-34s %-22s %12.3f ms %12.2f %s\n", name.c_str(), size.c_str(), 1000.0*seconds, throughput, unit.c_str());
+  fflush(stdout);
+}
+
+std::string
+SizeText(int nx, int ny, int nz)
+{
+  return NRLib::ToString(nx) + "x" + NRLib::ToString(ny) + "x" + NRLib::ToString(nz);
+}
+
+//
+// Fills a real FFTGrid (including padding) with a smooth positive field.
+//
+void
+FillGrid(FFTGrid * grid, float offset)
+{
+  grid->setAccessMode(FFTGrid::WRITE);
+  for (int k = 0 ; k < grid->getNzp() ; k++)
+    for (int j = 0 ; j < grid->getNyp() ; j++)
+      for (int i = 0 ; i < grid->getRNxp() ; i++)
+        grid->setNextReal(offset + 0.5f*static_cast<float>(sin(0.1*i + 0.07*j + 0.05*k)));
+  grid->endAccess();
+}
+
+FFTGrid *
+MakeGrid(int nx, int ny, int nz, float offset)
+{
+  int nxp = FFTGrid::findClosestFactorableNumber(static_cast<int>(ceil(1.1*nx)));
+  int nyp = FFTGrid::findClosestFactorableNumber(static_cast<int>(ceil(1.1*ny)));
+  int nzp = FFTGrid::findClosestFactorableNumber(static_cast<int>(ceil(1.1*nz)));
+
+  FFTGrid * grid = new FFTGrid(nx, ny, nz, nxp, nyp, nzp);
+  grid->createRealGrid();
+  grid->setType(FFTGrid::PARAMETER);
+  FillGrid(grid, offset);
+  return grid;
+}
+
+enum GridOperation { ADD, SUBTRACT, MULTIPLY, MULTIPLY_SCALAR, SQUARE, EXP, LOG,
+                     AXPBY, EXP_SCALED, EXP_SCALED_CHAIN,
+                     ADD_COMPLEX, MULTIPLY_COMPLEX, CONJUGATE, REAL_ABS, MULTIPLY_ADD_COMPLEX };
+
+void
+ApplyOperation(int operation, FFTGrid * a, FFTGrid * b)
+{
+  switch (operation) {
+  case ADD              :
+  case ADD_COMPLEX      : a->add(b)                 ; break;
+  case SUBTRACT         : a->subtract(b)            ; break;
+  case MULTIPLY         :
+  case MULTIPLY_COMPLEX : a->multiply(b)            ; break;
+  case MULTIPLY_SCALAR  : a->multiplyByScalar(1.01f); break;
+  case SQUARE           : a->square()               ; break;
+  case EXP              : a->expTransf()            ; break;
+  case LOG              : a->logTransf()            ; break;
+  case CONJUGATE        : a->conjugate()            ; break;
+  case REAL_ABS         : a->realAbs()              ; break;
+  case AXPBY            : a->axpby(0.5f, 0.5f, b)   ; break;
+  case EXP_SCALED       : a->expTransf(0.1f, -1.0f, 2.0f); break;
+  case EXP_SCALED_CHAIN : a->addScalar(0.1f);                    // What EXP_SCALED replaces
+                          a->expTransf();
+                          a->addScalar(-1.0f);
+                          a->multiplyByScalar(2.0f) ; break;
+  case MULTIPLY_ADD_COMPLEX : a->multiplyAdd(b, b, true); break;
+  }
+}
+
+void
+BenchFFTGrid(const BenchSettings & settings)
+{
+  const SyntheticCase::Settings & m = settings.model;
+  int nz = m.nz*m.n_intervals;
+
+  printf("\nFFTGrid\n");
+
+  FFTGrid * a = MakeGrid(m.nx, m.ny, nz, 1.0f);
+  FFTGrid * b = MakeGrid(m.nx, m.ny, nz, 1.0f);
+
+  std::string size  = SizeText(a->getNxp(), a->getNyp(), a->getNzp());
+  double      n     = static_cast<double>(a->getNxp())*a->getNyp()*a->getNzp();
+  double      flops = 2.5*n*log(n)/log(2.0);                 // Real-to-complex FFT
+
+  double best_forward = 1.0e30;
+  double best_inverse = 1.0e30;
+  for (int r = 0 ; r < settings.repeat ; r++) {
+    double start = TimeKit::getWallClock();
+    a->fftInPlace();
+    double mid   = TimeKit::getWallClock();
+    a->invFFTInPlace();
+    double end   = TimeKit::getWallClock();
+    best_forward = std::min(best_forward, mid - start);
+    best_inverse = std::min(best_inverse, end - mid);
+  }
+  Report("fftInPlace",    size, best_forward, flops*1.0e-9, "GFlop/s");
+  Report("invFFTInPlace", size, best_inverse, flops*1.0e-9, "GFlop/s");
+
+  const int   n_ops                = 15;
+  const int   operations[n_ops]    = { ADD, SUBTRACT, MULTIPLY, MULTIPLY_SCALAR, SQUARE, EXP, LOG,
+                                       AXPBY, EXP_SCALED, EXP_SCALED_CHAIN,
+                                       ADD_COMPLEX, MULTIPLY_COMPLEX, CONJUGATE, REAL_ABS, MULTIPLY_ADD_COMPLEX };
+  const char *names[n_ops]         = { "add", "subtract", "multiply", "multiplyByScalar", "square", "expTransf", "logTransf",
+                                       "axpby", "expTransf (fused)", "expTransf (unfused chain)",
+                                       "add (complex)", "multiply (complex)", "conjugate", "realAbs", "multiplyAdd (complex)" };
+
+  for (int op = 0 ; op < n_ops ; op++) {
+    bool complex = (operations[op] >= ADD_COMPLEX);
+    double best  = 1.0e30;
+    for (int r = 0 ; r < settings.repeat ; r++) {
+      FillGrid(a, 1.0f);                                     // Keep values in range; not timed
+      if (complex) {
+        a->fftInPlace();
+        if (!b->getIsTransformed())
+          b->fftInPlace();
+      }
+      else if (b->getIsTransformed())
+        b->invFFTInPlace();
+
+      double start = TimeKit::getWallClock();
+      ApplyOperation(operations[op], a, b);
+      best = std::min(best, TimeKit::getWallClock() - start);
+
+      if (a->getIsTransformed())
+        a->setTransformedStatus(false);
+    }
+    Report(names[op], size, best, n*1.0e-6, "Mcells/s");
+  }
+
+  delete a;
+  delete b;
+}
+
+fftw_complex **
+NewComplexMatrix(int n1, int n2)
+{
+  fftw_complex ** mat = new fftw_complex * [n1];
+  for (int i = 0 ; i < n1 ; i++)
+    mat[i] = new fftw_complex[n2];
+  return mat;
+}
+
+void
+DeleteComplexMatrix(fftw_complex ** mat, int n1)
+{
+  for (int i = 0 ; i < n1 ; i++)
+    delete [] mat[i];
+  delete [] mat;
+}
+
+void
+BenchLibMatr(const BenchSettings & settings)
+{
+  const SyntheticCase::Settings & m = settings.model;
+
+  printf("\nlib_matr\n");
+
+  //
+  // The per-frequency posterior update of AVOInversion::computePostMeanResidAndFFTCov,
+  // run for the number of complex cells in the inversion grid.
+  //
+  int nt      = m.n_angles;
+  int n_freq  = (m.nx/2 + 1)*m.ny*m.nz*m.n_intervals;
+
+  fftw_complex ** K         = NewComplexMatrix(nt, 3);
+  fftw_complex ** KS        = NewComplexMatrix(nt, 3);
+  fftw_complex ** KScc      = NewComplexMatrix(3, nt);
+  fftw_complex ** par_var   = NewComplexMatrix(3, 3);
+  fftw_complex ** reduce    = NewComplexMatrix(3, 3);
+  fftw_complex ** marg_var  = NewComplexMatrix(nt, nt);
+  fftw_complex ** err_var   = NewComplexMatrix(nt, nt);
+
+  for (int l = 0 ; l < nt ; l++) {
+    for (int i = 0 ; i < 3 ; i++) {
+      K[l][i].re = static_cast<float>(0.5 + 0.1*l - 0.2*i);
+      K[l][i].im = static_cast<float>(0.05*(i + 1));
+    }
+    for (int i = 0 ; i < nt ; i++) {
+      err_var[l][i].re = (l == i ? 0.1f : 0.01f);
+      err_var[l][i].im = 0.0f;
+    }
+  }
+
+  double best = 1.0e30;
+  for (int r = 0 ; r < settings.repeat ; r++) {
+    double start = TimeKit::getWallClock();
+    for (int f = 0 ; f < n_freq ; f++) {
+      for (int i = 0 ; i < 3 ; i++) {
+        for (int j = 0 ; j < 3 ; j++) {
+          par_var[i][j].re = (i == j ? 1.0f : 0.7f);
+          par_var[i][j].im = 0.0f;
+        }
+      }
+      lib_matrProdCpx(K, par_var, nt, 3, 3, KS);
+      lib_matrProdAdjointCpx(KS, K, nt, 3, nt, marg_var);
+      lib_matrAddMatCpx(err_var, nt, nt, marg_var);
+      if (lib_matrCholCpx(nt, marg_var) == 0) {
+        lib_matrAdjoint(KS, nt, 3, KScc);
+        lib_matrAXeqBMatCpx(nt, marg_var, KS, 3);
+        lib_matrProdCpx(KScc, KS, 3, nt, 3, reduce);
+        lib_matrSubtMatCpx(reduce, 3, 3, par_var);
+      }
+    }
+    best = std::min(best, TimeKit::getWallClock() - start);
+  }
+  Report("posterior update " + NRLib::ToString(nt) + "x3", NRLib::ToString(n_freq) + " freq", best, n_freq*1.0e-6, "Mfreq/s");
+
+  DeleteComplexMatrix(K,        nt);
+  DeleteComplexMatrix(KS,       nt);
+  DeleteComplexMatrix(KScc,     3);
+  DeleteComplexMatrix(par_var,  3);
+  DeleteComplexMatrix(reduce,   3);
+  DeleteComplexMatrix(marg_var, nt);
+  DeleteComplexMatrix(err_var,  nt);
+
+  //
+  // Real Cholesky factorisation and solve, as used for kriging and wavelet estimation.
+  //
+  int       n   = 200;
+  double ** A   = new double * [n];
+  double ** B   = new double * [n];
+  for (int i = 0 ; i < n ; i++) {
+    A[i] = new double[n];
+    B[i] = new double[1];
+  }
+
+  best = 1.0e30;
+  for (int r = 0 ; r < settings.repeat ; r++) {
+    for (int i = 0 ; i < n ; i++) {
+      for (int j = 0 ; j < n ; j++)
+        A[i][j] = exp(-std::abs(i - j)/20.0) + (i == j ? 0.1 : 0.0);
+      B[i][0] = 1.0;
+    }
+    double start = TimeKit::getWallClock();
+    lib_matrCholR(n, A);
+    lib_matrAXeqBMatR(n, A, B, 1);
+    best = std::min(best, TimeKit::getWallClock() - start);
+  }
+  Report("lib_matrCholR + AXeqBMatR", NRLib::ToString(n) + "x" + NRLib::ToString(n), best, n*n*n/3.0*1.0e-9, "GFlop/s");
+
+  for (int i = 0 ; i < n ; i++) {
+    delete [] A[i];
+    delete [] B[i];
+  }
+  delete [] A;
+  delete [] B;
+}
+
+void
+BenchIO(const BenchSettings       & settings,
+        const SyntheticCase       & synthetic,
+        const Simbox              * simbox)
+{
+  const SyntheticCase::Settings & m = synthetic.GetSettings();
+  int    ns      = synthetic.NumberOfSamples();
+  float  t0      = static_cast<float>(synthetic.SeismicStartTime());
+  double n_bytes = 4.0*m.nx*m.ny*ns;
+  std::string size = SizeText(m.nx, m.ny, ns);
+
+  printf("\nSEG-Y and STORM I/O\n");
+
+  std::vector<std::vector<float> > traces(m.nx*m.ny);
+  for (int j = 0 ; j < m.ny ; j++)
+    for (int i = 0 ; i < m.nx ; i++)
+      synthetic.MakeSeismicTrace(0, i, j, traces[i + j*m.nx]);
+
+  std::string segy_file  = settings.directory + "/io/bench.segy";
+  std::string storm_file = settings.directory + "/io/bench.storm";
+  NRLib::CreateDirIfNotExists(segy_file);
+
+  double best_write = 1.0e30;
+  double best_read  = 1.0e30;
+  for (int r = 0 ; r < settings.repeat ; r++) {
+    double start = TimeKit::getWallClock();
+    {
+      NRLib::SegY         segy(segy_file, t0, ns, static_cast<float>(m.dt), NRLib::TextualHeader::standardHeader());
+      NRLib::SegyGeometry * geometry = synthetic.MakeSegyGeometry();
+      segy.SetGeometry(geometry);
+      delete geometry;
+      for (int j = 0 ; j < m.ny ; j++)
+        for (int i = 0 ; i < m.nx ; i++)
+          segy.StoreTrace(m.x0 + (i + 0.5)*m.dx, m.y0 + (j + 0.5)*m.dy, traces[i + j*m.nx], NULL);
+      segy.WriteAllTracesToFile();
+    }
+    double mid = TimeKit::getWallClock();
+    {
+      NRLib::SegY segy(segy_file, t0);
+      segy.ReadAllTraces(simbox, 100.0, true, false);
+      segy.CreateRegularGrid(false);
+    }
+    double end = TimeKit::getWallClock();
+    best_write = std::min(best_write, mid - start);
+    best_read  = std::min(best_read,  end - mid);
+  }
+  Report("SEG-Y write", size, best_write, n_bytes/(1024.0*1024.0), "MB/s");
+  Report("SEG-Y read",  size, best_read,  n_bytes/(1024.0*1024.0), "MB/s");
+
+  NRLib::Volume        volume(m.x0, m.y0, t0, m.nx*m.dx, m.ny*m.dy, ns*m.dt, 0.0);
+  NRLib::StormContGrid grid(volume, m.nx, m.ny, ns);
+  for (int j = 0 ; j < m.ny ; j++)
+    for (int i = 0 ; i < m.nx ; i++)
+      for (int k = 0 ; k < ns ; k++)
+        grid(i, j, k) = traces[i + j*m.nx][k];
+
+  best_write = 1.0e30;
+  best_read  = 1.0e30;
+  for (int r = 0 ; r < settings.repeat ; r++) {
+    double start = TimeKit::getWallClock();
+    grid.WriteToFile(storm_file, synthetic.MakeStormHeader());
+    double mid   = TimeKit::getWallClock();
+    NRLib::StormContGrid read_grid(storm_file);
+    double end   = TimeKit::getWallClock();
+    best_write = std::min(best_write, mid - start);
+    best_read  = std::min(best_read,  end - mid);
+  }
+  Report("STORM write", size, best_write, n_bytes/(1024.0*1024.0), "MB/s");
+  Report("STORM read",  size, best_read,  n_bytes/(1024.0*1024.0), "MB/s");
+
+  // Lossless chunked STORM, as used for <chunked> output and the
+  // FFTFileGrid temporaries.
+  std::string chunked_file = settings.directory + "/io/bench.cstorm";
+  grid.SetFormat(NRLib::StormContGrid::STORM_CHUNKED);
+  grid.SetNumberOfThreads(FFTGrid::getNumberOfThreads());
+  best_write = 1.0e30;
+  best_read  = 1.0e30;
+  for (int r = 0 ; r < settings.repeat ; r++) {
+    double start = TimeKit::getWallClock();
+    grid.WriteToFile(chunked_file, synthetic.MakeStormHeader());
+    double mid   = TimeKit::getWallClock();
+    NRLib::StormContGrid read_grid(chunked_file);
+    double end   = TimeKit::getWallClock();
+    best_write = std::min(best_write, mid - start);
+    best_read  = std::min(best_read,  end - mid);
+  }
+  Report("chunked STORM write", size, best_write, n_bytes/(1024.0*1024.0), "MB/s");
+  Report("chunked STORM read",  size, best_read,  n_bytes/(1024.0*1024.0), "MB/s");
+  double ratio = static_cast<double>(NRLib::FindFileSize(storm_file))/NRLib::FindFileSize(chunked_file);
+  printf("  %-34s %-22s %16s %12.2f x\n", "chunked STORM compression", size.c_str(), "", ratio);
+}
+
+void
+BenchFillInData(const BenchSettings & settings,
+                const SyntheticCase & synthetic,
+                const Simbox        * simbox)
+{
+  const SyntheticCase::Settings & m = synthetic.GetSettings();
+  std::string segy_file  = settings.directory + "/io/bench.segy";
+  std::string storm_file = settings.directory + "/io/bench.storm";
+
+  printf("\nFillInData\n");
+
+  NRLib::SegY segy(segy_file, static_cast<float>(synthetic.SeismicStartTime()));
+  segy.ReadAllTraces(simbox, 100.0, true, false);
+  segy.CreateRegularGrid(false);
+
+  NRLib::StormContGrid storm_grid(storm_file);
+
+  std::string size     = SizeText(simbox->getnx(), simbox->getny(), simbox->getnz());
+  double      n_traces = static_cast<double>(simbox->getnx())*simbox->getny();
+
+  for (int source = 0 ; source < 2 ; source++) {
+    bool   is_segy = (source == 0);
+    double best    = 1.0e30;
+    for (int r = 0 ; r < settings.repeat ; r++) {
+      NRLib::Grid<float>   grid(simbox->getnx(), simbox->getny(), simbox->getnz(), 0.0f);
+      NRLib::Grid2D<bool>  dead_traces_map;
+      int missing_traces_simbox  = 0;
+      int missing_traces_padding = 0;
+      int dead_traces_simbox     = 0;
+
+      double start = TimeKit::getWallClock();
+      CommonData::FillInData(&grid,
+                             NULL,
+                             simbox,
+                             (is_segy ? NULL : &storm_grid),
+                             (is_segy ? &segy : NULL),
+                             static_cast<float>(2.0*m.dt),
+                             missing_traces_simbox,
+                             missing_traces_padding,
+                             dead_traces_simbox,
+                             &dead_traces_map,
+                             FFTGrid::DATA,
+                             false,
+                             is_segy,
+                             !is_segy,
+                             true);
+      best = std::min(best, TimeKit::getWallClock() - start);
+      printf("\n");                                  // Ends the progress bar written by FillInData
+    }
+    Report(is_segy ? "resample from SEG-Y" : "resample from STORM", size, best, n_traces*1.0e-3, "Ktraces/s");
+  }
+}
+
+void
+BenchFaciesProbability(const BenchSettings & settings,
+                       const SyntheticCase & synthetic)
+{
+  const SyntheticCase::Settings & m = synthetic.GetSettings();
+
+  printf("\nFacies probability\n");
+
+  //
+  // Density of elastic parameters sampled from the synthetic model, smoothed
+  // with a Gaussian kernel as in FaciesProb, and evaluated in every grid cell.
+  //
+  std::vector<double> d1, d2, d3;
+  std::vector<float>  vp, vs, rho;
+  for (int w = 0 ; w < std::max(m.n_wells, 1) ; w++) {
+    synthetic.MakeElasticTraces((w*37) % m.nx, (w*53) % m.ny, vp, vs, rho);
+    for (size_t k = 0 ; k < vp.size() ; k++) {
+      d1.push_back(log(vp[k]));
+      d2.push_back(log(vs[k]));
+      d3.push_back(log(rho[k]));
+    }
+  }
+
+  double min1 = *std::min_element(d1.begin(), d1.end()) - 0.2;
+  double max1 = *std::max_element(d1.begin(), d1.end()) + 0.2;
+  double min2 = *std::min_element(d2.begin(), d2.end()) - 0.2;
+  double max2 = *std::max_element(d2.begin(), d2.end()) + 0.2;
+  double min3 = *std::min_element(d3.begin(), d3.end()) - 0.2;
+  double max3 = *std::max_element(d3.begin(), d3.end()) + 0.2;
+
+  double   sigma_data[3][3] = {{0.0010, 0.0008, 0.0004},
+                               {0.0008, 0.0012, 0.0003},
+                               {0.0004, 0.0003, 0.0005}};
+  double * sigma[3]         = { sigma_data[0], sigma_data[1], sigma_data[2] };
+
+  int    n_density = 64;
+  double best      = 1.0e30;
+  PosteriorElasticPDF3D * pdf = NULL;
+  for (int r = 0 ; r < settings.repeat ; r++) {
+    delete pdf;
+    double start = TimeKit::getWallClock();
+    pdf = new PosteriorElasticPDF3D(d1, d2, d3, sigma, n_density, n_density, n_density,
+                                    min1, max1, min2, max2, min3, max3);
+    best = std::min(best, TimeKit::getWallClock() - start);
+  }
+  Report("density estimation", SizeText(n_density, n_density, n_density), best,
+         n_density*n_density*n_density*1.0e-6, "Mcells/s");
+
+  int    nz       = m.nz*m.n_intervals;
+  double n_points = static_cast<double>(m.nx)*m.ny*nz;
+  best            = 1.0e30;
+  double sum      = 0.0;
+  for (int r = 0 ; r < settings.repeat ; r++) {
+    double start = TimeKit::getWallClock();
+    for (int j = 0 ; j < m.ny ; j++) {
+      for (int i = 0 ; i < m.nx ; i++) {
+        for (int k = 0 ; k < nz ; k++) {
+          size_t l = (i + j + k) % d1.size();
+          sum += pdf->Density(d1[l], d2[l], d3[l]);
+        }
+      }
+    }
+    best = std::min(best, TimeKit::getWallClock() - start);
+  }
+  Report("density evaluation", SizeText(m.nx, m.ny, nz), best, n_points*1.0e-6, "Mcells/s");
+
+  if (sum < 0.0)                                    // Keeps the evaluations from being optimised away
+    printf("  (negative density sum)\n");
+  delete pdf;
+}
+
+void
+BenchKriging(const BenchSettings & settings,
+             const SyntheticCase & synthetic)
+{
+  const SyntheticCase::Settings & m = synthetic.GetSettings();
+
+  printf("\nKriging\n");
+
+  //
+  // One background layer: data in the well columns plus scattered points, as
+  // for deviated wells. The second case has enough data to use the FFT
+  // based prediction.
+  //
+  GenExpVario vario(1.0f, static_cast<float>(20.0*m.dx), static_cast<float>(20.0*m.dy));
+  CovGrid2D   cov(&vario, m.nx, m.ny, m.dx, m.dy);
+
+  const int n_cases    = 2;
+  int       n_data[n_cases] = { std::max(10*m.n_wells, 20), 400 };
+
+  for (int c = 0 ; c < n_cases ; c++) {
+    KrigingData2D kriging_data(n_data[c]);
+    for (int d = 0 ; d < n_data[c] ; d++) {
+      int i = (d*7919 + 13) % m.nx;
+      int j = (d*104729 + 17) % m.ny;
+      kriging_data.addData(i, j, static_cast<float>(2500.0 + 100.0*sin(0.3*d)));
+    }
+    kriging_data.findMeanValues();
+
+    double best = 1.0e30;
+    for (int r = 0 ; r < settings.repeat ; r++) {
+      Grid2D trend(m.nx, m.ny, 2500.0);
+      double start = TimeKit::getWallClock();
+      Kriging2D::krigSurface(trend, kriging_data, cov);
+      best = std::min(best, TimeKit::getWallClock() - start);
+    }
+    Report("krigSurface (" + NRLib::ToString(kriging_data.getNumberOfData()) + " data)", SizeText(m.nx, m.ny, 1), best,
+           m.nx*m.ny*1.0e-6, "Mcells/s");
+  }
+}
+
+void
+Usage(const char * program)
+{
+  printf("\nUsage: %s [options]\n\n", program);
+  printf("  -nx n           Number of cells in x direction         (default 100)\n");
+  printf("  -ny n           Number of cells in y direction         (default 100)\n");
+  printf("  -nz n           Number of layers in each interval      (default 100)\n");
+  printf("  -angles n       Number of angle gathers                (default 3)\n");
+  printf("  -wells n        Number of wells                        (default 4)\n");
+  printf("  -intervals n    Number of intervals                    (default 1)\n");
+  printf("  -storm          Write seismic as STORM instead of SEG-Y\n");
+  printf("  -seed n         Seed for the synthetic model           (default 12345)\n");
+  printf("  -repeat n       Repetitions of each benchmark          (default 3)\n");
+  printf("  -threads n      Number of threads (parallel builds only)\n");
+  printf("  -dir name       Directory for the synthetic case       (default bench_case)\n");
+  printf("  -generate-only  Write the synthetic case and exit\n\n");
+}
+
+bool
+ParseArguments(int argc, char ** argv, BenchSettings & settings)
+{
+  settings.repeat        = 3;
+  settings.threads       = 0;
+  settings.directory     = "bench_case";
+  settings.generate_only = false;
+
+  for (int i = 1 ; i < argc ; i++) {
+    std::string arg   = argv[i];
+    bool        value = (i + 1 < argc);
+    if      (arg == "-nx"            && value) settings.model.nx          = atoi(argv[++i]);
+    else if (arg == "-ny"            && value) settings.model.ny          = atoi(argv[++i]);
+    else if (arg == "-nz"            && value) settings.model.nz          = atoi(argv[++i]);
+    else if (arg == "-angles"        && value) settings.model.n_angles    = atoi(argv[++i]);
+    else if (arg == "-wells"         && value) settings.model.n_wells     = atoi(argv[++i]);
+    else if (arg == "-intervals"     && value) settings.model.n_intervals = atoi(argv[++i]);
+    else if (arg == "-seed"          && value) settings.model.seed        = static_cast<unsigned int>(atoi(argv[++i]));
+    else if (arg == "-repeat"        && value) settings.repeat            = atoi(argv[++i]);
+    else if (arg == "-threads"       && value) settings.threads           = atoi(argv[++i]);
+    else if (arg == "-dir"           && value) settings.directory         = argv[++i];
+    else if (arg == "-storm")                  settings.model.storm_seismic = true;
+    else if (arg == "-generate-only")          settings.generate_only       = true;
+    else
+      return false;
+  }
+
+  const SyntheticCase::Settings & m = settings.model;
+  return (m.nx > 1 && m.ny > 1 && m.nz > 1 && m.n_angles > 0 && m.n_wells >= 0 &&
+          m.n_intervals > 0 && settings.repeat > 0);
+}
+
+}
+
+int
+main(int argc, char ** argv)
+{
+  BenchSettings settings;
+  if (!ParseArguments(argc, argv, settings)) {
+    Usage(argv[0]);
+    return 1;
+  }
+
+  // The benchmarked code logs progress; keep the report readable.
+  NRLib::LogKit::SetScreenLog(NRLib::LogKit::L_Error);
+  FFTGrid::setMaxAllowedGrids(1000);
+
+  int threads = 1;
+#ifdef PARALLEL
+  if (settings.threads > 0)
+    omp_set_num_threads(settings.threads);
+  threads = omp_get_max_threads();
+#endif
+  FFTGrid::setNumberOfThreads(threads);
+
+  const SyntheticCase::Settings & m = settings.model;
+  printf("\nCRAVA benchmarks: %dx%dx%d cells, %d interval(s), %d angle(s), %d well(s), %d thread(s), best of %d\n",
+         m.nx, m.ny, m.nz, m.n_intervals, m.n_angles, m.n_wells, threads, settings.repeat);
+
+  try {
+    SyntheticCase synthetic(settings.model);
+
+    double start      = TimeKit::getWallClock();
+    std::string model = synthetic.WriteCase(settings.directory);
+    printf("\nSynthetic case written to %s (%.2f s). Invert it with: cd %s && cravarun modelfile.xml\n",
+           model.c_str(), TimeKit::getWallClock() - start, settings.directory.c_str());
+
+    if (settings.generate_only)
+      return 0;
+
+    Simbox * simbox = synthetic.MakeSimbox();
+
+    BenchFFTGrid(settings);
+    BenchLibMatr(settings);
+    BenchIO(settings, synthetic, simbox);
+    BenchFillInData(settings, synthetic, simbox);
+    BenchFaciesProbability(settings, synthetic);
+    BenchKriging(settings, synthetic);
+
+    delete simbox;
+  }
+  catch (NRLib::Exception & e) {
+    printf("\nBenchmark failed: %s\n", e.what());
+    return 1;
+  }
+
+  printf("\n");
+  return 0;
+}
@@ -0,0 +1,481 @@
+/***************************************************************************
+*      Copyright (C) 2008 by Norwegian Computing Center and Statoil        *
+***************************************************************************/
+
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <algorithm>
+
+#include "nrlib/iotools/fileio.hpp"
+#include "nrlib/iotools/stringtools.hpp"
+#include "nrlib/math/constants.hpp"
+#include "nrlib/segy/segy.hpp"
+#include "nrlib/segy/segygeometry.hpp"
+#include "nrlib/segy/commonheaders.hpp"
+#include "nrlib/stormgrid/stormcontgrid.hpp"
+#include "nrlib/volume/volume.hpp"
+
+#include "lib/random.h"
+
+#include "src/definitions.h"
+#include "src/simbox.h"
+
+#include "bench/syntheticcase.h"
+
+SyntheticCase::Settings::Settings()
+  : nx(100),
+    ny(100),
+    nz(100),
+    n_angles(3),
+    n_wells(4),
+    n_intervals(1),
+    dx(25.0),
+    dy(25.0),
+    dt(4.0),
+    top_time(2000.0),
+    x0(450000.0),
+    y0(6780000.0),
+    max_angle(40.0),
+    peak_frequency(30.0),
+    signal_to_noise(4.0),
+    storm_seismic(false),
+    seed(12345)
+{
+}
+
+SyntheticCase::SyntheticCase(const Settings & settings)
+  : settings_(settings)
+{
+  const Settings & s = settings_;
+
+  int n_guard = static_cast<int>(ceil(150.0/s.dt)); // Covers CRAVA's default 100 ms FFT guard zone
+  t_start_    = s.top_time - n_guard*s.dt;
+  n_samples_  = s.n_intervals*s.nz + 2*n_guard;
+
+  double max_shift = 3.0*s.dt;
+  t_fine_     = floor(t_start_ - max_shift - 2.0*s.dt);
+  n_fine_     = static_cast<int>(ceil(n_samples_*s.dt + 2.0*max_shift + 4.0*s.dt));
+
+  angles_.resize(s.n_angles);
+  for (int a = 0 ; a < s.n_angles ; a++) {
+    double degrees = floor(10.0*s.max_angle*(a + 1)/s.n_angles + 0.5)/10.0;
+    angles_[a]     = degrees*NRLib::Pi/180.0;
+  }
+
+  // Ricker wavelet sampled at dt, truncated at 1.5 periods on each side.
+  double f     = s.peak_frequency;
+  int    half  = static_cast<int>(1500.0/(f*s.dt));
+  wavelet_.resize(2*half + 1);
+  for (int k = -half ; k <= half ; k++) {
+    double t   = 0.001*k*s.dt;
+    double arg = NRLib::Pi*NRLib::Pi*f*f*t*t;
+    wavelet_[k + half] = (1.0 - 2.0*arg)*exp(-arg);
+  }
+
+  RandomGen random(s.seed);
+
+  well_x_.resize(s.n_wells);
+  well_y_.resize(s.n_wells);
+  for (int w = 0 ; w < s.n_wells ; w++) {
+    well_x_[w] = s.x0 + (0.1 + 0.8*RandomGen::unif01())*s.nx*s.dx;
+    well_y_[w] = s.y0 + (0.1 + 0.8*RandomGen::unif01())*s.ny*s.dy;
+  }
+
+  MakeLayering();
+}
+
+SyntheticCase::~SyntheticCase()
+{
+}
+
+void
+SyntheticCase::MakeLayering(void)
+{
+  //
+  // Blocky layers of random thickness on a 1 ms axis. The relative contrasts
+  // are correlated between parameters, as they are for real rocks.
+  //
+  ln_vp_.resize(n_fine_);
+  ln_vs_.resize(n_fine_);
+  ln_rho_.resize(n_fine_);
+
+  double max_thickness = 4.0*settings_.dt;
+  int    k             = 0;
+  while (k < n_fine_) {
+    int    thickness = 2 + static_cast<int>(RandomGen::unif01()*max_thickness);
+    double z1        = RandomGen::rnorm01();
+    double z2        = RandomGen::rnorm01();
+    double z3        = RandomGen::rnorm01();
+    double d_vp      = 0.06*z1;
+    double d_vs      = 0.8*d_vp + 0.04*z2;
+    double d_rho     = 0.4*d_vp + 0.02*z3;
+    for (int l = 0 ; l < thickness && k < n_fine_ ; l++, k++) {
+      double trend = 0.0002*k;
+      ln_vp_[k]    = log(2500.0)       + trend + d_vp;
+      ln_vs_[k]    = log(2500.0/1.9)   + trend + d_vs;
+      ln_rho_[k]   = log(2.2)          + 0.25*trend + d_rho;
+    }
+  }
+}
+
+double
+SyntheticCase::LateralShift(double x, double y) const
+{
+  double lx = settings_.nx*settings_.dx;
+  double ly = settings_.ny*settings_.dy;
+  return 3.0*settings_.dt*sin(2.0*NRLib::Pi*(x - settings_.x0)/lx)*cos(2.0*NRLib::Pi*(y - settings_.y0)/ly);
+}
+
+double
+SyntheticCase::BaseTime(int interval) const
+{
+  return settings_.top_time + (interval + 1)*settings_.nz*settings_.dt;
+}
+
+void
+SyntheticCase::MakeElasticTraces(int                  i,
+                                 int                  j,
+                                 std::vector<float> & vp,
+                                 std::vector<float> & vs,
+                                 std::vector<float> & rho) const
+{
+  double x     = settings_.x0 + (i + 0.5)*settings_.dx;
+  double y     = settings_.y0 + (j + 0.5)*settings_.dy;
+  double shift = LateralShift(x, y);
+  int    n_dt  = std::max(1, static_cast<int>(settings_.dt + 0.5));
+
+  vp.resize(n_samples_);
+  vs.resize(n_samples_);
+  rho.resize(n_samples_);
+
+  for (int k = 0 ; k < n_samples_ ; k++) {
+    int    first = static_cast<int>(floor(t_start_ + k*settings_.dt - shift - t_fine_));
+    double s_vp  = 0.0;
+    double s_vs  = 0.0;
+    double s_rho = 0.0;
+    for (int l = 0 ; l < n_dt ; l++) {
+      int m  = std::min(std::max(first + l, 0), n_fine_ - 1);
+      s_vp  += ln_vp_[m];
+      s_vs  += ln_vs_[m];
+      s_rho += ln_rho_[m];
+    }
+    vp[k]  = static_cast<float>(exp(s_vp/n_dt));
+    vs[k]  = static_cast<float>(exp(s_vs/n_dt));
+    rho[k] = static_cast<float>(exp(s_rho/n_dt));
+  }
+}
+
+void
+SyntheticCase::MakeSeismicTrace(int                  angle,
+                                int                  i,
+                                int                  j,
+                                std::vector<float> & trace) const
+{
+  std::vector<float> vp, vs, rho;
+  MakeElasticTraces(i, j, vp, vs, rho);
+
+  // Linearised Aki-Richards (Stolt and Weglein) with constant vs/vp.
+  double k2    = 1.0/(1.9*1.9);
+  double sin2  = sin(angles_[angle])*sin(angles_[angle]);
+  double cos2  = 1.0 - sin2;
+  double a_vp  = 0.5/cos2;
+  double a_vs  = -4.0*k2*sin2;
+  double a_rho = 0.5*(1.0 - 4.0*k2*sin2);
+
+  std::vector<double> refl(n_samples_, 0.0);
+  for (int k = 0 ; k < n_samples_ - 1 ; k++) {
+    refl[k] = a_vp *(log(vp[k+1])  - log(vp[k]))
+            + a_vs *(log(vs[k+1])  - log(vs[k]))
+            + a_rho*(log(rho[k+1]) - log(rho[k]));
+  }
+
+  int half = static_cast<int>(wavelet_.size())/2;
+  trace.assign(n_samples_, 0.0f);
+  double sum2 = 0.0;
+  for (int k = 0 ; k < n_samples_ ; k++) {
+    double value = 0.0;
+    for (int l = -half ; l <= half ; l++) {
+      int m = k - l;
+      if (m >= 0 && m < n_samples_)
+        value += wavelet_[l + half]*refl[m];
+    }
+    trace[k] = static_cast<float>(value);
+    sum2    += value*value;
+  }
+
+  //
+  // White noise from a hash of the position, so that traces can be made in
+  // any order and still be reproducible.
+  //
+  double       sigma = sqrt(sum2/n_samples_/settings_.signal_to_noise);
+  unsigned int state = settings_.seed ^ (2654435761u*(i + 1)) ^ (40503u*(j + 1)) ^ (97u*(angle + 1));
+  for (int k = 0 ; k < n_samples_ ; k++) {
+    double u = 0.0;
+    for (int l = 0 ; l < 4 ; l++) {                  // Sum of uniforms is close enough to Gaussian here
+      state = 1664525u*state + 1013904223u;
+      u    += static_cast<double>(state >> 8)/16777216.0;
+    }
+    trace[k] += static_cast<float>(sigma*(u - 2.0)*sqrt(3.0));
+  }
+}
+
+Simbox *
+SyntheticCase::MakeSimbox(void) const
+{
+  const Settings & s  = settings_;
+  double           lx = s.nx*s.dx;
+  double           ly = s.ny*s.dy;
+  Surface          top(s.x0, s.y0, lx, ly, s.nx, s.ny, 0.0, s.top_time);
+  double           lz = BaseTime(s.n_intervals - 1) - s.top_time;
+  return new Simbox(s.x0, s.y0, top, lx, ly, lz, 0.0, s.dx, s.dy, s.dt);
+}
+
+NRLib::SegyGeometry *
+SyntheticCase::MakeSegyGeometry(void) const
+{
+  Simbox              * simbox   = MakeSimbox();
+  NRLib::SegyGeometry * geometry = new NRLib::SegyGeometry(simbox->getx0(), simbox->gety0(), simbox->getdx(), simbox->getdy(),
+                                                           simbox->getnx(), simbox->getny(), simbox->getIL0(), simbox->getXL0(),
+                                                           simbox->getILStepX(), simbox->getILStepY(),
+                                                           simbox->getXLStepX(), simbox->getXLStepY(),
+                                                           simbox->getAngle());
+  delete simbox;
+  return geometry;
+}
+
+std::string
+SyntheticCase::MakeStormHeader(void) const
+{
+  //
+  // Same layout as Simbox::getStormHeader(), but with the true time of the
+  // top and base, as StormContGrid::WriteToFile() does not write a header
+  // that StormContGrid can read back.
+  //
+  const Settings & s  = settings_;
+  double           lz = n_samples_*s.dt;
+  std::string header = "storm_petro_binary\n";
+  header += "0 " + NRLib::ToString(1) + " " + NRLib::ToString(RMISSING, 6) + "\n";
+  header += "SyntheticCase\n";
+  header += NRLib::ToString(s.x0, 6) + " " + NRLib::ToString(s.nx*s.dx, 6) + " "
+          + NRLib::ToString(s.y0, 6) + " " + NRLib::ToString(s.ny*s.dy, 6) + " "
+          + NRLib::ToString(t_start_, 6) + " " + NRLib::ToString(t_start_ + lz, 6) + " 0.0 0.0\n";
+  header += NRLib::ToString(lz, 6) + " 0.0\n\n";
+  header += NRLib::ToString(s.nx) + " " + NRLib::ToString(s.ny) + " " + NRLib::ToString(n_samples_) + "\n";
+  return header;
+}
+
+std::string
+SyntheticCase::SurfaceName(int surface) const
+{
+  if (surface == 0)
+    return "surfaces/top.storm";
+  return "surfaces/base_" + NRLib::ToString(surface) + ".storm";
+}
+
+std::string
+SyntheticCase::SeismicName(int angle) const
+{
+  std::string suffix = (settings_.storm_seismic ? ".storm" : ".segy");
+  return "seismic/angle_" + NRLib::ToString(angle + 1) + suffix;
+}
+
+std::string
+SyntheticCase::WellName(int well) const
+{
+  return "wells/well_" + NRLib::ToString(well + 1) + ".rms";
+}
+
+std::string
+SyntheticCase::WriteCase(const std::string & directory) const
+{
+  std::string input = directory + "/input/";
+  WriteSurfaces(input);
+  WriteSeismic(input);
+  WriteWells(input);
+  return WriteModelFile(directory);
+}
+
+void
+SyntheticCase::WriteSurfaces(const std::string & directory) const
+{
+  const Settings & s  = settings_;
+  double           lx = s.nx*s.dx;
+  double           ly = s.ny*s.dy;
+
+  for (int surface = 0 ; surface <= s.n_intervals ; surface++) {
+    double      time      = (surface == 0 ? s.top_time : BaseTime(surface - 1));
+    std::string file_name = directory + SurfaceName(surface);
+    Surface     surf(s.x0, s.y0, lx, ly, s.nx + 1, s.ny + 1, 0.0, time);
+    NRLib::CreateDirIfNotExists(file_name);
+    surf.WriteToFile(file_name, NRLib::SURF_STORM_BINARY);
+  }
+}
+
+void
+SyntheticCase::WriteSeismic(const std::string & directory) const
+{
+  const Settings & s = settings_;
+  std::vector<float> trace;
+
+  for (int a = 0 ; a < s.n_angles ; a++) {
+    std::string file_name = directory + SeismicName(a);
+    NRLib::CreateDirIfNotExists(file_name);
+
+    if (s.storm_seismic) {
+      NRLib::Volume        volume(s.x0, s.y0, t_start_, s.nx*s.dx, s.ny*s.dy, n_samples_*s.dt, 0.0);
+      NRLib::StormContGrid grid(volume, s.nx, s.ny, n_samples_);
+      for (int j = 0 ; j < s.ny ; j++) {
+        for (int i = 0 ; i < s.nx ; i++) {
+          MakeSeismicTrace(a, i, j, trace);
+          for (int k = 0 ; k < n_samples_ ; k++)
+            grid(i, j, k) = trace[k];
+        }
+      }
+      grid.WriteToFile(file_name, MakeStormHeader());
+    }
+    else {
+      NRLib::SegY         segy(file_name, static_cast<float>(t_start_), n_samples_, static_cast<float>(s.dt),
+                               NRLib::TextualHeader::standardHeader());
+      NRLib::SegyGeometry * geometry = MakeSegyGeometry();
+      segy.SetGeometry(geometry);
+      delete geometry;
+      for (int j = 0 ; j < s.ny ; j++) {
+        for (int i = 0 ; i < s.nx ; i++) {
+          MakeSeismicTrace(a, i, j, trace);
+          segy.StoreTrace(s.x0 + (i + 0.5)*s.dx, s.y0 + (j + 0.5)*s.dy, trace, NULL);
+        }
+      }
+      segy.WriteAllTracesToFile();
+    }
+  }
+}
+
+void
+SyntheticCase::WriteWells(const std::string & directory) const
+{
+  const Settings & s = settings_;
+
+  for (int w = 0 ; w < s.n_wells ; w++) {
+    std::string   file_name = directory + WellName(w);
+    std::ofstream file;
+    NRLib::OpenWrite(file, file_name);
+
+    file << "1.0\n"
+         << "Undefined\n"
+         << "SYNTHETIC_" << w + 1 << " " << std::fixed << std::setprecision(2) << well_x_[w] << " " << well_y_[w] << "\n"
+         << "4\n"
+         << "TWT UNK lin\n"
+         << "VP UNK lin\n"
+         << "VS UNK lin\n"
+         << "RHO UNK lin\n";
+
+    // Vertical well, logged with 1 ms sampling over the full seismic window.
+    double shift = LateralShift(well_x_[w], well_y_[w]);
+    double z     = 1500.0;
+    for (int k = 0 ; k < static_cast<int>(n_samples_*s.dt) ; k++) {
+      double t = t_start_ + k;
+      int    m = std::min(std::max(static_cast<int>(floor(t - shift - t_fine_)), 0), n_fine_ - 1);
+      double vp = exp(ln_vp_[m]);
+      file << std::setprecision(2) << well_x_[w] << " " << well_y_[w] << " " << z << " "
+           << std::setprecision(3) << t << " " << vp << " " << exp(ln_vs_[m]) << " "
+           << std::setprecision(5) << exp(ln_rho_[m]) << "\n";
+      z += 0.0005*vp;
+    }
+    file.close();
+  }
+}
+
+std::string
+SyntheticCase::WriteModelFile(const std::string & directory) const
+{
+  const Settings & s = settings_;
+  std::string file_name = directory + "/modelfile.xml";
+
+  std::ofstream file;
+  NRLib::OpenWrite(file, file_name);
+
+  file << "<?xml version=\"1.0\" ?>\n"
+       << "<crava>\n"
+       << "  <actions>\n"
+       << "    <mode> inversion </mode>\n"
+       << "    <inversion-settings>\n"
+       << "      <prediction> yes </prediction>\n"
+       << "    </inversion-settings>\n"
+       << "  </actions>\n\n";
+
+  file << "  <well-data>\n"
+       << "    <log-names>\n"
+       << "      <time>    TWT </time>\n"
+       << "      <vp>      VP  </vp>\n"
+       << "      <vs>      VS  </vs>\n"
+       << "      <density> RHO </density>\n"
+       << "    </log-names>\n";
+  for (int w = 0 ; w < s.n_wells ; w++)
+    file << "    <well>\n"
+         << "      <file-name> " << WellName(w) << " </file-name>\n"
+         << "    </well>\n";
+  file << "  </well-data>\n\n";
+
+  file << "  <survey>\n";
+  if (!s.storm_seismic)
+    file << "    <segy-start-time> " << t_start_ << " </segy-start-time>\n";
+  for (int a = 0 ; a < s.n_angles ; a++)
+    file << "    <angle-gather>\n"
+         << "      <offset-angle> " << std::fixed << std::setprecision(1) << angles_[a]*180.0/NRLib::Pi << " </offset-angle>\n"
+         << "      <seismic-data>\n"
+         << "        <file-name> " << SeismicName(a) << " </file-name>\n"
+         << "      </seismic-data>\n"
+         << "    </angle-gather>\n";
+  file << "  </survey>\n\n";
+
+  file << "  <project-settings>\n"
+       << "    <output-volume>\n"
+       << "      <utm-coordinates>\n"
+       << std::setprecision(2)
+       << "        <reference-point-x> " << s.x0      << " </reference-point-x>\n"
+       << "        <reference-point-y> " << s.y0      << " </reference-point-y>\n"
+       << "        <length-x>          " << s.nx*s.dx << " </length-x>\n"
+       << "        <length-y>          " << s.ny*s.dy << " </length-y>\n"
+       << "        <angle>             0.0 </angle>\n"
+       << "        <sample-density-x>  " << s.dx      << " </sample-density-x>\n"
+       << "        <sample-density-y>  " << s.dy      << " </sample-density-y>\n"
+       << "      </utm-coordinates>\n";
+  if (s.n_intervals == 1) {
+    file << "      <interval-two-surfaces>\n"
+         << "        <top-surface>\n"
+         << "          <time-file> " << SurfaceName(0) << " </time-file>\n"
+         << "        </top-surface>\n"
+         << "        <base-surface>\n"
+         << "          <time-file> " << SurfaceName(1) << " </time-file>\n"
+         << "        </base-surface>\n"
+         << "        <number-of-layers> " << s.nz << " </number-of-layers>\n"
+         << "      </interval-two-surfaces>\n";
+  }
+  else {
+    file << "      <multiple-intervals>\n"
+         << "        <top-surface>\n"
+         << "          <time-file> " << SurfaceName(0) << " </time-file>\n"
+         << "        </top-surface>\n";
+    for (int interval = 0 ; interval < s.n_intervals ; interval++)
+      file << "        <interval>\n"
+           << "          <name> Interval" << interval + 1 << " </name>\n"
+           << "          <base-surface>\n"
+           << "            <time-file> " << SurfaceName(interval + 1) << " </time-file>\n"
+           << "            <erosion-priority> " << interval + 2 << " </erosion-priority>\n"
+           << "          </base-surface>\n"
+           << "          <number-of-layers> " << s.nz << " </number-of-layers>\n"
+           << "        </interval>\n";
+    file << "      </multiple-intervals>\n";
+  }
+  file << "    </output-volume>\n\n"
+       << "    <io-settings>\n"
+       << "      <input-directory>  input  </input-directory>\n"
+       << "      <output-directory> output </output-directory>\n"
+       << "    </io-settings>\n"
+       << "  </project-settings>\n"
+       << "</crava>\n";
+
+  file.close();
+  return file_name;
+}
@@ -0,0 +1,117 @@
+/***************************************************************************
+*      Copyright (C) 2008 by Norwegian Computing Center and Statoil        *
+***************************************************************************/
+
+#ifndef SYNTHETICCASE_H
+#define SYNTHETICCASE_H
+
+#include <string>
+#include <vector>
+
+class Simbox;
+
+namespace NRLib {
+  class SegyGeometry;
+}
+
+//
+// Generator for synthetic CRAVA cases.
+//
+// The elastic model is a blocky layered earth with a depth trend and a
+// smooth lateral time shift. From this we make flat top and base surfaces
+// (one base per interval), one seismic cube per angle (linearised
+// Aki-Richards reflectivity convolved with a Ricker wavelet, plus white
+// noise), vertical wells in RMS format, and an XML model file tying it
+// together.
+//
+// Everything is generated from a fixed seed, so that the same settings
+// always give the same files.
+//
+class SyntheticCase
+{
+public:
+  struct Settings
+  {
+    Settings();
+
+    int          nx;              // Number of cells in the inversion volume
+    int          ny;
+    int          nz;              // Number of layers in each interval
+    int          n_angles;
+    int          n_wells;
+    int          n_intervals;
+    double       dx;              // Lateral sampling (m)
+    double       dy;
+    double       dt;              // Sampling of seismic and layers (ms)
+    double       top_time;        // Time of top surface (ms)
+    double       x0;
+    double       y0;
+    double       max_angle;       // Largest offset angle (degrees)
+    double       peak_frequency;  // Ricker wavelet peak frequency (Hz)
+    double       signal_to_noise;
+    bool         storm_seismic;   // Write seismic as STORM instead of SEG-Y
+    unsigned int seed;
+  };
+
+  SyntheticCase(const Settings & settings);
+  ~SyntheticCase();
+
+  // Writes input files and model file below directory. Returns the model file name.
+  std::string                WriteCase(const std::string & directory) const;
+
+  // Seismic trace for angle at lateral position (i,j), sampled from SeismicStartTime().
+  void                       MakeSeismicTrace(int                  angle,
+                                              int                  i,
+                                              int                  j,
+                                              std::vector<float> & trace) const;
+
+  // Elastic parameters at lateral position (i,j), sampled from SeismicStartTime().
+  void                       MakeElasticTraces(int                  i,
+                                               int                  j,
+                                               std::vector<float> & vp,
+                                               std::vector<float> & vs,
+                                               std::vector<float> & rho) const;
+
+  Simbox                   * MakeSimbox(void) const;                 // Simbox of the whole inversion volume
+  NRLib::SegyGeometry      * MakeSegyGeometry(void) const;           // Geometry of the seismic cubes
+  std::string                MakeStormHeader(void) const;            // Header for seismic cubes on STORM format
+
+  const Settings           & GetSettings(void)         const { return settings_                  ;}
+  double                     GetAngle(int angle)       const { return angles_[angle]             ;}
+  double                     SeismicStartTime(void)    const { return t_start_                   ;}
+  double                     BaseTime(int interval)    const;
+  int                        NumberOfSamples(void)     const { return n_samples_                 ;}
+  double                     WellX(int w)              const { return well_x_[w]                 ;}
+  double                     WellY(int w)              const { return well_y_[w]                 ;}
+
+private:
+  void                       MakeLayering(void);
+
+  double                     LateralShift(double x, double y) const;
+
+  void                       WriteSurfaces(const std::string & directory) const;
+  void                       WriteSeismic(const std::string & directory) const;
+  void                       WriteWells(const std::string & directory) const;
+  std::string                WriteModelFile(const std::string & directory) const;
+
+  std::string                SurfaceName(int surface) const;
+  std::string                SeismicName(int angle) const;
+  std::string                WellName(int well) const;
+
+  Settings                   settings_;
+
+  double                     t_start_;            // Start time of seismic traces
+  int                        n_samples_;          // Number of samples in seismic traces
+  int                        n_fine_;             // Number of samples in the fine (1 ms) layering
+  double                     t_fine_;             // Start time of the fine layering
+
+  std::vector<double>        angles_;             // Offset angles in radians
+  std::vector<double>        wavelet_;            // Ricker wavelet, centred at wavelet_.size()/2
+  std::vector<double>        ln_vp_;              // Layering on the fine time axis
+  std::vector<double>        ln_vs_;
+  std::vector<double>        ln_rho_;
+  std::vector<double>        well_x_;
+  std::vector<double>        well_y_;
+};
+
+#endif
@@ -21,6 +21,8 @@ public:
   ~RandomGen();
 
   int writeSeedFile(const std::string & filename) const;
+  unsigned int getCurrentSeed() const { return seed_; } // Seed of the next number drawn
+  void setCurrentSeed(unsigned int seed) { seed_ = seed; } // Continues a sequence from getCurrentSeed()
 
   static double rnorm01();
   static double unif01();
@@ -12,6 +12,7 @@
 #else
 #include <unistd.h>
 #include <pwd.h>
+#include <sys/resource.h>
 #endif
 
 #include <ctime>
@@ -100,3 +101,20 @@ SystemCall::getCurrentTime(void)
 
   return strBuffer;
 }
+
+double
+SystemCall::getPeakMemoryUsage(void)
+{
+#if defined(__WIN32__) || defined(WIN32) || defined(_WINDOWS)
+  return 0.0;
+#else
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) != 0)
+    return 0.0;
+#if defined(__APPLE__)
+  return static_cast<double>(usage.ru_maxrss);        // Bytes on Mac OS X
+#else
+  return 1024.0*static_cast<double>(usage.ru_maxrss); // Kilobytes on Linux
+#endif
+#endif
+}
@@ -13,6 +13,7 @@ public:
   static const std::string  getHostName(void);
   static const std::string  getUserName(void);
   static const std::string  getCurrentTime(void);
+  static double             getPeakMemoryUsage(void);   // Peak resident set size in bytes (0 if unknown)
 
   static const std::string  getTime(void) { return __TIME__ ; }
   static const std::string  getDate(void) { return __DATE__  ;}
@@ -4,6 +4,12 @@
 
 #include <iostream>
 
+#if defined(__WIN32__) || defined(WIN32) || defined(_WINDOWS)
+#include <windows.h>
+#else
+#include <sys/time.h>
+#endif
+
 #include "lib/timekit.hpp"
 
 void
@@ -41,5 +47,23 @@ TimeKit::getPassedTime()
   return(static_cast<double>(clock() - timeMark_)/CLOCKS_PER_SEC);
 }
 
+double
+TimeKit::getWallClock()
+{
+#if defined(__WIN32__) || defined(WIN32) || defined(_WINDOWS)
+  return(static_cast<double>(GetTickCount())/1000.0);
+#else
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return(static_cast<double>(tv.tv_sec) + 1.0e-6*static_cast<double>(tv.tv_usec));
+#endif
+}
+
+double
+TimeKit::getCpuClock()
+{
+  return(static_cast<double>(clock())/CLOCKS_PER_SEC);
+}
+
 clock_t TimeKit::timeMark_   = 0;
 
@@ -9,6 +9,8 @@ public:
   static void     getTime(double& wall, double& cpu);
   static void     markTime();
   static double   getPassedTime();
+  static double   getWallClock();    // Sub-second wall clock in seconds (arbitrary origin)
+  static double   getCpuClock();     // Process CPU time in seconds
 
 private:
   static clock_t timeMark_;
@@ -3,6 +3,7 @@
 ***************************************************************************/
 
 #include <iostream>
+#include <map>
 #include <string.h>
 
 #include "lib/utils.h"
@@ -157,26 +158,115 @@ Utils::writeMatrix(double ** matrix,
   }
 }
 
+//------------------------------------------------------------
+rfftwnd_plan
+Utils::getFFTPlan(int  nt,
+                  bool forward)
+{
+  static std::map<int, rfftwnd_plan> forward_plans;
+  static std::map<int, rfftwnd_plan> backward_plans;
+
+  rfftwnd_plan plan;
+#ifdef PARALLEL
+#pragma omp critical(fftw_planner)
+#endif
+  {
+    std::map<int, rfftwnd_plan> & plans = (forward ? forward_plans : backward_plans);
+    std::map<int, rfftwnd_plan>::iterator it = plans.find(nt);
+    if (it != plans.end()) {
+      plan = it->second;
+    }
+    else {
+      int flag = FFTW_ESTIMATE | FFTW_IN_PLACE | FFTW_THREADSAFE;
+      plan = rfftwnd_create_plan(1, &nt, (forward ? FFTW_REAL_TO_COMPLEX : FFTW_COMPLEX_TO_REAL), flag);
+      plans[nt] = plan;
+    }
+  }
+  return plan;
+}
+
 //------------------------------------------------------------
 void
 Utils::fft(fftw_real* rAmp,fftw_complex* cAmp,int nt)
 {
-  rfftwnd_plan p1 = rfftwnd_create_plan(1, &nt, FFTW_REAL_TO_COMPLEX, FFTW_ESTIMATE | FFTW_IN_PLACE);
+  rfftwnd_plan p1 = getFFTPlan(nt, true);
   rfftwnd_one_real_to_complex(p1, rAmp, cAmp);
-  fftwnd_destroy_plan(p1);
 }
 
 //------------------------------------------------------------
 void
 Utils::fftInv(fftw_complex* cAmp,fftw_real* rAmp,int nt)
 {
-  rfftwnd_plan p2 = rfftwnd_create_plan(1, &nt, FFTW_COMPLEX_TO_REAL, FFTW_ESTIMATE | FFTW_IN_PLACE);
+  rfftwnd_plan p2 = getFFTPlan(nt, false);
   rfftwnd_one_complex_to_real(p2, cAmp, rAmp);
-  fftwnd_destroy_plan(p2);
   double sf = 1.0/double(nt);
   for(int i=0;i<nt;i++)
     rAmp[i]*=fftw_real(sf);
 }
+
+//------------------------------------------------------------
+void
+Utils::fftMany(fftw_real* rAmp,int nt,int howmany)
+{
+  int rnt = 2*(nt/2+1);
+  rfftwnd_plan p1 = getFFTPlan(nt, true);
+  rfftwnd_real_to_complex(p1, howmany, rAmp, 1, rnt, NULL, 0, 0);
+}
+
+//------------------------------------------------------------
+void
+Utils::fftInvMany(fftw_real* rAmp,int nt,int howmany)
+{
+  int cnt = nt/2+1;
+  rfftwnd_plan p2 = getFFTPlan(nt, false);
+  rfftwnd_complex_to_real(p2, howmany, reinterpret_cast<fftw_complex*>(rAmp), 1, cnt, NULL, 0, 0);
+  double sf = 1.0/double(nt);
+  for(int h=0;h<howmany;h++) {
+    fftw_real * trace = rAmp + h*2*cnt;
+    for(int i=0;i<nt;i++)
+      trace[i]*=fftw_real(sf);
+  }
+}
+
+//------------------------------------------------------------
+void
+Utils::makeTwiddles(std::vector<std::complex<double> > & twiddle,
+                    int                                  n)
+{
+  twiddle.resize(n/2);
+  for (int m = 0 ; m < n/2 ; m++)
+    twiddle[m] = std::polar(1.0, -2.0*NRLib::Pi*m/n);
+}
+
+//------------------------------------------------------------
+void
+Utils::fftDouble(std::vector<std::complex<double> >       & data,
+                 const std::vector<std::complex<double> > & twiddle,
+                 bool                                       inverse)
+{
+  int n = static_cast<int>(data.size());
+  for (int i = 1, j = 0 ; i < n ; i++) {
+    int bit = n >> 1;
+    for ( ; (j & bit) != 0 ; bit >>= 1)
+      j ^= bit;
+    j ^= bit;
+    if (i < j)
+      std::swap(data[i], data[j]);
+  }
+  for (int len = 2 ; len <= n ; len <<= 1) {
+    int half = len/2;
+    int step = n/len;
+    for (int i = 0 ; i < n ; i += len) {
+      for (int k = 0 ; k < half ; k++) {
+        std::complex<double> w = (inverse ? std::conj(twiddle[k*step]) : twiddle[k*step]);
+        std::complex<double> u = data[i + k];
+        std::complex<double> v = data[i + k + half]*w;
+        data[i + k]        = u + v;
+        data[i + k + half] = u - v;
+      }
+    }
+  }
+}
 //-----------------------------------------------------------
 int
 Utils::findEnd(std::string & seek, int start, std::string & find)
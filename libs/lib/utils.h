@@ -6,9 +6,13 @@
 #ifndef UTILS_H
 #define UTILS_H
 
+#include <complex>
+#include <vector>
+
 #include "src/definitions.h"
 #include "nrlib/iotools/logkit.hpp"
 #include "fftw.h"
+#include "rfftw.h"
 
 
 class Utils
@@ -48,6 +52,12 @@ public:
                              int       ndim1,
                              int       ndim2);
 
+  // In-place 1D plan of length nt, made once and kept for the rest of the
+  // run. The plans are thread safe, as the transforms of traces, wells and
+  // local wavelets are often done from parallel loops.
+  static rfftwnd_plan getFFTPlan(int  nt,
+                                 bool forward);
+
   static void    fft(fftw_real    * rAmp,
                      fftw_complex * cAmp,
                      int            nt);
@@ -56,6 +66,29 @@ public:
                         fftw_real    * rAmp,
                         int            nt);
 
+  // In-place transforms of howmany traces stored one after another, each
+  // padded to 2*(nt/2+1) reals. Gives the same result as fft/fftInv on
+  // each trace.
+  static void    fftMany(fftw_real * rAmp,
+                         int         nt,
+                         int         howmany);
+
+  static void    fftInvMany(fftw_real * rAmp,
+                            int         nt,
+                            int         howmany);
+
+  // Sets twiddle[m] = exp(-2*pi*i*m/n) for m < n/2, as used by fftDouble.
+  static void    makeTwiddles(std::vector<std::complex<double> > & twiddle,
+                              int                                  n);
+
+  // In-place radix-2 FFT in double precision, for when the single precision
+  // FFTW library is too coarse. The length of data must be a power of two,
+  // and twiddle made by makeTwiddles for this length. The inverse transform
+  // is not scaled.
+  static void    fftDouble(std::vector<std::complex<double> >       & data,
+                           const std::vector<std::complex<double> > & twiddle,
+                           bool                                       inverse);
+
   static  void   readUntilStop(int           pos,
                                std::string & in,
                                std::string & out,
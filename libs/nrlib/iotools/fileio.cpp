@@ -365,6 +365,9 @@ int NRLib::FindGridFileType(const std::string& filename )
   else if (token == format_desc[STORM_PETRO_ASCII]) {
       return STORM_PETRO_ASCII;
   }
+  else if (token == "storm_petro_chunked") {
+      return STORM_PETRO_CHUNKED;
+  }
   else if (token == format_desc[STORM_FACIES_BINARY]) {
       return STORM_FACIES_BINARY;
   }
@@ -42,7 +42,8 @@ namespace NRLib {
                        STORM_FACIES_ASCII  = 3,
                        SGRI                = 4,
                        SEGY                = 5,
-                       PLAIN_ASCII         = 6};
+                       PLAIN_ASCII         = 6,
+                       STORM_PETRO_CHUNKED = 7};
 
   /// \brief Open file for reading.
   void OpenRead(std::ifstream&          stream,
@@ -23,6 +23,7 @@
 
 #include <algorithm>
 #include <cctype>
+#include <cstdlib>
 #include <iostream>
 #include <string>
 #include <sstream>
@@ -172,6 +173,58 @@ NRLib::IsNumber(const std::string & s)
     return false;
 }
 
+bool
+NRLib::ParseAsciiRecordsFast(const std::string   & s,
+                             size_t                n_items,
+                             bool                  wrap,
+                             std::vector<double> & values)
+{
+  const char * p         = s.c_str();
+  const char * end       = p + s.size();
+  size_t       in_record = 0;   // Items read so far in the current record
+
+  values.reserve(values.size() + s.size()/8);
+
+  while (p < end) {
+    const char * line_end = p;
+    while (line_end < end && *line_end != '\n')
+      line_end++;
+
+    if (line_end > p) {
+      size_t n_line = 0;
+      while (p < line_end) {
+        if (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\f' || *p == '\v') {
+          p++;
+          continue;
+        }
+        const char * token_end = p;
+        while (token_end < line_end && *token_end != ' ' && *token_end != '\t' &&
+               *token_end != '\r' && *token_end != '\f' && *token_end != '\v') {
+          char c = *token_end;
+          if (!((c >= '0' && c <= '9') || c == '.' || c == '-' || c == '+' || c == 'e' || c == 'E'))
+            return false;
+          token_end++;
+        }
+        char * parsed_end;
+        values.push_back(strtod(p, &parsed_end));
+        if (parsed_end != token_end)
+          return false;
+        n_line++;
+        p = token_end;
+      }
+
+      in_record += n_line;
+      if (n_line == 0 || in_record > n_items || (!wrap && in_record != n_items))
+        return false;
+      if (in_record == n_items)
+        in_record = 0;
+    }
+    p = line_end + 1;
+  }
+
+  return in_record == 0;
+}
+
 std::string
 NRLib::Chomp(const std::string& s)
 {
@@ -60,6 +60,17 @@ namespace NRLib {
   template <typename I>
   I ParseAsciiArrayFast(std::string& s, I begin, size_t n);
 
+  /// Parses a table of numbers with n_items items per record, appending
+  /// them to values. Empty lines are skipped. If wrap is true, a record may
+  /// continue over several lines, but must end at the end of a line.
+  /// Returns false if a token is not a plain decimal number or a record has
+  /// the wrong number of items; values is then unspecified. Meant as a fast
+  /// path in front of a slower reader giving detailed error messages.
+  bool ParseAsciiRecordsFast(const std::string   & s,
+                             size_t                n_items,
+                             bool                  wrap,
+                             std::vector<double> & values);
+
   /// Get the path from a full file name.
   std::string GetPath(const std::string& filename);
 
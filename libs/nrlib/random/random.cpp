@@ -20,6 +20,7 @@
 // EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "random.hpp"
+#include "randomgenerator.hpp"
 #include "../exception/exception.hpp"
 
 #include <ctime>
@@ -33,6 +34,13 @@ unsigned long Random::start_seed_     = 0;
 bool          Random::use_seed_file_  = false;
 std::string   Random::seed_file_      = "";
 
+namespace {
+  RandomGenerator * thread_generator = NULL; // Set by SetThreadGenerator
+#ifdef PARALLEL
+#pragma omp threadprivate(thread_generator)
+#endif
+}
+
 void Random::Initialize() {
   unsigned long seed = static_cast<unsigned long>(time(0));
   InitializeMT(seed);
@@ -61,6 +69,32 @@ void Random::Initialize(const std::string& filename) {
   InitializeMT(start_seed_);
 }
 
+double Random::Unif01()
+{
+  if (thread_generator != NULL)
+    return thread_generator->Unif01();
+  return dsfmt_gv_genrand_close_open();
+}
+
+double Random::Unif01Open()
+{
+  if (thread_generator != NULL)
+    return thread_generator->Unif01Open();
+  return dsfmt_gv_genrand_open_open();
+}
+
+unsigned long Random::DrawUint32()
+{
+  if (thread_generator != NULL)
+    return thread_generator->DrawUint32();
+  return dsfmt_gv_genrand_uint32();
+}
+
+void Random::SetThreadGenerator(RandomGenerator * generator)
+{
+  thread_generator = generator;
+}
+
 double Random::Norm01()
 {
   double u, u1, u2, u3;
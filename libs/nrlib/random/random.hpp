@@ -28,6 +28,8 @@
 
 namespace NRLib {
 
+class RandomGenerator;
+
 /// Random generator class based on the Mersenne-Twister random
 /// number generator.
 /// Always initialize before use!
@@ -41,13 +43,18 @@ public:
   static void Initialize(const std::string& seed_file_);
 
   /// \return uniform number in [0,1)
-  static double Unif01()             { return dsfmt_gv_genrand_close_open(); }
+  static double Unif01();
 
   /// \return uniform number in (0,1)
-  static double Unif01Open()             { return dsfmt_gv_genrand_open_open(); }
+  static double Unif01Open();
 
   /// \return unsigned 32-bit integer betwen 0 and 0xFFFFFFFF
-  static unsigned long DrawUint32()  { return dsfmt_gv_genrand_uint32(); }
+  static unsigned long DrawUint32();
+
+  /// Makes the draws of the calling thread come from generator instead of the
+  /// global generator, until it is called with NULL. Lets threads sampling
+  /// with the static functions use streams of their own.
+  static void SetThreadGenerator(RandomGenerator * generator);
 
   /// Marsaglia-Bray's method, see Ripley, p. 84.
   static double Norm01();
@@ -0,0 +1,834 @@
+// Copyright (c)  2011, Norwegian Computing Center
+// All rights reserved.
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//   Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+//   Redistributions in binary form must reproduce the above copyright notice, this list of
+//    conditions and the following disclaimer in the documentation and/or other materials
+//    provided with the distribution.
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+// OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+// HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+// EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "chunkedgrid.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <queue>
+#include <utility>
+#include <vector>
+
+#include "../exception/exception.hpp"
+#include "../iotools/fileio.hpp"
+#include "../iotools/stringtools.hpp"
+
+using namespace NRLib;
+
+struct NRLib::ChunkSection {
+  int                             version;
+  size_t                          ni, nj, nk;       // Grid dimensions
+  size_t                          ci, cj, ck;       // Chunk dimensions
+  size_t                          n_ci, n_cj, n_ck; // Number of chunks in each direction
+  double                          step;             // Quantization step, 0 if lossless
+  float                           missing_code;
+  std::vector<unsigned long long> offsets;          // Relative to the first chunk
+  std::vector<int>                sizes;
+  unsigned long long              total_size;
+  std::streampos                  data_start;
+};
+
+namespace {
+
+// Version 1 run-length encoded each chunk as one stream. Version 2 codes
+// each byte plane on its own, with an optional Huffman stage.
+const int CHUNKED_GRID_VERSION = 2;
+
+// Longest Huffman code. Short codes keep the decoding table small, which
+// matters for the small chunks of the FFTFileGrid temporaries.
+const int MAX_CODE_LENGTH = 12;
+
+// How a byte stream of a chunk is stored.
+enum StreamMode { RUN_LENGTH = 0, RUN_LENGTH_HUFFMAN = 1 };
+
+
+void WriteUInt64(std::ostream & stream, unsigned long long value)
+{
+  char buffer[8];
+  for (int b = 0; b < 8; b++)
+    buffer[b] = static_cast<char>((value >> (56 - 8*b)) & 0xff);
+  if (!stream.write(buffer, 8))
+    throw Exception("Error writing to stream.");
+}
+
+
+unsigned long long ReadUInt64(std::istream & stream)
+{
+  unsigned char buffer[8];
+  if (!stream.read(reinterpret_cast<char *>(buffer), 8))
+    throw Exception("Error reading from stream.");
+  unsigned long long value = 0;
+  for (int b = 0; b < 8; b++)
+    value = (value << 8) | buffer[b];
+  return value;
+}
+
+
+size_t NumberOfChunks(size_t n, size_t chunk)
+{
+  return (n + chunk - 1) / chunk;
+}
+
+
+void FindChunkBox(const ChunkSection & section,
+                  size_t               chunk,
+                  size_t             & i0,
+                  size_t             & j0,
+                  size_t             & k0,
+                  size_t             & ni,
+                  size_t             & nj,
+                  size_t             & nk)
+{
+  size_t ic = chunk % section.n_ci;
+  size_t jc = (chunk / section.n_ci) % section.n_cj;
+  size_t kc = chunk / (section.n_ci*section.n_cj);
+  i0 = ic*section.ci;
+  j0 = jc*section.cj;
+  k0 = kc*section.ck;
+  ni = std::min(section.ci, section.ni - i0);
+  nj = std::min(section.cj, section.nj - j0);
+  nk = std::min(section.ck, section.nk - k0);
+}
+
+
+/// Packets of 1-128 literal bytes (control byte 0-127), or runs of 2-129
+/// equal bytes (control byte 128-255) followed by the repeated byte.
+void RunLengthEncode(const std::vector<unsigned char> & in,
+                     std::vector<unsigned char>       & out)
+{
+  size_t n = in.size();
+  size_t i = 0;
+  while (i < n) {
+    size_t run = 1;
+    while (i + run < n && run < 129 && in[i + run] == in[i])
+      run++;
+    if (run >= 3) {
+      out.push_back(static_cast<unsigned char>(128 + run - 2));
+      out.push_back(in[i]);
+      i += run;
+    }
+    else {
+      size_t start = i;
+      while (i < n && i - start < 128) {
+        if (i + 2 < n && in[i] == in[i + 1] && in[i] == in[i + 2])
+          break;
+        i++;
+      }
+      out.push_back(static_cast<unsigned char>(i - start - 1));
+      out.insert(out.end(), in.begin() + start, in.begin() + i);
+    }
+  }
+}
+
+
+void RunLengthDecode(const std::vector<unsigned char> & in,
+                     std::vector<unsigned char>       & out)
+{
+  size_t n = in.size();
+  size_t i = 0;
+  while (i < n) {
+    size_t c = in[i++];
+    if (c < 128) {
+      if (i + c + 1 > n)
+        throw FileFormatError("Corrupt chunk in chunked grid.");
+      out.insert(out.end(), in.begin() + i, in.begin() + i + c + 1);
+      i += c + 1;
+    }
+    else {
+      if (i >= n)
+        throw FileFormatError("Corrupt chunk in chunked grid.");
+      out.insert(out.end(), c - 126, in[i++]);
+    }
+  }
+}
+
+
+void PutUInt32(std::vector<unsigned char> & out, size_t value)
+{
+  for (int b = 0; b < 4; b++)
+    out.push_back(static_cast<unsigned char>((value >> (24 - 8*b)) & 0xff));
+}
+
+
+size_t GetUInt32(const std::vector<unsigned char> & in, size_t & pos)
+{
+  if (pos + 4 > in.size())
+    throw FileFormatError("Corrupt chunk in chunked grid.");
+  size_t value = 0;
+  for (int b = 0; b < 4; b++)
+    value = (value << 8) | in[pos++];
+  return value;
+}
+
+
+/// Huffman code lengths of the bytes of in, at most MAX_CODE_LENGTH. Too
+/// long codes are avoided by flattening the counts until the tree is
+/// shallow enough.
+void FindCodeLengths(const std::vector<unsigned char> & in,
+                     std::vector<int>                 & lengths)
+{
+  std::vector<unsigned long long> counts(256, 0);
+  for (size_t i = 0; i < in.size(); i++)
+    counts[in[i]]++;
+
+  typedef std::pair<unsigned long long, int> Node;   // Weight and node number
+  lengths.assign(256, 0);
+  for (;;) {
+    std::priority_queue<Node, std::vector<Node>, std::greater<Node> > queue;
+    std::vector<int> parent;
+    std::vector<int> leaf(256, -1);
+    for (int s = 0; s < 256; s++) {
+      if (counts[s] > 0) {
+        leaf[s] = static_cast<int>(parent.size());
+        queue.push(Node(counts[s], leaf[s]));
+        parent.push_back(-1);
+      }
+    }
+    if (queue.size() == 1) {
+      for (int s = 0; s < 256; s++)
+        lengths[s] = (leaf[s] >= 0 ? 1 : 0);
+      return;
+    }
+    while (queue.size() > 1) {
+      Node a = queue.top();
+      queue.pop();
+      Node b = queue.top();
+      queue.pop();
+      int node = static_cast<int>(parent.size());
+      parent.push_back(-1);
+      parent[a.second] = node;
+      parent[b.second] = node;
+      queue.push(Node(a.first + b.first, node));
+    }
+
+    int max_length = 0;
+    for (int s = 0; s < 256; s++) {
+      lengths[s] = 0;
+      for (int node = leaf[s]; node >= 0 && parent[node] >= 0; node = parent[node])
+        lengths[s]++;
+      max_length = std::max(max_length, lengths[s]);
+    }
+    if (max_length <= MAX_CODE_LENGTH)
+      return;
+
+    for (int s = 0; s < 256; s++) {
+      if (counts[s] > 0)
+        counts[s] = (counts[s] + 1)/2;
+    }
+  }
+}
+
+
+/// Canonical codes for the code lengths: shorter codes first, and symbols
+/// of equal length in increasing order.
+void FindCanonicalCodes(const std::vector<int>   & lengths,
+                        std::vector<unsigned int> & codes)
+{
+  codes.assign(256, 0);
+  unsigned int code = 0;
+  for (int length = 1; length <= MAX_CODE_LENGTH; length++) {
+    for (int s = 0; s < 256; s++) {
+      if (lengths[s] == length)
+        codes[s] = code++;
+    }
+    code <<= 1;
+  }
+}
+
+
+/// The 256 code lengths as nibbles, the number of symbols, the number of
+/// bytes of the bit stream, and the bit stream, most significant bit first.
+void HuffmanEncode(const std::vector<unsigned char> & in,
+                   std::vector<unsigned char>       & out)
+{
+  std::vector<int>          lengths;
+  std::vector<unsigned int> codes;
+  FindCodeLengths(in, lengths);
+  FindCanonicalCodes(lengths, codes);
+
+  for (int s = 0; s < 256; s += 2)
+    out.push_back(static_cast<unsigned char>((lengths[s] << 4) | lengths[s + 1]));
+  PutUInt32(out, in.size());
+  size_t size_pos = out.size();
+  PutUInt32(out, 0);
+  size_t start = out.size();
+
+  unsigned long long buffer = 0;
+  int                n_bits = 0;
+  for (size_t i = 0; i < in.size(); i++) {
+    buffer  = (buffer << lengths[in[i]]) | codes[in[i]];
+    n_bits += lengths[in[i]];
+    while (n_bits >= 8) {
+      n_bits -= 8;
+      out.push_back(static_cast<unsigned char>((buffer >> n_bits) & 0xff));
+    }
+  }
+  if (n_bits > 0)
+    out.push_back(static_cast<unsigned char>((buffer << (8 - n_bits)) & 0xff));
+
+  size_t n_bytes = out.size() - start;
+  for (int b = 0; b < 4; b++)
+    out[size_pos + b] = static_cast<unsigned char>((n_bytes >> (24 - 8*b)) & 0xff);
+}
+
+
+void HuffmanDecode(const std::vector<unsigned char> & in,
+                   size_t                           & pos,
+                   std::vector<unsigned char>       & out)
+{
+  if (pos + 128 > in.size())
+    throw FileFormatError("Corrupt chunk in chunked grid.");
+  std::vector<int> lengths(256);
+  for (int s = 0; s < 256; s += 2) {
+    lengths[s]     = in[pos] >> 4;
+    lengths[s + 1] = in[pos] & 0x0f;
+    pos++;
+  }
+  size_t n_symbols = GetUInt32(in, pos);
+  size_t n_bytes   = GetUInt32(in, pos);
+  if (pos + n_bytes > in.size())
+    throw FileFormatError("Corrupt chunk in chunked grid.");
+
+  for (int s = 0; s < 256; s++) {
+    if (lengths[s] > MAX_CODE_LENGTH)
+      throw FileFormatError("Corrupt chunk in chunked grid.");
+  }
+  std::vector<unsigned int> codes;
+  FindCanonicalCodes(lengths, codes);
+
+  // Each entry holds the symbol and the length of the code starting with
+  // the MAX_CODE_LENGTH bits of its index. Unused entries have length 0.
+  std::vector<unsigned short> table(1 << MAX_CODE_LENGTH, 0);
+  for (int s = 0; s < 256; s++) {
+    if (lengths[s] > 0) {
+      int    shift = MAX_CODE_LENGTH - lengths[s];
+      size_t first = static_cast<size_t>(codes[s]) << shift;
+      size_t last  = static_cast<size_t>(codes[s] + 1) << shift;
+      if (last > table.size())
+        throw FileFormatError("Corrupt chunk in chunked grid.");
+      for (size_t e = first; e < last; e++)
+        table[e] = static_cast<unsigned short>((s << 4) | lengths[s]);
+    }
+  }
+
+  size_t             end    = pos + n_bytes;
+  unsigned long long buffer = 0;
+  int                n_bits = 0;    // Bits in buffer, past the end counted as zeros
+  size_t             n_real = 8*n_bytes;
+  out.reserve(out.size() + n_symbols);
+  for (size_t i = 0; i < n_symbols; i++) {
+    while (n_bits < MAX_CODE_LENGTH) {
+      buffer  = (buffer << 8) | (pos < end ? in[pos] : 0);
+      n_bits += 8;
+      pos++;
+    }
+    unsigned short entry  = table[(buffer >> (n_bits - MAX_CODE_LENGTH)) & ((1 << MAX_CODE_LENGTH) - 1)];
+    int            length = entry & 0x0f;
+    if (length == 0 || static_cast<size_t>(length) > n_real)
+      throw FileFormatError("Corrupt chunk in chunked grid.");
+    n_bits -= length;
+    n_real -= length;
+    out.push_back(static_cast<unsigned char>(entry >> 4));
+  }
+  pos = end;
+}
+
+
+/// Run-length encodes in, and adds the Huffman stage when that is smaller.
+/// Planes with many equal neighbours are mostly shrunk by the run-length
+/// coding, while planes of varying bytes with a skewed distribution are
+/// mostly shrunk by the Huffman coding.
+void EncodeStream(const std::vector<unsigned char> & in,
+                  std::vector<unsigned char>       & out)
+{
+  std::vector<unsigned char> runs;
+  RunLengthEncode(in, runs);
+
+  std::vector<unsigned char> huffman;
+  if (runs.size() > 256)
+    HuffmanEncode(runs, huffman);
+
+  if (huffman.size() > 0 && huffman.size() < runs.size()) {
+    out.push_back(RUN_LENGTH_HUFFMAN);
+    out.insert(out.end(), huffman.begin(), huffman.end());
+  }
+  else {
+    out.push_back(RUN_LENGTH);
+    PutUInt32(out, runs.size());
+    out.insert(out.end(), runs.begin(), runs.end());
+  }
+}
+
+
+void DecodeStream(const std::vector<unsigned char> & in,
+                  size_t                           & pos,
+                  std::vector<unsigned char>       & out)
+{
+  if (pos >= in.size())
+    throw FileFormatError("Corrupt chunk in chunked grid.");
+  int mode = in[pos++];
+
+  std::vector<unsigned char> runs;
+  if (mode == RUN_LENGTH_HUFFMAN) {
+    HuffmanDecode(in, pos, runs);
+  }
+  else if (mode == RUN_LENGTH) {
+    size_t n = GetUInt32(in, pos);
+    if (pos + n > in.size())
+      throw FileFormatError("Corrupt chunk in chunked grid.");
+    runs.assign(in.begin() + pos, in.begin() + pos + n);
+    pos += n;
+  }
+  else {
+    throw FileFormatError("Corrupt chunk in chunked grid.");
+  }
+  RunLengthDecode(runs, out);
+}
+
+
+void EncodeChunk(const std::vector<float>   & values,
+                 float                        missing_code,
+                 double                       step,
+                 std::vector<unsigned char> & out)
+{
+  size_t n = values.size();
+  std::vector<unsigned char> bytes;
+
+  if (step > 0.0) {
+    bytes.reserve(n);
+    long long previous = 0;
+    for (size_t v = 0; v < n; v++) {
+      unsigned long long symbol = 0; // Missing
+      if (values[v] != missing_code) {
+        double scaled = values[v]/step;
+        if (!(std::fabs(scaled) < 1.0e18))
+          throw Exception("Value " + ToString(values[v]) + " can not be quantized with step " + ToString(step) + ".");
+        long long q = static_cast<long long>(std::floor(scaled + 0.5));
+        long long d = q - previous;
+        previous = q;
+        unsigned long long zigzag = (d >= 0 ? 2*static_cast<unsigned long long>(d)
+                                            : 2*static_cast<unsigned long long>(-(d + 1)) + 1);
+        symbol = zigzag + 1;
+      }
+      while (symbol >= 128) {
+        bytes.push_back(static_cast<unsigned char>((symbol & 127) | 128));
+        symbol >>= 7;
+      }
+      bytes.push_back(static_cast<unsigned char>(symbol));
+    }
+  }
+  else {
+    bytes.resize(4*n);
+    unsigned int previous = 0;
+    for (size_t v = 0; v < n; v++) {
+      unsigned int u;
+      std::memcpy(&u, &values[v], 4);
+      unsigned int r = u ^ previous;
+      previous = u;
+      bytes[v]       = static_cast<unsigned char>(r >> 24);
+      bytes[n + v]   = static_cast<unsigned char>((r >> 16) & 0xff);
+      bytes[2*n + v] = static_cast<unsigned char>((r >> 8) & 0xff);
+      bytes[3*n + v] = static_cast<unsigned char>(r & 0xff);
+    }
+  }
+
+  // The byte planes differ a lot in how well they compress, and are coded
+  // separately.
+  size_t n_streams = (step > 0.0 ? 1 : 4);
+  size_t length    = bytes.size()/n_streams;
+  std::vector<unsigned char> stream;
+  for (size_t p = 0; p < n_streams; p++) {
+    stream.assign(bytes.begin() + p*length, bytes.begin() + (p + 1)*length);
+    EncodeStream(stream, out);
+  }
+}
+
+
+void DecodeChunk(const std::vector<unsigned char> & in,
+                 int                                version,
+                 float                              missing_code,
+                 double                             step,
+                 std::vector<float>               & values)
+{
+  size_t n = values.size();
+  std::vector<unsigned char> bytes;
+  bytes.reserve(step > 0.0 ? n : 4*n);
+  if (version == 1) {
+    RunLengthDecode(in, bytes);
+  }
+  else {
+    size_t pos       = 0;
+    size_t n_streams = (step > 0.0 ? 1 : 4);
+    for (size_t p = 0; p < n_streams; p++)
+      DecodeStream(in, pos, bytes);
+    if (pos != in.size())
+      throw FileFormatError("Corrupt chunk in chunked grid.");
+  }
+
+  if (step > 0.0) {
+    size_t    b        = 0;
+    long long previous = 0;
+    for (size_t v = 0; v < n; v++) {
+      unsigned long long symbol = 0;
+      int                shift  = 0;
+      unsigned char      byte;
+      do {
+        if (b >= bytes.size() || shift > 63)
+          throw FileFormatError("Corrupt chunk in chunked grid.");
+        byte    = bytes[b++];
+        symbol |= static_cast<unsigned long long>(byte & 127) << shift;
+        shift  += 7;
+      } while ((byte & 128) != 0);
+
+      if (symbol == 0) {
+        values[v] = missing_code;
+      }
+      else {
+        unsigned long long zigzag = symbol - 1;
+        long long d = ((zigzag & 1) == 0 ? static_cast<long long>(zigzag >> 1)
+                                         : -static_cast<long long>(zigzag >> 1) - 1);
+        previous += d;
+        values[v] = static_cast<float>(previous*step);
+      }
+    }
+  }
+  else {
+    if (bytes.size() != 4*n)
+      throw FileFormatError("Corrupt chunk in chunked grid.");
+    unsigned int previous = 0;
+    for (size_t v = 0; v < n; v++) {
+      unsigned int r = (static_cast<unsigned int>(bytes[v]) << 24)
+                     | (static_cast<unsigned int>(bytes[n + v]) << 16)
+                     | (static_cast<unsigned int>(bytes[2*n + v]) << 8)
+                     |  static_cast<unsigned int>(bytes[3*n + v]);
+      unsigned int u = r ^ previous;
+      previous = u;
+      std::memcpy(&values[v], &u, 4);
+    }
+  }
+}
+
+
+void ReadChunkSection(std::istream & stream,
+                      ChunkSection & section)
+{
+  int version = ReadBinaryInt(stream);
+  if (version < 1 || version > CHUNKED_GRID_VERSION)
+    throw FileFormatError("Unsupported chunked grid version " + ToString(version) + ".");
+
+  section.version      = version;
+  section.ni           = ReadBinaryInt(stream);
+  section.nj           = ReadBinaryInt(stream);
+  section.nk           = ReadBinaryInt(stream);
+  section.ci           = ReadBinaryInt(stream);
+  section.cj           = ReadBinaryInt(stream);
+  section.ck           = ReadBinaryInt(stream);
+  section.step         = ReadBinaryDouble(stream);
+  section.missing_code = ReadBinaryFloat(stream);
+
+  size_t n_chunks = ReadBinaryInt(stream);
+  section.n_ci    = NumberOfChunks(section.ni, section.ci);
+  section.n_cj    = NumberOfChunks(section.nj, section.cj);
+  section.n_ck    = NumberOfChunks(section.nk, section.ck);
+  if (n_chunks != section.n_ci*section.n_cj*section.n_ck)
+    throw FileFormatError("Inconsistent number of chunks in chunked grid.");
+
+  section.offsets.resize(n_chunks);
+  section.sizes.resize(n_chunks);
+  for (size_t c = 0; c < n_chunks; c++) {
+    section.offsets[c] = ReadUInt64(stream);
+    section.sizes[c]   = ReadBinaryInt(stream);
+  }
+  section.total_size = ReadUInt64(stream);
+  section.data_start = stream.tellg();
+}
+
+
+void ReadChunks(std::istream       & stream,
+                const ChunkSection & section,
+                size_t               i0,
+                size_t               j0,
+                size_t               k0,
+                Grid<float>        & sub_grid)
+{
+  size_t ni = sub_grid.GetNI();
+  size_t nj = sub_grid.GetNJ();
+  size_t nk = sub_grid.GetNK();
+  if (i0 + ni > section.ni || j0 + nj > section.nj || k0 + nk > section.nk)
+    throw Exception("The sub-volume is not inside the chunked grid.");
+
+  std::vector<unsigned char> compressed;
+  std::vector<float>         values;
+
+  // Only the chunks overlapping the sub-volume are visited.
+  std::vector<size_t> chunks;
+  if (ni > 0 && nj > 0 && nk > 0) {
+    for (size_t kc = k0/section.ck; kc*section.ck < k0 + nk; kc++) {
+      for (size_t jc = j0/section.cj; jc*section.cj < j0 + nj; jc++) {
+        for (size_t ic = i0/section.ci; ic*section.ci < i0 + ni; ic++)
+          chunks.push_back(ic + section.n_ci*(jc + section.n_cj*kc));
+      }
+    }
+  }
+
+  for (size_t b = 0; b < chunks.size(); b++) {
+    size_t c = chunks[b];
+    size_t ci0, cj0, ck0, cni, cnj, cnk;
+    FindChunkBox(section, c, ci0, cj0, ck0, cni, cnj, cnk);
+
+    compressed.resize(section.sizes[c]);
+    stream.seekg(section.data_start + static_cast<std::streamoff>(section.offsets[c]));
+    if (compressed.size() > 0 && !stream.read(reinterpret_cast<char *>(&compressed[0]), compressed.size()))
+      throw Exception("Error reading from stream.");
+
+    values.resize(cni*cnj*cnk);
+    DecodeChunk(compressed, section.version, section.missing_code, section.step, values);
+
+    size_t i_start = std::max(ci0, i0);
+    size_t j_start = std::max(cj0, j0);
+    size_t k_start = std::max(ck0, k0);
+    size_t i_end   = std::min(ci0 + cni, i0 + ni);
+    size_t j_end   = std::min(cj0 + cnj, j0 + nj);
+    size_t k_end   = std::min(ck0 + cnk, k0 + nk);
+    for (size_t k = k_start; k < k_end; k++) {
+      for (size_t j = j_start; j < j_end; j++) {
+        for (size_t i = i_start; i < i_end; i++)
+          sub_grid(i - i0, j - j0, k - k0) = values[(i - ci0) + cni*((j - cj0) + cnj*(k - ck0))];
+      }
+    }
+  }
+
+  stream.seekg(section.data_start + static_cast<std::streamoff>(section.total_size));
+}
+
+} // namespace
+
+
+void NRLib::WriteChunkedGrid(std::ostream      & stream,
+                             const Grid<float> & grid,
+                             float               missing_code,
+                             double              quantization_step,
+                             size_t              chunk_size,
+                             int                 n_threads)
+{
+  ChunkedGridWriter writer(stream, grid.GetNI(), grid.GetNJ(), grid.GetNK(), missing_code,
+                           quantization_step, chunk_size, n_threads);
+  writer.WriteBand(grid);
+  writer.Finish();
+}
+
+
+NRLib::ChunkedGridWriter::ChunkedGridWriter(std::ostream & stream,
+                                            size_t         ni,
+                                            size_t         nj,
+                                            size_t         nk,
+                                            float          missing_code,
+                                            double         quantization_step,
+                                            size_t         chunk_size,
+                                            int            n_threads)
+  : stream_(stream),
+    ni_(ni),
+    nj_(nj),
+    nk_(nk),
+    chunk_size_(chunk_size),
+    missing_code_(missing_code),
+    quantization_step_(quantization_step > 0.0 ? quantization_step : 0.0),
+    n_threads_(n_threads),
+    next_j_(0),
+    total_size_(0)
+{
+  if (chunk_size == 0)
+    throw Exception("The chunk size must be positive.");
+
+  size_t n_chunks = NumberOfChunks(ni, chunk_size)*NumberOfChunks(nj, chunk_size)*NumberOfChunks(nk, chunk_size);
+  offsets_.assign(n_chunks, 0);
+  sizes_.assign(n_chunks, 0);
+
+  WriteBinaryInt(stream_, CHUNKED_GRID_VERSION);
+  WriteBinaryInt(stream_, static_cast<int>(ni));
+  WriteBinaryInt(stream_, static_cast<int>(nj));
+  WriteBinaryInt(stream_, static_cast<int>(nk));
+  WriteBinaryInt(stream_, static_cast<int>(chunk_size));
+  WriteBinaryInt(stream_, static_cast<int>(chunk_size));
+  WriteBinaryInt(stream_, static_cast<int>(chunk_size));
+  WriteBinaryDouble(stream_, quantization_step_);
+  WriteBinaryFloat(stream_, missing_code);
+  WriteBinaryInt(stream_, static_cast<int>(n_chunks));
+
+  // The index is filled in by Finish().
+  index_start_ = stream_.tellp();
+  for (size_t c = 0; c < n_chunks; c++) {
+    WriteUInt64(stream_, 0);
+    WriteBinaryInt(stream_, 0);
+  }
+  WriteUInt64(stream_, 0);
+}
+
+
+void NRLib::ChunkedGridWriter::WriteBand(const Grid<float> & band)
+{
+  size_t j0 = next_j_;
+  size_t nb = band.GetNJ();
+  if (band.GetNI() != ni_ || band.GetNK() != nk_ || j0 + nb > nj_ || (j0 + nb < nj_ && nb % chunk_size_ != 0))
+    throw Exception("The band of rows does not fit the chunked grid.");
+
+  ChunkSection section;
+  section.version = CHUNKED_GRID_VERSION;
+  section.ni      = ni_;
+  section.nj      = nj_;
+  section.nk      = nk_;
+  section.ci      = chunk_size_;
+  section.cj      = chunk_size_;
+  section.ck      = chunk_size_;
+  section.n_ci    = NumberOfChunks(ni_, chunk_size_);
+  section.n_cj    = NumberOfChunks(nj_, chunk_size_);
+  section.n_ck    = NumberOfChunks(nk_, chunk_size_);
+
+  // The chunks of the band, in the order of the index.
+  std::vector<int> band_chunks;
+  for (size_t kc = 0; kc < section.n_ck; kc++) {
+    for (size_t jc = j0/chunk_size_; jc*chunk_size_ < j0 + nb; jc++) {
+      for (size_t ic = 0; ic < section.n_ci; ic++)
+        band_chunks.push_back(static_cast<int>(ic + section.n_ci*(jc + section.n_cj*kc)));
+    }
+  }
+
+  int n_chunks = static_cast<int>(band_chunks.size());
+  std::vector<std::vector<unsigned char> > chunks(n_chunks);
+  std::string error;
+
+  // The chunks are independent, and are compressed in parallel.
+#ifdef PARALLEL
+#pragma omp parallel for schedule(dynamic, 1) num_threads(n_threads_)
+#endif
+  for (int b = 0; b < n_chunks; b++) {
+    size_t i0, cj0, k0, ni, nj, nk;
+    FindChunkBox(section, band_chunks[b], i0, cj0, k0, ni, nj, nk);
+
+    std::vector<float> values(ni*nj*nk);
+    size_t v = 0;
+    for (size_t k = k0; k < k0 + nk; k++) {
+      for (size_t j = cj0; j < cj0 + nj; j++) {
+        for (size_t i = i0; i < i0 + ni; i++)
+          values[v++] = band(i, j - j0, k);
+      }
+    }
+
+    try {
+      EncodeChunk(values, missing_code_, quantization_step_, chunks[b]);
+    }
+    catch (Exception & e) {
+#ifdef PARALLEL
+#pragma omp critical(chunked_grid_error)
+#endif
+      error = e.what();
+    }
+  }
+  if (error != "")
+    throw Exception(error);
+
+  for (int b = 0; b < n_chunks; b++) {
+    int c       = band_chunks[b];
+    offsets_[c] = total_size_;
+    sizes_[c]   = static_cast<int>(chunks[b].size());
+    total_size_ += chunks[b].size();
+    if (chunks[b].size() > 0 &&
+        !stream_.write(reinterpret_cast<const char *>(&chunks[b][0]), static_cast<std::streamsize>(chunks[b].size())))
+      throw Exception("Error writing to stream.");
+  }
+
+  next_j_ += nb;
+}
+
+
+void NRLib::ChunkedGridWriter::Finish()
+{
+  if (next_j_ != nj_)
+    throw Exception("Only " + ToString(next_j_) + " of the " + ToString(nj_) + " rows of the chunked grid were written.");
+
+  std::streampos end = stream_.tellp();
+  stream_.seekp(index_start_);
+  for (size_t c = 0; c < offsets_.size(); c++) {
+    WriteUInt64(stream_, offsets_[c]);
+    WriteBinaryInt(stream_, sizes_[c]);
+  }
+  WriteUInt64(stream_, total_size_);
+  stream_.seekp(end);
+  if (!stream_)
+    throw Exception("Error writing to stream.");
+}
+
+
+void NRLib::ReadChunkedGrid(std::istream & stream,
+                            Grid<float>  & grid)
+{
+  ChunkSection section;
+  ReadChunkSection(stream, section);
+  grid.Resize(section.ni, section.nj, section.nk);
+  ReadChunks(stream, section, 0, 0, 0, grid);
+}
+
+
+NRLib::ChunkedGridReader::ChunkedGridReader(std::istream & stream)
+  : stream_(stream),
+    section_(new ChunkSection)
+{
+  try {
+    ReadChunkSection(stream_, *section_);
+  }
+  catch (...) {
+    delete section_;
+    throw;
+  }
+}
+
+
+NRLib::ChunkedGridReader::~ChunkedGridReader()
+{
+  delete section_;
+}
+
+
+void NRLib::ChunkedGridReader::ReadSubGrid(size_t        i0,
+                                           size_t        j0,
+                                           size_t        k0,
+                                           size_t        ni,
+                                           size_t        nj,
+                                           size_t        nk,
+                                           Grid<float> & sub_grid)
+{
+  sub_grid.Resize(ni, nj, nk);
+  ReadChunks(stream_, *section_, i0, j0, k0, sub_grid);
+}
+
+
+void NRLib::ReadChunkedSubGrid(std::istream & stream,
+                               size_t         i0,
+                               size_t         j0,
+                               size_t         k0,
+                               size_t         ni,
+                               size_t         nj,
+                               size_t         nk,
+                               Grid<float>  & sub_grid)
+{
+  ChunkedGridReader reader(stream);
+  reader.ReadSubGrid(i0, j0, k0, ni, nj, nk, sub_grid);
+}
@@ -0,0 +1,144 @@
+// Copyright (c)  2011, Norwegian Computing Center
+// All rights reserved.
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//   Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+//   Redistributions in binary form must reproduce the above copyright notice, this list of
+//    conditions and the following disclaimer in the documentation and/or other materials
+//    provided with the distribution.
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+// OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+// HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+// EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef NRLIB_CHUNKEDGRID_HPP
+#define NRLIB_CHUNKEDGRID_HPP
+
+#include <iostream>
+#include <vector>
+
+#include "../grid/grid.hpp"
+
+namespace NRLib {
+  /// \brief Writes the grid as independent 3D chunks, each compressed on its own.
+  ///
+  /// The chunk section starts with the grid and chunk dimensions and an index
+  /// holding the position and size of every chunk, so that a sub-volume can
+  /// be read without decoding the rest of the file. Within a chunk, each value
+  /// is predicted from the one before it. Without quantization, the bit
+  /// patterns are XOR'ed with the prediction and split in byte planes, so
+  /// that the leading bytes common to neighbouring values become zero runs.
+  /// With quantization_step > 0, values are rounded to multiples of the step,
+  /// giving an error of at most half the step, and the differences are
+  /// stored as variable length integers. Cells equal to missing_code are
+  /// always kept exactly. Each byte plane, or the integer stream, is
+  /// finally run-length encoded, followed by a Huffman code of the result
+  /// when that makes it smaller.
+  /// The chunks are compressed on n_threads threads. The stream must be
+  /// seekable.
+  void WriteChunkedGrid(std::ostream      & stream,
+                        const Grid<float> & grid,
+                        float               missing_code,
+                        double              quantization_step = 0.0,
+                        size_t              chunk_size        = 64,
+                        int                 n_threads         = 1);
+
+  /// \brief Writes a chunk section as WriteChunkedGrid, from bands of rows.
+  ///
+  /// Lets a grid too large to be held be written piece by piece. Each band
+  /// holds all cells of the rows [j0, j0 + band.GetNJ()), where j0 is the
+  /// first row not yet written, and every band but the last must hold a
+  /// whole number of chunk rows. The chunk index is reserved when the writer
+  /// is made and written by Finish(), so the stream must be seekable.
+  class ChunkedGridWriter {
+  public:
+    ChunkedGridWriter(std::ostream & stream,
+                      size_t         ni,
+                      size_t         nj,
+                      size_t         nk,
+                      float          missing_code,
+                      double         quantization_step = 0.0,
+                      size_t         chunk_size        = 64,
+                      int            n_threads         = 1);
+
+    void WriteBand(const Grid<float> & band);
+
+    /// Writes the chunk index, and leaves the stream at the end of the section.
+    void Finish();
+
+  private:
+    std::ostream                    & stream_;
+    size_t                            ni_, nj_, nk_;
+    size_t                            chunk_size_;
+    float                             missing_code_;
+    double                            quantization_step_;
+    int                               n_threads_;
+    size_t                            next_j_;        // First row of the next band
+    std::streampos                    index_start_;
+    std::vector<unsigned long long>   offsets_;       // Relative to the first chunk
+    std::vector<int>                  sizes_;
+    unsigned long long                total_size_;
+  };
+
+  struct ChunkSection;
+
+  /// \brief Reads sub-volumes of a chunk section written by WriteChunkedGrid.
+  ///
+  /// The header and chunk index are parsed once, when the reader is made,
+  /// so that many sub-volumes can be read without parsing them again. The
+  /// stream must be positioned at the start of the chunk section, and must
+  /// outlive the reader.
+  class ChunkedGridReader {
+  public:
+    explicit ChunkedGridReader(std::istream & stream);
+    ~ChunkedGridReader();
+
+    /// \brief Reads the cells [i0, i0+ni) x [j0, j0+nj) x [k0, k0+nk).
+    ///
+    /// Only the chunks overlapping the sub-volume are read and decoded. The
+    /// stream is left at the end of the section.
+    /// \throw Exception if the sub-volume is not inside the grid.
+    void ReadSubGrid(size_t        i0,
+                     size_t        j0,
+                     size_t        k0,
+                     size_t        ni,
+                     size_t        nj,
+                     size_t        nk,
+                     Grid<float> & sub_grid);
+
+  private:
+    ChunkedGridReader(const ChunkedGridReader &);
+    ChunkedGridReader & operator=(const ChunkedGridReader &);
+
+    std::istream & stream_;
+    ChunkSection * section_;
+  };
+
+  /// \brief Reads a chunk section written by WriteChunkedGrid into grid.
+  ///
+  /// The stream must be positioned at the start of the chunk section, and
+  /// is left at its end.
+  void ReadChunkedGrid(std::istream & stream,
+                       Grid<float>  & grid);
+
+  /// \brief Reads the cells [i0, i0+ni) x [j0, j0+nj) x [k0, k0+nk) of a chunk section.
+  ///
+  /// Only the chunks overlapping the sub-volume are read and decoded.
+  /// \throw Exception if the sub-volume is not inside the grid.
+  void ReadChunkedSubGrid(std::istream & stream,
+                          size_t         i0,
+                          size_t         j0,
+                          size_t         k0,
+                          size_t         ni,
+                          size_t         nj,
+                          size_t         nk,
+                          Grid<float>  & sub_grid);
+}
+
+#endif // NRLIB_CHUNKEDGRID_HPP
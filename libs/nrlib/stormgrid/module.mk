@@ -1,2 +1,3 @@
-SRC += $(NRLIB_BASE_DIR)stormgrid/stormfaciesgrid.cpp \
+SRC += $(NRLIB_BASE_DIR)stormgrid/chunkedgrid.cpp \
+       $(NRLIB_BASE_DIR)stormgrid/stormfaciesgrid.cpp \
        $(NRLIB_BASE_DIR)stormgrid/stormcontgrid.cpp
\ No newline at end of file
@@ -20,6 +20,7 @@
 // EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "stormcontgrid.hpp"
+#include "chunkedgrid.hpp"
 #include <cmath>
 #include <fstream>
 #include <math.h>
@@ -36,8 +37,9 @@
 using namespace NRLib;
 
 const float STD_MISSING_CODE = -999.0F;
-const std::string format_desc[2] = {"storm_petro_binary",
-                                    "storm_petro_ascii"};
+const std::string format_desc[3] = {"storm_petro_binary",
+                                    "storm_petro_ascii",
+                                    "storm_petro_chunked"};
 
 
 StormContGrid::StormContGrid(size_t nx, size_t ny, size_t nz)
@@ -45,6 +47,8 @@ StormContGrid::StormContGrid(size_t nx, size_t ny, size_t nz)
 {
   // Default values
   file_format_ = STORM_BINARY;
+  quantization_step_ = 0.0;
+  n_threads_ = 1;
   missing_code_ = STD_MISSING_CODE;
   zone_number_ = 0;
   model_file_name_ = "ModelFile";
@@ -55,6 +59,8 @@ StormContGrid::StormContGrid(const Volume &vol, size_t nx, size_t ny, size_t nz)
 :Volume(vol)
 {
   file_format_ = STORM_BINARY;
+  quantization_step_ = 0.0;
+  n_threads_ = 1;
   missing_code_ = STD_MISSING_CODE;
   zone_number_ = 0;
   model_file_name_ = "ModelFile";
@@ -67,6 +73,8 @@ StormContGrid::StormContGrid(const Volume &vol, const Grid<float> & grid)
  Volume(vol)
 {
   file_format_ = STORM_BINARY;
+  quantization_step_ = 0.0;
+  n_threads_ = 1;
   missing_code_ = STD_MISSING_CODE;
   zone_number_ = 0;
   model_file_name_ = "ModelFile";
@@ -75,6 +83,8 @@ StormContGrid::StormContGrid(const Volume &vol, const Grid<float> & grid)
 
 StormContGrid::StormContGrid(const std::string& filename, Endianess file_format)
 {
+  quantization_step_ = 0.0;
+  n_threads_ = 1;
   ReadFromFile(filename, true, file_format);
 }
 
@@ -104,6 +114,9 @@ void StormContGrid::ReadFromFile(const std::string& filename, bool commonPath, E
     else if (token == format_desc[STORM_ASCII]) {
       file_format_ = STORM_ASCII;
     }
+    else if (token == format_desc[STORM_CHUNKED]) {
+      file_format_ = STORM_CHUNKED;
+    }
     else if(token=="NORSAR")
     {
       std::string binfilename;
@@ -150,6 +163,12 @@ void StormContGrid::ReadFromFile(const std::string& filename, bool commonPath, E
     case STORM_ASCII:
       ReadAsciiArrayFast(file, begin(), GetN());
       break;
+    case STORM_CHUNKED:
+      DiscardRestOfLine(file, line, true);
+      ReadChunkedGrid(file, *this);
+      if (GetNI() != static_cast<size_t>(nx) || GetNJ() != static_cast<size_t>(ny) || GetNK() != static_cast<size_t>(nz))
+        throw FileFormatError("The chunks do not match the grid dimensions in the header.");
+      break;
     default:
       throw Exception("Bug in STORM grid parser: unknown fileformat");
     }
@@ -194,6 +213,8 @@ void StormContGrid::WriteToFile(const std::string& filename, const std::string&
     file << "\n";
     file << GetNI() << " " << GetNJ() << " " << GetNK() << "\n";
   }
+  else if (file_format_ == STORM_CHUNKED) // The predefined header is given for the binary format
+    file << format_desc[STORM_CHUNKED] << predefinedHeader.substr(predefinedHeader.find('\n'));
   else
     file << predefinedHeader;
   // Data
@@ -211,6 +232,9 @@ void StormContGrid::WriteToFile(const std::string& filename, const std::string&
       }
     }
     break;
+  case STORM_CHUNKED:
+    WriteChunkedGrid(file, *this, missing_code_, quantization_step_, 64, n_threads_);
+    break;
   default:
     throw Exception("Unknown fileformat");
   }
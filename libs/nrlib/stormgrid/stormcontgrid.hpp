@@ -31,7 +31,7 @@
 namespace NRLib {
   class StormContGrid : public Grid<float>, public Volume {
   public:
-    enum FileFormat {STORM_BINARY = 0, STORM_ASCII};
+    enum FileFormat {STORM_BINARY = 0, STORM_ASCII, STORM_CHUNKED};
 
     explicit StormContGrid(const std::string& filename, Endianess file_format = END_BIG_ENDIAN);
     explicit StormContGrid(size_t nx = 0, size_t ny = 0, size_t nz = 0);
@@ -53,6 +53,14 @@ namespace NRLib {
     FileFormat GetFormat() const
     { return file_format_; }
 
+    /// Quantization step of the STORM_CHUNKED format. With 0, the grid is stored losslessly.
+    void SetQuantizationStep(double step)
+    { quantization_step_ = step; }
+
+    /// Number of threads compressing the chunks of the STORM_CHUNKED format.
+    void SetNumberOfThreads(int n_threads)
+    { n_threads_ = (n_threads > 0 ? n_threads : 1); }
+
     void SetModelFileName(const std::string& filename)
     { model_file_name_ = filename; }
 
@@ -86,7 +94,7 @@ namespace NRLib {
                          Endianess           file_format = END_BIG_ENDIAN) const;
 
     /// \throw IOError if the file can not be opened.
-    /// \throw FileFormatError if file format is not either storm_binary or storm_ascii, or if grid contains barriers.
+    /// \throw FileFormatError if file format is not either storm_binary, storm_ascii or storm_chunked, or if grid contains barriers.
     void ReadFromFile(const std::string& filename, bool commonPath = true, Endianess file_format = END_BIG_ENDIAN);
 
     double GetDX() const       { return GetLX() / GetNI(); }
@@ -141,6 +149,8 @@ namespace NRLib {
     double GetRelThick(double x, double y) const;
 
     FileFormat file_format_;
+    double quantization_step_;
+    int n_threads_;
     float missing_code_;
     int zone_number_;
     std::string model_file_name_;
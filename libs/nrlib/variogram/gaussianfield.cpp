@@ -19,6 +19,8 @@
 // OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
 // EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
+#include <algorithm>
+#include <cassert>
 #include <cmath>
 #include "gaussianfield.hpp"
 
@@ -26,7 +28,6 @@
 #include "../grid/grid2d.hpp"
 #include "../random/random.hpp"
 
-#include "../fft/fftgrid2d.hpp"
 #include "../fft/fft.hpp"
 
 
@@ -77,12 +78,36 @@ Grid2D<double> CovGridForFFT2D(const Variogram & variogram,
   return cov;
 }
 
-void NRLib::Simulate2DGaussianField(const Variogram& variogram,
-                                    size_t nx, double dx,
-                                    size_t ny, double dy,
-                                    // double padding_fraction,
-                                    // bool   user_defined_padding,
-                                    Grid2D<double> & grid_out)
+// Local function, not accessible elsewhere.
+void CopyField(const double     * real,
+               size_t             nx,
+               size_t             ny,
+               size_t             nx_tot,
+               Grid2D<double>   & grid)
+{
+  grid.Resize(nx, ny);
+  for (size_t j = 0; j < ny; j++)
+    for (size_t i = 0; i < nx; i++)
+      grid(i,j) = real[i + j*nx_tot];
+}
+
+// Local function, not accessible elsewhere.
+void CopyField(const double        * real,
+               size_t                nx,
+               size_t                /*ny*/,
+               size_t                /*nx_tot*/,
+               std::vector<double> & field)
+{
+  field.assign(real, real + nx);
+}
+
+NRLib::GaussianFieldSimulator::GaussianFieldSimulator(const Variogram & variogram,
+                                                      size_t            nx,
+                                                      double            dx,
+                                                      size_t            ny,
+                                                      double            dy)
+  : nx_(nx),
+    ny_(ny)
 {
   // Find grid size.
   double range_x, range_y;
@@ -97,28 +122,172 @@ void NRLib::Simulate2DGaussianField(const Variogram& variogram,
   size_t n_pad_x = std::max(static_cast<size_t>(4.0 * range_x / dx), 2*nx) - nx;
   size_t n_pad_y = std::max(static_cast<size_t>(4.0 * range_y / dy), 2*ny) - ny;
 
-  FFTGrid2D<double> fftgrid(nx, ny, n_pad_x, n_pad_y, true);
-
-  size_t nx_tot = fftgrid.GetNItot();
-  size_t ny_tot = fftgrid.GetNJtot();
+  nx_tot_ = FindNewSizeWithPadding(nx + n_pad_x, true);
+  ny_tot_ = FindNewSizeWithPadding(ny + n_pad_y);
 
   // Covariance grid.
-  Grid2D<double> cov = CovGridForFFT2D(variogram,
-                                       static_cast<int>(nx_tot), dx,
-                                       static_cast<int>(ny_tot), dy);
-
-  // Grid with white noice.
-  Grid2D<double> noise(nx_tot,ny_tot);
-  size_t i,j;
-    for (i = 0; i < nx_tot; i++)
-      for (j = 0; j < ny_tot; j++)
-        noise(i,j) = NRLib::Random::Norm01();
-
-  fftgrid.Initialize(noise);
-  FFTGrid2D<double> filter(nx, ny, n_pad_x, n_pad_y, false);
-  filter.Initialize(cov);
-  fftgrid.ConvolveCovariance(filter);
-  grid_out = fftgrid.GetRealGrid();
+  Grid2D<double> cov_grid = CovGridForFFT2D(variogram,
+                                            static_cast<int>(nx_tot_), dx,
+                                            static_cast<int>(ny_tot_), dy);
+  std::vector<double> cov(nx_tot_*ny_tot_);
+  for (size_t j = 0; j < ny_tot_; j++)
+    for (size_t i = 0; i < nx_tot_; i++)
+      cov[i + j*nx_tot_] = cov_grid(i,j);
+
+  Setup(cov);
+}
+
+NRLib::GaussianFieldSimulator::GaussianFieldSimulator(const Variogram & variogram,
+                                                      size_t            nx,
+                                                      double            dx)
+  : nx_(nx),
+    ny_(1)
+{
+  double range  = variogram.GetRangeX();
+  size_t nx_pad = std::min(static_cast<size_t>(2.0 * range / dx), nx);
+  nx_tot_ = NRLib::FindNewSizeWithPadding(nx + nx_pad);
+  ny_tot_ = 1;
+
+  std::vector<double> cov(nx_tot_);
+  size_t nxm = (nx_tot_+1)/2;
+  for(size_t i = 0; i < nxm; i++) {
+    cov[i] = variogram.GetCov(i*dx);
+  }
+  for(size_t i=nxm; i < nx_tot_; i++) {
+    double ddx = dx*(nx_tot_ - i);
+    cov[i] = variogram.GetCov(ddx);
+  }
+
+  Setup(cov);
+}
+
+NRLib::GaussianFieldSimulator::~GaussianFieldSimulator()
+{
+  fftw_destroy_plan(forward_plan_);
+  fftw_destroy_plan(inverse_plan_);
+}
+
+void
+NRLib::GaussianFieldSimulator::Setup(const std::vector<double> & cov)
+{
+  size_t n         = nx_tot_*ny_tot_;
+  size_t n_complex = (nx_tot_/2 + 1)*ny_tot_;
+
+  double               * real    = reinterpret_cast<double *>(fftw_malloc(n * sizeof(double)));
+  std::complex<double> * complex = reinterpret_cast<std::complex<double> *>(fftw_malloc(n_complex * sizeof(std::complex<double>)));
+  fftw_complex         * complex_data = reinterpret_cast<fftw_complex *>(complex);
+
+  // The plans are only made here, since making a plan is not thread safe.
+  // Executing a plan on other arrays with the same alignment is, and that is
+  // how the fields are made.
+  forward_plan_ = fftw_plan_dft_r2c_2d(static_cast<int>(ny_tot_), static_cast<int>(nx_tot_),
+                                       real, complex_data, FFTW_ESTIMATE);
+  inverse_plan_ = fftw_plan_dft_c2r_2d(static_cast<int>(ny_tot_), static_cast<int>(nx_tot_),
+                                       complex_data, real, FFTW_ESTIMATE);
+  assert(forward_plan_ != 0 && inverse_plan_ != 0);
+
+  for (size_t i = 0; i < n; i++)
+    real[i] = cov[i];
+  fftw_execute(forward_plan_);
+
+  // The spectrum of a symmetric covariance is real. Negative values come
+  // from an embedding that is small compared to the range, and are set to zero.
+  // The scaling of the two transforms of the noise is included.
+  amplitude_.resize(n_complex);
+  for (size_t i = 0; i < n_complex; i++)
+    amplitude_[i] = std::sqrt(std::max(complex[i].real(), 0.0)) / static_cast<double>(n);
+
+  fftw_free(real);
+  fftw_free(complex);
+}
+
+void
+NRLib::GaussianFieldSimulator::SimulateField(unsigned long          seed,
+                                             double               * real,
+                                             std::complex<double> * complex) const
+{
+  RandomGenerator rg;
+  rg.Initialize(seed);
+
+  size_t n = nx_tot_*ny_tot_;
+  for (size_t i = 0; i < n; i++)
+    real[i] = rg.Norm01();
+
+  fftw_execute_dft_r2c(forward_plan_, real, reinterpret_cast<fftw_complex *>(complex));
+  for (size_t i = 0; i < amplitude_.size(); i++)
+    complex[i] *= amplitude_[i];
+  fftw_execute_dft_c2r(inverse_plan_, reinterpret_cast<fftw_complex *>(complex), real);
+}
+
+template <class Field>
+void
+NRLib::GaussianFieldSimulator::SimulateFields(int                  n_fields,
+                                              RandomGenerator    & rg,
+                                              std::vector<Field> & fields_out) const
+{
+  // The seeds are drawn before the fields are made, so that the fields do not
+  // depend on which thread makes them.
+  std::vector<unsigned long> seeds(n_fields);
+  for (int f = 0; f < n_fields; f++)
+    seeds[f] = rg.DrawUint32();
+
+  size_t first = fields_out.size();
+  fields_out.resize(first + n_fields);
+
+  size_t n         = nx_tot_*ny_tot_;
+  size_t n_complex = (nx_tot_/2 + 1)*ny_tot_;
+
+#ifdef PARALLEL
+#pragma omp parallel
+#endif
+  {
+    double               * real    = reinterpret_cast<double *>(fftw_malloc(n * sizeof(double)));
+    std::complex<double> * complex = reinterpret_cast<std::complex<double> *>(fftw_malloc(n_complex * sizeof(std::complex<double>)));
+
+#ifdef PARALLEL
+#pragma omp for schedule(dynamic, 1)
+#endif
+    for (int f = 0; f < n_fields; f++) {
+      SimulateField(seeds[f], real, complex);
+      CopyField(real, nx_, ny_, nx_tot_, fields_out[first + f]);
+    }
+
+    fftw_free(real);
+    fftw_free(complex);
+  }
+}
+
+void
+NRLib::GaussianFieldSimulator::Simulate(int                            n_fields,
+                                        RandomGenerator              & rg,
+                                        std::vector<Grid2D<double> > & grid_out) const
+{
+  SimulateFields(n_fields, rg, grid_out);
+}
+
+void
+NRLib::GaussianFieldSimulator::Simulate(int                                 n_fields,
+                                        RandomGenerator                   & rg,
+                                        std::vector<std::vector<double> > & fields_out) const
+{
+  SimulateFields(n_fields, rg, fields_out);
+}
+
+void NRLib::Simulate2DGaussianField(const Variogram& variogram,
+                                    size_t nx, double dx,
+                                    size_t ny, double dy,
+                                    // double padding_fraction,
+                                    // bool   user_defined_padding,
+                                    Grid2D<double> & grid_out)
+{
+  GaussianFieldSimulator simulator(variogram, nx, dx, ny, dy);
+
+  RandomGenerator rg;
+  rg.Initialize(NRLib::Random::DrawUint32());
+
+  std::vector<Grid2D<double> > fields;
+  simulator.Simulate(1, rg, fields);
+  grid_out = fields[0];
 }
 
 // Simulation of multiple fields with the same covariance function.
@@ -131,64 +300,15 @@ void NRLib::Simulate2DGaussianField(const Variogram              & variogram,
                                     std::vector<Grid2D<double> > & grid_out,
                                     NRLib::RandomGenerator        *rg)
 {
-  // Find grid size.
-  double range_x, range_y;
-  if (variogram.GetAzimuthAngle() == 0.0) {
-    range_x = variogram.GetRangeX();
-    range_y = variogram.GetRangeY();
-  }
-  else {
-    range_x = std::max(variogram.GetRangeX(), variogram.GetRangeY());
-    range_y = range_x;
-  }
-  size_t n_pad_x = std::max(static_cast<size_t>(4.0 * range_x / dx), 2*nx) - nx;
-  size_t n_pad_y = std::max(static_cast<size_t>(4.0 * range_y / dy), 2*ny) - ny;
-
-  FFTGrid2D<double> fftgrid(nx, ny, n_pad_x, n_pad_y, true);
-
-  size_t nx_tot = fftgrid.GetNItot();
-  size_t ny_tot = fftgrid.GetNJtot();
-
-  // Covariance grid.
-  Grid2D<double> cov = CovGridForFFT2D(variogram,
-                                       static_cast<int>(nx_tot), dx,
-                                       static_cast<int>(ny_tot), dy);
-
-
-  FFTGrid2D<double> filter(nx, ny, n_pad_x, n_pad_y, false);
-  filter.Initialize(cov);
-  filter.DoFFT();
-  // Convolve with covariance grid.
-  for (size_t i = 0; i < filter.GetComplexNI()*filter.GetComplexNJ(); i++)
-    filter.ComplexData()[i] = std::sqrt(filter.ComplexData()[i]);
-
-
-  // Grid with white noice.
-  Grid2D<double> noise(nx_tot,ny_tot);
-
-  //if (seed == -999)
-  //  seed = NRLib::Random::DrawUint32();
-  // This is done to be able to do multithreading
-  //NRLib::RandomGenerator random;
- // random.Initialize(seed);
-  if(rg == NULL) {
-    rg = new RandomGenerator();
-    rg->Initialize(NRLib::Random::DrawUint32());
-  }
-  for (int k = 0; k < n_fields; k++) {
-    for (size_t i = 0; i < nx_tot; i++)
-      for (size_t j = 0; j < ny_tot; j++)
-        noise(i,j) = rg->Norm01();
-
-    fftgrid.Initialize(noise);
+  GaussianFieldSimulator simulator(variogram, nx, dx, ny, dy);
 
-    fftgrid.DoFFT();
-    for(size_t i = 0; i < filter.GetComplexNI()*filter.GetComplexNJ(); i++)
-      fftgrid.ComplexData()[i] *=filter.ComplexData()[i];
-
-    fftgrid.DoInverseFFT();
-    grid_out.push_back(fftgrid.GetRealGrid());
+  if (rg == NULL) {
+    RandomGenerator random;
+    random.Initialize(NRLib::Random::DrawUint32());
+    simulator.Simulate(n_fields, random, grid_out);
   }
+  else
+    simulator.Simulate(n_fields, *rg, grid_out);
 }
 
 void
@@ -198,42 +318,19 @@ NRLib::Simulate1DGaussianField(const Variogram       & variogram,
                                std::vector<double>   & grid_out,
                                NRLib::RandomGenerator *rg)
 {
-  double range = variogram.GetRangeX();
-  size_t nx_pad = std::min(static_cast<size_t>(2.0 * range / dx), nx);
-  size_t nxp = NRLib::FindNewSizeWithPadding(nx + nx_pad);
-  nx_pad =nxp-nx;
+  GaussianFieldSimulator simulator(variogram, nx, dx);
 
-  std::vector<double> cov(nxp);
-  size_t nxm = (nxp+1)/2;
-  for(size_t i = 0; i < nxm; i++) {
-    cov[i] = variogram.GetCov(i*dx);
-  }
-  for(size_t i=nxm; i < nxp; i++) {
-    double ddx = dx*(nxp - i);
-    cov[i] = variogram.GetCov(ddx);
+  std::vector<std::vector<double> > fields;
+  if (rg == NULL) {
+    RandomGenerator random;
+    random.Initialize(NRLib::Random::DrawUint32());
+    simulator.Simulate(1, random, fields);
   }
-  if(rg == NULL) {
-    rg = new RandomGenerator();
-    rg->Initialize(NRLib::Random::DrawUint32());
-  }
-  std::vector<double> noise(nxp);
-  for(size_t i = 0; i < nxp; i++)
-    noise[i] = rg->Norm01();
-  std::vector<std::complex<double> > cov_fft;
-  std::vector<std::complex<double> > noise_fft;
-  NRLib::ComputeFFT1D(cov, cov_fft, false,0);
-  NRLib::ComputeFFT1D(noise, noise_fft, true,0);
-  std::vector<std::complex<double> > convolve(cov_fft.size());
-
-  for(size_t i = 0; i < cov_fft.size(); i++)
-    convolve[i] = std::sqrt(cov_fft[i])*noise_fft[i];
-
-  std::vector<double> tmp(nxp);
-
-  NRLib::ComputeFFTInv1D(convolve, tmp, true);
+  else
+    simulator.Simulate(1, *rg, fields);
 
-  for(size_t i = 0; i < grid_out.size(); i++)
-    grid_out[i] = tmp[i];
+  for(size_t i = 0; i < grid_out.size() && i < fields[0].size(); i++)
+    grid_out[i] = fields[0][i];
 }
 
 
@@ -23,13 +23,79 @@
 #define NRLIB_VARIOGRAM_GAUSSIANFIELD_HPP
 
 #include <cstdlib>
+#include <complex>
 #include <vector>
+#include "fftw3.h"
 #include "../random/randomgenerator.hpp"
 
 namespace NRLib {
   class Variogram;
   template <typename T> class Grid2D;
 
+  /// \brief Simulation of many Gaussian fields with the same covariance function.
+  ///
+  /// The square root of the spectrum of the circulant embedding of the covariance
+  /// is computed once, together with the FFT plans, when the simulator is made.
+  /// A field then costs one forward and one inverse FFT of white noise. Each field
+  /// has its own random number stream, seeded from the generator given to Simulate,
+  /// so the fields are the same whatever the number of threads they are made by.
+  class GaussianFieldSimulator
+  {
+  public:
+    /// Fields on a 2D grid of nx x ny cells.
+    GaussianFieldSimulator(const Variogram & variogram,
+                           size_t            nx,
+                           double            dx,
+                           size_t            ny,
+                           double            dy);
+
+    /// Fields on a 1D grid of nx cells.
+    GaussianFieldSimulator(const Variogram & variogram,
+                           size_t            nx,
+                           double            dx);
+
+    ~GaussianFieldSimulator();
+
+    /// Appends n_fields 2D fields to grid_out. Draws one seed per field from rg.
+    void Simulate(int                            n_fields,
+                  RandomGenerator              & rg,
+                  std::vector<Grid2D<double> > & grid_out) const;
+
+    /// Appends n_fields 1D fields to fields_out. Draws one seed per field from rg.
+    void Simulate(int                                 n_fields,
+                  RandomGenerator                   & rg,
+                  std::vector<std::vector<double> > & fields_out) const;
+
+    size_t GetNxTot() const { return nx_tot_; }
+    size_t GetNyTot() const { return ny_tot_; }
+
+  private:
+    void   Setup(const std::vector<double> & cov);
+
+    /// Appends n_fields fields to fields_out, in parallel over the fields.
+    template <class Field>
+    void   SimulateFields(int                  n_fields,
+                          RandomGenerator    & rg,
+                          std::vector<Field> & fields_out) const;
+
+    /// Simulates a field on the padded grid into real, using complex as work space.
+    void   SimulateField(unsigned long          seed,
+                         double               * real,
+                         std::complex<double> * complex) const;
+
+    size_t              nx_;
+    size_t              ny_;
+    size_t              nx_tot_;        ///< Grid size with padding
+    size_t              ny_tot_;
+    fftw_plan           forward_plan_;
+    fftw_plan           inverse_plan_;
+    std::vector<double> amplitude_;     ///< Square root of the spectrum, divided by the grid size
+
+    // Make copying illegal. The plans are owned by the simulator.
+    GaussianFieldSimulator(const GaussianFieldSimulator & rhs);
+    GaussianFieldSimulator & operator=(const GaussianFieldSimulator & rhs);
+  };
+
   void Simulate2DGaussianField(const Variogram &              variogram,
                                size_t                         nx,
                                double                         dx,
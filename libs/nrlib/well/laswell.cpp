@@ -19,8 +19,10 @@
 // OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
 // EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
+#include <algorithm>
 #include <cassert>
 #include <fstream>
+#include <sstream>
 #include <string>
 #include <vector>
 #include <math.h>
@@ -361,6 +363,34 @@ LasWell::ReadLogs(std::ifstream                  & fin,
       log[i].resize(n_data);
   }
 
+  // Fast path: parse the whole data section in one go. If anything is
+  // irregular, the data are read again record by record below, to get
+  // the error messages.
+  if(log.size() > 0) {
+    std::streampos data_start = fin.tellg();
+    std::ostringstream data;
+    data << fin.rdbuf();
+    std::string buffer = data.str();
+    std::replace(buffer.begin(), buffer.end(), ',', ' '); //Makes comma delimited space delimited.
+    std::vector<double> values;
+    if(NRLib::ParseAsciiRecordsFast(buffer, log.size(), wrap_, values) == true) {
+      size_t n_found = values.size()/log.size();
+      if(n_data_given == false || n_found >= n_data) {
+        if(n_data_given == false)
+          n_data = n_found;
+        for(size_t i=0;i<log.size();i++) {
+          log[i].resize(n_data);
+          for(size_t j=0;j<n_data;j++)
+            log[i][j] = values[j*log.size()+i];
+          AddContLog(log_name_[i],log[i]);
+        }
+        return;
+      }
+    }
+    fin.clear();
+    fin.seekg(data_start);
+  }
+
   std::string line;
   size_t n_records = 0;
   size_t n_errors  = 0;
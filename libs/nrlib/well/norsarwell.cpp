@@ -21,6 +21,7 @@
 
 #include <fstream>
 #include <iostream>
+#include <sstream>
 #include <string>
 #include <stdlib.h>
 #include <assert.h>
@@ -200,6 +201,24 @@ NorsarWell::ReadLogs(const std::string & filename, int n_col, int n_row, int ski
   for(int i=0;i<skip_lines;i++)
     DiscardRestOfLine(file, line, false);
 
+  // Fast path: parse all rows in one go. Irregular files are read again
+  // element by element below, to get the error messages.
+  std::streampos data_start = file.tellg();
+  std::ostringstream data;
+  data << file.rdbuf();
+  std::string buffer = data.str();
+  std::vector<double> values;
+  if(ParseAsciiRecordsFast(buffer, n_col, false, values) == true &&
+     values.size() >= static_cast<size_t>(n_row)*n_col) {
+    for(int r=0;r<n_row;r++) {
+      for(int c=0;c<n_col;c++)
+        result[c][r] = values[static_cast<size_t>(r)*n_col+c];
+    }
+    return(result);
+  }
+  file.clear();
+  file.seekg(data_start);
+
   int baseline = line;
   int i,j; //For use in error message.
 
@@ -107,9 +107,51 @@ RMSWell::RMSWell(const std::string& filename)
   std::vector<std::vector<int> > disclogs(ndisc);
   std::vector<std::vector<double> > contlogs(ncont);
 
+  // Fast path: parse all data lines in one go. Irregular data are read
+  // again line by line below, to get the error messages.
+  std::streampos data_start = file.tellg();
+  std::ostringstream data;
+  data << file.rdbuf();
+  std::string buffer = data.str();
+  std::vector<double> values;
+  bool parsed = NRLib::ParseAsciiRecordsFast(buffer, nlog + 3, false, values);
+  if (parsed) {
+    size_t n_col  = nlog + 3;
+    size_t n_rows = values.size()/n_col;
+    for (size_t i = 0; i < ncont; i++)
+      contlogs[i].reserve(n_rows);
+    for (size_t i = 0; i < ndisc; i++)
+      disclogs[i].reserve(n_rows);
+    for (size_t r = 0; r < n_rows; r++) {
+      const double * row = &values[r*n_col];
+      contlogs[0].push_back(row[0]);
+      contlogs[1].push_back(row[1]);
+      contlogs[2].push_back(row[2]);
+      j = 0;
+      k = 3;
+      for (size_t i = 0; i < nlog; i++) {
+        if (isDiscrete_[i+3]) {
+          if (IsMissing(row[i+3]) == false)
+            disclogs[j].push_back(static_cast<int>(row[i+3]));
+          else
+            disclogs[j].push_back(GetIntMissing());
+          j++;
+        }
+        else {
+          contlogs[k].push_back(row[i+3]);
+          k++;
+        }
+      }
+    }
+  }
+  else {
+    file.clear();
+    file.seekg(data_start);
+  }
+
   int count = 0;
 
-  while(NRLib::CheckEndOfFile(file)==false && getline(file,dummy)) {
+  while(parsed == false && NRLib::CheckEndOfFile(file)==false && getline(file,dummy)) {
     count ++;
     std::istringstream ist(dummy);
     contlogs[0].push_back(ReadNext<double>(ist, line)); //x
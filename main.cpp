@@ -38,6 +38,7 @@
 #include "src/gridmapping.h"
 #include "src/simbox.h"
 #include "src/timings.h"
+#include "src/profiler.h"
 #include "src/spatialwellfilter.h"
 #include "src/tasklist.h"
 #include "src/commondata.h"
@@ -55,6 +56,8 @@
 #include "src/doinversion.h"
 
 #include "src/cravaresult.h"
+#include "src/gridmemorypool.h"
+#include "src/lateraltiles.h"
 
 #if defined(COMPILE_STORM_MODULES_FOR_RMS)
 
@@ -177,6 +180,7 @@ int main(int argc, char** argv)
 
   double wall=0.0, cpu=0.0;
   TimeKit::getTime(wall,cpu);
+  Profiler::Start();
 
   try
   {
@@ -206,12 +210,36 @@ int main(int argc, char** argv)
       return(1);
     }
 
+    if (modelSettings->getNumberOfLateralTilesX()*modelSettings->getNumberOfLateralTilesY() > 1) {
+      //
+      // Each tile is inverted by a separate run of this program on a
+      // model file of its own. Here the tiles are only set up and blended.
+      //
+      LogKit::SetFileLog(IO::makeFullFileName("",IO::FileLog()+IO::SuffixTextFiles()), modelSettings->getLogLevel());
+      LogKit::EndBuffering();
+
+      LateralTiles lateral_tiles(modelSettings);
+      bool failed = lateral_tiles.Run(argv[0], argv[1]);
+
+      Timings::setTimeTotal(wall,cpu);
+      Timings::reportTotal();
+
+      delete crava_result;
+      delete modelSettings;
+      delete inputFiles;
+      LogKit::EndLog();
+      return(failed ? 1 : 0);
+    }
+
     /*------------------------------------------------------------
     READ COMMON DATA AND PERFORM ESTIMATION BASED ON INPUT FILES
     AND MODEL SETTINGS
     -------------------------------------------------------------*/
 
-    common_data = new CommonData(modelSettings, inputFiles);
+    {
+      Profiler::Region region("Common data");
+      common_data = new CommonData(modelSettings, inputFiles);
+    }
     int n_intervals = common_data->GetMultipleIntervalGrid()->GetNIntervals();
     std::vector<SeismicParametersHolder> seismicParametersIntervals(common_data->GetMultipleIntervalGrid()->GetNIntervals());
 
@@ -228,6 +256,8 @@ int main(int argc, char** argv)
           interval_text = " for interval " + NRLib::ToString(common_data->GetMultipleIntervalGrid()->GetIntervalName(i_interval));
         LogKit::WriteHeader("Setting up model" + interval_text);
 
+        Profiler::Region interval_region("Interval " + common_data->GetMultipleIntervalGrid()->GetIntervalName(i_interval));
+
         //Priormodell i 3D
         const Simbox * simbox = common_data->GetMultipleIntervalGrid()->GetIntervalSimbox(i_interval);
 
@@ -308,6 +338,7 @@ int main(int argc, char** argv)
                 modelGeneral->AdvanceTime(time_index, seismicParametersIntervals[i_interval], modelSettings);
                 time_index++;
             }
+            Profiler::Region vintage_region("Vintage " + CommonData::ConvertIntToString(time_index));
             bool failed = false;
             switch(eventType) {
             case TimeLine::AVO : {
@@ -353,11 +384,20 @@ int main(int argc, char** argv)
         }
 
         crava_result->AddBlockedLogs(modelGeneral->GetBlockedWells());
+
+        if (n_intervals > 1 && modelSettings->getSpillIntervalResults() && !modelSettings->getDo4DInversion()) {
+          LogKit::LogFormatted(LogKit::Low,"\nMoving results" + interval_text + " to disk until they are combined.\n");
+          crava_result->SpillIntervalGrids(seismicParametersIntervals[i_interval]);
+        }
       } //interval_loop
     }
     if (n_intervals == 1)
       crava_result->SetBgBlockedLogs(common_data->GetBgBlockedLogs());
 
+    // Grids freed while combining and writing results are not reused, so
+    // they go back to the system instead of staying in the pool.
+    GridMemoryPool::SetMaxCachedBytes(0.0);
+
     if (modelSettings->getEstimationMode() == true) {
       LogKit::WriteHeader("Combine Results and Write to Files");
       if (modelSettings->getEstimateBackground() == true && n_intervals == 1 && ((modelSettings->getOutputGridFormat() & IO::CRAVA) > 0)) {
@@ -377,13 +417,16 @@ int main(int argc, char** argv)
     else {
       //Combine interval grids to one grid per parameter
       LogKit::WriteHeader("Combine Results and Write to Files");
-      crava_result->CombineResults(modelSettings,
-                                   common_data,
-                                   seismicParametersIntervals);
+      {
+        Profiler::Region region("Combine and write results");
+        crava_result->CombineResults(modelSettings,
+                                     common_data,
+                                     seismicParametersIntervals);
 
-      crava_result->WriteResults(modelSettings,
-                                 common_data,
-                                 seismicParametersIntervals[0]);
+        crava_result->WriteResults(modelSettings,
+                                   common_data,
+                                   seismicParametersIntervals[0]);
+      }
 
       if(modelSettings->getDo4DInversion())
       {
@@ -392,6 +435,7 @@ int main(int argc, char** argv)
         if(modelSettings->getDo4DRockPhysicsInversion())
         {
           LogKit::WriteHeader("4D Rock Physics Inversion");
+          Profiler::Region region("4D rock physics inversion");
           failed = modelGeneral->Do4DRockPhysicsInversion(modelSettings);
 
           if(failed)
@@ -409,6 +453,7 @@ int main(int argc, char** argv)
 
     Timings::setTimeTotal(wall,cpu);
     Timings::reportAll(LogKit::Medium);
+    Profiler::WriteJson(IO::makeFullFileName("", IO::FileProfile()+IO::SuffixJson()));
 
     TaskList::viewAllTasks(modelSettings->getTaskFileFlag());
 
@@ -421,6 +466,7 @@ int main(int argc, char** argv)
     modelSettings           = NULL;
     delete inputFiles;
     inputFiles              = NULL;
+    GridMemoryPool::Clear();
 
     Timings::reportTotal();
     LogKit::LogFormatted(LogKit::Low,"\n*** CRAVA closing  ***\n");
@@ -106,7 +106,7 @@ BetaDistributionWithTrend::BetaDistributionWithTrend(const NRLib::Trend * mean,
 }
 
 BetaDistributionWithTrend::BetaDistributionWithTrend(const BetaDistributionWithTrend & dist)
-: DistributionWithTrend(dist.share_level_,dist.current_u_,dist.resample_),
+: DistributionWithTrend(dist.share_level_,dist.sample_state_.current_u,dist.sample_state_.resample),
   use_trend_cube_(dist.use_trend_cube_),
   ni_(dist.ni_),
   nj_(dist.nj_),
@@ -159,11 +159,12 @@ BetaDistributionWithTrend::GetQuantileValue(double u, double s1, double s2)
 
   double y;
 
-  if(share_level_ > None && resample_ == false)
-    u = current_u_;
+  SampleState & state = GetSampleState();
+  if(share_level_ > None && state.resample == false)
+    u = state.current_u;
   else {
-    current_u_ = u;
-    resample_ = false;
+    state.current_u = u;
+    state.resample = false;
   }
 
   if(ni_ == 1 && nj_ == 1)
@@ -30,7 +30,7 @@ class BetaDistributionWithTrend : public DistributionWithTrend {
 
    //Triggers resampling for share_level_ <= level_. Not necessary for share_level_ = 0/None
    virtual void                       TriggerNewSample(int level)             {if(share_level_<=level)
-                                                                                 resample_ = true; }
+                                                                                 GetSampleState().resample = true; }
 
    virtual double                     ReSample(double s1, double s2);
    virtual double                     GetQuantileValue(double u, double s1, double s2);
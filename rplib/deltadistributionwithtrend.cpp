@@ -31,7 +31,7 @@ DeltaDistributionWithTrend::DeltaDistributionWithTrend(const NRLib::Trend * mean
 }
 
 DeltaDistributionWithTrend::DeltaDistributionWithTrend(const DeltaDistributionWithTrend & dist)
-  : DistributionWithTrend(dist.share_level_,dist.current_u_,dist.resample_),
+  : DistributionWithTrend(dist.share_level_,dist.sample_state_.current_u,dist.sample_state_.resample),
   use_trend_cube_(dist.use_trend_cube_)
 {
   dirac_ = dist.dirac_->Clone();
@@ -7,7 +7,12 @@
 #include <numeric>
 #include <cmath>
 
-static DEM* global_dem;
+// The DEM being integrated by Ode45. Rock samples are drawn on several
+// threads, so each thread has its own.
+static DEM* global_dem = NULL;
+#ifdef PARALLEL
+#pragma omp threadprivate(global_dem)
+#endif
 
 static std::vector<double> WrapperGEQDEMYPrime(std::vector<double>&       y,
                                                double                     t) {
@@ -28,8 +33,6 @@ DEM::DEM(const std::vector<double>&       bulk_modulus,
   aspect_ratio_(aspect_ratio),
   concentration_(concentration) {
 
-  global_dem = this;
-
 }
 
 DEM::~DEM() {
@@ -82,6 +85,7 @@ DEM::CalcEffectiveModulus(double&                    effective_bulk_modulus,
     y0[0] = bulk_modulus_bg_;
     y0[1] = shear_modulus_bg_;
 
+    global_dem = this;
     OrdDiffEqSolver::
     Ode45(&WrapperGEQDEMYPrime,
           0.0,
@@ -69,8 +69,8 @@ DEMTools::CalcCo2Prop(double& bulk_modulus,
   std::vector<double> t(ttmp, ttmp + nt);
   std::vector<double> pmpa(pmpatmp, pmpatmp + np);
 
-  static std::vector< std::vector<double> > co2_bulk(np, std::vector<double>(nt, 0.0));
-  static std::vector< std::vector<double> > co2_density(np, std::vector<double>(nt, 0.0));
+  std::vector< std::vector<double> > co2_bulk(np, std::vector<double>(nt, 0.0));
+  std::vector< std::vector<double> > co2_density(np, std::vector<double>(nt, 0.0));
 
   { // local scope co2 density
     double tmp0[] = {1.8600000e-003,  1.8000000e-003,  1.7400000e-003,  1.6800000e-003,  1.6300000e-003,  1.5800000e-003,  1.5400000e-003,  1.4900000e-003,  1.4500000e-003,  1.4100000e-003,  1.3800000e-003,  1.3400000e-003};
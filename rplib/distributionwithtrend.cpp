@@ -1,25 +1,33 @@
 #include "rplib/distributionwithtrend.h"
 
+#include <cstddef>
+
+namespace {
+  DistributionWithTrend::SampleStates * thread_sample_states = NULL; // Set by SetThreadSampleStates
+#ifdef PARALLEL
+#pragma omp threadprivate(thread_sample_states)
+#endif
+}
 
 DistributionWithTrend::DistributionWithTrend()
-: share_level_(None),
-  current_u_(0),  //Ok since resample is true.
-  resample_(true)
+: share_level_(None)
 {
+  sample_state_.current_u = 0;  //Ok since resample is true.
+  sample_state_.resample  = true;
 }
 
 DistributionWithTrend::DistributionWithTrend(const int shareLevel,bool reSample)
-: share_level_(shareLevel),
-  current_u_(0),  //Shaky, should not be used with reSample = false, use the one below.
-  resample_(reSample)
+: share_level_(shareLevel)
 {
+  sample_state_.current_u = 0;  //Shaky, should not be used with reSample = false, use the one below.
+  sample_state_.resample  = reSample;
 }
 
 DistributionWithTrend::DistributionWithTrend(const int shareLevel,double currentU,bool reSample)
-: share_level_(shareLevel),
-  current_u_(currentU),
-  resample_(reSample)
+: share_level_(shareLevel)
 {
+  sample_state_.current_u = currentU;
+  sample_state_.resample  = reSample;
 }
 
 
@@ -45,6 +53,25 @@ double
 DistributionWithTrend::GetCurrentSample(const std::vector<double> & trend_params)
 {
   double samples;
-  samples=GetQuantileValue(current_u_, trend_params[0], trend_params[1]);
+  samples=GetQuantileValue(GetSampleState().current_u, trend_params[0], trend_params[1]);
   return samples;
 }
+
+void
+DistributionWithTrend::SetThreadSampleStates(SampleStates * states)
+{
+  thread_sample_states = states;
+}
+
+DistributionWithTrend::SampleState &
+DistributionWithTrend::GetSampleState()
+{
+  if(thread_sample_states == NULL)
+    return sample_state_;
+
+  // A distribution not sampled by this thread yet starts from its own state.
+  SampleStates::iterator it = thread_sample_states->find(this);
+  if(it == thread_sample_states->end())
+    it = thread_sample_states->insert(std::make_pair(this, sample_state_)).first;
+  return it->second;
+}
@@ -2,9 +2,16 @@
 #define RPLIB_DISTRIBUTIONWITHTREND_H
 
 #include <vector>
+#include <map>
 
 class DistributionWithTrend {
  public:
+   struct SampleState {
+     double current_u;                                    // Quantile of current sample.
+     bool   resample;                                     // If false, and share_level_ > 0, reuse current_u
+   };
+   typedef std::map<const DistributionWithTrend *, SampleState> SampleStates;
+
    DistributionWithTrend();
    DistributionWithTrend(const int shareLevel,bool reSample);
    DistributionWithTrend(const int shareLevel,double currentU,bool reSample);
@@ -20,7 +27,7 @@ class DistributionWithTrend {
 
    //Triggers resampling for share_level_ <= level_. Not necessary for share_level_ = 0/None
    void                       TriggerNewSample(int level)             {if(share_level_<=level)
-                                                                                 resample_ = true; }
+                                                                                 GetSampleState().resample = true; }
 
    virtual double                     ReSample(double s1, double s2)                            = 0;
    virtual double                     GetQuantileValue(double u, double s1, double s2)          = 0;
@@ -33,11 +40,17 @@ class DistributionWithTrend {
                                                        int                 dim,
                                                        int                 reference);
 
+   // Keeps the sample state of all distributions in states while the calling
+   // thread samples, so that threads can sample from the same distributions.
+   // NULL makes the thread use the state of the distributions again.
+   static void                        SetThreadSampleStates(SampleStates * states);
+
    enum                               ShareLevel {None, SingleSample, Full}; //Note: New levels should be inserted between SingleSample and Full.
 protected:
+  SampleState                       & GetSampleState();  // State of the calling thread, see SetThreadSampleStates.
+
   const int                           share_level_;      // Use like in DistributionWithTrendStorage to know if we have a reservoir variable.
-  double                              current_u_;        // Quantile of current sample.
-  bool                                resample_;         // If false, and share_level_ > 0, reuse current_u_
+  SampleState                         sample_state_;
 
 };
 #endif
@@ -26,14 +26,14 @@ Ode45(std::vector<double>                 (*func_ptr)(std::vector<double>&, doub
 
 
   // constant matrices initialization
-  static std::vector<double> alpha(5);
+  std::vector<double> alpha(5);
   alpha[0] = 1.0/4.0;
   alpha[1] = 3.0/8.0;
   alpha[2] = 12.0/13.0;
   alpha[3] = 1.0;
   alpha[4] = 1.0/2.0;
 
-  static std::vector< std::vector<double> > beta(5);
+  std::vector< std::vector<double> > beta(5);
 
   beta[0].resize(6, 0.0);
   beta[0][0] = 1.0/4.0;
@@ -60,7 +60,7 @@ Ode45(std::vector<double>                 (*func_ptr)(std::vector<double>&, doub
   beta[4][3] = 9295.0/20520.0;
   beta[4][4] = -5643.0/20520.0;
 
-  static std::vector< std::vector<double> > gamma(2);
+  std::vector< std::vector<double> > gamma(2);
 
   gamma[0].resize(6, 0.0);
   gamma[0][0] = 902880.0/7618050.0;
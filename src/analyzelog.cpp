@@ -6,6 +6,7 @@
 #include <time.h>
 #include <iostream>
 #include <fstream>
+#include <complex>
 #include "nrlib/iotools/logkit.hpp"
 #include "src/definitions.h"
 #include "src/analyzelog.h"
@@ -15,6 +16,7 @@
 #include "src/blockedlogscommon.h"
 #include "src/simbox.h"
 #include "src/io.h"
+#include "lib/utils.h"
 
 Analyzelog::Analyzelog(const std::vector<NRLib::Well *>                        & wells,
                        const std::map<std::string, BlockedLogsCommon *>        & mapped_blocked_logs,
@@ -563,177 +565,74 @@ void Analyzelog::EstimateAutoCovarianceFunction(std::vector<NRLib::Matrix >
   // matrices for each time lag, i.e. cov(h)(vp, vs) != cov(h)(vs, vp)
   // but cov(h)(vp,vs) = cov(-h)(vs,vp) and cov(h)(vs,vp) = cov(-h)(vp,vs)
   //
-  for (size_t i = 0; i < well_names.size(); i++){
-    time_t timestart, timeend;
-    time(&timestart);
+  // The wells are processed in parallel, each into its own sums, which are
+  // added in well order afterwards.
+  //
+  int n_wells = static_cast<int>(well_names.size());
+  std::vector<std::vector<NRLib::Matrix> > well_auto_cov(n_wells);
+  std::vector<std::vector<NRLib::Matrix> > well_count(n_wells);
+  std::vector<int>                         well_max_lag(n_wells, 0);
+
+#ifdef PARALLEL
+#pragma omp parallel for schedule(dynamic, 1)
+#endif
+  for (int i = 0; i < n_wells; i++){
+    const BlockedLogsCommon   * blocked_log = mapped_blocked_logs.find(well_names[i])->second;
+    const std::vector<double> & x_pos       = blocked_log->GetXposBlocked();
+    const std::vector<double> & y_pos       = blocked_log->GetYposBlocked();
+    const std::vector<double> & z_pos       = blocked_log->GetZposBlocked();
+    const std::vector<double> & log_vp      = log_data_vp.find(well_names[i])->second;
+    const std::vector<double> & log_vs      = log_data_vs.find(well_names[i])->second;
+    const std::vector<double> & log_rho     = log_data_rho.find(well_names[i])->second;
+    bool use_regression = !all_Vs_logs_synthetic && blocked_log->HasSyntheticVsLog() == true;
+    bool use_vs         = blocked_log->HasSyntheticVsLog() == false;
+
+    well_auto_cov[i].resize(max_nd);
+    well_count[i].resize(max_nd);
+    for (int lag = 0; lag < max_nd; lag++){
+      well_auto_cov[i][lag].resize(3, 3);
+      well_count[i][lag].resize(3, 3);
+      for (int j = 0; j < 3; j++){
+        for (int k = 0; k < 3; k++){
+          well_auto_cov[i][lag](j,k) = 0.0;
+          well_count[i][lag](j,k)    = 0;
+        }
+      }
+    }
+
     for (size_t j = 0; j < interval_simboxes.size(); j++){
       std::string interval_name = interval_simboxes[j]->GetIntervalName();
-      size_t nd = mapped_blocked_logs.find(well_names[i])->second->GetNBlocksWithData(interval_name);
-      const std::vector<double> & x_pos = mapped_blocked_logs.find(well_names[i])->second->GetXposBlocked();
-      const std::vector<double> & y_pos = mapped_blocked_logs.find(well_names[i])->second->GetYposBlocked();
-      const std::vector<double> & z_pos = mapped_blocked_logs.find(well_names[i])->second->GetZposBlocked();
-      std::vector<double> z(nd);
-      const std::vector<double> log_vp   = log_data_vp.find(well_names[i])->second;
-      const std::vector<double> log_vs   = log_data_vs.find(well_names[i])->second;
-      const std::vector<double> log_rho  = log_data_rho.find(well_names[i])->second;
+      size_t nd = blocked_log->GetNBlocksWithData(interval_name);
+      std::vector<double> z_rel(nd, 0.0);
+      for (size_t k = 0; k < nd; k++){
+        if(log_vp[k] != RMISSING || log_vs[k] != RMISSING || log_rho[k] != RMISSING){
+          double xk = x_pos[k];
+          double yk = y_pos[k];
+          z_rel[k] = (z_pos[k] - interval_simboxes[j]->getTop(xk, yk))/interval_simboxes[j]->getRelThick(xk, yk);
+        }
+      }
       //
       // 2.2.1 Add autocovariance data
       //
-      int lag = 0;
+      bool regular = AddAutoCovarianceFFT(well_auto_cov[i], well_count[i], well_max_lag[i], log_vp, log_vs, log_rho, z_rel,
+                                          use_regression, use_vs, regression_coef, residual_variance_vs, min_dz);
+      if (!regular)
+        AddAutoCovarianceDirect(well_auto_cov[i], well_count[i], well_max_lag[i], log_vp, log_vs, log_rho, z_rel,
+                                use_regression, use_vs, regression_coef, residual_variance_vs, min_dz);
+    }
+  }
 
-      for (size_t k = 0; k < nd; k++){
-        for (size_t l = k; l < nd; l++){
-
-          if(log_vp[k] != RMISSING || log_vs[k] != RMISSING || log_rho[k] != RMISSING){
-            if (log_vp[l] != RMISSING || log_vs[l] != RMISSING || log_rho[l] != RMISSING) {
-              double xk = x_pos[k];
-              double yk = y_pos[k];
-              double xl = x_pos[l];
-              double yl = y_pos[l];
-              double z_k_rel = (z_pos[k] - interval_simboxes[j]->getTop(xk, yk))/interval_simboxes[j]->getRelThick(xk, yk);
-              double z_l_rel = (z_pos[l] - interval_simboxes[j]->getTop(xl, yl))/interval_simboxes[j]->getRelThick(xl, yl);
-              lag = static_cast<int>(std::floor(std::abs(z_k_rel - z_l_rel)/min_dz + 0.5));
-
-              // cov(vp_k, vp_l)
-              if(log_vp[k] != RMISSING && log_vp[l] != RMISSING){
-                if (lag > max_lag_with_data)
-                  max_lag_with_data = lag;
-                temp_auto_cov[lag](0,0) += log_vp[k]*log_vp[l];
-                count[lag](0,0) += 1;
-              }
-              // cov(rho_k, rho_l)
-              if(log_rho[k] != RMISSING && log_rho[l] != RMISSING){
-                if (lag > max_lag_with_data)
-                  max_lag_with_data = lag;
-                temp_auto_cov[lag](2,2) += log_rho[k]*log_rho[l];
-                count[lag](2,2) += 1;
-              }
-              // cov(vp_k, rho_l)
-              if(log_vp[k] != RMISSING && log_rho[l] != RMISSING){
-                temp_auto_cov[lag](0,2) += log_vp[k]*log_rho[l];
-                count[lag](0,2) += 1;
-                if (lag == 0){ // In lag 0, the autocov matrix is symmetric
-                  temp_auto_cov[lag](2,0) += log_vp[k]*log_rho[l];
-                  count[lag](2,0)         += 1;
-                }
-              }
-              // cov(rho_k, vp_l)
-              if(log_rho[k] != RMISSING && log_vp[l] != RMISSING){
-                temp_auto_cov[lag](2,0) += log_rho[k]*log_vp[l];
-                count[lag](2,0) += 1;
-                if (lag == 0){ // In lag 0, the autocov matrix is symmetric
-                  temp_auto_cov[lag](0,2) += log_rho[k]*log_vp[l];
-                  count[lag](0,2)         += 1;
-                }
-              }
-              //
-              // If this Vs log is synthetic and there exist real Vs logs: use regression coefficients
-              //
-              if(!all_Vs_logs_synthetic && mapped_blocked_logs.find(well_names[i])->second->HasSyntheticVsLog() == true){
-                // Use the relation Vs = a*Vp + b*Rho + e, where e is iid
-                // cov[t](vs_i, vs_j) = cov[t](a*vp_k + b*rho_k + e_k, a*vp_l + b*rho_l + e_l) = a*a*cov(vp_k,vp_l) + a*b*cov(vp_k, rho_l) + a*b*cov(vp_l, rho_k) + b*b*cov(rho_k, rho_l) + I(k = l) var(e)
-                if(log_vp[k] != RMISSING && log_rho[k] != RMISSING && log_rho[l] != RMISSING && log_vp[l] != RMISSING){
-                  double vs_k = regression_coef(0)*log_vp[k] + regression_coef(1)*log_rho[k];
-                  double vs_l = regression_coef(0)*log_vp[l] + regression_coef(1)*log_rho[l];
-
-                  temp_auto_cov[lag](1,1) += vs_k*vs_l + residual_variance_vs[lag];
-                  //if (k == l)
-                  //  temp_auto_cov[lag](1,1) += var_vs_resid;
-                  count[lag](1,1) += 1;
-                }
-                // cov[l-k](vp, vs) = cov[l-k](vp_k, a*vp_l + b*rho_l + e_l) = a*autocov[l-k](vp_k, vp_l) + b*autocov[l-k](vp_k, rho_l)
-                if (log_vp[k] != RMISSING && log_vp[l] != RMISSING && log_rho[l] != RMISSING){
-                  temp_auto_cov[lag](0,1) += regression_coef(0)*log_vp[k]*log_vp[l] + regression_coef(1)*log_vp[k]*log_rho[l];
-                  count[lag](0,1)         += 1;
-                  if (lag == 0){ // In lag 0, the autocov matrix is symmetric
-                    temp_auto_cov[lag](1,0) += regression_coef(0)*log_vp[k]*log_vp[l] + regression_coef(1)*log_vp[k]*log_rho[l];
-                    count[lag](1,0)         += 1;
-                  }
-                }
-                // cov[l-k](vs, vp) = a*cov[l-k](vp_k, vp_l) + b*cov[l-k](rho_k, vp_l)
-                if (log_vp[k] != RMISSING && log_rho[k] != RMISSING && log_vp[l] != RMISSING){
-                  temp_auto_cov[lag](1,0) += regression_coef(0)*log_vp[k]*log_vp[l] + regression_coef(1)*log_rho[k]*log_vp[l];
-                  count[lag](1,0)         += 1;
-                  if (lag == 0){ // In lag 0, the autocov matrix is symmetric
-                    temp_auto_cov[lag](0,1) += regression_coef(0)*log_vp[k]*log_vp[l] + regression_coef(1)*log_rho[k]*log_vp[l];
-                    count[lag](0,1)         += 1;
-                  }
-                }
-                // cov[l-k](rho_k, vs_l) = cov[l-k](rho_k, a*vp_l + b*rho_l + e_l) = a*cov[l-k](rho_k,vp_l) + b*cov[l-k](rho_k, rho_l)
-                if (log_rho[k] != RMISSING && log_vp[l] != RMISSING && log_rho[l] != RMISSING){
-                  temp_auto_cov[lag](1,2) += regression_coef(0)*log_rho[k]*log_vp[l] + regression_coef(1)*log_rho[k]*log_rho[l];
-                  count[lag](1,2)         += 1;
-                  if (lag == 0){ // In lag 0, the autocov matrix is symmetric
-                    temp_auto_cov[lag](2,1) += regression_coef(0)*log_rho[k]*log_vp[l] + regression_coef(1)*log_rho[k]*log_rho[l];
-                    count[lag](2,1)         += 1;
-                  }
-                }
-                // cov[l-k](vs_k, rho_l) = a*cov[l-k](vp_k, rho_l) + b*cov[l-k](rho_k, rho_l)
-                if (log_rho[k] != RMISSING && log_vp[k] != RMISSING && log_rho[l] != RMISSING){
-                  temp_auto_cov[lag](2,1) += regression_coef(0)*log_vp[k]*log_rho[l] + regression_coef(1)*log_rho[k]*log_rho[l];
-                  count[lag](2,1)         += 1;
-                  if (lag == 0){ // In lag 0, the autocov matrix is symmetric
-                    temp_auto_cov[lag](1,2) += regression_coef(0)*log_vp[k]*log_rho[l] + regression_coef(1)*log_rho[k]*log_rho[l];
-                    count[lag](1,2)         += 1;
-                  }
-                }
-              }
-              //
-              // Non-synthetic Vs log
-              //
-              else if(mapped_blocked_logs.find(well_names[i])->second->HasSyntheticVsLog() == false){
-                // cov[t](vs, vs)
-                if(log_vs[k] != RMISSING && log_vs[l] != RMISSING){
-                  if (lag > max_lag_with_data)
-                    max_lag_with_data = lag;
-                  temp_auto_cov[lag](1,1) += log_vs[k]*log_vs[l];
-                  count[lag](1,1)         += 1;
-                }
-                // cov[t](vp, vs)
-                if(log_vp[k] != RMISSING && log_vs[l] != RMISSING){
-                  temp_auto_cov[lag](0,1) += log_vp[k]*log_vs[l];
-                  count[lag](0,1)         += 1;
-                  if (lag == 0){ // In lag 0, the autocov matrix is symmetric
-                    temp_auto_cov[lag](1,0) += log_vp[k]*log_vs[l];
-                    count[lag](1,0)         += 1;
-                  }
-                }
-                // cov[t](vs, vp)
-                if(log_vs[k] != RMISSING && log_vp[l] != RMISSING){
-                  temp_auto_cov[lag](1,0) += log_vs[k]*log_vp[l];
-                  count[lag](1,0)         += 1;
-                  if (lag == 0){ // In lag 0, the autocov matrix is symmetric
-                    temp_auto_cov[lag](0,1) += log_vs[k]*log_vp[l];
-                    count[lag](0,1)         += 1;
-                  }
-                }
-                // cov[t](vs, rho)
-                if(log_vs[k] != RMISSING && log_rho[l] != RMISSING){
-                  temp_auto_cov[lag](1,2) += log_vs[k]*log_rho[l];
-                  count[lag](1,2)         += 1;
-                  if (lag == 0){ // In lag 0, the autocov matrix is symmetric
-                    temp_auto_cov[lag](2,1) += log_vs[k]*log_rho[l];
-                    count[lag](2,1)         += 1;
-                  }
-                }
-                // cov[t](rho, vs)
-                if(log_rho[k] != RMISSING && log_vs[l] != RMISSING){
-                  temp_auto_cov[lag](2,1) += log_rho[k]*log_vs[l];
-                  count[lag](2,1)         += 1;
-                  if (lag == 0){ // In lag 0, the autocov matrix is symmetric
-                    temp_auto_cov[lag](1,2) += log_rho[k]*log_vs[l];
-                    count[lag](1,2)         += 1;
-                  }
-                }
-              }
-            }
-          }
+  for (int i = 0; i < n_wells; i++){
+    for (int lag = 0; lag < max_nd; lag++){
+      for (int j = 0; j < 3; j++){
+        for (int k = 0; k < 3; k++){
+          temp_auto_cov[lag](j,k) += well_auto_cov[i][lag](j,k);
+          count[lag](j,k)         += well_count[i][lag](j,k);
         }
       }
     }
-    time(&timeend);
-    //long int time = static_cast<long int>(timeend - timestart);
-    //printf("\nWell %s processed in %ld seconds.",well_names[i].c_str(),time);
+    if (well_max_lag[i] > max_lag_with_data)
+      max_lag_with_data = well_max_lag[i];
   }
 
   //
@@ -1049,6 +948,416 @@ void Analyzelog::EstimateAutoCovarianceFunction(std::vector<NRLib::Matrix >
 
 }
 
+//
+// Adds the sums and pair counts of the blocks [0, nd) of a well log to
+// auto_cov and count, finding the lag of each pair of blocks from the
+// relative positions z_rel.
+//
+void Analyzelog::AddAutoCovarianceDirect(std::vector<NRLib::Matrix> & auto_cov,
+                                         std::vector<NRLib::Matrix> & count,
+                                         int                        & max_lag_with_data,
+                                         const std::vector<double>  & log_vp,
+                                         const std::vector<double>  & log_vs,
+                                         const std::vector<double>  & log_rho,
+                                         const std::vector<double>  & z_rel,
+                                         bool                         use_regression,
+                                         bool                         use_vs,
+                                         const NRLib::Vector        & regression_coef,
+                                         const std::vector<double>  & residual_variance_vs,
+                                         float                        min_dz)
+{
+  size_t nd  = z_rel.size();
+  int    lag = 0;
+
+  for (size_t k = 0; k < nd; k++){
+    for (size_t l = k; l < nd; l++){
+
+      if(log_vp[k] != RMISSING || log_vs[k] != RMISSING || log_rho[k] != RMISSING){
+        if (log_vp[l] != RMISSING || log_vs[l] != RMISSING || log_rho[l] != RMISSING) {
+          lag = static_cast<int>(std::floor(std::abs(z_rel[k] - z_rel[l])/min_dz + 0.5));
+
+          // cov(vp_k, vp_l)
+          if(log_vp[k] != RMISSING && log_vp[l] != RMISSING){
+            if (lag > max_lag_with_data)
+              max_lag_with_data = lag;
+            auto_cov[lag](0,0) += log_vp[k]*log_vp[l];
+            count[lag](0,0) += 1;
+          }
+          // cov(rho_k, rho_l)
+          if(log_rho[k] != RMISSING && log_rho[l] != RMISSING){
+            if (lag > max_lag_with_data)
+              max_lag_with_data = lag;
+            auto_cov[lag](2,2) += log_rho[k]*log_rho[l];
+            count[lag](2,2) += 1;
+          }
+          // cov(vp_k, rho_l)
+          if(log_vp[k] != RMISSING && log_rho[l] != RMISSING){
+            auto_cov[lag](0,2) += log_vp[k]*log_rho[l];
+            count[lag](0,2) += 1;
+            if (lag == 0){ // In lag 0, the autocov matrix is symmetric
+              auto_cov[lag](2,0) += log_vp[k]*log_rho[l];
+              count[lag](2,0)         += 1;
+            }
+          }
+          // cov(rho_k, vp_l)
+          if(log_rho[k] != RMISSING && log_vp[l] != RMISSING){
+            auto_cov[lag](2,0) += log_rho[k]*log_vp[l];
+            count[lag](2,0) += 1;
+            if (lag == 0){ // In lag 0, the autocov matrix is symmetric
+              auto_cov[lag](0,2) += log_rho[k]*log_vp[l];
+              count[lag](0,2)         += 1;
+            }
+          }
+          //
+          // If this Vs log is synthetic and there exist real Vs logs: use regression coefficients
+          //
+          if(use_regression){
+            // Use the relation Vs = a*Vp + b*Rho + e, where e is iid
+            // cov[t](vs_i, vs_j) = cov[t](a*vp_k + b*rho_k + e_k, a*vp_l + b*rho_l + e_l) = a*a*cov(vp_k,vp_l) + a*b*cov(vp_k, rho_l) + a*b*cov(vp_l, rho_k) + b*b*cov(rho_k, rho_l) + I(k = l) var(e)
+            if(log_vp[k] != RMISSING && log_rho[k] != RMISSING && log_rho[l] != RMISSING && log_vp[l] != RMISSING){
+              double vs_k = regression_coef(0)*log_vp[k] + regression_coef(1)*log_rho[k];
+              double vs_l = regression_coef(0)*log_vp[l] + regression_coef(1)*log_rho[l];
+
+              auto_cov[lag](1,1) += vs_k*vs_l + residual_variance_vs[lag];
+              //if (k == l)
+              //  auto_cov[lag](1,1) += var_vs_resid;
+              count[lag](1,1) += 1;
+            }
+            // cov[l-k](vp, vs) = cov[l-k](vp_k, a*vp_l + b*rho_l + e_l) = a*autocov[l-k](vp_k, vp_l) + b*autocov[l-k](vp_k, rho_l)
+            if (log_vp[k] != RMISSING && log_vp[l] != RMISSING && log_rho[l] != RMISSING){
+              auto_cov[lag](0,1) += regression_coef(0)*log_vp[k]*log_vp[l] + regression_coef(1)*log_vp[k]*log_rho[l];
+              count[lag](0,1)         += 1;
+              if (lag == 0){ // In lag 0, the autocov matrix is symmetric
+                auto_cov[lag](1,0) += regression_coef(0)*log_vp[k]*log_vp[l] + regression_coef(1)*log_vp[k]*log_rho[l];
+                count[lag](1,0)         += 1;
+              }
+            }
+            // cov[l-k](vs, vp) = a*cov[l-k](vp_k, vp_l) + b*cov[l-k](rho_k, vp_l)
+            if (log_vp[k] != RMISSING && log_rho[k] != RMISSING && log_vp[l] != RMISSING){
+              auto_cov[lag](1,0) += regression_coef(0)*log_vp[k]*log_vp[l] + regression_coef(1)*log_rho[k]*log_vp[l];
+              count[lag](1,0)         += 1;
+              if (lag == 0){ // In lag 0, the autocov matrix is symmetric
+                auto_cov[lag](0,1) += regression_coef(0)*log_vp[k]*log_vp[l] + regression_coef(1)*log_rho[k]*log_vp[l];
+                count[lag](0,1)         += 1;
+              }
+            }
+            // cov[l-k](rho_k, vs_l) = cov[l-k](rho_k, a*vp_l + b*rho_l + e_l) = a*cov[l-k](rho_k,vp_l) + b*cov[l-k](rho_k, rho_l)
+            if (log_rho[k] != RMISSING && log_vp[l] != RMISSING && log_rho[l] != RMISSING){
+              auto_cov[lag](1,2) += regression_coef(0)*log_rho[k]*log_vp[l] + regression_coef(1)*log_rho[k]*log_rho[l];
+              count[lag](1,2)         += 1;
+              if (lag == 0){ // In lag 0, the autocov matrix is symmetric
+                auto_cov[lag](2,1) += regression_coef(0)*log_rho[k]*log_vp[l] + regression_coef(1)*log_rho[k]*log_rho[l];
+                count[lag](2,1)         += 1;
+              }
+            }
+            // cov[l-k](vs_k, rho_l) = a*cov[l-k](vp_k, rho_l) + b*cov[l-k](rho_k, rho_l)
+            if (log_rho[k] != RMISSING && log_vp[k] != RMISSING && log_rho[l] != RMISSING){
+              auto_cov[lag](2,1) += regression_coef(0)*log_vp[k]*log_rho[l] + regression_coef(1)*log_rho[k]*log_rho[l];
+              count[lag](2,1)         += 1;
+              if (lag == 0){ // In lag 0, the autocov matrix is symmetric
+                auto_cov[lag](1,2) += regression_coef(0)*log_vp[k]*log_rho[l] + regression_coef(1)*log_rho[k]*log_rho[l];
+                count[lag](1,2)         += 1;
+              }
+            }
+          }
+          //
+          // Non-synthetic Vs log
+          //
+          else if(use_vs){
+            // cov[t](vs, vs)
+            if(log_vs[k] != RMISSING && log_vs[l] != RMISSING){
+              if (lag > max_lag_with_data)
+                max_lag_with_data = lag;
+              auto_cov[lag](1,1) += log_vs[k]*log_vs[l];
+              count[lag](1,1)         += 1;
+            }
+            // cov[t](vp, vs)
+            if(log_vp[k] != RMISSING && log_vs[l] != RMISSING){
+              auto_cov[lag](0,1) += log_vp[k]*log_vs[l];
+              count[lag](0,1)         += 1;
+              if (lag == 0){ // In lag 0, the autocov matrix is symmetric
+                auto_cov[lag](1,0) += log_vp[k]*log_vs[l];
+                count[lag](1,0)         += 1;
+              }
+            }
+            // cov[t](vs, vp)
+            if(log_vs[k] != RMISSING && log_vp[l] != RMISSING){
+              auto_cov[lag](1,0) += log_vs[k]*log_vp[l];
+              count[lag](1,0)         += 1;
+              if (lag == 0){ // In lag 0, the autocov matrix is symmetric
+                auto_cov[lag](0,1) += log_vs[k]*log_vp[l];
+                count[lag](0,1)         += 1;
+              }
+            }
+            // cov[t](vs, rho)
+            if(log_vs[k] != RMISSING && log_rho[l] != RMISSING){
+              auto_cov[lag](1,2) += log_vs[k]*log_rho[l];
+              count[lag](1,2)         += 1;
+              if (lag == 0){ // In lag 0, the autocov matrix is symmetric
+                auto_cov[lag](2,1) += log_vs[k]*log_rho[l];
+                count[lag](2,1)         += 1;
+              }
+            }
+            // cov[t](rho, vs)
+            if(log_rho[k] != RMISSING && log_vs[l] != RMISSING){
+              auto_cov[lag](2,1) += log_rho[k]*log_vs[l];
+              count[lag](2,1)         += 1;
+              if (lag == 0){ // In lag 0, the autocov matrix is symmetric
+                auto_cov[lag](1,2) += log_rho[k]*log_vs[l];
+                count[lag](1,2)         += 1;
+              }
+            }
+          }
+        }
+      }
+    }
+  }
+}
+
+namespace {
+  typedef std::complex<double> Complex;
+
+  //
+  // Sets corr[h] = sum_p x[p]*y[p+h] and corr[nzp-h] = sum_p y[p]*x[p+h], where x
+  // and y are transformed logs.
+  //
+  void CrossCorrelate(const std::vector<Complex> & x,
+                      const std::vector<Complex> & y,
+                      std::vector<double>        & corr,
+                      std::vector<Complex>       & work,
+                      const std::vector<Complex> & twiddle)
+  {
+    int nzp = static_cast<int>(x.size());
+    for (int i = 0; i < nzp; i++)
+      work[i] = std::conj(x[i])*y[i];
+    Utils::fftDouble(work, twiddle, true);
+    for (int i = 0; i < nzp; i++)
+      corr[i] = work[i].real()/nzp;
+  }
+
+  //
+  // Adds the sums corr and pair counts pairs of cov(i_k, j_l) for each block offset
+  // to auto_cov(i,j) at the lag of the offset, and those of cov(j_k, i_l) to
+  // auto_cov(j,i). As in AddAutoCovarianceDirect, lag 0 is symmetric, and a log
+  // with itself counts each pair once.
+  //
+  void AddLagSums(std::vector<NRLib::Matrix>   & auto_cov,
+                  std::vector<NRLib::Matrix>   & count,
+                  int                          & max_lag_with_data,
+                  int                            i,
+                  int                            j,
+                  const std::vector<double>    & corr,
+                  const std::vector<double>    & pairs,
+                  int                            nzp,
+                  const std::vector<int>       & lag_of_offset,
+                  bool                           same_log)
+  {
+    for (size_t d = 0; d < lag_of_offset.size(); d++){
+      int lag = lag_of_offset[d];
+      if (lag < 0)
+        continue;
+      int    neg     = (nzp - static_cast<int>(d)) % nzp;
+      double n_ij    = std::floor(pairs[d] + 0.5);
+      double n_ji    = std::floor(pairs[neg] + 0.5);
+      double sum_ij  = (n_ij > 0 ? corr[d] : 0.0);
+      double sum_ji  = (n_ji > 0 ? corr[neg] : 0.0);
+
+      if (same_log){
+        if (n_ij > 0 && lag > max_lag_with_data)
+          max_lag_with_data = lag;
+        auto_cov[lag](i,i) += sum_ij;
+        count[lag](i,i)    += n_ij;
+      }
+      else{
+        auto_cov[lag](i,j) += sum_ij;
+        count[lag](i,j)    += n_ij;
+        auto_cov[lag](j,i) += sum_ji;
+        count[lag](j,i)    += n_ji;
+        if (lag == 0){ // In lag 0, the autocov matrix is symmetric
+          auto_cov[lag](i,j) += sum_ji;
+          count[lag](i,j)    += n_ji;
+          auto_cov[lag](j,i) += sum_ij;
+          count[lag](j,i)    += n_ij;
+        }
+      }
+    }
+  }
+}
+
+//
+// Adds the same sums and pair counts as AddAutoCovarianceDirect, from
+// cross-correlations of the logs computed by FFT. Missing values are set to
+// zero in the logs, and the pair counts are the cross-correlations of the
+// masks of the logs. The sums for each offset between blocks are then added
+// to the lag of that offset. The cost is O(n log n) in the log length
+// instead of O(n^2).
+//
+// This requires the blocks with data to be on a regular grid, in increasing
+// order, as they are for a well through a simbox. Otherwise, false is
+// returned and nothing is added.
+//
+bool Analyzelog::AddAutoCovarianceFFT(std::vector<NRLib::Matrix> & auto_cov,
+                                      std::vector<NRLib::Matrix> & count,
+                                      int                        & max_lag_with_data,
+                                      const std::vector<double>  & log_vp,
+                                      const std::vector<double>  & log_vs,
+                                      const std::vector<double>  & log_rho,
+                                      const std::vector<double>  & z_rel,
+                                      bool                         use_regression,
+                                      bool                         use_vs,
+                                      const NRLib::Vector        & regression_coef,
+                                      const std::vector<double>  & residual_variance_vs,
+                                      float                        min_dz)
+{
+  int nd    = static_cast<int>(z_rel.size());
+  int first = -1;
+  for (int k = 0; k < nd && first < 0; k++){
+    if(log_vp[k] != RMISSING || log_vs[k] != RMISSING || log_rho[k] != RMISSING)
+      first = k;
+  }
+  if (first < 0)
+    return true;
+
+  // Positions of the blocks with data relative to the first one, in lags.
+  std::vector<double> w(nd, 0.0);
+  for (int k = first; k < nd; k++)
+    w[k] = (z_rel[k] - z_rel[first])/min_dz;
+
+  // The positions are put on a grid of 1/n_sub lag, where n_sub is the
+  // smallest subdivision that holds all of them. Partly filled blocks at the
+  // ends of a well are typically offset by a fraction of a lag.
+  int n_sub = 0;
+  for (int m = 1; m <= 16 && n_sub == 0; m++){
+    bool on_grid = true;
+    for (int k = first; k < nd && on_grid; k++){
+      if(log_vp[k] == RMISSING && log_vs[k] == RMISSING && log_rho[k] == RMISSING)
+        continue;
+      double u = w[k]*m;
+      on_grid  = std::abs(u - std::floor(u + 0.5)) < 1.0e-3;
+    }
+    if (on_grid)
+      n_sub = m;
+  }
+  if (n_sub == 0)
+    return false;
+
+  std::vector<int> pos(nd, -1);
+  int last_pos = -1;
+  for (int k = first; k < nd; k++){
+    if(log_vp[k] == RMISSING && log_vs[k] == RMISSING && log_rho[k] == RMISSING)
+      continue;
+    pos[k] = static_cast<int>(std::floor(w[k]*n_sub + 0.5));
+    if (pos[k] <= last_pos)
+      return false;
+    last_pos = pos[k];
+  }
+
+  // Lag of each offset, found as for a pair of blocks in AddAutoCovarianceDirect.
+  // Offsets with lags beyond the autocovariance are skipped.
+  int max_nd = static_cast<int>(auto_cov.size());
+  int n_pos  = last_pos + 1;
+  std::vector<int> lag_of_offset(n_pos);
+  for (int d = 0; d < n_pos; d++){
+    int lag = (2*d + n_sub)/(2*n_sub);
+    lag_of_offset[d] = (lag < max_nd ? lag : -1);
+  }
+
+  // With this padding, offsets in both directions do not wrap around.
+  int nzp = 1;
+  while (nzp < 2*n_pos)
+    nzp *= 2;
+
+  enum { VP, VS, RHO, VS_REG, VP_MASK, VS_MASK, RHO_MASK, VS_REG_MASK, N_LOGS };
+  std::vector<std::vector<Complex> > logs(N_LOGS, std::vector<Complex>(nzp, 0.0));
+
+  for (int k = 0; k < nd; k++){
+    int p = pos[k];
+    if (p < 0)
+      continue;
+    if(log_vp[k] != RMISSING){
+      logs[VP][p]      = log_vp[k];
+      logs[VP_MASK][p] = 1.0;
+    }
+    if(use_vs && log_vs[k] != RMISSING){
+      logs[VS][p]      = log_vs[k];
+      logs[VS_MASK][p] = 1.0;
+    }
+    if(log_rho[k] != RMISSING){
+      logs[RHO][p]      = log_rho[k];
+      logs[RHO_MASK][p] = 1.0;
+    }
+    // Vs = a*Vp + b*Rho + e, where e is iid
+    if(use_regression && log_vp[k] != RMISSING && log_rho[k] != RMISSING){
+      logs[VS_REG][p]      = regression_coef(0)*log_vp[k] + regression_coef(1)*log_rho[k];
+      logs[VS_REG_MASK][p] = 1.0;
+    }
+  }
+
+  // Double precision, as the single precision FFTW is too coarse for the
+  // sums to match those of the direct estimator.
+  std::vector<Complex> twiddle;
+  Utils::makeTwiddles(twiddle, nzp);
+
+  for (int s = 0; s < N_LOGS; s++)
+    Utils::fftDouble(logs[s], twiddle, false);
+
+  std::vector<double>  corr(nzp);
+  std::vector<double>  pairs(nzp);
+  std::vector<Complex> work(nzp);
+
+  // cov(vp_k, vp_l) and cov(rho_k, rho_l)
+  CrossCorrelate(logs[VP], logs[VP], corr, work, twiddle);
+  CrossCorrelate(logs[VP_MASK], logs[VP_MASK], pairs, work, twiddle);
+  AddLagSums(auto_cov, count, max_lag_with_data, 0, 0, corr, pairs, nzp, lag_of_offset, true);
+
+  CrossCorrelate(logs[RHO], logs[RHO], corr, work, twiddle);
+  CrossCorrelate(logs[RHO_MASK], logs[RHO_MASK], pairs, work, twiddle);
+  AddLagSums(auto_cov, count, max_lag_with_data, 2, 2, corr, pairs, nzp, lag_of_offset, true);
+
+  // cov(vp_k, rho_l) and cov(rho_k, vp_l)
+  CrossCorrelate(logs[VP], logs[RHO], corr, work, twiddle);
+  CrossCorrelate(logs[VP_MASK], logs[RHO_MASK], pairs, work, twiddle);
+  AddLagSums(auto_cov, count, max_lag_with_data, 0, 2, corr, pairs, nzp, lag_of_offset, false);
+
+  if (use_regression){
+    // cov[t](vs_k, vs_l) = a*a*cov(vp_k,vp_l) + a*b*cov(vp_k, rho_l) + a*b*cov(vp_l, rho_k) + b*b*cov(rho_k, rho_l) + var(e)
+    CrossCorrelate(logs[VS_REG], logs[VS_REG], corr, work, twiddle);
+    CrossCorrelate(logs[VS_REG_MASK], logs[VS_REG_MASK], pairs, work, twiddle);
+    for (int d = 0; d < n_pos; d++){
+      int    lag = lag_of_offset[d];
+      double n   = std::floor(pairs[d] + 0.5);
+      if (lag >= 0 && n > 0){
+        auto_cov[lag](1,1) += corr[d] + n*residual_variance_vs[lag];
+        count[lag](1,1)    += n;
+      }
+    }
+    // cov[l-k](vp_k, vs_l) and cov[l-k](vs_k, vp_l)
+    CrossCorrelate(logs[VP], logs[VS_REG], corr, work, twiddle);
+    CrossCorrelate(logs[VP_MASK], logs[VS_REG_MASK], pairs, work, twiddle);
+    AddLagSums(auto_cov, count, max_lag_with_data, 0, 1, corr, pairs, nzp, lag_of_offset, false);
+    // cov[l-k](rho_k, vs_l) and cov[l-k](vs_k, rho_l)
+    CrossCorrelate(logs[RHO], logs[VS_REG], corr, work, twiddle);
+    CrossCorrelate(logs[RHO_MASK], logs[VS_REG_MASK], pairs, work, twiddle);
+    AddLagSums(auto_cov, count, max_lag_with_data, 1, 2, corr, pairs, nzp, lag_of_offset, false);
+  }
+  else if (use_vs){
+    // cov[t](vs, vs)
+    CrossCorrelate(logs[VS], logs[VS], corr, work, twiddle);
+    CrossCorrelate(logs[VS_MASK], logs[VS_MASK], pairs, work, twiddle);
+    AddLagSums(auto_cov, count, max_lag_with_data, 1, 1, corr, pairs, nzp, lag_of_offset, true);
+    // cov[t](vp, vs) and cov[t](vs, vp)
+    CrossCorrelate(logs[VP], logs[VS], corr, work, twiddle);
+    CrossCorrelate(logs[VP_MASK], logs[VS_MASK], pairs, work, twiddle);
+    AddLagSums(auto_cov, count, max_lag_with_data, 0, 1, corr, pairs, nzp, lag_of_offset, false);
+    // cov[t](rho, vs) and cov[t](vs, rho)
+    CrossCorrelate(logs[RHO], logs[VS], corr, work, twiddle);
+    CrossCorrelate(logs[RHO_MASK], logs[VS_MASK], pairs, work, twiddle);
+    AddLagSums(auto_cov, count, max_lag_with_data, 2, 1, corr, pairs, nzp, lag_of_offset, false);
+  }
+
+  return true;
+}
+
 void  Analyzelog::SetParameterCov(const NRLib::Matrix                           & auto_cov,
                                   NRLib::Matrix                                 & var_0,
                                   int                                             n_params){
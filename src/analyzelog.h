@@ -109,6 +109,32 @@ private:
                                                  int                                                & max_lag_with_data,
                                                  std::string                                        & err_text);
 
+  void            AddAutoCovarianceDirect(std::vector<NRLib::Matrix> & auto_cov,
+                                          std::vector<NRLib::Matrix> & count,
+                                          int                        & max_lag_with_data,
+                                          const std::vector<double>  & log_vp,
+                                          const std::vector<double>  & log_vs,
+                                          const std::vector<double>  & log_rho,
+                                          const std::vector<double>  & z_rel,
+                                          bool                         use_regression,
+                                          bool                         use_vs,
+                                          const NRLib::Vector        & regression_coef,
+                                          const std::vector<double>  & residual_variance_vs,
+                                          float                        min_dz);
+
+  bool            AddAutoCovarianceFFT(std::vector<NRLib::Matrix> & auto_cov,
+                                       std::vector<NRLib::Matrix> & count,
+                                       int                        & max_lag_with_data,
+                                       const std::vector<double>  & log_vp,
+                                       const std::vector<double>  & log_vs,
+                                       const std::vector<double>  & log_rho,
+                                       const std::vector<double>  & z_rel,
+                                       bool                         use_regression,
+                                       bool                         use_vs,
+                                       const NRLib::Vector        & regression_coef,
+                                       const std::vector<double>  & residual_variance_vs,
+                                       float                        min_dz);
+
   void            SetParameterCov(const NRLib::Matrix                           & auto_cov,
                                   NRLib::Matrix                                 & var_0,
                                   int                                             n_params);
@@ -27,10 +27,12 @@
 #include "src/gridmapping.h"
 #include "src/parameteroutput.h"
 #include "src/timings.h"
+#include "src/profiler.h"
 #include "src/spatialwellfilter.h"
 #include "src/qualitygrid.h"
 #include "src/io.h"
 #include "src/tasklist.h"
+#include "src/checkpoint.h"
 
 #include "lib/timekit.hpp"
 #include "lib/random.h"
@@ -54,7 +56,8 @@ AVOInversion::AVOInversion(ModelSettings           * modelSettings,
                            ModelGeneral            * modelGeneral,
                            ModelAVOStatic          * modelAVOstatic,
                            ModelAVODynamic         * modelAVOdynamic,
-                           SeismicParametersHolder & seismicParameters)
+                           SeismicParametersHolder & seismicParameters,
+                           Checkpoint              * checkpoint)
 {
 
   if(modelAVOstatic->GetForwardModeling())
@@ -62,6 +65,8 @@ AVOInversion::AVOInversion(ModelSettings           * modelSettings,
 
   LogKit::WriteHeader("Building Stochastic Model");
 
+  Profiler::Region region("Building stochastic model");
+
   time_t timestart, timeend;
   time(&timestart);
 
@@ -72,6 +77,7 @@ AVOInversion::AVOInversion(ModelSettings           * modelSettings,
   modelGeneral_      = modelGeneral;
   modelAVOstatic_    = modelAVOstatic;
   modelAVOdynamic_   = modelAVOdynamic;
+  checkpoint_        = checkpoint;
 
   simbox_            = modelGeneral_->GetSimbox();
   nx_                = seismicParameters.GetMeanVp()->getNx();
@@ -226,12 +232,6 @@ AVOInversion::AVOInversion(ModelSettings           * modelSettings,
     if(simbox_->getIsConstantThick() == false)
       divideDataByScaleWavelet(seismicParameters);
 
-    for (int i = 0 ; i < ntheta_ ; i++){
-      seisData_[i]->setAccessMode(FFTGrid::RANDOMACCESS);
-      seisData_[i]->fftInPlace();
-      seisData_[i]->endAccess();
-    }
-
     if ((modelSettings_->getEstimateFaciesProb() && modelSettings_->getFaciesProbRelative()) || modelAVOdynamic_->GetUseLocalNoise())
     {
       meanVp2_  = copyFFTGrid(meanVp_);
@@ -239,9 +239,15 @@ AVOInversion::AVOInversion(ModelSettings           * modelSettings,
       meanRho2_ = copyFFTGrid(meanRho_);
     }
 
-    meanVp_ ->fftInPlace();
-    meanVs_ ->fftInPlace();
-    meanRho_->fftInPlace();
+    if (checkpoint_ != NULL)
+      addInputToFingerprint(seismicParameters);
+
+    // The seismic and background grids are transformed concurrently.
+    std::vector<FFTGrid *> grids(seisData_.begin(), seisData_.begin() + ntheta_);
+    grids.push_back(meanVp_);
+    grids.push_back(meanVs_);
+    grids.push_back(meanRho_);
+    FFTGrid::fftInPlaceAll(grids);
   }
   else{
     modelAVOdynamic_->ReleaseGrids();
@@ -268,8 +274,24 @@ AVOInversion::AVOInversion(ModelSettings           * modelSettings,
     time(&timeend);
     LogKit::LogFormatted(LogKit::DebugLow,"\nTime elapsed :  %d\n",timeend-timestart);
 
-    if(modelSettings->getNumberOfSimulations() > 0)
-      simulate(seismicParameters, modelGeneral->GetRandomGen());
+    if(modelSettings->getNumberOfSimulations() > 0) {
+      if (checkpoint_ != NULL) {
+        //
+        // The generator state covers seeds read from a seed file as well as
+        // the seed in the model file.
+        //
+        checkpoint_->AddToFingerprint(nSim_);
+        checkpoint_->AddToFingerprint(modelGeneral->GetRandomGen()->getCurrentSeed());
+        checkpoint_->AddToFingerprint(krigingParameter_);
+      }
+      if (checkpoint_ != NULL && checkpoint_->CanRestore(Checkpoint::SIMULATION, 3*nSim_))
+        restoreSimulations(seismicParameters);
+      else {
+        simulate(seismicParameters, modelGeneral->GetRandomGen());
+        if (checkpoint_ != NULL)
+          saveSimulations(seismicParameters);
+      }
+    }
 
     seismicParameters.invFFTCovGrids();
     seismicParameters.updatePriorVar();
@@ -313,9 +335,11 @@ AVOInversion::AVOInversion(ModelSettings           * modelSettings,
     LogKit::LogFormatted(LogKit::Low,"\n               ... model built\n");
   }
 
-  postVp_ ->fftInPlace();
-  postVs_ ->fftInPlace();
-  postRho_->fftInPlace();
+  std::vector<FFTGrid *> postGrids(3);
+  postGrids[0] = postVp_;
+  postGrids[1] = postVs_;
+  postGrids[2] = postRho_;
+  FFTGrid::fftInPlaceAll(postGrids);
 
   seismicParameters.setBackgroundParameters(postVp_, postVs_, postRho_);
   //seismicParameters.FFTCovGrids();
@@ -484,27 +508,26 @@ AVOInversion::checkScale(void)
 void
 AVOInversion::divideDataByScaleWavelet(const SeismicParametersHolder & seismicParameters)
 {
-  int i,j,k,l,flag;
-
-  fftw_real*    rData;
-  fftw_real     tmp;
-  fftw_complex* cData ;
-  fftw_complex* adjustmentFactor;
-
-
-  rfftwnd_plan plan1,plan2;
+  //
+  // Each trace is transformed, multiplied by the adjustment factor of its
+  // local wavelet and transformed back. The traces of a row are transformed
+  // together with batched FFTs, and the rows are shared between threads.
+  //
+  int cnzp = nzp_/2 + 1;
+  int rnzp = 2*cnzp;
 
-  rData  = static_cast<fftw_real*>(fftw_malloc(2*(nzp_/2+1)*sizeof(fftw_real)));
-  cData  = reinterpret_cast<fftw_complex*>(rData);
-  adjustmentFactor= static_cast<fftw_complex*>(fftw_malloc(2*(nzp_/2+1)*sizeof(fftw_real)));
+  int          flag  = FFTW_ESTIMATE | FFTW_IN_PLACE | FFTW_THREADSAFE;
+  rfftwnd_plan plan1 = rfftwnd_create_plan(1, &nzp_, FFTW_REAL_TO_COMPLEX, flag);
+  rfftwnd_plan plan2 = rfftwnd_create_plan(1, &nzp_, FFTW_COMPLEX_TO_REAL, flag);
 
-  Wavelet1D* localWavelet ;
+  // The reflection coefficient spectrum is the same for all traces of an angle.
+  float        * corrT        = seismicParameters.getPriorCorrTFiltered(nz_, nzp_);
+  fftw_real    * rcCovT       = static_cast<fftw_real*>(fftw_malloc(rnzp*sizeof(fftw_real)));
+  fftw_complex * rcSpecIntens = reinterpret_cast<fftw_complex*>(rcCovT);
 
-  flag   = FFTW_ESTIMATE | FFTW_IN_PLACE;
-  plan1  = rfftwnd_create_plan(1,&nzp_,FFTW_REAL_TO_COMPLEX,flag);
-  plan2  = rfftwnd_create_plan(1,&nzp_,FFTW_COMPLEX_TO_REAL,flag);
+  float scale = static_cast<float>(sqrt(static_cast<float>(nzp_)));
 
-  for (l=0 ; l< ntheta_ ; l++ )
+  for (int l=0 ; l< ntheta_ ; l++ )
   {
     int dim=seisWavelet_[l]->getDim();
     std::string angle = NRLib::ToString(thetaDeg_[l], 1);
@@ -514,156 +537,180 @@ AVOInversion::divideDataByScaleWavelet(const SeismicParametersHolder & seismicPa
       seisData_[l]->writeStormFile(fileName, simbox_, false, true, true);
     }
 
+    float A[3];
+    A[0] = static_cast<float>(A_(l,0));
+    A[1] = static_cast<float>(A_(l,1));
+    A[2] = static_cast<float>(A_(l,2));
+    computeReflectionCoefficientTimeCovariance(rcCovT, corrT, A);
+    rfftwnd_one_real_to_complex(plan1,rcCovT ,rcSpecIntens); // operator FFT (not isometric)
+
+    float errorVar = static_cast<float>(errThetaCov_[l][l]);
+
+    // Local wavelets are copied from the angle wavelet, so it is kept in the
+    // time domain while the threads use it. The global wavelet is transformed
+    // once, in a copy.
+    if(!seisWavelet_[l]->getIsReal())
+      seisWavelet_[l]->invFFT1DInPlace();
+    Wavelet * wGlobal = (dim==1 ? seisWavelet_[l] : seisWavelet_[l]->getGlobalWavelet());
+    Wavelet1D globalWavelet(wGlobal);
+    globalWavelet.fft1DInPlace();
+
     seisData_[l]->setAccessMode(FFTGrid::RANDOMACCESS);
-    for (i=0; i < nxp_; i++)
-      for (j=0; j< nyp_; j++)
+
+#ifdef PARALLEL
+    int n_threads = FFTGrid::getNumberOfThreads();
+#pragma omp parallel num_threads(n_threads)
+#endif
+    {
+      fftw_real    * rData            = static_cast<fftw_real*>(fftw_malloc(nyp_*rnzp*sizeof(fftw_real)));
+      fftw_complex * adjustmentFactor = static_cast<fftw_complex*>(fftw_malloc(cnzp*sizeof(fftw_complex)));
+
+#ifdef PARALLEL
+#pragma omp for schedule(dynamic, 1)
+#endif
+      for (int i=0; i < nxp_; i++)
       {
         // gets data
-        int iInd=i;
-        int jInd=j;
+        for (int j=0; j< nyp_; j++)
+        {
+          fftw_real * trace = rData + j*rnzp;
+          for (int k=0;k<nzp_;k++)
+          {
+            trace[k] = seisData_[l]->getRealValue(i,j,k, true)/scale;
 
+            if(k > nz_)
+            {
+              float dist = seisData_[l]->getDistToBoundary( k, nz_, nzp_);
+              trace[k] *= std::max<float>(1-dist*dist,0);
+            }
+          }
+        }
+        rfftwnd_real_to_complex(plan1, nyp_, rData, 1, rnzp, NULL, 0, 0); // fourier transform of data in the profiles of row i
+        // end get data
+
+        int iInd=i;
         if(iInd > 3*nx_-1  ){
           iInd = 0;
         }
-        if(jInd > 3*ny_-1  ){
-          jInd = 0;
-        }
-
         if((iInd > (nxp_+nx_)/2))
           iInd = nxp_-iInd;
         if(iInd >= nx_ )
           iInd = 2*nx_-iInd-1;
 
-        if(jInd > (nyp_+ny_)/2)
-          jInd = nyp_-jInd;
-        if(jInd >= ny_ )
-          jInd = 2*ny_-jInd-1;
-
-        for (k=0;k<nzp_;k++)
+        for (int j=0; j< nyp_; j++)
         {
-          rData[k] = seisData_[l]->getRealValue(i,j,k, true)/static_cast<float>(sqrt(static_cast<float>(nzp_)));
-
-          if(k > nz_)
-          {
-            float dist = seisData_[l]->getDistToBoundary( k, nz_, nzp_);
-            rData[k] *= std::max<float>(1-dist*dist,0);
+          int jInd=j;
+          if(jInd > 3*ny_-1  ){
+            jInd = 0;
           }
-        }
-        rfftwnd_one_real_to_complex(plan1,rData ,cData); // fourier transform of data in profile (i,j)
-        // end get data
+          if(jInd > (nyp_+ny_)/2)
+            jInd = nyp_-jInd;
+          if(jInd >= ny_ )
+            jInd = 2*ny_-jInd-1;
 
-        // Wavelet local properties
-        localWavelet = seisWavelet_[l]->createLocalWavelet1D(iInd,jInd);  //
-        double sfLoc =(simbox_->getRelThick(i,j)*seisWavelet_[l]->getLocalStretch(iInd,jInd));// scale factor from thickness stretch + (local stretch when 3D wavelet)
-
-        double relT   = simbox_->getRelThick(i,j);
-        double deltaF = static_cast<double>(nz_)*1000.0/(relT*simbox_->getlz()*static_cast<double>(nzp_));
-        std::vector<float> A(3);
-        A[0] = static_cast<float>(A_(l,0));
-        A[1] = static_cast<float>(A_(l,1));
-        A[2] = static_cast<float>(A_(l,2));
-        if(dim==1)
-          computeAdjustmentFactor( adjustmentFactor, localWavelet , sfLoc, seisWavelet_[l], seismicParameters, &A[0],static_cast<float>(errThetaCov_[l][l]));
-        else
-          computeAdjustmentFactor( adjustmentFactor, localWavelet , sfLoc, seisWavelet_[l]->getGlobalWavelet(), seismicParameters, &A[0],static_cast<float>(errThetaCov_[l][l]));
+          // Wavelet local properties
+          Wavelet1D * localWavelet = seisWavelet_[l]->createLocalWavelet1D(iInd,jInd);
+          double sfLoc =(simbox_->getRelThick(i,j)*seisWavelet_[l]->getLocalStretch(iInd,jInd));// scale factor from thickness stretch + (local stretch when 3D wavelet)
 
-        delete localWavelet;
+          double relT   = simbox_->getRelThick(i,j);
+          double deltaF = static_cast<double>(nz_)*1000.0/(relT*simbox_->getlz()*static_cast<double>(nzp_));
 
-        for (k=0;k < (nzp_/2 +1);k++) // all complex values
-        {
-          if( (deltaF*k < highCut_ ) && (deltaF*k > lowCut_ )) //NBNB frequency cleaning
-          {
-            tmp           = cData[k].re * adjustmentFactor[k].re - cData[k].im * adjustmentFactor[k].im;
-            cData[k].im   = cData[k].im * adjustmentFactor[k].re + cData[k].re * adjustmentFactor[k].im;
-            cData[k].re   = tmp;
-          }
-          else
+          computeAdjustmentFactor(adjustmentFactor, localWavelet, sfLoc, &globalWavelet, rcSpecIntens, errorVar);
+
+          delete localWavelet;
+
+          fftw_complex * cData = reinterpret_cast<fftw_complex*>(rData + j*rnzp);
+          for (int k=0;k < cnzp;k++) // all complex values
           {
-            cData[k].im = 0.0f;
-            cData[k].re = 0.0f;
+            if( (deltaF*k < highCut_ ) && (deltaF*k > lowCut_ )) //NBNB frequency cleaning
+            {
+              fftw_real tmp = cData[k].re * adjustmentFactor[k].re - cData[k].im * adjustmentFactor[k].im;
+              cData[k].im   = cData[k].im * adjustmentFactor[k].re + cData[k].re * adjustmentFactor[k].im;
+              cData[k].re   = tmp;
+            }
+            else
+            {
+              cData[k].im = 0.0f;
+              cData[k].re = 0.0f;
+            }
           }
         }
-        rfftwnd_one_complex_to_real(plan2 ,cData ,rData);
-        for (k=0;k<nzp_;k++)
+
+        rfftwnd_complex_to_real(plan2, nyp_, reinterpret_cast<fftw_complex*>(rData), 1, cnzp, NULL, 0, 0);
+        for (int j=0; j< nyp_; j++)
         {
-          seisData_[l]->setRealValue(i,j,k,rData[k]/static_cast<float>(sqrt(static_cast<float>(nzp_))),true);
+          fftw_real * trace = rData + j*rnzp;
+          for (int k=0;k<nzp_;k++)
+            seisData_[l]->setRealValue(i,j,k,trace[k]/scale,true);
         }
       }
 
-      if(ModelSettings::getDebugLevel() > 0)
-      {
-        ///* NBNB How to handle
-        std::string fileName1 = IO::PrefixReflectionCoefficients() + angle;
-        std::string fileName2 = IO::PrefixReflectionCoefficients() + "With_Padding_" + angle;
-        std::string sgriLabel = "Reflection coefficients for incidence angle " + angle;
-        seisData_[l]->writeFile(fileName1, IO::PathToDebug(), simbox_, sgriLabel);
-        seisData_[l]->writeStormFile(fileName2, simbox_, false, true, true);
-        //*/
-      }
+      fftw_free(rData);
+      fftw_free(adjustmentFactor);
+    }
 
-      LogKit::LogFormatted(LogKit::Medium,"\nInterpolating reflections for angle stack "+angle+": ");
-      seisData_[l]->interpolateSeismic(energyTreshold_);
+    // The global wavelet was previously left in the frequency domain.
+    wGlobal->fft1DInPlace();
 
-      if(ModelSettings::getDebugLevel() > 0)
-      {
-        ///*
-        std::string sgriLabel = "Interpolated reflections for incidence angle "+angle;
-        std::string fileName1 = IO::PrefixReflectionCoefficients() + "Interpolated_" + angle;
-        std::string fileName2 = IO::PrefixReflectionCoefficients()  + "Interpolated_With_Padding_" + angle;
-        seisData_[l]->writeFile(fileName1, IO::PathToDebug(), simbox_, sgriLabel);
-        seisData_[l]->writeStormFile(fileName2, simbox_, false, true, true);
-        //*/
-      }
-      seisData_[l]->endAccess();
+    if(ModelSettings::getDebugLevel() > 0)
+    {
+      ///* NBNB How to handle
+      std::string fileName1 = IO::PrefixReflectionCoefficients() + angle;
+      std::string fileName2 = IO::PrefixReflectionCoefficients() + "With_Padding_" + angle;
+      std::string sgriLabel = "Reflection coefficients for incidence angle " + angle;
+      seisData_[l]->writeFile(fileName1, IO::PathToDebug(), simbox_, sgriLabel);
+      seisData_[l]->writeStormFile(fileName2, simbox_, false, true, true);
+      //*/
+    }
+
+    LogKit::LogFormatted(LogKit::Medium,"\nInterpolating reflections for angle stack "+angle+": ");
+    seisData_[l]->interpolateSeismic(energyTreshold_);
+
+    if(ModelSettings::getDebugLevel() > 0)
+    {
+      ///*
+      std::string sgriLabel = "Interpolated reflections for incidence angle "+angle;
+      std::string fileName1 = IO::PrefixReflectionCoefficients() + "Interpolated_" + angle;
+      std::string fileName2 = IO::PrefixReflectionCoefficients()  + "Interpolated_With_Padding_" + angle;
+      seisData_[l]->writeFile(fileName1, IO::PathToDebug(), simbox_, sgriLabel);
+      seisData_[l]->writeStormFile(fileName2, simbox_, false, true, true);
+      //*/
+    }
+    seisData_[l]->endAccess();
   }
 
-  fftw_free(rData);
-  fftw_free(adjustmentFactor);
+  delete [] corrT;
+  fftw_free(rcCovT);
   fftwnd_destroy_plan(plan1);
   fftwnd_destroy_plan(plan2);
 }
 
 
 void
-AVOInversion::computeAdjustmentFactor(fftw_complex                  * adjustmentFactor,
-                                      Wavelet1D                     * wLocal,
-                                      double                          sf,
-                                      Wavelet                       * wGlobal,
-                                      const SeismicParametersHolder & seismicParameters,
-                                      const float                         * A,
-                                      float                           errorVar)
+AVOInversion::computeAdjustmentFactor(fftw_complex       * adjustmentFactor,
+                                      Wavelet1D          * wLocal,
+                                      double               sf,
+                                      const Wavelet      * wGlobal,
+                                      const fftw_complex * rcSpecIntens,
+                                      float                errorVar) const
 {
 // Computes the 1D inversion (of a single cube) with the local wavelet
 // and then multiply up with the values of the global wavelet
 // in order to adjust the data that inversion is ok with new data.
+// wGlobal must be in the frequency domain, and rcSpecIntens is the spectrum
+// of the time covariance for reflection coefficients.
   float tolFac= 0.05f;
 
-    // computes the time covariance for reflection coefficients rcCovT can be globaly stored
-  fftw_real* rcCovT;
-  int flag   = FFTW_ESTIMATE | FFTW_IN_PLACE;
-  rfftwnd_plan plan1  = rfftwnd_create_plan(1, &nzp_ ,FFTW_REAL_TO_COMPLEX,flag);
-  rcCovT = static_cast<fftw_real*>(fftw_malloc(2*(nzp_/2+1)*sizeof(fftw_real)));
-  fftw_complex * rcSpecIntens = reinterpret_cast<fftw_complex*>(rcCovT);
-
-  float * corrT = seismicParameters.getPriorCorrTFiltered(nz_, nzp_);
-  computeReflectionCoefficientTimeCovariance(rcCovT, corrT, A);
-  rfftwnd_one_real_to_complex(plan1,rcCovT ,rcSpecIntens); // operator FFT (not isometric)
-  delete [] corrT;
-
   // computes the time Covariance in the errorterm with wavelet Local can be more efficiently computed
   Wavelet1D *errorSmooth  = new Wavelet1D(wLocal ,Wavelet::FIRSTORDERFORWARDDIFF);
   Wavelet1D *errorSmooth2 = new Wavelet1D(errorSmooth, Wavelet::FIRSTORDERBACKWARDDIFF);
   Wavelet1D *errorSmooth3 = new Wavelet1D(errorSmooth2,Wavelet::FIRSTORDERCENTRALDIFF);
-  errorSmooth->fft1DInPlace();
-  float normF1 = errorSmooth->findNormWithinFrequencyBand(lowCut_,highCut_);
-  errorSmooth->multiplyRAmpByConstant(1.0f/normF1);
   errorSmooth3->fft1DInPlace();
   float normF3 = errorSmooth3->findNormWithinFrequencyBand(lowCut_,highCut_);
   errorSmooth3->multiplyRAmpByConstant(1.0f/normF3);
   wLocal->fft1DInPlace();
 
   // Wavelet global properties sets order of size
-  wGlobal->fft1DInPlace();
   float modW = wGlobal->getNorm();// note the wavelet norm is in time domain. In frequency domain we have an additional factor float(nzp_);
                                   // this is because we define the wavelet as an operator hence the fft is not norm preserving.
   modW *= modW;
@@ -714,78 +761,97 @@ AVOInversion::computeAdjustmentFactor(fftw_complex                  * adjustment
   delete errorSmooth;
   delete errorSmooth2;
   delete errorSmooth3;
-  fftwnd_destroy_plan(plan1);
-  fftw_free(rcCovT);
 }
 
 void
 AVOInversion::multiplyDataByScaleWaveletAndWriteToFile(const std::string & typeName, std::string & interval_name)
 {
-  int i,j,k,l,flag;
-
-  fftw_real*    rData;
-  fftw_real     tmp;
-  fftw_complex* cData;
-  fftw_complex scaleWVal;
-  rfftwnd_plan plan1,plan2;
-
-  rData  = static_cast<fftw_real*>(fftw_malloc(2*(nzp_/2+1)*sizeof(fftw_real)));
-  cData  = reinterpret_cast<fftw_complex*>(rData);
+  // Trace-wise multiplication by the local wavelet, with the traces of a
+  // row transformed together and the rows shared between threads.
+  int cnzp = nzp_/2 + 1;
+  int rnzp = 2*cnzp;
 
-  flag   = FFTW_ESTIMATE | FFTW_IN_PLACE;
-  plan1  = rfftwnd_create_plan(1, &nzp_ ,FFTW_REAL_TO_COMPLEX,flag);
-  plan2  = rfftwnd_create_plan(1,&nzp_,FFTW_COMPLEX_TO_REAL,flag);
+  int          flag  = FFTW_ESTIMATE | FFTW_IN_PLACE | FFTW_THREADSAFE;
+  rfftwnd_plan plan1 = rfftwnd_create_plan(1, &nzp_, FFTW_REAL_TO_COMPLEX, flag);
+  rfftwnd_plan plan2 = rfftwnd_create_plan(1, &nzp_, FFTW_COMPLEX_TO_REAL, flag);
 
-  Wavelet1D* localWavelet;
+  float scaleIn  = static_cast<float>(sqrt(static_cast<float>(nzp_)));
+  float scaleOut = static_cast<float>(sqrt(static_cast<double>(nzp_)));
 
-  for (l=0 ; l< ntheta_ ; l++ )
+  for (int l=0 ; l< ntheta_ ; l++ )
   {
     seisData_[l]->setAccessMode(FFTGrid::RANDOMACCESS);
     seisData_[l]->invFFTInPlace();
 
-    for (i=0; i < nx_; i++)
-      for (j=0; j< ny_; j++)
-      {
-        float sf = static_cast<float>(simbox_->getRelThick(i,j))*seisWavelet_[l]->getLocalStretch(i,j);
+    // Local wavelets are copied from this one by all threads.
+    if(!seisWavelet_[l]->getIsReal())
+      seisWavelet_[l]->invFFT1DInPlace();
+
+#ifdef PARALLEL
+    int n_threads = FFTGrid::getNumberOfThreads();
+#pragma omp parallel num_threads(n_threads)
+#endif
+    {
+      fftw_real * rData = static_cast<fftw_real*>(fftw_malloc(ny_*rnzp*sizeof(fftw_real)));
 
-        for (k=0;k<nzp_;k++)
+#ifdef PARALLEL
+#pragma omp for schedule(dynamic, 1)
+#endif
+      for (int i=0; i < nx_; i++)
+      {
+        for (int j=0; j< ny_; j++)
         {
-          rData[k] = seisData_[l]->getRealValue(i,j,k, true)/static_cast<float>(sqrt(static_cast<float>(nzp_)));
+          fftw_real * trace = rData + j*rnzp;
+          for (int k=0;k<nzp_;k++)
+            trace[k] = seisData_[l]->getRealValue(i,j,k, true)/scaleIn;
         }
 
-        rfftwnd_one_real_to_complex(plan1,rData ,cData);
-        localWavelet = seisWavelet_[l]->createLocalWavelet1D(i,j);
+        rfftwnd_real_to_complex(plan1, ny_, rData, 1, rnzp, NULL, 0, 0);
 
-        for (k=0;k < (nzp_/2 +1);k++) // all complex values
+        for (int j=0; j< ny_; j++)
         {
-            scaleWVal    =  localWavelet->getCAmp(k,sf);    // NBNB change here
-          //scaleWVal    =  localWavelet->getCAmp(k);
-          // note scaleWVal is acctually the value of the complex conjugate
-          // (see definition of getCAmp)
-          tmp           = cData[k].re * scaleWVal.re + cData[k].im * scaleWVal.im;
-          cData[k].im   = cData[k].im * scaleWVal.re - cData[k].re * scaleWVal.im;
-          cData[k].re   = tmp;
+          float sf = static_cast<float>(simbox_->getRelThick(i,j))*seisWavelet_[l]->getLocalStretch(i,j);
+
+          Wavelet1D    * localWavelet = seisWavelet_[l]->createLocalWavelet1D(i,j);
+          fftw_complex * cData        = reinterpret_cast<fftw_complex*>(rData + j*rnzp);
+
+          for (int k=0;k < cnzp;k++) // all complex values
+          {
+            fftw_complex scaleWVal = localWavelet->getCAmp(k,sf);    // NBNB change here
+            //scaleWVal    =  localWavelet->getCAmp(k);
+            // note scaleWVal is acctually the value of the complex conjugate
+            // (see definition of getCAmp)
+            fftw_real tmp = cData[k].re * scaleWVal.re + cData[k].im * scaleWVal.im;
+            cData[k].im   = cData[k].im * scaleWVal.re - cData[k].re * scaleWVal.im;
+            cData[k].re   = tmp;
+          }
+          delete localWavelet;
         }
-        delete localWavelet;
-        rfftwnd_one_complex_to_real(plan2 ,cData ,rData);
-        for (k=0;k<nzp_;k++)
+
+        rfftwnd_complex_to_real(plan2, ny_, reinterpret_cast<fftw_complex*>(rData), 1, cnzp, NULL, 0, 0);
+
+        for (int j=0; j< ny_; j++)
         {
-          seisData_[l]->setRealValue(i,j,k,rData[k]/static_cast<float>(sqrt(static_cast<double>(nzp_))),true);
+          fftw_real * trace = rData + j*rnzp;
+          for (int k=0;k<nzp_;k++)
+            seisData_[l]->setRealValue(i,j,k,trace[k]/scaleOut,true);
         }
-
       }
-      std::string angle     = NRLib::ToString(thetaDeg_[l],1);
-      std::string sgriLabel = typeName + " for incidence angle "+angle;
-      std::string fileName  = typeName + angle;
 
-      if (interval_name != "")
-        fileName += "_" + interval_name;
+      fftw_free(rData);
+    }
+
+    std::string angle     = NRLib::ToString(thetaDeg_[l],1);
+    std::string sgriLabel = typeName + " for incidence angle "+angle;
+    std::string fileName  = typeName + angle;
+
+    if (interval_name != "")
+      fileName += "_" + interval_name;
 
-      seisData_[l]->writeFile(fileName, IO::PathToSeismicData(), simbox_, sgriLabel);
-      seisData_[l]->endAccess();
+    seisData_[l]->writeFile(fileName, IO::PathToSeismicData(), simbox_, sgriLabel);
+    seisData_[l]->endAccess();
   }
 
-  fftw_free(rData);
   fftwnd_destroy_plan(plan1);
   fftwnd_destroy_plan(plan2);
 }
@@ -798,6 +864,8 @@ AVOInversion::computePostMeanResidAndFFTCov(ModelGeneral            * modelGener
 {
   LogKit::WriteHeader("Posterior model / Performing Inversion");
 
+  Profiler::Region region("Inversion");
+
   double wall=0.0, cpu=0.0;
   TimeKit::getTime(wall,cpu);
   int i,j,k,l;
@@ -934,163 +1002,213 @@ AVOInversion::computePostMeanResidAndFFTCov(ModelGeneral            * modelGener
     }
   }
 
-  LogKit::LogFormatted(LogKit::Low,"\nBuilding posterior distribution:");
-  float monitorSize = std::max(1.0f, static_cast<float>(nzp_)*0.02f);
-  float nextMonitor = monitorSize;
-  std::cout
-    << "\n  0%       20%       40%       60%       80%      100%"
-    << "\n  |    |    |    |    |    |    |    |    |    |    |  "
-    << "\n  ^";
+  //
+  // The state at the end of this phase is the posterior mean, the posterior
+  // covariance in the Fourier domain and the residuals. It is read back
+  // instead of inverting if a checkpoint with the same input is found.
+  //
+  std::vector<FFTGrid *> checkpointGrids;
+  checkpointGrids.push_back(postVp_);
+  checkpointGrids.push_back(postVs_);
+  checkpointGrids.push_back(postRho_);
+  checkpointGrids.push_back(postCovVp);
+  checkpointGrids.push_back(postCovVs);
+  checkpointGrids.push_back(postCovRho);
+  checkpointGrids.push_back(postCrCovVpVs);
+  checkpointGrids.push_back(postCrCovVpRho);
+  checkpointGrids.push_back(postCrCovVsRho);
+  for (l = 0; l < ntheta_; l++)
+    checkpointGrids.push_back(seisData_[l]);
 
-  for (k = 0; k < nzp_; k++)
-  {
-    realFrequency = static_cast<float>((nz_*1000.0f)/(simbox_->getlz()*nzp_)*std::min(k,nzp_-k)); // the physical frequency
-    kD = diff1Operator->getCAmp(k);                      // defines content of kD
-    if(simbox_->getIsConstantThick())
-    {
-      // defines content of K=WDA
-      fillkW(k, kW, seisWavelet_);
-
-      lib_matrProdScalVecCpx(kD, kW, ntheta_);
-
-      // Copy matrix A to float**
-      float ** A = new float * [3];
-      for (int i = 0; i < ntheta_; i++)
-        A[i] = new float[3];
-      for (int i = 0; i < ntheta_; i++){
-        for (int j = 0; j < 3; j++){
-          A[i][j] = static_cast<float>(A_(i,j));
-        }
-      }
+  bool restore = checkpoint_ != NULL && checkpoint_->CanRestore(Checkpoint::POSTERIOR, static_cast<int>(checkpointGrids.size()));
 
-      lib_matrProdDiagCpxR(kW, A, ntheta_, 3, K); // defines content of (WDA) K
+  if (restore == false) {
+    LogKit::LogFormatted(LogKit::Low,"\nBuilding posterior distribution:");
+    float monitorSize = std::max(1.0f, static_cast<float>(nzp_)*0.02f);
+    float nextMonitor = monitorSize;
+    std::cout
+      << "\n  0%       20%       40%       60%       80%      100%"
+      << "\n  |    |    |    |    |    |    |    |    |    |    |  "
+      << "\n  ^";
 
-      for (int i = 0; i < ntheta_; i++)
-        delete [] A[i];
-      delete [] A;
+    int nCells = nyp_*cnxp; // Complex values in one frequency slice
 
-      // defines error-term multipliers
-      fillkWNorm(k,errMult1,seisWaveletForNorm);         // defines input of  (kWNorm) errMult1
-      fillkWNorm(k,errMult2,errorSmooth3);               // defines input of  (kWD3Norm) errMult2
-      lib_matrFillOnesVecCpx(errMult3,ntheta_);          // defines content of errMult3
-    }
-    else
+    for (k = 0; k < nzp_; k++)
     {
-      kD3 = diff3Operator->getCAmp(k);                   // defines  kD3
-
-      // Copy matrix A to float **
-      float ** A = new float * [ntheta_];
-      for (int i = 0; i < ntheta_; i++)
-        A[i] = new float[3];
-      for (int i = 0; i < ntheta_; i++){
-        for (int j = 0; j < 3; j++){
-          A[i][j] = static_cast<float>(A_(i,j));
+      realFrequency = static_cast<float>((nz_*1000.0f)/(simbox_->getlz()*nzp_)*std::min(k,nzp_-k)); // the physical frequency
+      bool invert_frequency = realFrequency > lowCut_*simbox_->getMinRelThick() &&  realFrequency < highCut_;
+
+      if(invert_frequency == false)
+      {
+        // Outside the frequency band the posterior equals the prior. The mean
+        // and the seismic residual are updated in place, so these slices are
+        // passed over. The covariances are written back as in the band.
+        meanVp_ ->skipNextComplex(nCells);
+        meanVs_ ->skipNextComplex(nCells);
+        meanRho_->skipNextComplex(nCells);
+        errCorr_->skipNextComplex(nCells);
+        for (l = 0; l < ntheta_; l++)
+          seisData_[l]->skipNextComplex(nCells);
+
+        for (i = 0; i < nCells; i++) {
+          seismicParameters.getNextParameterCovariance(parVar);
+          postCovVp ->setNextComplex(parVar[0][0]);
+          postCovVs ->setNextComplex(parVar[1][1]);
+          postCovRho->setNextComplex(parVar[2][2]);
+          postCrCovVpVs ->setNextComplex(parVar[0][1]);
+          postCrCovVpRho->setNextComplex(parVar[0][2]);
+          postCrCovVsRho->setNextComplex(parVar[1][2]);
         }
       }
+      else
+      {
+        kD = diff1Operator->getCAmp(k);                      // defines content of kD
+        if(simbox_->getIsConstantThick())
+        {
+          // defines content of K=WDA
+          fillkW(k, kW, seisWavelet_);
+
+          lib_matrProdScalVecCpx(kD, kW, ntheta_);
+
+          // Copy matrix A to float**
+          float ** A = new float * [3];
+          for (int i = 0; i < ntheta_; i++)
+            A[i] = new float[3];
+          for (int i = 0; i < ntheta_; i++){
+            for (int j = 0; j < 3; j++){
+              A[i][j] = static_cast<float>(A_(i,j));
+            }
+          }
 
-      // defines content of K = DA
-      lib_matrFillValueVecCpx(kD, errMult1, ntheta_);    // errMult1 used as dummy
-      lib_matrProdDiagCpxR(errMult1, A, ntheta_, 3, K); // defines content of ( K = DA )
+          lib_matrProdDiagCpxR(kW, A, ntheta_, 3, K); // defines content of (WDA) K
 
-      for (int i = 0; i < ntheta_; i++)
-        delete [] A[i];
-      delete [] A;
+          for (int i = 0; i < ntheta_; i++)
+            delete [] A[i];
+          delete [] A;
 
-      // defines error-term multipliers
-      lib_matrFillOnesVecCpx(errMult1,ntheta_);          // defines content of errMult1
-      for (l=0; l < ntheta_; l++)
-      {
-        errMult1[l].re /= seisWavelet_[l]->getNorm();    // defines content of errMult1
-      }
+          // defines error-term multipliers
+          fillkWNorm(k,errMult1,seisWaveletForNorm);         // defines input of  (kWNorm) errMult1
+          fillkWNorm(k,errMult2,errorSmooth3);               // defines input of  (kWD3Norm) errMult2
+          lib_matrFillOnesVecCpx(errMult3,ntheta_);          // defines content of errMult3
+        }
+        else
+        {
+          kD3 = diff3Operator->getCAmp(k);                   // defines  kD3
+
+          // Copy matrix A to float **
+          float ** A = new float * [ntheta_];
+          for (int i = 0; i < ntheta_; i++)
+            A[i] = new float[3];
+          for (int i = 0; i < ntheta_; i++){
+            for (int j = 0; j < 3; j++){
+              A[i][j] = static_cast<float>(A_(i,j));
+            }
+          }
 
-      lib_matrFillValueVecCpx(kD3,errMult2,ntheta_);     // defines content of errMult2
-      for (l=0; l < ntheta_; l++)
-      {
-        //float errorSmoothMult =  1.0f/errorSmooth3[l]->findNormWithinFrequencyBand(lowCut_,highCut_); // defines scaleFactor;
-        float errorSmoothMult =  1.0f/errorSmooth3[l]->getNorm(); // defines scaleFactor;
-        errMult2[l].re  *= errorSmoothMult; // defines content of errMult2
-        errMult2[l].im  *= errorSmoothMult; // defines content of errMult2
-      }
-      fillInverseAbskWRobust(k,errMult3,seisWaveletForNorm);// defines content of errMult3
-    }
+          // defines content of K = DA
+          lib_matrFillValueVecCpx(kD, errMult1, ntheta_);    // errMult1 used as dummy
+          lib_matrProdDiagCpxR(errMult1, A, ntheta_, 3, K); // defines content of ( K = DA )
 
-    for ( j = 0; j < nyp_; j++) {
-      for ( i = 0; i < cnxp; i++) {
-        ijkMean[0] = meanVp_ ->getNextComplex();
-        ijkMean[1] = meanVs_ ->getNextComplex();
-        ijkMean[2] = meanRho_->getNextComplex();
+          for (int i = 0; i < ntheta_; i++)
+            delete [] A[i];
+          delete [] A;
 
-        for (l = 0; l < ntheta_; l++ )
-        {
-          ijkData[l] = seisData_[l]->getNextComplex();
-          ijkRes[l]  = ijkData[l];
+          // defines error-term multipliers
+          lib_matrFillOnesVecCpx(errMult1,ntheta_);          // defines content of errMult1
+          for (l=0; l < ntheta_; l++)
+          {
+            errMult1[l].re /= seisWavelet_[l]->getNorm();    // defines content of errMult1
+          }
+
+          lib_matrFillValueVecCpx(kD3,errMult2,ntheta_);     // defines content of errMult2
+          for (l=0; l < ntheta_; l++)
+          {
+            //float errorSmoothMult =  1.0f/errorSmooth3[l]->findNormWithinFrequencyBand(lowCut_,highCut_); // defines scaleFactor;
+            float errorSmoothMult =  1.0f/errorSmooth3[l]->getNorm(); // defines scaleFactor;
+            errMult2[l].re  *= errorSmoothMult; // defines content of errMult2
+            errMult2[l].im  *= errorSmoothMult; // defines content of errMult2
+          }
+          fillInverseAbskWRobust(k,errMult3,seisWaveletForNorm);// defines content of errMult3
         }
 
-        seismicParameters.getNextParameterCovariance(parVar);
-        bool invert_frequency = realFrequency > lowCut_*simbox_->getMinRelThick() &&  realFrequency < highCut_;
+        for ( j = 0; j < nyp_; j++) {
+          for ( i = 0; i < cnxp; i++) {
+            ijkMean[0] = meanVp_ ->getNextComplex();
+            ijkMean[1] = meanVs_ ->getNextComplex();
+            ijkMean[2] = meanRho_->getNextComplex();
 
-        priorVarVp = parVar[0][0].re;
+            for (l = 0; l < ntheta_; l++ )
+            {
+              ijkData[l] = seisData_[l]->getNextComplex();
+              ijkRes[l]  = ijkData[l];
+            }
 
-        getNextErrorVariance(errVar, errMult1, errMult2, errMult3, ntheta_, wnc_, errThetaCov_, invert_frequency);
+            seismicParameters.getNextParameterCovariance(parVar);
 
-        if(invert_frequency){
-          lib_matrProdCpx(K, parVar , ntheta_, 3 ,3, KS);              //  KS is defined here
-          lib_matrProdAdjointCpx(KS, K, ntheta_, 3 ,ntheta_, margVar); // margVar = (K)S(K)' is defined here
-          lib_matrAddMatCpx(errVar, ntheta_,ntheta_, margVar);         // errVar  is added to margVar = (WDA)S(WDA)'  + errVar
+            priorVarVp = parVar[0][0].re;
 
-          cholFlag=lib_matrCholCpx(ntheta_,margVar);                   // Choleskey factor of margVar is Defined
+            getNextErrorVariance(errVar, errMult1, errMult2, errMult3, ntheta_, wnc_, errThetaCov_, invert_frequency);
 
-          if(cholFlag==0)
-          { // then it is ok else posterior is identical to prior
+            if(invert_frequency){
+              lib_matrProdCpx(K, parVar , ntheta_, 3 ,3, KS);              //  KS is defined here
+              lib_matrProdAdjointCpx(KS, K, ntheta_, 3 ,ntheta_, margVar); // margVar = (K)S(K)' is defined here
+              lib_matrAddMatCpx(errVar, ntheta_,ntheta_, margVar);         // errVar  is added to margVar = (WDA)S(WDA)'  + errVar
 
-            lib_matrAdjoint(KS,ntheta_,3,KScc);                        //  WDAScc is adjoint of WDAS
-            lib_matrAXeqBMatCpx(ntheta_, margVar, KS, 3);              // redefines WDAS
-            lib_matrProdCpx(KScc,KS,3,ntheta_,3,reduceVar);            // defines reduceVar
-            //double hj=1000000.0;
-            //if(reduceVar[0][0].im!=0)
-            // hj = MAXIM(reduceVar[0][0].re/reduceVar[0][0].im,-reduceVar[0][0].re/reduceVar[0][0].im); //NBNB DEBUG
-            lib_matrSubtMatCpx(reduceVar,3,3,parVar);                  // redefines parVar as the posterior solution
+              cholFlag=lib_matrCholCpx(ntheta_,margVar);                   // Choleskey factor of margVar is Defined
 
-            lib_matrProdMatVecCpx(K,ijkMean, ntheta_, 3, ijkDataMean); //  defines content of ijkDataMean
-            lib_matrSubtVecCpx(ijkDataMean, ntheta_, ijkData);         //  redefines content of ijkData
+              if(cholFlag==0)
+              { // then it is ok else posterior is identical to prior
 
-            lib_matrProdAdjointMatVecCpx(KS,ijkData,3,ntheta_,ijkAns); // defines ijkAns
+                lib_matrAdjoint(KS,ntheta_,3,KScc);                        //  WDAScc is adjoint of WDAS
+                lib_matrAXeqBMatCpx(ntheta_, margVar, KS, 3);              // redefines WDAS
+                lib_matrProdCpx(KScc,KS,3,ntheta_,3,reduceVar);            // defines reduceVar
+                //double hj=1000000.0;
+                //if(reduceVar[0][0].im!=0)
+                // hj = MAXIM(reduceVar[0][0].re/reduceVar[0][0].im,-reduceVar[0][0].re/reduceVar[0][0].im); //NBNB DEBUG
+                lib_matrSubtMatCpx(reduceVar,3,3,parVar);                  // redefines parVar as the posterior solution
 
-            lib_matrAddVecCpx(ijkAns, 3,ijkMean);                      // redefines ijkMean
-            lib_matrProdMatVecCpx(K,ijkMean, ntheta_, 3, ijkData);     // redefines ijkData
-            lib_matrSubtVecCpx(ijkData, ntheta_,ijkRes);               // redefines ijkRes
-          }
+                lib_matrProdMatVecCpx(K,ijkMean, ntheta_, 3, ijkDataMean); //  defines content of ijkDataMean
+                lib_matrSubtVecCpx(ijkDataMean, ntheta_, ijkData);         //  redefines content of ijkData
 
-          // quality control DEBUG
-          if(priorVarVp*4 < ijkAns[0].re*ijkAns[0].re + ijkAns[0].re*ijkAns[0].re)
-          {
-            justfactor = sqrt(ijkAns[0].re*ijkAns[0].re + ijkAns[0].re*ijkAns[0].re)/sqrt(priorVarVp);
+                lib_matrProdAdjointMatVecCpx(KS,ijkData,3,ntheta_,ijkAns); // defines ijkAns
+
+                lib_matrAddVecCpx(ijkAns, 3,ijkMean);                      // redefines ijkMean
+                lib_matrProdMatVecCpx(K,ijkMean, ntheta_, 3, ijkData);     // redefines ijkData
+                lib_matrSubtVecCpx(ijkData, ntheta_,ijkRes);               // redefines ijkRes
+              }
+
+              // quality control DEBUG
+              if(priorVarVp*4 < ijkAns[0].re*ijkAns[0].re + ijkAns[0].re*ijkAns[0].re)
+              {
+                justfactor = sqrt(ijkAns[0].re*ijkAns[0].re + ijkAns[0].re*ijkAns[0].re)/sqrt(priorVarVp);
+              }
+            }
+
+            postVp_ ->setNextComplex(ijkMean[0]);
+            postVs_ ->setNextComplex(ijkMean[1]);
+            postRho_->setNextComplex(ijkMean[2]);
+            postCovVp ->setNextComplex(parVar[0][0]);
+            postCovVs ->setNextComplex(parVar[1][1]);
+            postCovRho->setNextComplex(parVar[2][2]);
+            postCrCovVpVs ->setNextComplex(parVar[0][1]);
+            postCrCovVpRho->setNextComplex(parVar[0][2]);
+            postCrCovVsRho->setNextComplex(parVar[1][2]);
+
+            for (l=0;l<ntheta_;l++)
+              seisData_[l]->setNextComplex(ijkRes[l]);
           }
         }
-
-        postVp_ ->setNextComplex(ijkMean[0]);
-        postVs_ ->setNextComplex(ijkMean[1]);
-        postRho_->setNextComplex(ijkMean[2]);
-        postCovVp ->setNextComplex(parVar[0][0]);
-        postCovVs ->setNextComplex(parVar[1][1]);
-        postCovRho->setNextComplex(parVar[2][2]);
-        postCrCovVpVs ->setNextComplex(parVar[0][1]);
-        postCrCovVpRho->setNextComplex(parVar[0][2]);
-        postCrCovVsRho->setNextComplex(parVar[1][2]);
-
-        for (l=0;l<ntheta_;l++)
-          seisData_[l]->setNextComplex(ijkRes[l]);
+      }
+      // Log progress
+      if (k+1 >= static_cast<int>(nextMonitor))
+      {
+        nextMonitor += monitorSize;
+        std::cout << "^";
+        fflush(stdout);
       }
     }
-    // Log progress
-    if (k+1 >= static_cast<int>(nextMonitor))
-    {
-      nextMonitor += monitorSize;
-      std::cout << "^";
-      fflush(stdout);
-    }
+    std::cout << "\n";
   }
-  std::cout << "\n";
 
   //  time(&timeend);
   // LogKit::LogFormatted(LogKit::Low,"\n Core inversion finished after %ld seconds ***\n",timeend-timestart);
@@ -1110,13 +1228,22 @@ AVOInversion::computePostMeanResidAndFFTCov(ModelGeneral            * modelGener
   postCrCovVsRho->endAccess();
   errCorr_      ->endAccess();
 
-  postVp_ ->invFFTInPlace();
-  postVs_ ->invFFTInPlace();
-  postRho_->invFFTInPlace();
-
   for (l=0;l<ntheta_;l++)
     seisData_[l]->endAccess();
 
+  if (restore == true)
+    checkpoint_->Restore(Checkpoint::POSTERIOR, checkpointGrids);
+  else {
+    std::vector<FFTGrid *> postGrids(3);
+    postGrids[0] = postVp_;
+    postGrids[1] = postVs_;
+    postGrids[2] = postRho_;
+    FFTGrid::invFFTInPlaceAll(postGrids);
+
+    if (checkpoint_ != NULL)
+      checkpoint_->Save(Checkpoint::POSTERIOR, checkpointGrids, simbox_);
+  }
+
   //Finish use of seisData_, since we need the memory.
   if((outputGridsSeismic_ & IO::FOURIER_RESIDUAL) > 0)
   {
@@ -1342,6 +1469,8 @@ void
 AVOInversion::doPredictionKriging(SeismicParametersHolder & seismicParameters)
 {
   if(writePrediction_ == true) { //No need to do this if output not requested.
+    Profiler::Region region("Kriging");
+
     double wall2=0.0, cpu2=0.0;
     TimeKit::getTime(wall2,cpu2);
     doPostKriging(seismicParameters, *postVp_, *postVs_, *postRho_);
@@ -1358,6 +1487,8 @@ AVOInversion::simulate(SeismicParametersHolder & seismicParameters, RandomGen *
 {
   LogKit::WriteHeader("Simulating from posterior model");
 
+  Profiler::Region region("Simulation");
+
   double wall=0.0, cpu=0.0;
   TimeKit::getTime(wall,cpu);
 
@@ -1541,6 +1672,71 @@ AVOInversion::simulate(SeismicParametersHolder & seismicParameters, RandomGen *
   return(0);
 }
 
+void
+AVOInversion::addInputToFingerprint(SeismicParametersHolder & seismicParameters)
+{
+  // Everything the posterior distribution is computed from.
+  checkpoint_->AddToFingerprint(meanVp_);
+  checkpoint_->AddToFingerprint(meanVs_);
+  checkpoint_->AddToFingerprint(meanRho_);
+  checkpoint_->AddToFingerprint(seismicParameters.GetCovVp());
+  checkpoint_->AddToFingerprint(seismicParameters.GetCovVs());
+  checkpoint_->AddToFingerprint(seismicParameters.GetCovRho());
+  checkpoint_->AddToFingerprint(seismicParameters.GetCrCovVpVs());
+  checkpoint_->AddToFingerprint(seismicParameters.GetCrCovVpRho());
+  checkpoint_->AddToFingerprint(seismicParameters.GetCrCovVsRho());
+  checkpoint_->AddToFingerprint(errCorr_);
+
+  checkpoint_->AddToFingerprint(ntheta_);
+  for (int l = 0; l < ntheta_; l++) {
+    checkpoint_->AddToFingerprint(thetaDeg_[l]);
+    checkpoint_->AddToFingerprint(seisData_[l]);
+    checkpoint_->AddToFingerprint(seisWavelet_[l]);
+    for (int m = 0; m < ntheta_; m++)
+      checkpoint_->AddToFingerprint(errThetaCov_[l][m]);
+    for (int m = 0; m < 3; m++)
+      checkpoint_->AddToFingerprint(A_(l,m));
+  }
+
+  checkpoint_->AddToFingerprint(lowCut_);
+  checkpoint_->AddToFingerprint(highCut_);
+  checkpoint_->AddToFingerprint(wnc_);
+  checkpoint_->AddToFingerprint(simbox_->getlz());
+  checkpoint_->AddToFingerprint(simbox_->getMinRelThick());
+  checkpoint_->AddToFingerprint(simbox_->getIsConstantThick());
+}
+
+void
+AVOInversion::restoreSimulations(SeismicParametersHolder & seismicParameters)
+{
+  // The grids are copied by the holder, so they are kept in memory here.
+  std::vector<FFTGrid *> simulations(3*nSim_);
+  for (int i = 0; i < 3*nSim_; i++)
+    simulations[i] = new FFTGrid(nx_, ny_, nz_, nxp_, nyp_, nzp_);
+
+  checkpoint_->Restore(Checkpoint::SIMULATION, simulations);
+
+  for (int simNr = 0; simNr < nSim_; simNr++) {
+    seismicParameters.AddSimulationSeed0(simulations[3*simNr]);
+    seismicParameters.AddSimulationSeed1(simulations[3*simNr + 1]);
+    seismicParameters.AddSimulationSeed2(simulations[3*simNr + 2]);
+  }
+  for (int i = 0; i < 3*nSim_; i++)
+    delete simulations[i];
+}
+
+void
+AVOInversion::saveSimulations(SeismicParametersHolder & seismicParameters)
+{
+  std::vector<FFTGrid *> simulations;
+  for (int simNr = 0; simNr < nSim_; simNr++) {
+    simulations.push_back(seismicParameters.GetSimulationSeed0(simNr));
+    simulations.push_back(seismicParameters.GetSimulationSeed1(simNr));
+    simulations.push_back(seismicParameters.GetSimulationSeed2(simNr));
+  }
+  checkpoint_->Save(Checkpoint::SIMULATION, simulations, simbox_);
+}
+
 void
 AVOInversion::doPostKriging(SeismicParametersHolder & seismicParameters,
                             FFTGrid                 & postVp,
@@ -1719,6 +1915,8 @@ AVOInversion::computeFaciesProb(SpatialRealWellFilter             * filteredReal
   {
     LogKit::WriteHeader("Facies probability volumes");
 
+    Profiler::Region region("Facies probabilities");
+
     double wall=0.0, cpu=0.0;
     TimeKit::getTime(wall,cpu);
 
@@ -28,6 +28,7 @@ class SpatialWellFilter;
 class SeismicParametersHolder;
 class SpatialSyntWellFilter;
 class SpatialRealWellFilter;
+class Checkpoint;
 
 class BlockedLogsCommon;
 
@@ -39,7 +40,8 @@ public:
                ModelGeneral            * modelGeneral,
                ModelAVOStatic          * modelAVOstatic,
                ModelAVODynamic         * modelAVOdynamic,
-               SeismicParametersHolder & seismicParameters);
+               SeismicParametersHolder & seismicParameters,
+               Checkpoint              * checkpoint);
 
   ~AVOInversion();
 
@@ -76,6 +78,9 @@ private:
   float                  getDataVariance(int l)   const { return dataVariance_[l]   ;}
 
   int                simulate(SeismicParametersHolder & seismicParameters, RandomGen * randomGen );
+  void               restoreSimulations(SeismicParametersHolder & seismicParameters);
+  void               saveSimulations(SeismicParametersHolder & seismicParameters);
+  void               addInputToFingerprint(SeismicParametersHolder & seismicParameters);
   int                computePostMeanResidAndFFTCov(ModelGeneral * modelGeneral);
   void               printEnergyToScreen();
   void               computeFaciesProb(SpatialRealWellFilter             * filteredRealLogs,
@@ -102,13 +107,12 @@ private:
   void                   fillInverseAbskWRobust_flens(int k, NRLib::ComplexVector & invkW, Wavelet1D** seisWaveletForNorm);
   void                   fillkWNorm_flens(int k, NRLib::ComplexVector & kWNorm, Wavelet1D** wavelet);
 
-  void                   computeAdjustmentFactor(fftw_complex                  * relativeWeights,
-                                                 Wavelet1D                     * wLocal,
-                                                 double                          scaleF,
-                                                 Wavelet                       * wGlobal,
-                                                 const SeismicParametersHolder & seismicParameters,
-                                                 const float                         * A,
-                                                 float                           errorVar);
+  void                   computeAdjustmentFactor(fftw_complex       * relativeWeights,
+                                                 Wavelet1D          * wLocal,
+                                                 double               scaleF,
+                                                 const Wavelet      * wGlobal,
+                                                 const fftw_complex * rcSpecIntens,
+                                                 float                errorVar) const;
 
   FFTGrid              * createFFTGrid();
   FFTGrid              * copyFFTGrid(FFTGrid * fftGridOld);
@@ -214,7 +218,7 @@ private:
   ModelGeneral     * modelGeneral_;
   ModelAVOStatic   * modelAVOstatic_;
   ModelAVODynamic  * modelAVOdynamic_;
-
+  Checkpoint       * checkpoint_;       // NULL if no checkpoints are written or read
 
   NRLib::Grid2D<double **> * sigmamdnew_;
 };
@@ -27,6 +27,7 @@
 #include "src/covgrid2d.h"
 #include "src/krigingdata2d.h"
 #include "src/kriging2d.h"
+#include "src/krigingcache2d.h"
 #include "src/krigingdata3d.h"
 #include "src/covgridseparated.h"
 #include "src/fftgrid.h"
@@ -38,6 +39,7 @@
 void
 Background::SetupBackground(std::vector<NRLib::Grid<float> *>                & parameters,
                             std::vector<std::vector<double> >                & vertical_trends,
+                            std::vector<std::vector<double> >                & deviations,
                             NRLib::Grid<float>                               * velocity,
                             const Simbox                                     * simbox,
                             const Simbox                                     * bg_simbox,
@@ -67,6 +69,7 @@ Background::SetupBackground(std::vector<NRLib::Grid<float> *>                & p
   if (bg_simbox == NULL) {
     GenerateBackgroundModel(parameters[0], parameters[1], parameters[2],
                             vertical_trends,
+                            deviations,
                             velocity,
                             simbox,
                             blocked_logs,
@@ -77,6 +80,7 @@ Background::SetupBackground(std::vector<NRLib::Grid<float> *>                & p
   else {
     GenerateBackgroundModel(parameters[0], parameters[1], parameters[2],
                             vertical_trends,
+                            deviations,
                             velocity,
                             bg_simbox,
                             bg_blocked_logs,
@@ -105,6 +109,7 @@ Background::GenerateBackgroundModel(NRLib::Grid<float>
                                     NRLib::Grid<float>                               * bg_vs,
                                     NRLib::Grid<float>                               * bg_rho,
                                     std::vector<std::vector<double> >                & vertical_trends,
+                                    std::vector<std::vector<double> >                & deviations,
                                     NRLib::Grid<float>                               * velocity,
                                     const Simbox                                     * simbox,
                                     const std::map<std::string, BlockedLogsCommon *> & blocked_logs,
@@ -186,6 +191,7 @@ Background::GenerateBackgroundModel(NRLib::Grid<float>
                              high_cut_well_trend_rho,
                              name_rho);
 
+    deviations.assign(n_deviations, std::vector<double>());
     if (velocity->GetN() != 0) {
       //
       // We still want CalculateBackgroundTrend() for alpha above. By calculating
@@ -206,12 +212,22 @@ Background::GenerateBackgroundModel(NRLib::Grid<float>
       WriteDeviationsFromVerticalTrend(avg_dev_vel, avg_dev_vs, avg_dev_rho,
                                        trend_vel, trend_vs, trend_rho,
                                        blocked_logs, n_wells, nz);
+      deviations[0] = avg_dev_vel;
+      deviations[3] = trend_vel;
+      deviations[6] = avg_dev_vel;
+      deviations[7] = avg_dev_vp;
     }
     else {
       WriteDeviationsFromVerticalTrend(avg_dev_vp, avg_dev_vs, avg_dev_rho,
                                        trend_vp, trend_vs, trend_rho,
                                        blocked_logs, n_wells, nz);
+      deviations[0] = avg_dev_vp;
+      deviations[3] = trend_vp;
     }
+    deviations[1] = avg_dev_vs;
+    deviations[2] = avg_dev_rho;
+    deviations[4] = trend_vs;
+    deviations[5] = trend_rho;
 
     std::vector<KrigingData2D> kriging_data_vp(nz);
     std::vector<KrigingData2D> kriging_data_vs(nz);
@@ -338,12 +354,21 @@ Background::CalculateVelocityDeviations(NRLib::Grid<float>
   for (int k = 0; k < nz; k++)
     trend_vel[k] /= n_wells;
 
+  WriteVelocityDeviations(avg_dev_vel, avg_dev_vp, blocked_logs);
+}
+
+//---------------------------------------------------------------------------
+void
+Background::WriteVelocityDeviations(const std::vector<double>                        & avg_dev_vel,
+                                    const std::vector<double>                        & avg_dev_vp,
+                                    const std::map<std::string, BlockedLogsCommon *> & blocked_logs)
+{
   LogKit::LogFormatted(LogKit::Low,"\nAverage deviations of type well-log-Vp-minus-velocity-read-from-file and ");
   LogKit::LogFormatted(LogKit::Low,"\nwell-log-Vp-minus-estimated-Vp-trend (added for quality control):\n\n");
   LogKit::LogFormatted(LogKit::Low,"Well             TrendFromFile  TrendFromData\n");
   LogKit::LogFormatted(LogKit::Low,"---------------------------------------------\n");
 
-  w = 0;
+  int w = 0;
   for (std::map<std::string, BlockedLogsCommon *>::const_iterator it = blocked_logs.begin(); it != blocked_logs.end(); it++) {
     std::map<std::string, BlockedLogsCommon *>::const_iterator iter = blocked_logs.find(it->first);
     LogKit::LogFormatted(LogKit::Low,"%-24s %5.1f          %5.1f\n",
@@ -353,6 +378,25 @@ Background::CalculateVelocityDeviations(NRLib::Grid<float>
   }
 }
 
+//---------------------------------------------------------------------------
+void
+Background::WriteDeviations(const std::vector<std::vector<double> >        & deviations,
+                            const std::map<std::string, BlockedLogsCommon *> & blocked_logs)
+{
+  //
+  // The layout is that of GenerateBackgroundModel(). The last two vectors
+  // are only set when the background is made from a velocity field.
+  //
+  if (deviations[6].size() > 0)
+    WriteVelocityDeviations(deviations[6], deviations[7], blocked_logs);
+
+  WriteDeviationsFromVerticalTrend(deviations[0], deviations[1], deviations[2],
+                                   deviations[3], deviations[4], deviations[5],
+                                   blocked_logs,
+                                   static_cast<int>(blocked_logs.size()),
+                                   static_cast<int>(deviations[3].size()));
+}
+
 //---------------------------------------------------------------------------
 void
 Background::CalculateBackgroundTrend(std::vector<double>               & trend,
@@ -708,6 +752,12 @@ Background::MakeKrigedBackground(const std::vector<KrigingData2D> & kriging_data
     << "\n  |    |    |    |    |    |    |    |    |    |    |  "
     << "\n  ^";
 
+  //
+  // Factorize the kriging matrices once for layers sharing data locations
+  //
+  KrigingCache2D cache(kriging_data, cov_grid_2D, n_threads);
+  LogKit::LogFormatted(LogKit::DebugLow,"\n  Kriging matrices factorized: %d of %d layers.", cache.GetNumberOfFactorizations(), nz);
+
   bg_grid->Resize(nx, ny, nz);
 #ifdef PARALLEL
   int  chunk_size = 1;
@@ -719,7 +769,7 @@ Background::MakeKrigedBackground(const std::vector<KrigingData2D> & kriging_data
     surfaces[k].Assign(trend[k]);
 
     // Kriging of layer
-    Kriging2D::krigSurface(surfaces[k], kriging_data[k], cov_grid_2D);
+    Kriging2D::krigSurface(surfaces[k], kriging_data[k], cov_grid_2D, false, &cache, k);
 
     // Log progress
     if (k+1 >= static_cast<int>(next_monitor)) {
@@ -31,6 +31,7 @@ public:
   static
   void SetupBackground(std::vector<NRLib::Grid<float> *>                & parameters,
                        std::vector<std::vector<double> >                & vertical_trends,
+                       std::vector<std::vector<double> >                & deviations,
                        NRLib::Grid<float>                               * velocity,
                        const Simbox                                     * time_simbox,
                        const Simbox                                     * time_bg_simbox,
@@ -54,6 +55,15 @@ public:
                                  const Simbox       *  simbox_new,
                                  const Simbox       *  simbox_old);
 
+  // Logs the quality control tables of SetupBackground() from the deviations
+  // it returned, for a background model that is not computed again.
+  static
+  void         WriteDeviations(const std::vector<std::vector<double> >        & deviations,
+                               const std::map<std::string, BlockedLogsCommon *> & blocked_logs);
+
+  // Number of vectors returned as deviations from SetupBackground().
+  static const int n_deviations = 8;
+
 
 private:
 
@@ -62,6 +72,7 @@ private:
                                        NRLib::Grid<float>                               * bg_vs,
                                        NRLib::Grid<float>                               * bg_rho,
                                        std::vector<std::vector<double> >                & vertical_trends,
+                                       std::vector<std::vector<double> >                & deviations,
                                        NRLib::Grid<float>                               * velociy,
                                        const Simbox                                     * simbox,
                                        const std::map<std::string, BlockedLogsCommon *> & blocked_logs,
@@ -209,6 +220,10 @@ private:
                                                 const int                                          n_wells,
                                                 const int                                          nz);
 
+  static
+  void         WriteVelocityDeviations(const std::vector<double>                        & avg_dev_vel,
+                                       const std::vector<double>                        & avg_dev_vp,
+                                       const std::map<std::string, BlockedLogsCommon *> & blocked_logs);
 
   static
   void         SmoothTrendWithLocalLinearRegression(std::vector<double> & trend,
@@ -2331,9 +2331,7 @@ void BlockedLogsCommon::FindOptimalWellLocation(std::vector<SeismicStorage *> &
   int   polarity;
   int   i,j,k,l,m;
   int   start, length;
-  float sum;
   float shift_F;
-  float max_tot;
   float f1,f2,f3;
 
   int nx              = estimation_simbox->getnx();
@@ -2344,43 +2342,20 @@ void BlockedLogsCommon::FindOptimalWellLocation(std::vector<SeismicStorage *> &
   int rnzp            = 2*cnzp;
   int i_tot_offset    = 2*i_max_offset+1;
   int j_tot_offset    = 2*j_max_offset+1;
-  int polarityMax     = 0;
   float shift         = 0.0f;
   float max_value_tot = 0;
   float total_weight  = 0;
   float dz            = static_cast<float>(estimation_simbox->getdz());
 
   std::vector<double> seis_log(n_blocks_);
-  std::vector<double> seis_data(n_layers_);
   std::vector<double> vp_vert(n_layers_);
   std::vector<double> vs_vert(n_layers_);
   std::vector<double> rho_vert(n_layers_);
 
   std::vector<int>   i_offset(i_tot_offset);
   std::vector<int>   j_offset(j_tot_offset);
-  std::vector<int>   shift_I(n_angles);
-  std::vector<int>   shift_I_max(n_angles);
-  std::vector<float> max_value(n_angles);
-  std::vector<float> max_value_max(n_angles);
-
-  fftw_real    ** cpp_r               = new fftw_real*[n_angles];
-  fftw_complex ** cpp_c               = reinterpret_cast<fftw_complex**>(cpp_r);
-
-  fftw_real    ** cor_cpp_r           = new fftw_real*[n_angles];
-  fftw_complex ** cor_cpp_c           = reinterpret_cast<fftw_complex**>(cor_cpp_r);
-
-  fftw_real    ** seis_r              = new fftw_real*[n_angles];
-  fftw_complex ** seis_c              = reinterpret_cast<fftw_complex**>(seis_r);
-
-  fftw_real    ** ccor_seis_cpp_r     = new fftw_real*[n_angles];
-  fftw_complex ** ccor_seis_cpp_c     = reinterpret_cast<fftw_complex**>(ccor_seis_cpp_r);
-
-  fftw_real    ** ccor_seis_cpp_Max_r = new fftw_real*[n_angles];
-
-  for (i=0; i < n_angles; i++) {
-    max_value_max[i] = 0.0f;
-    shift_I_max[i]   = 0;
-  }
+  std::vector<int>   shift_I(n_angles, 0);
+  std::vector<float> max_value(n_angles, 0.0f);
 
   // make offset vectors
   for (i=-i_max_offset; i < i_max_offset+1; i++) {
@@ -2400,35 +2375,22 @@ void BlockedLogsCommon::FindOptimalWellLocation(std::vector<SeismicStorage *> &
   }
   FindContinuousPartOfData(has_data, n_layers_, start, length);
 
+  // Calculate reflection coefficients. The traces of all angles are stored
+  // one after another, so they can be transformed together.
+  std::vector<fftw_real> cpp_r(n_angles*rnzp, 0.0f);
   for ( j=0; j<n_angles; j++ ) {
-    seis_r[j]              = new fftw_real[rnzp];
-    cpp_r[j]               = new fftw_real[rnzp];
-    cor_cpp_r[j]           = new fftw_real[rnzp];
-    ccor_seis_cpp_r[j]     = new fftw_real[rnzp];
-    ccor_seis_cpp_Max_r[j] = new fftw_real[rnzp];
-  }
-
-  // Calculate reflection coefficients
-  for ( j=0; j<n_angles; j++ ) {
-    for (i=0; i<rnzp; i++) {
-      cpp_r[j][i] = 0;
-    }
-    float * refl_coefficients = new float[3];
+    float refl_coefficients[3];
     refl_coefficients[0] = static_cast<float>(refl_matrix(j,0));
     refl_coefficients[1] = static_cast<float>(refl_matrix(j,1));
     refl_coefficients[2] = static_cast<float>(refl_matrix(j,2));
-    FillInCpp(refl_coefficients,start,length,cpp_r[j],nzp);
-    Utils::fft(cpp_r[j],cpp_c[j],nzp);
-    EstimateCor(cpp_c[j],cpp_c[j],cor_cpp_c[j],cnzp);
-    Utils::fftInv(cor_cpp_c[j],cor_cpp_r[j],nzp);
-    delete [] refl_coefficients;
+    FillInCpp(refl_coefficients,start,length,&cpp_r[j*rnzp],nzp);
   }
+  Utils::fftMany(&cpp_r[0], nzp, n_angles);
 
   std::vector<NRLib::Grid<float> > seis_cube_small(n_angles,NRLib::Grid<float> (i_tot_offset,j_tot_offset,n_blocks_));
 
   for (j = 0 ; j < n_angles ; j++)
   {
-    //seismic_data[j]->setAccessMode(FFTGrid::RANDOMACCESS);
     for (k = 0; k < i_tot_offset; k++)
     {
       for (l = 0; l < j_tot_offset; l++)
@@ -2440,10 +2402,14 @@ void BlockedLogsCommon::FindOptimalWellLocation(std::vector<SeismicStorage *> &
         }
       }
     }
-    //seis_cube[j]->endAccess();
   }
 
-  // Loop through possible well locations
+  //
+  // Possible well locations, in the order they used to be searched.
+  //
+  std::vector<int>   candidate_k;
+  std::vector<int>   candidate_l;
+  std::vector<float> candidate_dz;
   for (k=0; k<i_tot_offset; k++) {
     int i_index = i_pos_[0]+i_offset[k];
     if (i_index<0 || i_index>nx-1) //Check if position is within seismic range
@@ -2459,95 +2425,78 @@ void BlockedLogsCommon::FindOptimalWellLocation(std::vector<SeismicStorage *> &
         if (inversion_simbox.isInside(xp, yp) == false)
           continue;
       }
+      candidate_k.push_back(k);
+      candidate_l.push_back(l);
+      candidate_dz.push_back(static_cast<float>(estimation_simbox->getRelThick(i_index,j_index)*estimation_simbox->getdz()));
+    }
+  }
 
-      for (j = 0; j < n_angles; j++) {
-
-        for (m=0; m<static_cast<int>(n_blocks_); m++)
-          seis_log[m] = seis_cube_small[j](k,l,m);
-
-        GetVerticalTrend(seis_log, seis_data);
-        FillInSeismic(seis_data,start,length,seis_r[j],nzp);
-
-        Utils::fft(seis_r[j],seis_c[j],nzp);
-        EstimateCor(seis_c[j],cpp_c[j],ccor_seis_cpp_c[j],cnzp);
-        Utils::fftInv(ccor_seis_cpp_c[j],ccor_seis_cpp_r[j],nzp);
-      }
+  //
+  // Find the weighted total maximum correlation at each location. The
+  // locations are independent and are searched concurrently.
+  //
+  int                n_candidates = static_cast<int>(candidate_k.size());
+  std::vector<float> candidate_max_tot(n_candidates, 0.0f);
 
-      // if the sum from -max_shift to max_shift ms is
-      // positive then polarity is positive
-      dz = static_cast<float>(estimation_simbox->getRelThick(i_index,j_index)*estimation_simbox->getdz());
-      sum = 0;
-      for ( j=0; j<n_angles; j++ ) {
-        if (angle_weight[j] > 0) {
-          for (i=0;i<ceil(max_shift/dz);i++)//zero included
-            sum+=ccor_seis_cpp_r[j][i];
-          for (i=0;i<floor(max_shift/dz);i++)
-            sum+=ccor_seis_cpp_r[j][nzp-i-1];
-        }
-      }
-      polarity=-1;
-      if (sum > 0)
-        polarity=1;
-
-      // Find maximum correlation and corresponding shift for each angle
-      max_tot = 0.0;
-      for ( j=0; j<n_angles; j++ ) {
-        if (angle_weight[j]>0) {
-          max_value[j] = 0.0f;
-          shift_I[j]=0;
-          for (i=0;i<ceil(max_shift/dz);i++) {
-            if (ccor_seis_cpp_r[j][i]*polarity > max_value[j]) {
-              max_value[j] = ccor_seis_cpp_r[j][i]*polarity;
-              shift_I[j] = i;
-            }
-          }
-          for (i=0;i<floor(max_shift/dz);i++) {
-            if (ccor_seis_cpp_r[j][nzp-1-i]*polarity > max_value[j]) {
-              max_value[j] = ccor_seis_cpp_r[j][nzp-1-i]*polarity;
-              shift_I[j] = -1-i;
-            }
-          }
-          max_tot += angle_weight[j]*max_value[j]; //Find weighted total maximum correlation
-        }
-      }
+#ifdef PARALLEL
+  int n_threads = FFTGrid::getNumberOfThreads();
+#pragma omp parallel num_threads(n_threads)
+#endif
+  {
+    std::vector<fftw_real> ccor_seis_cpp_r(n_angles*rnzp);
+    std::vector<int>       shift_I_c(n_angles);
+    std::vector<float>     max_value_c(n_angles);
+    int                    polarity_c;
+
+#ifdef PARALLEL
+#pragma omp for schedule(dynamic, 1)
+#endif
+    for (int c = 0; c < n_candidates; c++) {
+      candidate_max_tot[c] = CorrelateAtWellLocation(seis_cube_small, candidate_k[c], candidate_l[c], start, length, nzp,
+                                                     candidate_dz[c], max_shift, angle_weight, &cpp_r[0],
+                                                     &ccor_seis_cpp_r[0], shift_I_c, max_value_c, polarity_c);
+    }
+  }
 
-      if (max_tot > max_value_tot) {
-        max_value_tot = max_tot;
-        polarityMax = polarity;
-        i_move       = i_offset[k];
-        j_move       = j_offset[l];
-        for (m=0; m<n_angles; m++) {
-          shift_I_max[m]   = shift_I[m];
-          max_value_max[m] = max_value[m];
-          for (i=0;i<rnzp;i++)
-            ccor_seis_cpp_Max_r[m][i] = ccor_seis_cpp_r[m][i];
-        }
-      }
+  // The first location with the highest correlation is chosen.
+  int best = -1;
+  for (int c = 0; c < n_candidates; c++) {
+    if (candidate_max_tot[c] > max_value_tot) {
+      max_value_tot = candidate_max_tot[c];
+      best          = c;
     }
   }
 
-  for (i=0; i<n_angles; i++) {
-    shift_I[i] = shift_I_max[i];
-    max_value[i] = max_value_max[i];
-    for (j=0;j<rnzp;j++)
-      ccor_seis_cpp_r[i][j] = ccor_seis_cpp_Max_r[i][j];
+  std::vector<fftw_real> ccor_seis_cpp_r(n_angles*rnzp, 0.0f);
+  polarity = 0;
+  if (best >= 0) {
+    i_move = i_offset[candidate_k[best]];
+    j_move = j_offset[candidate_l[best]];
+    CorrelateAtWellLocation(seis_cube_small, candidate_k[best], candidate_l[best], start, length, nzp,
+                            candidate_dz[best], max_shift, angle_weight, &cpp_r[0],
+                            &ccor_seis_cpp_r[0], shift_I, max_value, polarity);
   }
-  polarity = polarityMax;
+
+  // As in the sequential search, the shift is scaled with the cell
+  // thickness of the last location searched.
+  if (n_candidates > 0)
+    dz = candidate_dz[n_candidates - 1];
 
   // Find kMove in optimal location
   for (j=0; j<n_angles; j++) {
     if (angle_weight[j]>0) {
+      const fftw_real * ccor = &ccor_seis_cpp_r[j*rnzp];
       if (shift_I[j] < 0) {
-        if (ccor_seis_cpp_r[j][nzp+shift_I[j]-1]*polarity < max_value[j]) //then local max
+        if (ccor[nzp+shift_I[j]-1]*polarity < max_value[j]) //then local max
         {
-          f1 = ccor_seis_cpp_r[j][nzp+shift_I[j]-1];
-          f2 = ccor_seis_cpp_r[j][nzp+shift_I[j]];
+          f1 = ccor[nzp+shift_I[j]-1];
+          f2 = ccor[nzp+shift_I[j]];
           int ind3;
           if (shift_I[j]==-1)
             ind3 = 0;
           else
             ind3=nzp+shift_I[j]+1;
-          f3 = ccor_seis_cpp_r[j][ind3];
+          f3 = ccor[ind3];
           float x0=(f1-f3)/(2*(f1+f3-2*f2));
           shift_F=shift_I[j]+x0;
         }
@@ -2556,16 +2505,16 @@ void BlockedLogsCommon::FindOptimalWellLocation(std::vector<SeismicStorage *> &
       }
       else //positive or zero shift
       {
-        if (ccor_seis_cpp_r[j][shift_I[j]+1]*polarity < max_value[j]) //then local max
+        if (ccor[shift_I[j]+1]*polarity < max_value[j]) //then local max
         {
-          f3 = ccor_seis_cpp_r[j][shift_I[j]+1];
-          f2 = ccor_seis_cpp_r[j][shift_I[j]];
+          f3 = ccor[shift_I[j]+1];
+          f2 = ccor[shift_I[j]];
           int ind1;
           if (shift_I[j]==0)
             ind1 = nzp-1;
           else
             ind1=shift_I[j]-1;
-          f1 = ccor_seis_cpp_r[j][ind1];
+          f1 = ccor[ind1];
           float x0=(f1-f3)/(2*(f1+f3-2*f2));
           shift_F=shift_I[j]+x0;
         }
@@ -2579,21 +2528,94 @@ void BlockedLogsCommon::FindOptimalWellLocation(std::vector<SeismicStorage *> &
 
   shift/=total_weight;
   k_move = shift;
+}
 
-  for ( j=0; j<n_angles; j++ ) {
-    delete [] ccor_seis_cpp_Max_r[j];
-    delete [] ccor_seis_cpp_r[j];
-    delete [] cor_cpp_r[j];
-    delete [] seis_r[j];
-    delete [] cpp_r[j];
+float BlockedLogsCommon::CorrelateAtWellLocation(const std::vector<NRLib::Grid<float> > & seis_cube_small,
+                                                 int                                      k,
+                                                 int                                      l,
+                                                 int                                      start,
+                                                 int                                      length,
+                                                 int                                      nzp,
+                                                 float                                    dz,
+                                                 float                                    max_shift,
+                                                 const std::vector<float>               & angle_weight,
+                                                 fftw_real                              * cpp_r,
+                                                 fftw_real                              * ccor_seis_cpp_r,
+                                                 std::vector<int>                       & shift_I,
+                                                 std::vector<float>                     & max_value,
+                                                 int                                    & polarity) const
+{
+  //
+  // Cross correlations between the seismic at lateral offset (k,l) and
+  // the reflection coefficients, for all angles. The Fourier transformed
+  // reflection coefficients cpp_r and the correlations are stored one angle
+  // after another. Returns the weighted total maximum correlation.
+  //
+  int i,j,m;
+  int n_angles = static_cast<int>(seis_cube_small.size());
+  int cnzp     = nzp/2+1;
+  int rnzp     = 2*cnzp;
+
+  std::vector<double>    seis_log(n_blocks_);
+  std::vector<double>    seis_data(n_layers_);
+  std::vector<fftw_real> seis_r(n_angles*rnzp);
+
+  for (j = 0; j < n_angles; j++) {
+    for (m=0; m<static_cast<int>(n_blocks_); m++)
+      seis_log[m] = seis_cube_small[j](k,l,m);
+
+    GetVerticalTrend(seis_log, seis_data);
+    FillInSeismic(seis_data,start,length,&seis_r[j*rnzp],nzp);
   }
 
+  Utils::fftMany(&seis_r[0], nzp, n_angles);
+  for (j = 0; j < n_angles; j++) {
+    EstimateCor(reinterpret_cast<fftw_complex*>(&seis_r[j*rnzp]),
+                reinterpret_cast<fftw_complex*>(cpp_r + j*rnzp),
+                reinterpret_cast<fftw_complex*>(ccor_seis_cpp_r + j*rnzp),
+                cnzp);
+  }
+  Utils::fftInvMany(ccor_seis_cpp_r, nzp, n_angles);
 
-  delete [] ccor_seis_cpp_Max_r;
-  delete [] ccor_seis_cpp_r;
-  delete [] cor_cpp_r;
-  delete [] seis_r;
-  delete [] cpp_r;
+  // if the sum from -max_shift to max_shift ms is
+  // positive then polarity is positive
+  float sum = 0;
+  for ( j=0; j<n_angles; j++ ) {
+    if (angle_weight[j] > 0) {
+      const fftw_real * ccor = ccor_seis_cpp_r + j*rnzp;
+      for (i=0;i<ceil(max_shift/dz);i++)//zero included
+        sum+=ccor[i];
+      for (i=0;i<floor(max_shift/dz);i++)
+        sum+=ccor[nzp-i-1];
+    }
+  }
+  polarity=-1;
+  if (sum > 0)
+    polarity=1;
+
+  // Find maximum correlation and corresponding shift for each angle
+  float max_tot = 0.0;
+  for ( j=0; j<n_angles; j++ ) {
+    if (angle_weight[j]>0) {
+      const fftw_real * ccor = ccor_seis_cpp_r + j*rnzp;
+      max_value[j] = 0.0f;
+      shift_I[j]=0;
+      for (i=0;i<ceil(max_shift/dz);i++) {
+        if (ccor[i]*polarity > max_value[j]) {
+          max_value[j] = ccor[i]*polarity;
+          shift_I[j] = i;
+        }
+      }
+      for (i=0;i<floor(max_shift/dz);i++) {
+        if (ccor[nzp-1-i]*polarity > max_value[j]) {
+          max_value[j] = ccor[nzp-1-i]*polarity;
+          shift_I[j] = -1-i;
+        }
+      }
+      max_tot += angle_weight[j]*max_value[j]; //Find weighted total maximum correlation
+    }
+  }
+  return max_tot;
 }
 
 void BlockedLogsCommon::GetVerticalTrendLimited(const std::vector<double>          & log,
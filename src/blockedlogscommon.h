@@ -355,6 +355,21 @@ private:
 
   // FUNCTIONS------------------------------------
 
+  float                                  CorrelateAtWellLocation(const std::vector<NRLib::Grid<float> > & seis_cube_small,
+                                                                 int                                      k,
+                                                                 int                                      l,
+                                                                 int                                      start,
+                                                                 int                                      length,
+                                                                 int                                      nzp,
+                                                                 float                                    dz,
+                                                                 float                                    max_shift,
+                                                                 const std::vector<float>               & angle_weight,
+                                                                 fftw_real                              * cpp_r,
+                                                                 fftw_real                              * ccor_seis_cpp_r,
+                                                                 std::vector<int>                       & shift_I,
+                                                                 std::vector<float>                     & max_value,
+                                                                 int                                    & polarity) const;
+
   void                                   InterpolateTrend(const double                    * blocked_log,
                                                           double                          * trend) const;
 
@@ -0,0 +1,253 @@
+/***************************************************************************
+*      Copyright (C) 2008 by Norwegian Computing Center and Statoil        *
+***************************************************************************/
+
+#include <fstream>
+#include <sstream>
+
+#include "nrlib/exception/exception.hpp"
+#include "nrlib/iotools/fileio.hpp"
+#include "nrlib/iotools/logkit.hpp"
+#include "nrlib/iotools/stringtools.hpp"
+
+#include "lib/random.h"
+
+#include "src/checkpoint.h"
+#include "src/fftgrid.h"
+#include "src/wavelet.h"
+#include "src/io.h"
+
+Checkpoint::Checkpoint(const std::string & name,
+                       bool                write,
+                       bool                restart,
+                       RandomGen         * random_gen)
+  : name_(name),
+    write_(write),
+    restart_(restart),
+    random_gen_(random_gen)
+{
+  manifest_ = IO::makeFullFileName(IO::PathToCheckpoints(), name_ + IO::SuffixTextFiles());
+}
+
+void
+Checkpoint::AddToFingerprint(const void * data,
+                             size_t       n_bytes)
+{
+  fingerprint_.Add(data, n_bytes);
+}
+
+void
+Checkpoint::AddToFingerprint(FFTGrid * grid)
+{
+  // Only the inner grid is used. The padding is made from it, and the
+  // row ends of an in-place FFT grid are never set.
+  int nx = grid->getNx();
+  int ny = grid->getNy();
+  int nz = grid->getNz();
+  AddToFingerprint(nx);
+  AddToFingerprint(ny);
+  AddToFingerprint(nz);
+  AddToFingerprint(grid->getNxp());
+  AddToFingerprint(grid->getNyp());
+  AddToFingerprint(grid->getNzp());
+
+  std::vector<float> trace(nz);
+  grid->setAccessMode(FFTGrid::RANDOMACCESS);
+  for (int j = 0 ; j < ny ; j++) {
+    for (int i = 0 ; i < nx ; i++) {
+      for (int k = 0 ; k < nz ; k++)
+        trace[k] = grid->getRealValue(i, j, k);
+      AddToFingerprint(&trace[0], nz*sizeof(float));
+    }
+  }
+  grid->endAccess();
+}
+
+void
+Checkpoint::AddToFingerprint(Wavelet * wavelet)
+{
+  AddToFingerprint(wavelet->getNzp());
+  AddToFingerprint(wavelet->getScale());
+  AddToFingerprint(wavelet->getNorm());
+  AddToFingerprint(wavelet->getIsReal());
+
+  // The amplitudes are taken in the domain the wavelet is in. Taking the
+  // real amplitudes of a transformed wavelet transforms it back and forth.
+  int nzp = wavelet->getNzp();
+  if (wavelet->getIsReal()) {
+    for (int k = 0 ; k < nzp ; k++)
+      AddToFingerprint(wavelet->getRAmp(k));
+  }
+  else {
+    for (int k = 0 ; k < nzp/2 + 1 ; k++) {
+      fftw_complex c = wavelet->getCAmp(k);
+      AddToFingerprint(c.re);
+      AddToFingerprint(c.im);
+    }
+  }
+}
+
+std::string
+Checkpoint::GetPhaseName(int phase) const
+{
+  if (phase == POSTERIOR)
+    return "posterior";
+  return "simulation";
+}
+
+std::string
+Checkpoint::GetGridFileName(int phase,
+                            int grid) const
+{
+  std::string base_name = name_ + "_" + GetPhaseName(phase) + "_" + NRLib::ToString(grid);
+  return IO::makeFullFileName(IO::PathToCheckpoints(), base_name);
+}
+
+std::string
+Checkpoint::GetFingerprint(void) const
+{
+  return fingerprint_.GetHexString();
+}
+
+void
+Checkpoint::ReadManifest(std::vector<Entry> & entries) const
+{
+  entries.clear();
+  if (!NRLib::FileExists(manifest_))
+    return;
+
+  std::ifstream file;
+  NRLib::OpenRead(file, manifest_);
+  std::string line;
+  while (std::getline(file, line)) {
+    // Lines not holding a complete entry are skipped, and the phase is computed again.
+    std::istringstream line_stream(line);
+    std::string phase_name;
+    Entry       entry;
+    if (line_stream >> phase_name >> entry.fingerprint >> entry.n_grids >> entry.seed) {
+      entry.phase = (phase_name == GetPhaseName(POSTERIOR) ? POSTERIOR : SIMULATION);
+      entries.push_back(entry);
+    }
+  }
+  file.close();
+}
+
+void
+Checkpoint::WriteManifest(const std::vector<Entry> & entries) const
+{
+  // A run killed while writing never leaves a half-written manifest behind.
+  TemporaryFile tmp_file(manifest_);
+  std::ofstream file;
+  NRLib::OpenWrite(file, tmp_file.GetName());
+  for (size_t e = 0 ; e < entries.size() ; e++)
+    file << GetPhaseName(entries[e].phase) << " " << entries[e].fingerprint << " " << entries[e].n_grids << " " << entries[e].seed << "\n";
+  bool ok = static_cast<bool>(file);
+  file.close();
+  if (!ok)
+    throw NRLib::IOError("Could not write checkpoint manifest " + tmp_file.GetName());
+
+  tmp_file.Commit();
+}
+
+bool
+Checkpoint::CanRestore(Phase phase,
+                       int   n_grids) const
+{
+  if (!restart_)
+    return false;
+
+  std::vector<Entry> entries;
+  ReadManifest(entries);
+
+  for (size_t e = 0 ; e < entries.size() ; e++) {
+    if (entries[e].phase != phase)
+      continue;
+    if (entries[e].fingerprint != GetFingerprint()) {
+      LogKit::LogFormatted(LogKit::Warning,"\nWARNING: The input has changed since the %s checkpoint of %s was written. The phase is computed again.\n",
+                           GetPhaseName(phase).c_str(), name_.c_str());
+      return false;
+    }
+    if (entries[e].n_grids != n_grids) {
+      LogKit::LogFormatted(LogKit::Warning,"\nWARNING: The %s checkpoint of %s has %d grids where %d are needed. The phase is computed again.\n",
+                           GetPhaseName(phase).c_str(), name_.c_str(), entries[e].n_grids, n_grids);
+      return false;
+    }
+    for (int i = 0 ; i < n_grids ; i++) {
+      if (!NRLib::FileExists(GetGridFileName(phase, i) + IO::SuffixCrava())) {
+        LogKit::LogFormatted(LogKit::Warning,"\nWARNING: The %s checkpoint of %s is incomplete. The phase is computed again.\n",
+                             GetPhaseName(phase).c_str(), name_.c_str());
+        return false;
+      }
+    }
+    return true;
+  }
+  return false;
+}
+
+void
+Checkpoint::Restore(Phase                          phase,
+                    const std::vector<FFTGrid *> & grids) const
+{
+  LogKit::LogFormatted(LogKit::Low,"\nRestarting from the %s checkpoint of %s.\n", GetPhaseName(phase).c_str(), name_.c_str());
+
+  std::vector<Entry> entries;
+  ReadManifest(entries);
+  for (size_t e = 0 ; e < entries.size() ; e++) {
+    if (entries[e].phase == phase)
+      random_gen_->setCurrentSeed(entries[e].seed);
+  }
+
+  std::string err_text;
+  for (size_t i = 0 ; i < grids.size() ; i++)
+    grids[i]->readCravaFile(GetGridFileName(phase, static_cast<int>(i)) + IO::SuffixCrava(), err_text);
+
+  // Some grids may already be overwritten, so there is no way back.
+  if (err_text != "")
+    throw NRLib::Exception("Could not read the " + GetPhaseName(phase) + " checkpoint of " + name_ + ":\n" + err_text
+                           + "Remove the directory " + IO::PathToCheckpoints() + " and run again.");
+}
+
+void
+Checkpoint::Save(Phase                          phase,
+                 const std::vector<FFTGrid *> & grids,
+                 const Simbox                 * simbox) const
+{
+  if (!write_)
+    return;
+
+  LogKit::LogFormatted(LogKit::Low,"\nWriting %s checkpoint of %s ...", GetPhaseName(phase).c_str(), name_.c_str());
+
+  //
+  // The grids of this and later phases are about to be overwritten, so
+  // these phases are dropped from the manifest first.
+  //
+  std::vector<Entry> entries;
+  ReadManifest(entries);
+  std::vector<Entry> kept;
+  for (size_t e = 0 ; e < entries.size() ; e++) {
+    if (entries[e].phase < phase)
+      kept.push_back(entries[e]);
+  }
+  WriteManifest(kept);
+
+  bool ok = true;
+  for (size_t i = 0 ; i < grids.size() && ok ; i++)
+    ok = grids[i]->writeCravaFile(GetGridFileName(phase, static_cast<int>(i)), simbox);
+
+  // A phase is only recorded once all its grids are safely on disk.
+  if (!ok) {
+    LogKit::LogFormatted(LogKit::Warning,"\nWARNING: The %s checkpoint of %s could not be written. A restart will compute the phase again.\n",
+                         GetPhaseName(phase).c_str(), name_.c_str());
+    return;
+  }
+
+  Entry entry;
+  entry.phase       = phase;
+  entry.fingerprint = GetFingerprint();
+  entry.n_grids     = static_cast<int>(grids.size());
+  entry.seed        = random_gen_->getCurrentSeed();
+  kept.push_back(entry);
+  WriteManifest(kept);
+
+  LogKit::LogFormatted(LogKit::Low,"\n");
+}
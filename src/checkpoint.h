@@ -0,0 +1,105 @@
+/***************************************************************************
+*      Copyright (C) 2008 by Norwegian Computing Center and Statoil        *
+***************************************************************************/
+
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <string>
+#include <vector>
+
+#include "src/fingerprint.h"
+
+class FFTGrid;
+class RandomGen;
+class Simbox;
+class Wavelet;
+
+//
+// Checkpoints of the AVO inversion of one interval and vintage.
+//
+// After each phase of the inversion, the grids making up the state are
+// written as CRAVA files to the checkpoints directory, and the phase is
+// recorded in a manifest together with a fingerprint of everything the
+// phase depends on. The fingerprint is built from the inversion input
+// (background, prior covariance, wavelets, seismic data and settings)
+// before the first phase, and extended with the extra input of each later
+// phase. A later run restarting from the checkpoints only reads a phase
+// back if its fingerprint is unchanged; otherwise the phase is computed
+// again as in a run without checkpoints.
+//
+// Only the products of the inversion are checkpointed. The background
+// model and the wavelets are made by CommonData in every run, and enter
+// the fingerprint instead. Facies probabilities and the output grids are
+// made again from the restored phases.
+//
+// The state of the random generator after each phase is recorded as
+// well, so that a run restarting from a phase draws the same numbers
+// afterwards as a run computing the phase.
+//
+class Checkpoint
+{
+public:
+  enum Phase { POSTERIOR = 0, SIMULATION = 1 };
+
+  Checkpoint(const std::string & name,
+             bool                write,
+             bool                restart,
+             RandomGen         * random_gen);
+
+  void                     AddToFingerprint(const void * data,
+                                            size_t       n_bytes);
+
+  void                     AddToFingerprint(FFTGrid * grid);
+
+  // Only for 1D wavelets. The filter of a 3D wavelet is not included.
+  void                     AddToFingerprint(Wavelet * wavelet);
+
+  template <class T>
+  void                     AddToFingerprint(const T & value) { AddToFingerprint(&value, sizeof(T)) ;}
+
+  // True if the phase was completed with the current fingerprint and n_grids grids.
+  bool                     CanRestore(Phase phase,
+                                      int   n_grids) const;
+
+  // Reads the grids of a phase back into allocated grids of the right size,
+  // and sets the random generator to where the phase left it.
+  void                     Restore(Phase                          phase,
+                                   const std::vector<FFTGrid *> & grids) const;
+
+  // Writes the grids of a phase and records the phase as completed.
+  void                     Save(Phase                          phase,
+                                const std::vector<FFTGrid *> & grids,
+                                const Simbox                 * simbox) const;
+
+  bool                     GetWrite(void) const { return write_ ;}
+
+private:
+  struct Entry
+  {
+    int                    phase;
+    std::string            fingerprint;
+    int                    n_grids;
+    unsigned int           seed;             ///< Seed of the random generator after the phase
+  };
+
+  std::string              GetPhaseName(int phase) const;
+
+  std::string              GetGridFileName(int phase,
+                                           int grid) const;
+
+  std::string              GetFingerprint(void) const;
+
+  void                     ReadManifest(std::vector<Entry> & entries) const;
+
+  void                     WriteManifest(const std::vector<Entry> & entries) const;
+
+  std::string              name_;
+  std::string              manifest_;
+  bool                     write_;
+  bool                     restart_;
+  RandomGen              * random_gen_;
+  Fingerprint              fingerprint_;     ///< Hash of the input added so far
+};
+
+#endif
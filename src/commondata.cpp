@@ -18,6 +18,8 @@
 
 #include "lib/timekit.hpp"
 #include "src/timings.h"
+#include "src/profiler.h"
+#include "src/preprocessingcache.h"
 
 CommonData::CommonData(ModelSettings * model_settings,
                        InputFiles    * input_files):
@@ -750,6 +752,8 @@ bool CommonData::ReadSeismicData(ModelSettings                               * m
                                  std::string                                 & err_text_common,
                                  std::vector<std::vector<SeismicStorage* > > & seismic_data) const
 {
+  Profiler::Region region("Reading seismic data");
+
   std::string err_text = "";
 
   //Skip if there is no AVO-seismic.
@@ -805,6 +809,7 @@ bool CommonData::ReadSeismicData(ModelSettings                               * m
           try {
             stormgrid = new StormContGrid(0,0,0);
             stormgrid->ReadFromFile(file_name);
+            Profiler::AddBytesRead(static_cast<double>(NRLib::FindFileSize(file_name)));
           }
           catch (NRLib::Exception & e) {
             err_text += "Error when reading storm-file " + file_name +": " + NRLib::ToString(e.what()) + "\n";
@@ -883,6 +888,7 @@ bool CommonData::ReadSeismicData(ModelSettings                               * m
           catch (NRLib::Exception & e) {
             err_text += NRLib::ToString(e.what());
           }
+          Profiler::AddBytesRead(static_cast<double>(NRLib::FindFileSize(file_name)));
 
           bool area_from_segy       = model_settings->getAreaSpecification() == ModelSettings::AREA_FROM_GRID_DATA;
           bool storm_output         = (model_settings->getOutputGridFormat() & IO::STORM) == 0;
@@ -1126,6 +1132,8 @@ bool CommonData::ReadWellData(ModelSettings                           * model_se
                               std::vector<std::string>                & facies_names,
                               std::string                             & err_text_common) const
 {
+  Profiler::Region region("Reading wells");
+
   std::string err_text = "";
 
   int                      n_wells             = model_settings->getNumberOfWells();
@@ -1177,18 +1185,27 @@ bool CommonData::ReadWellData(ModelSettings                           * model_se
     std::vector<std::string> facies_not_ok_wells;
     std::vector<std::string> upwards_wells;
 
+    //
+    // Read the well files and convert their logs concurrently. Everything
+    // that is logged or depends on the order of the wells is done in the
+    // loop below, one well at a time, so the output is the same for any
+    // number of threads.
+    //
+    std::vector<NRLib::Well *> read_wells(n_wells, static_cast<NRLib::Well *>(NULL));
+    std::vector<std::string>   read_err_text(n_wells);
+    std::vector<std::string>   process_err_text(n_wells);
+
+#ifdef PARALLEL
+    int n_threads = model_settings->getNumberOfThreads();
+#pragma omp parallel for schedule(dynamic, 1) num_threads(n_threads)
+#endif
     for (int well = 0; well < n_wells; well++) {
-      valid_index[well] = false;
       std::string well_file_name = input_files->getWellFile(well);
 
       int format = -1;
       try {
-        NRLib::Well * base_well = NRLib::Well::ReadWell(well_file_name, format);
-        NRLib::Well & new_well  = *base_well; //Convenience-variable.
-        LogKit::LogFormatted(LogKit::Low, new_well.GetWellName()+" : \n");
-
-        std::vector<int>         cur_facies_nr;
-        std::vector<std::string> cur_facies_names;
+        read_wells[well]       = NRLib::Well::ReadWell(well_file_name, format);
+        NRLib::Well & new_well = *read_wells[well]; //Convenience-variable.
 
         //Process logs. Start by finding current log names and settings.
         std::vector<std::string> well_log_names = model_settings->getWellLogNames(well);
@@ -1210,7 +1227,7 @@ bool CommonData::ReadWellData(ModelSettings                           * model_se
            well_log_names[j] = log_names[j];
         }
 
-        std::string tmp_err_text;
+        std::string & tmp_err_text = process_err_text[well];
         std::vector<std::string> well_position_log_names = model_settings->getWellPositionLogNames(well);
         bool well_relative_coord = model_settings->getWellRelativeCoord(well);
         if(well_position_log_names[0]+well_position_log_names[1] != "") { //At least one given
@@ -1234,6 +1251,30 @@ bool CommonData::ReadWellData(ModelSettings                           * model_se
         }
 
         ProcessLogsGeneralWell(new_well, well_log_names, well_position_log_names, well_inverse_velocity, well_relative_coord, facies_log_given, porosity_log_given, format, tmp_err_text);
+      }
+      catch (NRLib::Exception & e) {
+        read_err_text[well] = e.what();
+      }
+    }
+
+    for (int well = 0; well < n_wells; well++) {
+      valid_index[well] = false;
+
+      try {
+        if (read_wells[well] == NULL)
+          throw NRLib::Exception(read_err_text[well]);
+
+        NRLib::Well * base_well = read_wells[well];
+        NRLib::Well & new_well  = *base_well; //Convenience-variable.
+        LogKit::LogFormatted(LogKit::Low, new_well.GetWellName()+" : \n");
+
+        if (read_err_text[well] != "")
+          throw NRLib::Exception(read_err_text[well]);
+
+        std::vector<int>         cur_facies_nr;
+        std::vector<std::string> cur_facies_names;
+
+        const std::string & tmp_err_text = process_err_text[well];
         err_text += tmp_err_text;
         if (tmp_err_text == "") {
           //Store facies names.
@@ -2893,6 +2934,7 @@ bool CommonData::WaveletHandling(ModelSettings                               * m
                                  SegyGeometry                                * segy_geometry,
                                  std::string                                 & err_text_common) const
 {
+  Profiler::Region region("Wavelets");
 
   int n_timelapses     = model_settings->getNumberOfTimeLapses();
   int error            = 0;
@@ -3277,16 +3319,68 @@ CommonData::Process1DWavelet(const ModelSettings                        * model_
   Wavelet * wavelet_pre_resampling = NULL;
 
   if (estimate_wavelet) {
-    wavelet = new Wavelet1D(&estimation_simbox,
-                            seismic_data,
-                            mapped_blocked_logs,
-                            wavelet_estim_interval,
-                            model_settings,
-                            reflection_matrix,
-                            j_angle,
-                            well_wavelets,
-                            error,
-                            err_text);
+    //
+    // The estimated wavelet only depends on the seismic data, the blocked
+    // wells, the estimation interval and a few settings, and is read from
+    // the cache if these are unchanged. The well wavelets and their files
+    // are made from the cached item.
+    //
+    PreprocessingCache cache(model_settings);
+    bool               use_cache  = cache.IsEnabled();
+    bool               from_cache = false;
+    std::vector<std::vector<double> > estimate;
+    if (use_cache) {
+      cache.StartKey("wavelet");
+      cache.AddSeismicToKey(seismic_data);
+      cache.AddSimboxToKey(&estimation_simbox);
+      cache.AddToKey(estimation_simbox.GetNZpad());
+      cache.AddWaveletLogsToKey(mapped_blocked_logs);
+      cache.AddFileToKey(input_files->getWaveletEstIntFileTop(0));
+      cache.AddFileToKey(input_files->getWaveletEstIntFileBase(0));
+      cache.AddToKey(j_angle);
+      cache.AddToKey(reflection_coefs[0]);
+      cache.AddToKey(reflection_coefs[1]);
+      cache.AddToKey(reflection_coefs[2]);
+      cache.AddToKey(model_settings->getNumberOfWells());
+      cache.AddToKey(model_settings->getWaveletTaperingL());
+      cache.AddToKey(model_settings->getMaxWaveletShift());
+      cache.AddToKey(model_settings->getMinRelWaveletAmp());
+
+      // The item has the estimate of each well after the four first vectors.
+      std::vector<NRLib::Grid<float> *> no_grids;
+      estimate.resize(4 + 2*model_settings->getNumberOfWells());
+      from_cache = cache.Load(no_grids, estimate);
+      if (from_cache) {
+        LogKit::LogFormatted(LogKit::Low,"  Estimated wavelet read from the cache file %s.\n", cache.GetFileName().c_str());
+        wavelet = new Wavelet1D(&estimation_simbox,
+                                seismic_data->GetAngle(),
+                                mapped_blocked_logs,
+                                model_settings,
+                                reflection_matrix,
+                                j_angle,
+                                estimate,
+                                well_wavelets);
+      }
+    }
+
+    if (!from_cache) {
+      wavelet = new Wavelet1D(&estimation_simbox,
+                              seismic_data,
+                              mapped_blocked_logs,
+                              wavelet_estim_interval,
+                              model_settings,
+                              reflection_matrix,
+                              j_angle,
+                              well_wavelets,
+                              error,
+                              err_text,
+                              true,
+                              (use_cache ? &estimate : NULL));
+      if (use_cache && error == 0) {
+        std::vector<NRLib::Grid<float> *> no_grids;
+        cache.Save(no_grids, estimate);
+      }
+    }
   }
   else { //Not estimation modus
     if (use_ricker_wavelet) {
@@ -4581,6 +4675,7 @@ bool  CommonData::OptimizeWellLocations(ModelSettings
                                         SegyGeometry                                  * segy_geometry,
                                         const std::vector<NRLib::Matrix>              & reflection_matrix,
                                         std::string                                   & err_text_common) const{
+  Profiler::Region region("Optimizing well locations");
 
   std::string err_text = "";
 
@@ -5013,6 +5108,8 @@ bool CommonData::SetupRockPhysics(const ModelSettings
                                   const std::vector<std::string>                                & disc_logs_to_be_blocked,
                                   std::string                                                   & err_text_common) const
 {
+  Profiler::Region region("Rock physics");
+
   LogKit::WriteHeader("Processing Rock Physics");
 
   (void) multiple_interval_grid;
@@ -6195,7 +6292,7 @@ void CommonData::FillInData(NRLib::Grid<float>  * grid_new,
                             bool                  scale,
                             bool                  is_segy,
                             bool                  is_storm,
-                            bool                  is_seismic) const
+                            bool                  is_seismic)
 {
   //Resample to either a NRLib::Grid or a FFTGrid.
   //The one resampled to needs to be defined outside this function, and the other needs to be sent in as an empty grid.
@@ -6514,7 +6611,27 @@ void CommonData::FillInData(NRLib::Grid<float>  * grid_new,
   Timings::setTimeResamplingSeismic(wall,cpu);
 }
 
-int CommonData::GetFillNumber(int i, int n, int np) const{
+void CommonData::FillInLateralPadding(FFTGrid * fft_grid)
+{
+  int nx  = fft_grid->getNx();
+  int ny  = fft_grid->getNy();
+  int nxp = fft_grid->getNxp();
+  int nyp = fft_grid->getNyp();
+  int nzp = fft_grid->getNzp();
+
+  // Rows are visited in order, so the row a padding row repeats is complete.
+  std::vector<float> row(nxp);
+  for (int k = 0; k < nzp; k++) {
+    for (int j = 0; j < nyp; j++) {
+      fft_grid->getRealRow(&row[0], GetFillNumber(j, ny, nyp), k);
+      for (int i = nx; i < nxp; i++)
+        row[i] = row[GetFillNumber(i, nx, nxp)];
+      fft_grid->setRealRow(j, k, &row[0]);
+    }
+  }
+}
+
+int CommonData::GetFillNumber(int i, int n, int np){
 
   //  for the series                 i = 0,1,2,3,4,5,6,7
   //  GetFillNumber(i, 5 , 8)  returns   0,1,2,3,4,4,1,0 (cut middle, i.e 3,2)
@@ -6584,7 +6701,7 @@ int CommonData::FindClosestFactorableNumber(int leastint)
 
 void CommonData::SmoothTraceInGuardZone(std::vector<float> & data_trace,
                                         float                dz_data,
-                                        float                smooth_length) const
+                                        float                smooth_length)
 {
   // We recommend a guard zone of at least half a wavelet on each side of
   // the target zone and that half a wavelet of the guard zone is smoothed.
@@ -6690,7 +6807,7 @@ void CommonData::InterpolateGridValues(std::vector<float> & grid_trace,
                                        float                dz_fine,
                                        int                  n_fine,
                                        int                  nz,
-                                       int                  nzp) const
+                                       int                  nzp)
 {
   //
   // Bilinear interpolation
@@ -6740,7 +6857,7 @@ void CommonData::InterpolateAndShiftTrend(std::vector<float>       & interpolate
                                           float                      dz_fine,
                                           int                        n_fine,
                                           int                        nz,
-                                          int                        nzp) const
+                                          int                        nzp)
 {
   //
   // Bilinear interpolation
@@ -6787,7 +6904,7 @@ void CommonData::InterpolateAndShiftTrend(std::vector<float>       & interpolate
 
 int CommonData::GetZSimboxIndex(int k,
                                 int nz,
-                                int nzp) const
+                                int nzp)
 {
   int refk;
 
@@ -6802,7 +6919,7 @@ int CommonData::GetZSimboxIndex(int k,
 void CommonData::SetTrace(const std::vector<float> & trace,
                           NRLib::Grid<float>       * grid,
                           int                        i,
-                          int                        j) const
+                          int                        j)
 {
   for (size_t k = 0; k < grid->GetNK(); k++) {
     grid->SetValue(i, j, k, trace[k]);
@@ -6812,7 +6929,7 @@ void CommonData::SetTrace(const std::vector<float> & trace,
 void CommonData::SetTrace(float                value,
                           NRLib::Grid<float> * grid,
                           int                  i,
-                          int                  j) const
+                          int                  j)
 {
   for (size_t k = 0; k < grid->GetNK(); k++) {
     grid->SetValue(i, j, k, value);
@@ -6822,7 +6939,7 @@ void CommonData::SetTrace(float                value,
 void CommonData::SetTrace(const std::vector<float> & trace,
                           FFTGrid                  * grid,
                           int                        i,
-                          int                        j) const
+                          int                        j)
 {
   for (int k = 0; k < grid->getNzp(); k++) {
     grid->setRealValue(i, j, k, trace[k], true);
@@ -6832,7 +6949,7 @@ void CommonData::SetTrace(const std::vector<float> & trace,
 void CommonData::SetTrace(float     value,
                           FFTGrid * grid,
                           int       i,
-                          int       j) const
+                          int       j)
 {
   for (int k = 0; k < grid->getNzp(); k++) {
     grid->setRealValue(i, j, k, value, true);
@@ -7128,6 +7245,8 @@ bool CommonData::SetupBackgroundModel(ModelSettings
                                       SegyGeometry                                               * segy_geometry,
                                       std::string                                                & err_text_common) const
 {
+  Profiler::Region region("Background model");
+
   std::string err_text = "";
 
   if (forward_modeling_)
@@ -7346,7 +7465,54 @@ bool CommonData::SetupBackgroundModel(ModelSettings
         //Create background
         if (blocking_failed == false) {
           std::vector<std::vector<double> > interval_vertical_trends(3);
-          Background::SetupBackground(background_parameters[i], interval_vertical_trends, velocity, simbox, bg_simbox, blocked_logs, bg_blocked_logs_tmp, model_settings, interval_name, err_text);
+          std::vector<std::vector<double> > deviations(Background::n_deviations);
+
+          //
+          // The kriged background only depends on the blocked logs, the grids and a
+          // few settings, and is read from the cache if these are unchanged. The
+          // quality control tables are logged from the cached well deviations, but
+          // the background output files and debug output are only made when the
+          // background is computed.
+          //
+          const std::map<std::string, BlockedLogsCommon *> & bg_logs = (bg_simbox == NULL ? blocked_logs : bg_blocked_logs_tmp);
+
+          PreprocessingCache cache(model_settings);
+          bool               use_cache  = (cache.IsEnabled() && (model_settings->getOutputGridsElastic() & IO::BACKGROUND) == 0);
+          bool               from_cache = false;
+          if (use_cache) {
+            cache.StartKey("background");
+            cache.AddSimboxToKey(simbox);
+            cache.AddSimboxToKey(bg_simbox);
+            cache.AddGridToKey(velocity);
+            cache.AddBlockedLogsToKey(bg_logs);
+            cache.AddVarioToKey(model_settings->getBackgroundVario());
+            cache.AddToKey(model_settings->getMaxHzBackground());
+            cache.AddToKey(model_settings->getVpMin());
+            cache.AddToKey(model_settings->getVpMax());
+            cache.AddToKey(model_settings->getVsMin());
+            cache.AddToKey(model_settings->getVsMax());
+            cache.AddToKey(model_settings->getRhoMin());
+            cache.AddToKey(model_settings->getRhoMax());
+
+            std::vector<std::vector<double> > cached(interval_vertical_trends.size() + deviations.size());
+            from_cache = cache.Load(background_parameters[i], cached);
+            if (from_cache) {
+              std::copy(cached.begin(), cached.begin() + interval_vertical_trends.size(), interval_vertical_trends.begin());
+              std::copy(cached.begin() + interval_vertical_trends.size(), cached.end(), deviations.begin());
+              LogKit::LogFormatted(LogKit::Low,"\nBackground model%s read from the cache file %s.\n", interval_text.c_str(), cache.GetFileName().c_str());
+              Background::WriteDeviations(deviations, bg_logs);
+            }
+          }
+
+          if (!from_cache) {
+            size_t n_errors = err_text.size();
+            Background::SetupBackground(background_parameters[i], interval_vertical_trends, deviations, velocity, simbox, bg_simbox, blocked_logs, bg_blocked_logs_tmp, model_settings, interval_name, err_text);
+            if (use_cache && err_text.size() == n_errors) {
+              std::vector<std::vector<double> > cached(interval_vertical_trends);
+              cached.insert(cached.end(), deviations.begin(), deviations.end());
+              cache.Save(background_parameters[i], cached);
+            }
+          }
           for (int j = 0; j < 3; j++)
             vertical_trends(i,j) = interval_vertical_trends[j];
 
@@ -8032,6 +8198,7 @@ bool CommonData::SetupPriorCorrelation(const ModelSettings
                                        bool                                                             & prior_cov_estimated_or_file, //or prior_auto_cov read from file
                                        std::string                                                      & err_text_common) const
 {
+  Profiler::Region region("Prior correlation");
 
   if (model_settings->getForwardModeling())
     return true;
@@ -10433,7 +10600,7 @@ void CommonData::WriteOutputSurfaces(ModelSettings * model_settings,
         //simbox.WriteTopBaseErodedSurfaceGrids(top_surf_eroded, base_surf_eroded,
         //                                      IO::PathToInversionResults(), output_format);
     }
-    if ((output_format & IO::STORM) > 0) { // These copies are only needed with the STORM format
+    if ((output_format & (IO::STORM | IO::CHUNKED)) > 0) { // These copies are only needed with the STORM formats
       if ((output_grids_elastic & IO::BACKGROUND) > 0 ||
           (output_grids_elastic & IO::BACKGROUND_TREND) > 0 ||
           (estimation_mode && generate_background)) {
@@ -10499,6 +10666,8 @@ void CommonData::SetDebugLevel(ModelSettings * model_settings) const
   //Set output for all FFTGrids.
   FFTGrid::setOutputFlags(model_settings->getOutputGridFormat(),
                           model_settings->getOutputGridDomain());
+  FFTGrid::setChunkedQuantizationStep(model_settings->getChunkedQuantizationStep());
+  FFTGrid::setNumberOfThreads(model_settings->getNumberOfThreads());
 
 }
 
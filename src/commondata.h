@@ -322,7 +322,7 @@ public:
 
   //Resampling algorithm, from a storm_grid or a segy cube, to either a NRLib::Grid or fftgrid
   //The wanted result grid needs to be defined outside this function, and the other needs to be sent in as an empty grid
-  void               FillInData(NRLib::Grid<float>  * grid,          //resample to
+  static void        FillInData(NRLib::Grid<float>  * grid,          //resample to
                                 FFTGrid             * fft_grid,      //resample to
                                 const Simbox        * simbox,
                                 const StormContGrid * storm_grid,    //resample from
@@ -336,7 +336,11 @@ public:
                                 bool                  scale    = false,
                                 bool                  is_segy  = true,
                                 bool                  is_storm = false,
-                                bool                  is_seismic = false) const;
+                                bool                  is_seismic = false);
+
+  // Sets the lateral padding of a grid resampled by FillInData from the
+  // simbox part, which it repeats.
+  static void        FillInLateralPadding(FFTGrid * fft_grid);
 
   void               GetCorrGradIJ(float         & corr_grad_I,
                                    float         & corr_grad_J,
@@ -809,13 +813,13 @@ private:
                                   std::string                       & err_text,
                                   bool                                nopadding = false) const;
 
-  int                GetFillNumber(int i, int n, int np) const;
+  static int         GetFillNumber(int i, int n, int np);
 
-  void               SmoothTraceInGuardZone(std::vector<float> & data_trace,
+  static void        SmoothTraceInGuardZone(std::vector<float> & data_trace,
                                             float                dz_data,
-                                            float                smooth_length) const;
+                                            float                smooth_length);
 
-  void               InterpolateGridValues(std::vector<float> & grid_trace,
+  static void        InterpolateGridValues(std::vector<float> & grid_trace,
                                            float                z0_grid,
                                            float                dz_grid,
                                            fftw_real          * rAmpFine,
@@ -823,9 +827,9 @@ private:
                                            float                dz_fine,
                                            int                  n_fine,
                                            int                  nz,
-                                           int                  nzp) const;
+                                           int                  nzp);
 
-  void               InterpolateAndShiftTrend(std::vector<float>       & interpolated_trend,
+  static void        InterpolateAndShiftTrend(std::vector<float>       & interpolated_trend,
                                               float                      z0_grid,
                                               float                      dz_grid,
                                               const std::vector<float> & trend_long,
@@ -833,31 +837,31 @@ private:
                                               float                      dz_fine,
                                               int                        n_fine,
                                               int                        nz,
-                                              int                        nzp) const;
+                                              int                        nzp);
 
-  int                GetZSimboxIndex(int k,
+  static int         GetZSimboxIndex(int k,
                                      int nz,
-                                     int nzp) const;
+                                     int nzp);
 
-  void               SetTrace(const std::vector<float> & trace,
+  static void        SetTrace(const std::vector<float> & trace,
                               NRLib::Grid<float>       * grid,
                               int                        i,
-                              int                        j) const;
+                              int                        j);
 
-  void               SetTrace(float                value,
+  static void        SetTrace(float                value,
                               NRLib::Grid<float> * grid,
                               int                  i,
-                              int                  j) const;
+                              int                  j);
 
-  void               SetTrace(const std::vector<float> & trace,
+  static void        SetTrace(const std::vector<float> & trace,
                               FFTGrid                  * grid,
                               int                        i,
-                              int                        j) const;
+                              int                        j);
 
-  void               SetTrace(float     value,
+  static void        SetTrace(float     value,
                               FFTGrid * grid,
                               int       i,
-                              int       j) const;
+                              int       j);
 
   void               ReadStormFile(const std::string                 & file_name,
                                    std::vector<NRLib::Grid<float> *> & interval_grids,
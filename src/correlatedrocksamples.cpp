@@ -1,10 +1,13 @@
 #include "src/correlatedrocksamples.h"
 
 #include "rplib/rock.h"
+#include "nrlib/random/random.hpp"
+#include "nrlib/random/randomgenerator.hpp"
 #include <nrlib/flens/nrlib_flens.hpp>
 
 
-CorrelatedRockSamples::CorrelatedRockSamples()
+CorrelatedRockSamples::CorrelatedRockSamples(int n_threads)
+  : n_threads_(n_threads)
 {
 }
 
@@ -12,142 +15,109 @@ CorrelatedRockSamples::~CorrelatedRockSamples()
 {
 }
 
-std::vector< std::vector< std::vector<double> > >
+std::vector<double>
 CorrelatedRockSamples::CreateSamples(int                                             i_max,
                                      TimeLine                                      & time_line,
                                      const std::vector<DistributionsRock *>        & dist_rock)
 {
-  std::list<int> time;
-  time_line.GetAllTimes(time);
-  int k_max = static_cast<int>(dist_rock.size() );
-
-  // Set up time vectors, the same for all sets of correlated samples.
-  time_line.ReSet();
-  int et_dummy, edi_dummy;
-  double dt;
-  std::vector< std::vector<double> > delta_time(k_max);
-  for (int k = 0; k < k_max; ++k){
-    time_line.GetNextEvent(et_dummy, edi_dummy, dt);// dt in days
-    for (int l = k; l < k_max; ++l)
-      delta_time[l].push_back(dt); // dt in years
-  }
-
-  // Set up data structures.
-  // The order of indices is chosen to make extraction of all samples for a given time instance easy.
-  std::vector< std::vector< std::vector<double> > > m(k_max);
-  std::vector< std::vector< Rock * > > rock(k_max);
-  for (int k = 0; k < k_max; ++k){
-    m[k].resize(i_max);
-    rock[k].resize(i_max);
-    for (int i = 0; i < i_max; ++i)
-      m[k][i].resize(3);
-  }
-
-  const std::vector<double> trend_params_dummy(2,0);
-  // Finding the sets of correlated samples.
-  // Each set of samples for a specific i are correlated in time.
-  dist_rock[0]->SetResamplingLevel(DistributionWithTrend::Full);
-  for (int i = 0; i < i_max; ++i){
-    rock[0][i] = dist_rock[0]->GenerateSample(trend_params_dummy);
-    rock[0][i]->GetSeismicParams(m[0][i][0], m[0][i][1], m[0][i][2]);
-    m[0][i][0]=std::log(m[0][i][0]);
-    m[0][i][1]=std::log(m[0][i][1]);
-    m[0][i][2]=std::log(m[0][i][2]);
-    std::vector< Rock * > rock_seen(1, rock[0][i]);
-    for (int k = 1; k < k_max; ++k){
-      dist_rock[k]->SetResamplingLevel(DistributionWithTrend::Full);
-      rock[k][i] = dist_rock[k]->EvolveSample(delta_time[k][k], *(rock[k-1][i])); // delta_time info also for the rock to be found.
-      rock[k][i]->GetSeismicParams(m[k][i][0], m[k][i][1], m[k][i][2]);
-      m[k][i][0]=std::log(m[k][i][0]);
-      m[k][i][1]=std::log(m[k][i][1]);
-      m[k][i][2]=std::log(m[k][i][2]);
-      rock_seen.push_back(rock[k][i]);
-    }
-  }
-
-  // Must delete memory allocated by classes DistributionsRock and Rock.
-  for (int k = 0; k < k_max; ++k){
-    for (int i = 0; i < i_max; ++i){
-      if (rock[k][i] != NULL)
-        delete rock[k][i];
-    }
-  }
+  std::vector<double> m;
+  SampleChains(i_max, time_line, dist_rock, false, m);
   return m;
 }
 
-
-
-
-std::vector< std::vector< std::vector<double> > >
+std::vector<double>
 CorrelatedRockSamples::CreateSamplesExtended(int                                      i_max,
                                              TimeLine                               & time_line,
                                              const std::vector<DistributionsRock*>  & dist_rock)
+{
+  std::vector<double> m;
+  SampleChains(i_max, time_line, dist_rock, true, m);
+  return m;
+}
+
+void
+CorrelatedRockSamples::SampleChains(int                                     i_max,
+                                    TimeLine                              & time_line,
+                                    const std::vector<DistributionsRock*> & dist_rock,
+                                    bool                                    add_reservoir_variables,
+                                    std::vector<double>                   & m)
 {
   std::list<int> time;
   time_line.GetAllTimes(time);
   int k_max = static_cast<int>(dist_rock.size());
 
-  // Set up time vectors, the same for all sets of correlated samples.
+  // Set up time steps, the same for all sets of correlated samples.
   time_line.ReSet();
   int et_dummy, edi_dummy;
-  double dt_year;
-  std::vector< std::vector<double> > delta_time(k_max);
-  for (int k = 0; k < k_max; ++k){
-    time_line.GetNextEvent(et_dummy, edi_dummy, dt_year);
-    for (int l = k; l < k_max; ++l)
-      delta_time[l].push_back(dt_year);
-  }
+  std::vector<double> delta_time(k_max);
+  for (int k = 0; k < k_max; ++k)
+    time_line.GetNextEvent(et_dummy, edi_dummy, delta_time[k]); // dt in years
 
-  int nReservoirVariables =  dist_rock[0]->GetNumberOfReservoirVariables();
+  int n_reservoir_variables = 0;
+  if (add_reservoir_variables)
+    n_reservoir_variables = dist_rock[0]->GetNumberOfReservoirVariables();
+  int n_params = 3 + n_reservoir_variables;
 
-  // Set up data structures.
   // The order of indices is chosen to make extraction of all samples for a given time instance easy.
-  std::vector< std::vector< std::vector<double> > > m(k_max);
-  std::vector< std::vector< Rock * > > rock(k_max);
-  for (int k = 0; k < k_max; ++k){
-    m[k].resize(i_max);
-    rock[k].resize(i_max);
-    for (int i = 0; i < i_max; ++i)
-      m[k][i].resize(3+nReservoirVariables);
-  }
+  m.assign(static_cast<size_t>(k_max)*i_max*n_params, 0.0);
+
+  for (int k = 0; k < k_max; ++k)
+    dist_rock[k]->SetResamplingLevel(DistributionWithTrend::Full);
+
+  // Each chain draws from a generator of its own, seeded from the global
+  // generator in chain order, so the samples do not depend on the number of
+  // threads.
+  std::vector<unsigned long> seeds(i_max);
+  for (int i = 0; i < i_max; ++i)
+    seeds[i] = NRLib::Random::DrawUint32();
 
-  const std::vector<double> trend_params_dummy(2,0);
-  std::vector<double>reservoirVariables(nReservoirVariables,0);
   // Finding the sets of correlated samples.
-  // Each set of samples for a specific i are correlated in time.
-  dist_rock[0]->SetResamplingLevel(DistributionWithTrend::Full);
+  // Each set of samples for a specific i are correlated in time. A chain only
+  // needs the rock of the previous time step, so at most two rocks are alive.
+  // The current samples of the distributions, which carry the reservoir
+  // variables between time steps, are kept per chain.
+  const std::vector<double> trend_params_dummy(2,0);
+#ifdef PARALLEL
+#pragma omp parallel for schedule(dynamic, 1) num_threads(n_threads_)
+#endif
   for (int i = 0; i < i_max; ++i){
-    rock[0][i] = dist_rock[0]->GenerateSampleAndReservoirVariables(trend_params_dummy,reservoirVariables);
-    rock[0][i]->GetSeismicParams(m[0][i][0], m[0][i][1], m[0][i][2]);
-    m[0][i][0]=std::log(m[0][i][0]);
-    m[0][i][1]=std::log(m[0][i][1]);
-    m[0][i][2]=std::log(m[0][i][2]);
-    for(int l =0;l< nReservoirVariables;l++)
-        m[0][i][l+3]=reservoirVariables[l];
-
-    std::vector< Rock * > rock_seen(1, rock[0][i]);
-    for (int k = 1; k < k_max; ++k){
-      dist_rock[k]->SetResamplingLevel(DistributionWithTrend::Full);
-      rock[k][i] = dist_rock[k]->EvolveSampleAndReservoirVaribles(delta_time[k][k], *(rock[k-1][i]),reservoirVariables); // delta_time info also for the rock to be found.
-      rock[k][i]->GetSeismicParams(m[k][i][0], m[k][i][1], m[k][i][2]);
-      m[k][i][0]=std::log(m[k][i][0]);
-      m[k][i][1]=std::log(m[k][i][1]);
-      m[k][i][2]=std::log(m[k][i][2]);
-      for(int l =0;l< nReservoirVariables;l++)
-        m[k][i][l+3]=reservoirVariables[l];
-      rock_seen.push_back(rock[k][i]);
+    NRLib::RandomGenerator generator;
+    generator.Initialize(seeds[i]);
+    NRLib::Random::SetThreadGenerator(&generator);
+
+    DistributionWithTrend::SampleStates sample_states;
+    DistributionWithTrend::SetThreadSampleStates(&sample_states);
+
+    std::vector<double> reservoir_variables(n_reservoir_variables, 0);
+    Rock * rock = NULL;
+    for (int k = 0; k < k_max; ++k){
+      Rock * next;
+      if (k == 0) {
+        if (add_reservoir_variables)
+          next = dist_rock[0]->GenerateSampleAndReservoirVariables(trend_params_dummy, reservoir_variables);
+        else
+          next = dist_rock[0]->GenerateSample(trend_params_dummy);
+      }
+      else {
+        if (add_reservoir_variables)
+          next = dist_rock[k]->EvolveSampleAndReservoirVaribles(delta_time[k], *rock, reservoir_variables);
+        else
+          next = dist_rock[k]->EvolveSample(delta_time[k], *rock); // delta_time info also for the rock to be found.
+        delete rock;
+      }
+      rock = next;
+
+      double * m_ki = &m[(static_cast<size_t>(k)*i_max + i)*n_params];
+      rock->GetSeismicParams(m_ki[0], m_ki[1], m_ki[2]);
+      m_ki[0] = std::log(m_ki[0]);
+      m_ki[1] = std::log(m_ki[1]);
+      m_ki[2] = std::log(m_ki[2]);
+      for (int l = 0; l < n_reservoir_variables; l++)
+        m_ki[l+3] = reservoir_variables[l];
     }
-  }
+    delete rock;
 
-  // Must delete memory allocated by classes DistributionsRock and Rock.
-  for (int k = 0; k < k_max; ++k){
-    for (int i = 0; i < i_max; ++i){
-      if (rock[k][i] != NULL)
-        delete rock[k][i];
-    }
+    DistributionWithTrend::SetThreadSampleStates(NULL);
+    NRLib::Random::SetThreadGenerator(NULL);
   }
-
-  return m;
 }
-
-
@@ -9,21 +9,36 @@
 // I = number of samples per time step.
 // Each sample is a 3-dim vector [vp, vs, rho].
 // Each set of samples for a specific i in [0:I-1] are correlated in time.
+//
+// The samples are returned in one buffer, with parameter p of sample i at
+// time step k in m[(k*I + i)*n + p], where n is the number of parameters.
 
 class CorrelatedRockSamples {
 public:
 
-  CorrelatedRockSamples();
+  // The chains are sampled on n_threads threads.
+  CorrelatedRockSamples(int n_threads);
 
   ~CorrelatedRockSamples();
 
-  std::vector< std::vector< std::vector<double> > > CreateSamples(int                                             i_max,
-                                                                  TimeLine                                      & time_line,
-                                                                  const std::vector<DistributionsRock*>         & dist_rock);
+  // n = 3
+  std::vector<double> CreateSamples(int                                             i_max,
+                                    TimeLine                                      & time_line,
+                                    const std::vector<DistributionsRock*>         & dist_rock);
 
-  std::vector< std::vector< std::vector<double> > > CreateSamplesExtended(int                                     i_max,
-                                                                          TimeLine                              & time_line,
-                                                                          const std::vector<DistributionsRock*> & dist_rock);
+  // n = 3 + number of reservoir variables
+  std::vector<double> CreateSamplesExtended(int                                     i_max,
+                                            TimeLine                              & time_line,
+                                            const std::vector<DistributionsRock*> & dist_rock);
+
+private:
+  void SampleChains(int                                     i_max,
+                    TimeLine                              & time_line,
+                    const std::vector<DistributionsRock*> & dist_rock,
+                    bool                                    add_reservoir_variables,
+                    std::vector<double>                   & m);
+
+  int n_threads_;
 };
 
 #endif
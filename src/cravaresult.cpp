@@ -2222,12 +2222,18 @@ void CravaResult::LogTransf(StormContGrid * grid)
 
 void CravaResult::ExpTransf(FFTGrid * grid)
 {
-  float value = 0.0f;
-  for (int i = 0; i < grid->getNx(); i++) {
-    for (int j = 0; j < grid->getNy(); j++) {
-      for (int k = 0; k < grid->getNz(); k++) {
+  // Loop in storage order (i fastest), one layer per thread.
+  int nx = grid->getNx();
+  int ny = grid->getNy();
+  int nz = grid->getNz();
+#ifdef PARALLEL
+#pragma omp parallel for schedule(static) num_threads(FFTGrid::getNumberOfThreads())
+#endif
+  for (int k = 0; k < nz; k++) {
+    for (int j = 0; j < ny; j++) {
+      for (int i = 0; i < nx; i++) {
 
-        value = grid->getRealValue(i, j, k);
+        float value = grid->getRealValue(i, j, k);
 
         if (value != RMISSING) {
           value = exp(value);
@@ -2241,12 +2247,17 @@ void CravaResult::ExpTransf(FFTGrid * grid)
 
 void CravaResult::LogTransf(FFTGrid * grid)
 {
-  float value = 0.0f;
-  for (int i = 0; i < grid->getNx(); i++) {
-    for (int j = 0; j < grid->getNy(); j++) {
-      for (int k = 0; k < grid->getNz(); k++) {
+  int nx = grid->getNx();
+  int ny = grid->getNy();
+  int nz = grid->getNz();
+#ifdef PARALLEL
+#pragma omp parallel for schedule(static) num_threads(FFTGrid::getNumberOfThreads())
+#endif
+  for (int k = 0; k < nz; k++) {
+    for (int j = 0; j < ny; j++) {
+      for (int i = 0; i < nx; i++) {
 
-        value = grid->getRealValue(i, j, k);
+        float value = grid->getRealValue(i, j, k);
 
         if (value == RMISSING || value < 0.0) {
           grid->setRealValue(i, j, k, 0);
@@ -2358,6 +2369,21 @@ CravaResult::ComputeSeismicImpedance(StormContGrid       * vp,
   return(impedance);
 }
 
+void CravaResult::SpillIntervalGrids(SeismicParametersHolder & seismic_parameters)
+{
+  // CombineResult() reads the interval grids trace by trace, which spilled
+  // grids support. Peak memory is then one interval plus the output grids.
+  seismic_parameters.spillGridsToDisk();
+
+  FFTGrid * backgrounds[3] = { background_vp_intervals_.back(),
+                               background_vs_intervals_.back(),
+                               background_rho_intervals_.back() };
+  for (int i = 0; i < 3; i++) {
+    if (backgrounds[i] != NULL && !backgrounds[i]->getIsTransformed() && !backgrounds[i]->getIsSpilled())
+      backgrounds[i]->spillToDisk();
+  }
+}
+
 void CravaResult::AddBlockedLogs(const std::map<std::string, BlockedLogsCommon *> & blocked_logs)
 {
   std::map<std::string, BlockedLogsCommon *> new_blocked_logs;
@@ -209,6 +209,8 @@ public:
 
   void AddBlockedLogs(const std::map<std::string, BlockedLogsCommon *> & blocked_logs);
 
+  void SpillIntervalGrids(SeismicParametersHolder & seismic_parameters);
+
   void SetBgBlockedLogs(const std::map<std::string, BlockedLogsCommon *> & bg_blocked_logs) { bg_blocked_logs_ = bg_blocked_logs ;}
 
 private:
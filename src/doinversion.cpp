@@ -15,6 +15,9 @@
 #include "src/seismicparametersholder.h"
 #include "src/simbox.h"
 #include "src/gravimetricinversion.h"
+#include "src/checkpoint.h"
+#include "nrlib/iotools/logkit.hpp"
+#include "nrlib/iotools/stringtools.hpp"
 
 #include "src/doinversion.h"
 
@@ -76,9 +79,29 @@ bool doTimeLapseAVOInversion(ModelSettings           * modelSettings,
   bool failedLoadingModel = modelAVOdynamic == NULL || modelAVOdynamic->GetFailed();
 
   if(failedLoadingModel == false) {
-    AVOInversion * avoinversion = new AVOInversion(modelSettings, modelGeneral, modelAVOstatic, modelAVOdynamic, seismicParameters);
+    // The 4D state is updated between vintages and is not part of a checkpoint.
+    Checkpoint * checkpoint = NULL;
+    bool useCheckpoints = (modelSettings->getWriteCheckpoints() || modelSettings->getRestartFromCheckpoints()) && !modelSettings->getDo4DInversion();
+    if (useCheckpoints && modelSettings->getUse3DWavelet()) {
+      // The fingerprint covers the amplitudes of 1D wavelets only.
+      LogKit::LogFormatted(LogKit::Warning,"\nWARNING: Checkpoints are not written or read when 3D wavelets are used.\n");
+      useCheckpoints = false;
+    }
+    if (useCheckpoints) {
+      std::string name = "Inversion";
+      if (modelGeneral->GetIntervalName() != "")
+        name += "_" + modelGeneral->GetIntervalName();
+      name += "_" + NRLib::ToString(vintage);
+      checkpoint = new Checkpoint(name,
+                                  modelSettings->getWriteCheckpoints(),
+                                  modelSettings->getRestartFromCheckpoints(),
+                                  modelGeneral->GetRandomGen());
+    }
+
+    AVOInversion * avoinversion = new AVOInversion(modelSettings, modelGeneral, modelAVOstatic, modelAVOdynamic, seismicParameters, checkpoint);
 
     delete avoinversion;
+    delete checkpoint;
   }
 
   delete modelAVOdynamic;
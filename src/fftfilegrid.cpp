@@ -2,8 +2,10 @@
 *      Copyright (C) 2008 by Norwegian Computing Center and Statoil        *
 ***************************************************************************/
 
+#include <algorithm>
 #include <iostream>
 #include <sstream>
+#include <vector>
 #include <math.h>
 #include <assert.h>
 #include <stdio.h>
@@ -15,21 +17,40 @@
 #include "f77_func.h"
 
 #include "nrlib/iotools/logkit.hpp"
+#include "nrlib/stormgrid/chunkedgrid.hpp"
 
 #include "src/definitions.h"
 #include "src/fftfilegrid.h"
 #include "src/simbox.h"
 #include "src/io.h"
+#include "src/gridmemorypool.h"
+
+namespace {
+  // Rows in a band of a temporary file. One row of chunks.
+  const int band_rows = 64;
+}
 
 FFTFileGrid::FFTFileGrid(int nx, int ny, int nz, int nxp, int nyp, int nzp) :
-FFTGrid(nx, ny, nz, nxp, nyp, nzp)
+FFTGrid(nx, ny, nz, nxp, nyp, nzp),
+inBandStart_(0),
+inNext_(0),
+reader_(NULL),
+writer_(NULL),
+outRow_(0),
+outNext_(0)
 {
   genFileName();
   accMode_=NONE;
 }
 
 FFTFileGrid::FFTFileGrid(FFTFileGrid  * fftGrid, bool expTrans) :
-FFTGrid()
+FFTGrid(),
+inBandStart_(0),
+inNext_(0),
+reader_(NULL),
+writer_(NULL),
+outRow_(0),
+outNext_(0)
 {
   float value;
   int   i,j,k;
@@ -107,14 +128,14 @@ FFTFileGrid::setAccessMode(int mode)
   switch(mode)
   {
   case READ:
-    NRLib::OpenRead(inFile_,fNameIn_,std::ios::in | std::ios::binary);
+    openRead();
     break;
   case WRITE:
-    NRLib::OpenWrite(outFile_,fNameOut_,std::ios::out | std::ios::binary);
+    openWrite();
     break;
   case READANDWRITE:
-    NRLib::OpenRead(inFile_,fNameIn_,std::ios::in | std::ios::binary);
-    NRLib::OpenWrite(outFile_,fNameOut_,std::ios::out | std::ios::binary);
+    openRead();
+    openWrite();
     break;
   case RANDOMACCESS:
     modified_ = 0;
@@ -131,12 +152,12 @@ FFTFileGrid::endAccess()
   switch(accMode_)
   {
   case READ:
-    inFile_.close();
+    closeRead();
     break;
   case READANDWRITE:
-    inFile_.close(); //Intentional fallthrough to WRITE
+    closeRead(); //Intentional fallthrough to WRITE
   case WRITE:
-    outFile_.close();
+    closeWrite();
     tmp = fNameIn_;
     fNameIn_ = fNameOut_;
     if(tmp != "")
@@ -173,8 +194,7 @@ FFTFileGrid::getNextComplex()
   assert(istransformed_==true);
   assert(accMode_ == READ || accMode_ == READANDWRITE);
   fftw_complex cVal;
-  char * buffer = reinterpret_cast<char *>(&cVal);
-  inFile_.read(buffer,sizeof(fftw_complex));
+  readValues(reinterpret_cast<fftw_real *>(&cVal), 2);
   return(cVal);
 }
 
@@ -185,9 +205,8 @@ FFTFileGrid::getNextReal()
 {
   assert(istransformed_ == false);
   assert(accMode_ == READ || accMode_ == READANDWRITE);
-  float rVal;
-  char * buffer = reinterpret_cast<char *>(&rVal);
-  inFile_.read(buffer,sizeof(float));
+  fftw_real rVal;
+  readValues(&rVal, 1);
   return float(rVal);
 }
 
@@ -255,19 +274,34 @@ FFTFileGrid::SetNextComplex(std::complex<double> & value)
   fftw_complex tmp;
   tmp.re = static_cast<fftw_real>(value.real());
   tmp.im = static_cast<fftw_real>(value.imag());
-  char * buffer = reinterpret_cast<char *>(&tmp);
-  outFile_.write(buffer,sizeof(fftw_complex));
+  writeValues(reinterpret_cast<fftw_real *>(&tmp), 2);
   return(0);
 }
 
 
+void
+FFTFileGrid::skipNextComplex(int n)
+{
+  assert(istransformed_==true);
+  assert(accMode_ == READ || accMode_ == READANDWRITE);
+  if(n <= 0)
+    return;
+  if(accMode_ == READ) {
+    inNext_ += 2*n;
+  }
+  else { // The output file is written in full, so the values are copied.
+    std::vector<fftw_real> values(2*n);
+    readValues(&values[0], 2*n);
+    writeValues(&values[0], 2*n);
+  }
+}
+
 int
 FFTFileGrid::setNextComplex(fftw_complex value)
 {
   assert(istransformed_==true);
   assert(accMode_ == READANDWRITE || accMode_ == WRITE);
-  char * buffer = reinterpret_cast<char *>(&value);
-  outFile_.write(buffer,sizeof(fftw_complex));
+  writeValues(reinterpret_cast<fftw_real *>(&value), 2);
   return(0);
 }
 
@@ -277,8 +311,7 @@ FFTFileGrid::setNextReal(float  value)
 {
   assert(istransformed_== false);
   assert(accMode_ == READANDWRITE || accMode_ == WRITE);
-  char * buffer = reinterpret_cast<char *>(&value);
-  outFile_.write(buffer,sizeof(float));
+  writeValues(&value, 1);
   return(0);
 }
 
@@ -327,6 +360,20 @@ FFTFileGrid::expTransf()
   return(0);
 }
 
+int
+FFTFileGrid::expTransf(float shift, float offset, float scale)
+{
+  assert(accMode_ == NONE || accMode_ == RANDOMACCESS);
+  if(accMode_ != RANDOMACCESS)
+    load();
+  else
+    modified_ = 1;
+  FFTGrid::expTransf(shift, offset, scale);
+  if(accMode_ != RANDOMACCESS)
+    save();
+  return(0);
+}
+
 int
 FFTFileGrid::logTransf()
 {
@@ -341,6 +388,20 @@ FFTFileGrid::logTransf()
   return(0);
 }
 
+int
+FFTFileGrid::logTransf(float scale, float offset, float shift)
+{
+  assert(accMode_ == NONE || accMode_ == RANDOMACCESS);
+  if(accMode_ != RANDOMACCESS)
+    load();
+  else
+    modified_ = 1;
+  FFTGrid::logTransf(scale, offset, shift);
+  if(accMode_ != RANDOMACCESS)
+    save();
+  return(0);
+}
+
 int
 FFTFileGrid::collapseAndAdd(float * grid)
 {
@@ -570,6 +631,84 @@ FFTFileGrid::conjugate()
     save();
 }
 
+void
+FFTFileGrid::axpby(float a, float b, FFTGrid * y)
+{
+  assert(accMode_ == NONE || accMode_ == RANDOMACCESS);
+  if(accMode_ != RANDOMACCESS)
+    load();
+  else
+    modified_ = 1;
+  assert(nxp_==y->getNxp());
+  y->setAccessMode(READ);
+
+  if(istransformed_==true)
+  {
+    int i;
+    fftw_complex value;
+    for(i=0;i<csize_;i++)
+    {
+      value = y->getNextComplex();
+      cvalue_[i].re = a*cvalue_[i].re + b*value.re;
+      cvalue_[i].im = a*cvalue_[i].im + b*value.im;
+    }
+  }
+  else
+  {
+    int i;
+    for(i=0;i < rsize_;i++)
+    {
+      rvalue_[i] = a*rvalue_[i] + b*y->getNextReal();
+    }
+  }
+  y->endAccess();
+
+  if(accMode_ != RANDOMACCESS)
+    save();
+}
+
+void
+FFTFileGrid::multiplyAdd(FFTGrid * x, FFTGrid * y, bool conjugateY)
+{
+  assert(accMode_ == NONE || accMode_ == RANDOMACCESS);
+  if(accMode_ != RANDOMACCESS)
+    load();
+  else
+    modified_ = 1;
+  assert(nxp_==x->getNxp() && nxp_==y->getNxp());
+  x->setAccessMode(READ);
+  y->setAccessMode(READ);
+
+  if(istransformed_==true)
+  {
+    int i;
+    fftw_complex xValue, yValue;
+    for(i=0;i<csize_;i++)
+    {
+      xValue = x->getNextComplex();
+      yValue = y->getNextComplex();
+      if(conjugateY)
+        yValue.im = -yValue.im;
+      cvalue_[i].re += xValue.re*yValue.re - xValue.im*yValue.im;
+      cvalue_[i].im += xValue.im*yValue.re + xValue.re*yValue.im;
+    }
+  }
+  else
+  {
+    int i;
+    for(i=0;i < rsize_;i++)
+    {
+      float xValue = x->getNextReal();
+      rvalue_[i] += xValue*y->getNextReal();
+    }
+  }
+  x->endAccess();
+  y->endAccess();
+
+  if(accMode_ != RANDOMACCESS)
+    save();
+}
+
 void
 FFTFileGrid::fillInComplexNoise(RandomGen * ranGen)
 {
@@ -617,6 +756,17 @@ FFTFileGrid::writeStormFile(const std::string & fileName, const Simbox * simbox,
     unload();
 }
 
+void
+FFTFileGrid::writeChunkedFile(const std::string & fileName, const Simbox * simbox, bool padding)
+{
+  assert(accMode_ == NONE || accMode_ == RANDOMACCESS);
+  if(accMode_ != RANDOMACCESS)
+    load();
+  FFTGrid::writeChunkedFile(fileName, simbox, padding);
+  if(accMode_ != RANDOMACCESS)
+    unload();
+}
+
 
 int
 FFTFileGrid::writeSegyFile(const std::string & fileName, const Simbox * simbox, float z0, const TraceHeaderFormat &thf,
@@ -643,15 +793,16 @@ FFTFileGrid::writeSgriFile(const std::string & fileName, const Simbox * simbox,
   return(ok);
 }
 
-void
+bool
 FFTFileGrid::writeCravaFile(const std::string & fileName, const Simbox * simbox)
 {
   assert(accMode_ == NONE || accMode_ == RANDOMACCESS);
   if(accMode_ != RANDOMACCESS)
     load();
-  FFTGrid::writeCravaFile(fileName,simbox);
+  bool ok = FFTGrid::writeCravaFile(fileName,simbox);
   if(accMode_ != RANDOMACCESS)
     unload();
+  return(ok);
 }
 
 
@@ -677,15 +828,10 @@ FFTFileGrid::load()
     FFTGrid::createComplexGrid();
   if(fNameIn_ != "") //Something has been saved.
   {
-    int i, nRead = 1;
-    NRLib::OpenRead(inFile_,fNameIn_,std::ios::in | std::ios::binary);
     //Real/complex does not matter in next line, since same meory is used.
-    for(i=0;((i<rsize_) && (nRead == 1));i++)
-    {
-      char * buffer = reinterpret_cast<char *>(&(rvalue_[i]));
-      inFile_.read(buffer,sizeof(float));
-    }
-    inFile_.close();
+    openRead();
+    readValues(rvalue_, rsize_);
+    closeRead();
   }
 }
 
@@ -693,15 +839,10 @@ void
 FFTFileGrid::save()
 {
   assert(accMode_ == NONE || accMode_ == RANDOMACCESS);
-  NRLib::OpenWrite(outFile_,fNameOut_,std::ios::out | std::ios::binary);
   //Real/complex does not matter in next line, since same meory is used.
-  int i, nWritten = 1;
-  for(i=0;((i<rsize_) && (nWritten == 1));i++)
-  {
-    char * buffer = reinterpret_cast<char *>(&(rvalue_[i]));
-    outFile_.write(buffer,sizeof(float));
-  }
-  outFile_.close();
+  openWrite();
+  writeValues(rvalue_, rsize_);
+  closeWrite();
   unload();
   std::string tmp = fNameIn_;
   fNameIn_ = fNameOut_;
@@ -711,10 +852,109 @@ FFTFileGrid::save()
     fNameOut_ = fNameIn_+"b";
 }
 
+void
+FFTFileGrid::openRead()
+{
+  NRLib::OpenRead(inFile_,fNameIn_,std::ios::in | std::ios::binary);
+  reader_      = new NRLib::ChunkedGridReader(inFile_);
+  inBand_.Resize(0, 0, 0);
+  inBandStart_ = 0;
+  inNext_      = 0;
+}
+
+void
+FFTFileGrid::closeRead()
+{
+  delete reader_;
+  reader_ = NULL;
+  inFile_.close();
+}
+
+void
+FFTFileGrid::readValues(fftw_real * values, int n)
+{
+  int done = 0;
+  while(done < n)
+  {
+    int bandSize = static_cast<int>(inBand_.GetN());
+    if(inNext_ < inBandStart_ || inNext_ >= inBandStart_ + bandSize)
+    {
+      readBand();
+      bandSize = static_cast<int>(inBand_.GetN());
+    }
+    int offset = inNext_ - inBandStart_;
+    int m      = std::min(n - done, bandSize - offset);
+    std::copy(inBand_.begin() + offset, inBand_.begin() + offset + m, values + done);
+    done    += m;
+    inNext_ += m;
+  }
+}
+
+void
+FFTFileGrid::readBand()
+{
+  assert(inNext_ < rsize_);
+  int nRows = rsize_/rnxp_;
+  int row0  = (inNext_/rnxp_/band_rows)*band_rows;
+  inFile_.clear();
+  reader_->ReadSubGrid(0, row0, 0, rnxp_, std::min(band_rows, nRows - row0), 1, inBand_);
+  inBandStart_ = row0*rnxp_;
+}
+
+void
+FFTFileGrid::openWrite()
+{
+  // Intermediate results must be kept exactly, so the file is lossless.
+  int nRows = rsize_/rnxp_;
+  NRLib::OpenWrite(outFile_,fNameOut_,std::ios::out | std::ios::binary);
+  writer_  = new NRLib::ChunkedGridWriter(outFile_, rnxp_, nRows, 1, RMISSING, 0.0, band_rows, nThreads_);
+  outRow_  = 0;
+  outNext_ = 0;
+  outBand_.Resize(rnxp_, std::min(band_rows, nRows), 1);
+}
+
+void
+FFTFileGrid::writeValues(const fftw_real * values, int n)
+{
+  int nRows = rsize_/rnxp_;
+  int done  = 0;
+  while(done < n)
+  {
+    int bandSize = static_cast<int>(outBand_.GetN());
+    assert(bandSize > 0);
+    int m = std::min(n - done, bandSize - outNext_);
+    std::copy(values + done, values + done + m, outBand_.begin() + outNext_);
+    done     += m;
+    outNext_ += m;
+    if(outNext_ == bandSize)
+    {
+      writer_->WriteBand(outBand_);
+      outRow_  += static_cast<int>(outBand_.GetNJ());
+      outNext_  = 0;
+      outBand_.Resize(rnxp_, std::min(band_rows, nRows - outRow_), 1);
+    }
+  }
+}
+
+void
+FFTFileGrid::closeWrite()
+{
+  // Values never set are zero, as in a grid in memory.
+  if(outNext_ > 0 || outRow_ < rsize_/rnxp_)
+  {
+    std::vector<fftw_real> zeros(rsize_ - outRow_*rnxp_ - outNext_, 0.0f);
+    writeValues(&zeros[0], static_cast<int>(zeros.size()));
+  }
+  writer_->Finish();
+  delete writer_;
+  writer_ = NULL;
+  outFile_.close();
+}
+
 void
 FFTFileGrid::unload()
 {
-  fftw_free(rvalue_); // changed
+  GridMemoryPool::Release(rvalue_, rsize_);
   nGrids_ = nGrids_ - 1;
 // LogKit::LogFormatted(LogKit::Error,"\nFFTFileGrid unload: nGrids_ = %d\n",nGrids_);
   rvalue_ = NULL;
@@ -774,4 +1014,29 @@ FFTFileGrid::setRealTrace(int i, int j, float *value)
 }
 
 
+void
+FFTFileGrid::getRealRow(float * value, int j, int k)
+{
+  assert(accMode_ == NONE || accMode_ == RANDOMACCESS);
+  if(accMode_ != RANDOMACCESS)
+    load();
+  FFTGrid::getRealRow(value, j, k);
+  if(accMode_ != RANDOMACCESS)
+    save();
+}
+
+void
+FFTFileGrid::setRealRow(int j, int k, const float * value)
+{
+  assert(accMode_ == NONE || accMode_ == RANDOMACCESS);
+  if(accMode_ != RANDOMACCESS)
+    load();
+  else
+    modified_ = 1;
+  FFTGrid::setRealRow(j, k, value);
+  if(accMode_ != RANDOMACCESS)
+    save();
+}
+
+
 int FFTFileGrid::gNum = 0; //Starting value
@@ -8,12 +8,25 @@
 #include <string>
 #include "fftw.h"
 
+#include "nrlib/grid/grid.hpp"
+
 #include "fftgrid.h"
 
 class Wavelet;
 class Simbox;
 class GridMapping;
 
+namespace NRLib {
+  class ChunkedGridReader;
+  class ChunkedGridWriter;
+}
+
+//
+// A grid kept in a temporary file while not accessed. The file is a
+// lossless chunked grid of rnxp_ x nyp_*nzp_ values, in the order of the
+// values in memory, and is read and written in bands of rows.
+//
+
 class FFTFileGrid : public FFTGrid
 {
 public:
@@ -28,11 +41,14 @@ public:
   int          setRealValue(int i, int j, int k, float value, bool extSimbox = false);
   int          SetNextComplex(std::complex<double> & value);
   int          setNextComplex(fftw_complex);
+  void         skipNextComplex(int n);
   int          setNextReal(float);
   float        getFirstRealValue();
   int          square();
   int          expTransf();
+  int          expTransf(float shift, float offset, float scale);
   int          logTransf();
+  int          logTransf(float scale, float offset, float shift);
   void         multiplyByScalar(float scalar);
   int          collapseAndAdd(float*);
   void         add(FFTGrid* fftGrid);
@@ -41,6 +57,8 @@ public:
   void         changeSign();
   void         multiply(FFTGrid* fftGrid);              // pointwise multiplication!
   void         conjugate();
+  void         axpby(float a, float b, FFTGrid * y);
+  void         multiplyAdd(FFTGrid * x, FFTGrid * y, bool conjugateY = false);
   void         fillInComplexNoise(RandomGen * ranGen);
   void         fftInPlace();
   void         invFFTInPlace();
@@ -60,24 +78,35 @@ public:
                          const std::vector<std::string> & headerText        = std::vector<std::string>());
   void         writeStormFile(const std::string & fileName, const Simbox * simbox, bool ascii = false,
                               bool padding = false, bool flat = false, bool scientific_format = false);
+  void         writeChunkedFile(const std::string & fileName, const Simbox * simbox, bool padding = false);
   int          writeSegyFile(const std::string & fileName, const Simbox * simbox, float z0,
                              const TraceHeaderFormat &thf = TraceHeaderFormat(TraceHeaderFormat::SEISWORKS),
                              const std::vector<std::string> & headerText = std::vector<std::string>());
   int          writeSgriFile(const std::string & fileName, const Simbox *simbox, const std::string label);
   void         writeResampledStormCube(const GridMapping *gridmapping, const std::string & fileName,
                                        const Simbox *simbox, const int format);
-  void         writeCravaFile(const std::string & fileName, const Simbox * simbox);
+  bool         writeCravaFile(const std::string & fileName, const Simbox * simbox);
   void         readCravaFile(const std::string & fileName, std::string & error, bool nopadding = false);
 
   bool         isFile() {return(1);}
   void         getRealTrace(float * value, int i, int j);
   int          setRealTrace(int i, int j, float *value);
+  void         getRealRow(float * value, int j, int k);
+  void         setRealRow(int j, int k, const float * value);
 private:
   void         genFileName();
   void         load();
   void         unload();
   void         save();
 
+  void         openRead();
+  void         readValues(fftw_real * values, int n);
+  void         readBand();
+  void         closeRead();
+  void         openWrite();
+  void         writeValues(const fftw_real * values, int n);
+  void         closeWrite();
+
   int          accMode_;
   int          modified_;   //Tells if grid is modified during RANDOMACCESS.
   std::string  fNameIn_; //Temporary names, switches whenever a write has occured.
@@ -85,6 +114,15 @@ private:
   std::ifstream inFile_;
   std::ofstream outFile_;
 
+  NRLib::Grid<float>         inBand_;      ///< Decoded rows of inFile_
+  int                        inBandStart_; ///< Position in the grid of the first value in inBand_
+  int                        inNext_;      ///< Position in the grid of the next value read
+  NRLib::ChunkedGridReader * reader_;      ///< Chunk index of inFile_, parsed by openRead()
+  NRLib::ChunkedGridWriter * writer_;
+  NRLib::Grid<float>         outBand_;     ///< Rows collected for writer_
+  int                        outRow_;      ///< First row of outBand_
+  int                        outNext_;     ///< Position in outBand_ of the next value written
+
   static int   gNum; //Number used for generating temporary files.
 };
 #endif
@@ -9,6 +9,7 @@
 #include <assert.h>
 #include <stdio.h>
 #include <string>
+#include <algorithm>
 
 #ifdef PARALLEL
 #include <omp.h>
@@ -31,6 +32,9 @@
 #include "src/fftgrid.h"
 #include "src/simbox.h"
 #include "src/timings.h"
+#include "src/profiler.h"
+#include "src/gridmemorypool.h"
+#include "src/taskgraph.h"
 #include "src/definitions.h"
 #include "src/gridmapping.h"
 #include "src/io.h"
@@ -61,6 +65,8 @@ FFTGrid::FFTGrid(int nx, int ny, int nz, int nxp, int nyp, int nzp)
   counterForSet_  = 0;
   istransformed_  = false;
   rvalue_         = NULL;
+  spillStream_    = NULL;
+  spillNextTrace_ = 0;
   add_            = true;
 
   // index= i+rnxp_*j+k*rnxp_*nyp_;
@@ -93,6 +99,8 @@ FFTGrid::FFTGrid(FFTGrid * fftGrid, bool expTrans)
   counterForGet_  = fftGrid->getCounterForGet();
   counterForSet_  = fftGrid->getCounterForSet();
   add_            = fftGrid->add_;
+  spillStream_    = NULL;
+  spillNextTrace_ = 0;
   istransformed_  = fftGrid->getIsTransformed();
 
   if(istransformed_ == false) {
@@ -146,6 +154,8 @@ FFTGrid::FFTGrid(const NRLib::Grid<float> * grid, int nxp, int nyp, int nzp)
   counterForSet_  = 0;
   istransformed_  = false;
   rvalue_         = NULL;
+  spillStream_    = NULL;
+  spillNextTrace_ = 0;
   add_            = true;
 
   // Copied from Background::createPaddedParameter
@@ -240,6 +250,8 @@ FFTGrid::FFTGrid(const StormContGrid * grid, int nxp, int nyp, int nzp)
   counterForSet_  = 0;
   istransformed_  = false;
   rvalue_         = NULL;
+  spillStream_    = NULL;
+  spillNextTrace_ = 0;
   add_            = true;
 
   // Copied from Background::createPaddedParameter
@@ -310,12 +322,17 @@ FFTGrid::FFTGrid(const StormContGrid * grid, int nxp, int nyp, int nzp)
 
 FFTGrid::~FFTGrid()
 {
+  if (spillStream_ != NULL)
+    delete spillStream_;
+  if (spillFile_ != "")
+    NRLib::RemoveFile(spillFile_);
+
   if (rvalue_!=NULL)
   {
     if(add_==true)
       nGrids_ = nGrids_ - 1;
 
-    fftw_free(rvalue_); //delete rvalue_;
+    GridMemoryPool::Release(rvalue_, rsize_);
 
     FFTMemUse_ -= rsize_ * sizeof(fftw_real);
     LogKit::LogFormatted(LogKit::DebugLow,"\nFFTGrid Destructor: nGrids_ = %d",nGrids_);
@@ -1069,7 +1086,7 @@ FFTGrid::createComplexGrid()
 
 void FFTGrid::createGrid()
 {
-  rvalue_         = static_cast<fftw_real*>(fftw_malloc(rsize_ * sizeof(fftw_real))); //new fftw_real[rsize_]; //static_cast<fftw_real*>(fftw_malloc(rsize_ * sizeof(fftw_real)));
+  rvalue_         = GridMemoryPool::Allocate(rsize_, nThreads_);
 
   cvalue_         = reinterpret_cast<fftw_complex*>(rvalue_); //
 
@@ -1100,6 +1117,7 @@ void FFTGrid::createGrid()
     maxFFTMemUse_ = FFTMemUse_;
     LogKit::LogFormatted(LogKit::DebugLow,"\nNew FFT-grid memory peak (%2d): %10.2f MB\n",nGrids_, FFTMemUse_/(1024.f*1024.f));
   }
+  Profiler::UpdateFFTGridMemory(FFTMemUse_);
 
 
 
@@ -1283,11 +1301,76 @@ FFTGrid::getRealTrace(int i, int j, bool add_padding) const
     z_end = nzp_;
   std::vector<float> value(z_end);
 
+  if (spillFile_ != "") {
+    // Values beyond nz_ are outside the simbox, as for getRealValue().
+    int trace = i*ny_ + j;
+    if (spillStream_ == NULL) {
+      spillStream_    = new std::ifstream;
+      NRLib::OpenRead(*spillStream_, spillFile_, std::ios::in | std::ios::binary);
+      spillNextTrace_ = 0;
+    }
+    if (trace != spillNextTrace_) {
+      spillStream_->clear();
+      spillStream_->seekg(static_cast<std::streamoff>(trace)*nz_*sizeof(float));
+    }
+    spillStream_->read(reinterpret_cast<char *>(&value[0]), nz_*sizeof(float));
+    if (!(*spillStream_))
+      throw NRLib::IOError("Could not read trace from spill file " + spillFile_);
+    spillNextTrace_ = trace + 1;
+    if (spillNextTrace_ == nx_*ny_) {
+      // The last trace ends the pass, and the file is closed until the next one.
+      delete spillStream_;
+      spillStream_ = NULL;
+    }
+    for (int k = nz_; k < z_end; k++)
+      value[k] = RMISSING;
+    return value;
+  }
+
   for(int k = 0; k < z_end; k++)
     value[k] = getRealValue(i,j,k);
   return value;
 }
 
+void
+FFTGrid::spillToDisk()
+{
+  assert(istransformed_ == false);
+  assert(spillFile_ == "");
+
+  std::string baseName = IO::PrefixTmpGrids() + "spill_" + NRLib::ToString(nSpilled_++);
+  std::string fileName = IO::makeFullFileName(IO::PathToTmpFiles(), baseName);
+
+  std::ofstream outFile;
+  NRLib::OpenWrite(outFile, fileName, std::ios::out | std::ios::binary);
+  std::vector<float> trace(nz_);
+  for (int i = 0; i < nx_; i++) {
+    for (int j = 0; j < ny_; j++) {
+      for (int k = 0; k < nz_; k++)
+        trace[k] = rvalue_[i + rnxp_*j + k*rnxp_*nyp_];
+      outFile.write(reinterpret_cast<char *>(&trace[0]), nz_*sizeof(float));
+    }
+  }
+  bool ok = static_cast<bool>(outFile);
+  outFile.close();
+  if (!ok)
+    throw NRLib::IOError("Could not write spill file " + fileName);
+
+  Profiler::AddCount("bytes_spilled", static_cast<double>(nx_)*ny_*nz_*sizeof(float));
+
+  if (add_ == true)
+    nGrids_ = nGrids_ - 1;
+  GridMemoryPool::Release(rvalue_, rsize_);
+  FFTMemUse_ -= rsize_ * sizeof(fftw_real);
+  rvalue_ = NULL;
+  cvalue_ = NULL;
+
+  // The file is opened by getRealTrace() for one pass over the traces, so
+  // that the many grids spilled before CombineResult() do not all hold a
+  // file descriptor.
+  spillFile_      = fileName;
+}
+
 float
 FFTGrid::getRealValueCyclic(int i, int j, int k) const
 {
@@ -1410,6 +1493,17 @@ FFTGrid::setNextComplex(fftw_complex value)
   return(0);
 }
 
+void
+FFTGrid::skipNextComplex(int n)
+{
+  // Moves both counters, so values are left as they are whether the
+  // grid is read only or read and written in place.
+  assert(istransformed_==true);
+  assert(counterForGet_ + n <= csize_);
+  counterForGet_ = (counterForGet_ + n) % csize_;
+  counterForSet_ = (counterForSet_ + n) % csize_;
+}
+
 int
 FFTGrid::SetNextComplex(std::complex<double> & value)
 {
@@ -1465,6 +1559,22 @@ FFTGrid::setRealValue(int i, int j ,int k, float  value, bool extSimbox)
     return( 1 );
 }
 
+void
+FFTGrid::getRealRow(float * value, int j, int k)
+{
+  assert(istransformed_ == false);
+  const fftw_real * row = rvalue_ + static_cast<size_t>(k)*rnxp_*nyp_ + static_cast<size_t>(j)*rnxp_;
+  std::copy(row, row + nxp_, value);
+}
+
+void
+FFTGrid::setRealRow(int j, int k, const float * value)
+{
+  assert(istransformed_ == false);
+  fftw_real * row = rvalue_ + static_cast<size_t>(k)*rnxp_*nyp_ + static_cast<size_t>(j)*rnxp_;
+  std::copy(value, value + nxp_, row);
+}
+
 int FFTGrid::setRealTrace(int i, int j, float *value)
 {
   int notok;
@@ -1500,37 +1610,35 @@ FFTGrid::setComplexValue(int i, int j ,int k, fftw_complex value, bool extSimbox
 int
 FFTGrid::square()
 {
-  int i;
-
   if(istransformed_==true)
   {
-    for(i = 0;i < csize_; i++)
+    fftw_complex * c = cvalue_;
+#ifdef PARALLEL
+#pragma omp parallel for schedule(static) num_threads(nThreads_) if(csize_ > minParallelSize_)
+#endif
+    for(int i = 0;i < csize_; i++)
     {
-      if ( cvalue_[i].re == RMISSING || cvalue_[i].im == RMISSING)
+      if ( c[i].re == RMISSING || c[i].im == RMISSING)
       {
-        cvalue_[i].re = RMISSING;
-        cvalue_[i].im = RMISSING;
+        c[i].re = RMISSING;
+        c[i].im = RMISSING;
       }
       else
       {
-        cvalue_[i].re = cvalue_[i].re * cvalue_[i].re + cvalue_[i].im * cvalue_[i].im;
-        cvalue_[i].im = 0.0;
+        c[i].re = c[i].re * c[i].re + c[i].im * c[i].im;
+        c[i].im = 0.0;
       }
     } // i
   }
   else
   {
-    for(i = 0;i < rsize_; i++)
+    fftw_real * r = rvalue_;
+#ifdef PARALLEL
+#pragma omp parallel for schedule(static) num_threads(nThreads_) if(rsize_ > minParallelSize_)
+#endif
+    for(int i = 0;i < rsize_; i++)
     {
-      if( rvalue_[i]== RMISSING)
-      {
-        rvalue_[i] = RMISSING;
-      }
-      else
-      {
-        rvalue_[i] = float( rvalue_[i]*rvalue_[i] );
-      }
-
+      r[i] = (r[i] == RMISSING ? static_cast<fftw_real>(RMISSING) : r[i]*r[i]);
     }// i
   }
 
@@ -1540,19 +1648,22 @@ FFTGrid::square()
 int
 FFTGrid::expTransf()
 {
+  return(FFTGrid::expTransf(0.0f, 0.0f, 1.0f));
+}
+
+int
+FFTGrid::expTransf(float shift, float offset, float scale)
+{
+  // value <- scale*(exp(value + shift) + offset). Missing values are kept.
   assert(istransformed_==false);
-  int i;
-  for(i = 0;i < rsize_; i++)
+  fftw_real * r = rvalue_;
+#ifdef PARALLEL
+#pragma omp parallel for schedule(static) num_threads(nThreads_) if(rsize_ > minParallelSize_)
+#endif
+  for(int i = 0;i < rsize_; i++)
   {
-    if( rvalue_[i]== RMISSING)
-    {
-      rvalue_[i] = RMISSING;
-    }
-    else
-    {
-      rvalue_[i] = float( exp(rvalue_[i]) );
-    }
-
+    if( r[i] != RMISSING)
+      r[i] = static_cast<fftw_real>(scale*(exp(r[i] + shift) + offset));
   }// i
   return(0);
 }
@@ -1560,19 +1671,27 @@ FFTGrid::expTransf()
 int
 FFTGrid::logTransf()
 {
+  return(FFTGrid::logTransf(1.0f, 0.0f, 0.0f));
+}
+
+int
+FFTGrid::logTransf(float scale, float offset, float shift)
+{
+  // value <- log(scale*value + offset) + shift. Missing values and
+  // non-positive arguments give shift, as logTransf() followed by
+  // addScalar(shift) would.
   assert(istransformed_==false);
-  int i;
-  for(i = 0;i < rsize_; i++)
+  fftw_real * r = rvalue_;
+#ifdef PARALLEL
+#pragma omp parallel for schedule(static) num_threads(nThreads_) if(rsize_ > minParallelSize_)
+#endif
+  for(int i = 0;i < rsize_; i++)
   {
-    if( rvalue_[i]== RMISSING ||  rvalue_[i] <= 0.0 )
-    {
-      rvalue_[i] = 0;
-    }
+    float arg = scale*r[i] + offset;
+    if( r[i] == RMISSING || arg <= 0.0 )
+      r[i] = shift;
     else
-    {
-      rvalue_[i] = float( log(rvalue_[i]) );
-    }
-
+      r[i] = static_cast<fftw_real>(log(arg) + shift);
   }// i
   return(0);
 }
@@ -1608,17 +1727,39 @@ FFTGrid::fftInPlace()
   assert(istransformed_==false);
   assert(cubetype_!= CTMISSING);
 
+  float scale = 1.0f;
   if( cubetype_!= COVARIANCE )
-    FFTGrid::multiplyByScalar(1.0f/sqrt(static_cast<float>(nxp_*nyp_*nzp_)));
+    scale = 1.0f/sqrt(static_cast<float>(nxp_*nyp_*nzp_));
 
-  int flag;
-  rfftwnd_plan plan;
-  flag = FFTW_ESTIMATE | FFTW_IN_PLACE;
-  plan= rfftw3d_create_plan(nzp_,nyp_,nxp_,FFTW_REAL_TO_COMPLEX,flag);
-  rfftwnd_one_real_to_complex(plan,rvalue_,cvalue_);
-  fftwnd_destroy_plan(plan);
+  if(useSlabFFT())
+  {
+    transformXYPlanes(true, scale);
+    transformZColumns(true);
+  }
+  else
+  {
+    if(scale != 1.0f)
+      FFTGrid::multiplyByScalar(scale);
+
+    int flag;
+    rfftwnd_plan plan;
+    flag = FFTW_ESTIMATE | FFTW_IN_PLACE;
+#ifdef PARALLEL
+#pragma omp critical(fftw_planner)
+#endif
+    plan= rfftw3d_create_plan(nzp_,nyp_,nxp_,FFTW_REAL_TO_COMPLEX,flag);
+    rfftwnd_one_real_to_complex(plan,rvalue_,cvalue_);
+#ifdef PARALLEL
+#pragma omp critical(fftw_planner)
+#endif
+    fftwnd_destroy_plan(plan);
+  }
+  Profiler::AddFFT("3d_forward");
   istransformed_=true;
   time(&timeend);
+#ifdef PARALLEL
+#pragma omp critical(fftgrid_log)
+#endif
   LogKit::LogFormatted(LogKit::DebugLow,"\nFFT of grid type %d finished after %ld seconds \n",cubetype_, timeend-timestart);
 }
 
@@ -1637,138 +1778,285 @@ FFTGrid::invFFTInPlace()
   assert(cubetype_!= CTMISSING);
 
   float scale;
-  int flag;
-  rfftwnd_plan plan;
   if(cubetype_==COVARIANCE)
     scale=float( 1.0/(nxp_*nyp_*nzp_));
   else
     scale=float( 1.0/sqrt(float(nxp_*nyp_*nzp_)));
 
-  flag = FFTW_ESTIMATE | FFTW_IN_PLACE;
-  plan= rfftw3d_create_plan(nzp_,nyp_,nxp_,FFTW_COMPLEX_TO_REAL,flag);
-  rfftwnd_one_complex_to_real(plan,cvalue_,rvalue_);
-  fftwnd_destroy_plan(plan);
+  bool slab = useSlabFFT();
+  if(slab)
+  {
+    transformZColumns(false);
+    transformXYPlanes(false, scale);
+  }
+  else
+  {
+    int flag;
+    rfftwnd_plan plan;
+    flag = FFTW_ESTIMATE | FFTW_IN_PLACE;
+#ifdef PARALLEL
+#pragma omp critical(fftw_planner)
+#endif
+    plan= rfftw3d_create_plan(nzp_,nyp_,nxp_,FFTW_COMPLEX_TO_REAL,flag);
+    rfftwnd_one_complex_to_real(plan,cvalue_,rvalue_);
+#ifdef PARALLEL
+#pragma omp critical(fftw_planner)
+#endif
+    fftwnd_destroy_plan(plan);
+  }
+  Profiler::AddFFT("3d_inverse");
   istransformed_=false;
 
-  FFTGrid::multiplyByScalar(scale);
+  if(!slab)
+    FFTGrid::multiplyByScalar(scale);
+
   time(&timeend);
+#ifdef PARALLEL
+#pragma omp critical(fftgrid_log)
+#endif
   LogKit::LogFormatted(LogKit::DebugLow,"\nInverse FFT of grid type %d finished after %ld seconds \n",cubetype_, timeend-timestart);
 }
 
+bool
+FFTGrid::useSlabFFT() const
+{
+  // The single 3D transform is kept for serial runs. With more threads the
+  // transform is split in xy-planes and z-columns (slab decomposition).
+  // Inside a parallel region (e.g. a TaskGraph task) the grid gets one thread.
+  bool inParallel = false;
+#ifdef PARALLEL
+  inParallel = (omp_in_parallel() != 0);
+#endif
+  return(nThreads_ > 1 && nzp_ > 1 && rsize_ > minParallelSize_ && !inParallel);
+}
+
 void
-FFTGrid::realAbs()
+FFTGrid::fftInPlaceAll(const std::vector<FFTGrid *> & grids)
 {
-  assert(istransformed_==true);
-  int i;
-  for(i=0;i<csize_;i++)
+  transformAll(grids, true);
+}
+
+void
+FFTGrid::invFFTInPlaceAll(const std::vector<FFTGrid *> & grids)
+{
+  transformAll(grids, false);
+}
+
+void
+FFTGrid::transformAll(const std::vector<FFTGrid *> & grids,
+                      bool                           forward)
+{
+  // A file grid is loaded while it is transformed. It is given the memory
+  // of a grid, and the budget of one grid keeps the disk storage promise.
+  // Grids in memory need no extra memory.
+  double gridMemory = 0.0;
+  for(size_t g = 0; g < grids.size(); g++)
+    if(grids[g]->isFile())
+      gridMemory = std::max(gridMemory, static_cast<double>(grids[g]->getrsize())*sizeof(fftw_real));
+
+  TaskGraph tasks(nThreads_, gridMemory);
+  for(size_t g = 0; g < grids.size(); g++)
   {
-    cvalue_[i].re = float (  sqrt( cvalue_[i].re * cvalue_[i].re ) );
-    cvalue_[i].im = 0.0;
+    double memory = (grids[g]->isFile() ? gridMemory : 0.0);
+    if(forward)
+      tasks.AddTask(MakeTask(grids[g], &FFTGrid::fftInPlace), "FFT of grid", memory);
+    else
+      tasks.AddTask(MakeTask(grids[g], &FFTGrid::invFFTInPlace), "Inverse FFT of grid", memory);
   }
+  tasks.Run();
 }
 
 void
-FFTGrid::add(FFTGrid* fftGrid)
+FFTGrid::transformXYPlanes(bool forward, float scale)
 {
-  assert(nxp_==fftGrid->getNxp());
-  if(istransformed_==true)
+  // 2D real transform of each xy-plane. The planes are contiguous in the
+  // in-place layout, so every thread works on its own part of the grid.
+  // The normalization is applied to the real values in the same pass.
+  int flag = FFTW_ESTIMATE | FFTW_IN_PLACE | FFTW_THREADSAFE;
+  rfftwnd_plan plan;
+#ifdef PARALLEL
+#pragma omp critical(fftw_planner)
+#endif
+  plan              = rfftw2d_create_plan(nyp_, nxp_, (forward ? FFTW_REAL_TO_COMPLEX : FFTW_COMPLEX_TO_REAL), flag);
+  int planeSize     = rnxp_*nyp_;
+
+#ifdef PARALLEL
+#pragma omp parallel for schedule(dynamic, 1) num_threads(nThreads_)
+#endif
+  for(int k = 0; k < nzp_; k++)
   {
-    int i;
-    for(i=0;i<csize_;i++)
+    fftw_real * plane = rvalue_ + static_cast<size_t>(k)*planeSize;
+    if(forward)
     {
-      cvalue_[i].re += fftGrid->cvalue_[i].re;
-      cvalue_[i].im += fftGrid->cvalue_[i].im;
+      if(scale != 1.0f)
+        for(int i = 0; i < planeSize; i++)
+          plane[i] *= scale;
+      rfftwnd_one_real_to_complex(plan, plane, NULL);
+    }
+    else
+    {
+      rfftwnd_one_complex_to_real(plan, reinterpret_cast<fftw_complex*>(plane), NULL);
+      if(scale != 1.0f)
+        for(int i = 0; i < planeSize; i++)
+          plane[i] *= scale;
     }
   }
+#ifdef PARALLEL
+#pragma omp critical(fftw_planner)
+#endif
+  fftwnd_destroy_plan(plan);
+}
+
+void
+FFTGrid::transformZColumns(bool forward)
+{
+  // 1D complex transform along z of all columns. Each thread copies one
+  // y-row of columns at a time into a contiguous buffer (the transpose),
+  // transforms them together and copies the result back.
+  fftw_plan plan;
+#ifdef PARALLEL
+#pragma omp critical(fftw_planner)
+#endif
+  plan             = fftw_create_plan(nzp_, (forward ? FFTW_FORWARD : FFTW_BACKWARD), FFTW_ESTIMATE);
+  int       cPlane = cnxp_*nyp_;
 
-  if(istransformed_==false)
+#ifdef PARALLEL
+#pragma omp parallel num_threads(nThreads_)
+#endif
   {
-    int i;
-    for(i=0;i < rsize_;i++)
+    fftw_complex * in  = static_cast<fftw_complex*>(fftw_malloc(2*nzp_*cnxp_*sizeof(fftw_complex)));
+    fftw_complex * out = in + nzp_*cnxp_;
+
+#ifdef PARALLEL
+#pragma omp for schedule(dynamic, 1)
+#endif
+    for(int j = 0; j < nyp_; j++)
     {
-      rvalue_[i] += fftGrid->rvalue_[i];
+      fftw_complex * row = cvalue_ + j*cnxp_;
+      for(int k = 0; k < nzp_; k++)
+        for(int i = 0; i < cnxp_; i++)
+          in[i*nzp_ + k] = row[i + static_cast<size_t>(k)*cPlane];
+
+      fftw(plan, cnxp_, in, 1, nzp_, out, 1, nzp_);
+
+      for(int k = 0; k < nzp_; k++)
+        for(int i = 0; i < cnxp_; i++)
+          row[i + static_cast<size_t>(k)*cPlane] = out[i*nzp_ + k];
     }
+    fftw_free(in);
   }
+#ifdef PARALLEL
+#pragma omp critical(fftw_planner)
+#endif
+  fftw_destroy_plan(plan);
 }
 
 void
-FFTGrid::addScalar(float scalar)
+FFTGrid::realAbs()
 {
-  // Only addition of scalar in real domain
-  assert(istransformed_==false);
-  int i;
-  for(i=0;i < rsize_;i++)
+  assert(istransformed_==true);
+  fftw_complex * c = cvalue_;
+#ifdef PARALLEL
+#pragma omp parallel for schedule(static) num_threads(nThreads_) if(csize_ > minParallelSize_)
+#endif
+  for(int i=0;i<csize_;i++)
   {
-    rvalue_[i] += scalar;
+    c[i].re = static_cast<fftw_real>(fabs(c[i].re));
+    c[i].im = 0.0;
   }
 }
 
+//
+// The complex grid shares storage with the real grid (rsize_ = 2*csize_),
+// so operations that act on real and imaginary parts alike are done as one
+// flat pass over rsize_ reals, which the compiler can vectorize.
+//
 void
-FFTGrid::subtract(FFTGrid* fftGrid)
+FFTGrid::add(FFTGrid* fftGrid)
 {
   assert(nxp_==fftGrid->getNxp());
-  if(istransformed_==true)
+  fftw_real       * r = rvalue_;
+  const fftw_real * x = fftGrid->rvalue_;
+#ifdef PARALLEL
+#pragma omp parallel for schedule(static) num_threads(nThreads_) if(rsize_ > minParallelSize_)
+#endif
+  for(int i=0;i < rsize_;i++)
   {
-    int i;
-    for(i=0;i<csize_;i++)
-    {
-      cvalue_[i].re -= fftGrid->cvalue_[i].re;
-      cvalue_[i].im -= fftGrid->cvalue_[i].im;
-    }
+    r[i] += x[i];
   }
+}
 
-  if(istransformed_==false)
+void
+FFTGrid::addScalar(float scalar)
+{
+  // Only addition of scalar in real domain
+  assert(istransformed_==false);
+  fftw_real * r = rvalue_;
+#ifdef PARALLEL
+#pragma omp parallel for schedule(static) num_threads(nThreads_) if(rsize_ > minParallelSize_)
+#endif
+  for(int i=0;i < rsize_;i++)
   {
-    int i;
-    for(i=0;i < rsize_;i++)
-    {
-      rvalue_[i] -= fftGrid->rvalue_[i];
-    }
+    r[i] += scalar;
   }
 }
+
 void
-FFTGrid::changeSign()
+FFTGrid::subtract(FFTGrid* fftGrid)
 {
-  if(istransformed_==true)
+  assert(nxp_==fftGrid->getNxp());
+  fftw_real       * r = rvalue_;
+  const fftw_real * x = fftGrid->rvalue_;
+#ifdef PARALLEL
+#pragma omp parallel for schedule(static) num_threads(nThreads_) if(rsize_ > minParallelSize_)
+#endif
+  for(int i=0;i < rsize_;i++)
   {
-    int i;
-    for(i=0;i<csize_;i++)
-    {
-      cvalue_[i].re = -cvalue_[i].re;
-      cvalue_[i].im = -cvalue_[i].im;
-    }
+    r[i] -= x[i];
   }
+}
 
-  if(istransformed_==false)
+void
+FFTGrid::changeSign()
+{
+  fftw_real * r = rvalue_;
+#ifdef PARALLEL
+#pragma omp parallel for schedule(static) num_threads(nThreads_) if(rsize_ > minParallelSize_)
+#endif
+  for(int i=0;i < rsize_;i++)
   {
-    int i;
-    for(i=0;i < rsize_;i++)
-    {
-      rvalue_[i] = -rvalue_[i];
-    }
+    r[i] = -r[i];
   }
 }
+
 void
 FFTGrid::multiply(FFTGrid* fftGrid)
 {
   assert(nxp_==fftGrid->getNxp());
   if(istransformed_==true)
   {
-    int i;
-    for(i=0;i<csize_;i++)
+    fftw_complex       * c = cvalue_;
+    const fftw_complex * x = fftGrid->cvalue_;
+#ifdef PARALLEL
+#pragma omp parallel for schedule(static) num_threads(nThreads_) if(csize_ > minParallelSize_)
+#endif
+    for(int i=0;i<csize_;i++)
     {
-      fftw_complex tmp = cvalue_[i];
-      cvalue_[i].re = fftGrid->cvalue_[i].re*tmp.re - fftGrid->cvalue_[i].im*tmp.im;
-      cvalue_[i].im = fftGrid->cvalue_[i].im*tmp.re + fftGrid->cvalue_[i].re*tmp.im;
+      fftw_complex tmp = c[i];
+      c[i].re = x[i].re*tmp.re - x[i].im*tmp.im;
+      c[i].im = x[i].im*tmp.re + x[i].re*tmp.im;
     }
   }
-
-  if(istransformed_==false)
+  else
   {
-    int i;
-    for(i=0;i < rsize_;i++)
+    fftw_real       * r = rvalue_;
+    const fftw_real * x = fftGrid->rvalue_;
+#ifdef PARALLEL
+#pragma omp parallel for schedule(static) num_threads(nThreads_) if(rsize_ > minParallelSize_)
+#endif
+    for(int i=0;i < rsize_;i++)
     {
-      rvalue_[i] *= fftGrid->rvalue_[i];
+      r[i] *= x[i];
     }
   }
 }
@@ -1777,9 +2065,13 @@ void
 FFTGrid::conjugate()
 {
   assert(istransformed_==true);
+  fftw_complex * c = cvalue_;
+#ifdef PARALLEL
+#pragma omp parallel for schedule(static) num_threads(nThreads_) if(csize_ > minParallelSize_)
+#endif
   for(int i=0;i<csize_;i++)
   {
-    cvalue_[i].im = -cvalue_[i].im;
+    c[i].im = -c[i].im;
   }
 }
 
@@ -1787,9 +2079,67 @@ void
 FFTGrid::multiplyByScalar(float scalar)
 {
   assert(istransformed_==false);
+  fftw_real * r = rvalue_;
+#ifdef PARALLEL
+#pragma omp parallel for schedule(static) num_threads(nThreads_) if(rsize_ > minParallelSize_)
+#endif
   for(int i=0;i<rsize_;i++)
   {
-    rvalue_[i]*=scalar;
+    r[i]*=scalar;
+  }
+}
+
+void
+FFTGrid::axpby(float a, float b, FFTGrid * y)
+{
+  // value <- a*value + b*y in one pass. Works in both domains.
+  assert(nxp_==y->getNxp());
+  assert(istransformed_==y->getIsTransformed());
+  fftw_real       * r  = rvalue_;
+  const fftw_real * yr = y->rvalue_;
+#ifdef PARALLEL
+#pragma omp parallel for schedule(static) num_threads(nThreads_) if(rsize_ > minParallelSize_)
+#endif
+  for(int i=0;i < rsize_;i++)
+  {
+    r[i] = a*r[i] + b*yr[i];
+  }
+}
+
+void
+FFTGrid::multiplyAdd(FFTGrid * x, FFTGrid * y, bool conjugateY)
+{
+  // value <- value + x*y (or x*conj(y)) in one pass. Works in both domains.
+  assert(nxp_==x->getNxp() && nxp_==y->getNxp());
+  assert(istransformed_==x->getIsTransformed() && istransformed_==y->getIsTransformed());
+  if(istransformed_==true)
+  {
+    fftw_complex       * c    = cvalue_;
+    const fftw_complex * xc   = x->cvalue_;
+    const fftw_complex * yc   = y->cvalue_;
+    float                sign = (conjugateY ? -1.0f : 1.0f);
+#ifdef PARALLEL
+#pragma omp parallel for schedule(static) num_threads(nThreads_) if(csize_ > minParallelSize_)
+#endif
+    for(int i=0;i<csize_;i++)
+    {
+      float yim = sign*yc[i].im;
+      c[i].re += xc[i].re*yc[i].re - xc[i].im*yim;
+      c[i].im += xc[i].im*yc[i].re + xc[i].re*yim;
+    }
+  }
+  else
+  {
+    fftw_real       * r  = rvalue_;
+    const fftw_real * xr = x->rvalue_;
+    const fftw_real * yr = y->rvalue_;
+#ifdef PARALLEL
+#pragma omp parallel for schedule(static) num_threads(nThreads_) if(rsize_ > minParallelSize_)
+#endif
+    for(int i=0;i < rsize_;i++)
+    {
+      r[i] += xr[i]*yr[i];
+    }
   }
 }
 
@@ -1865,6 +2215,8 @@ FFTGrid::writeFile(const std::string              & fName,
         FFTGrid::writeStormFile(fileName, simbox, false, padding);
       if((formatFlag_ & IO::ASCII) > 0)
         FFTGrid::writeStormFile(fileName, simbox, true, padding, false, scientific_format);
+      if((formatFlag_ & IO::CHUNKED) > 0)
+        FFTGrid::writeChunkedFile(fileName, simbox, padding);
 
       //SEGY, SGRI CRAVA are never resampled in time.
       if ((formatFlag_ & IO::SEGY) >0)
@@ -1887,6 +2239,8 @@ FFTGrid::writeFile(const std::string              & fName,
           FFTGrid::writeStormFile(depthName, depthMap->getSimbox(), false);
         if ((formatFlag_ & IO::ASCII) > 0)
           FFTGrid::writeStormFile(depthName, depthMap->getSimbox(), true);
+        if ((formatFlag_ & IO::CHUNKED) > 0)
+          FFTGrid::writeChunkedFile(depthName, depthMap->getSimbox());
         if ((formatFlag_ & IO::SEGY) >0)
           makeDepthCubeForSegy(depthMap->getSimbox(),depthName);
       }
@@ -1948,6 +2302,7 @@ FFTGrid::writeStormFile(const std::string & fileName,
         }
     binFile << "0\n";
     binFile.close();
+    Profiler::AddBytesWritten(static_cast<double>(header.size()) + 4.0*nx*ny*nz);
   }
   else {
     gfName = fileName + IO::SuffixGeneralData();
@@ -1977,6 +2332,35 @@ FFTGrid::writeStormFile(const std::string & fileName,
 }
 
 
+void
+FFTGrid::writeChunkedFile(const std::string & fileName,
+                          const Simbox      * simbox,
+                          bool                padding)
+{
+  int nx = (padding ? nxp_ : nx_);
+  int ny = (padding ? nyp_ : ny_);
+  int nz = (padding ? nzp_ : nz_);
+
+  std::string gfName = fileName + IO::SuffixStormChunked();
+  LogKit::LogFormatted(LogKit::Low,"\nWriting chunked STORM file "+gfName+"...");
+
+  StormContGrid grid(nx, ny, nz);
+  for(int k=0;k<nz;k++)
+    for(int j=0;j<ny;j++)
+      for(int i=0;i<nx;i++)
+        grid(i,j,k) = getRealValue(i,j,k,true);
+
+  grid.SetFormat(StormContGrid::STORM_CHUNKED);
+  grid.SetMissingCode(RMISSING);
+  grid.SetQuantizationStep(chunkedQuantizationStep_);
+  grid.SetNumberOfThreads(nThreads_);
+  grid.WriteToFile(gfName, simbox->getStormHeader(cubetype_, nx, ny, nz, false, false));
+  Profiler::AddBytesWritten(static_cast<double>(NRLib::FindFileSize(gfName)));
+
+  LogKit::LogFormatted(LogKit::Low,"done\n");
+}
+
+
 int
 FFTGrid::writeSegyFile(const std::string              & fileName,
                        const Simbox                   * simbox,
@@ -2061,6 +2445,7 @@ FFTGrid::writeSegyFile(const std::string              & fileName,
   }
 
   segy->WriteAllTracesToFile();
+  Profiler::AddBytesWritten(3600.0 + (240.0 + 4.0*segynz)*simbox->getnx()*simbox->getny());
 
   delete segy; //Closes file.
   // delete [] value;
@@ -2117,6 +2502,16 @@ FFTGrid::writeResampledStormCube(const GridMapping * gridmapping,
     outgrid->SetFormat(StormContGrid::STORM_BINARY);
     outgrid->WriteToFile(gfName,header);
   }
+  if ((format & IO::CHUNKED) > 0)
+  {
+    gfName =  fileName + IO::SuffixStormChunked();
+    header = gridmapping->getSimbox()->getStormHeader(FFTGrid::PARAMETER,nx_,ny_,nz, 0, 0);
+    outgrid->SetFormat(StormContGrid::STORM_CHUNKED);
+    outgrid->SetMissingCode(RMISSING);
+    outgrid->SetQuantizationStep(chunkedQuantizationStep_);
+    outgrid->SetNumberOfThreads(nThreads_);
+    outgrid->WriteToFile(gfName,header);
+  }
   if((formatFlag_ & IO::SEGY) > 0)
   {
     gfName =  fileName + IO::SuffixSegy();
@@ -2200,7 +2595,7 @@ FFTGrid::writeSgriFile(const std::string & fileName, const Simbox *simbox, const
 }
 
 
-void
+bool
 FFTGrid::writeCravaFile(const std::string & fileName, const Simbox * simbox)
 {
   try {
@@ -2209,7 +2604,10 @@ FFTGrid::writeCravaFile(const std::string & fileName, const Simbox * simbox)
     std::string fName = fileName + IO::SuffixCrava();
     NRLib::OpenWrite(binFile, fName, std::ios::out | std::ios::binary);
 
+    // Grids in the Fourier domain are only written as checkpoints.
     std::string fileType = "crava_fftgrid_binary";
+    if (istransformed_)
+      fileType += "_fourier";
     binFile << fileType << "\n";
 
     NRLib::WriteBinaryDouble(binFile, simbox->getx0());
@@ -2231,13 +2629,19 @@ FFTGrid::writeCravaFile(const std::string & fileName, const Simbox * simbox)
     for(int i=0;i<rsize_;i++)
       NRLib::WriteBinaryFloat(binFile, rvalue_[i]);
 
+    // Buffered data is only flushed on close, so a full disk shows up here.
     binFile.close();
+    if (binFile.fail())
+      throw NRLib::Exception("Error writing to file " + fName + ".");
+    Profiler::AddBytesWritten(4.0*rsize_);
     LogKit::LogFormatted(LogKit::Low,"done.");
   }
   catch (NRLib::Exception & e) {
     std::string message = "Error: "+std::string(e.what())+"\n";
     LogKit::LogMessage(LogKit::Error, message);
+    return(false);
   }
+  return(true);
 }
 
 
@@ -2278,13 +2682,16 @@ FFTGrid::readCravaFile(const std::string & fileName, std::string & errText, bool
       binFile.close();
       throw(NRLib::Exception("Grid dimension is wrong for file '"+fileName+"'."));
     }
-    createRealGrid(!nopadding);
-    add_ = !nopadding;
+    if (rvalue_ == NULL)
+      createRealGrid(!nopadding);
+    add_           = !nopadding;
+    istransformed_ = (fileType == "crava_fftgrid_binary_fourier");
     int i;
     for(i=0;i<rsize_;i++)
       rvalue_[i] = NRLib::ReadBinaryFloat(binFile);
 
     binFile.close();
+    Profiler::AddBytesRead(4.0*rsize_);
   }
   catch (NRLib::Exception & e) {
     error = std::string("Error: ") + e.what() + "\n";
@@ -2682,9 +3089,12 @@ int FFTGrid::findClosestFactorableNumber(int leastint)
 
 int FFTGrid::formatFlag_        = 0;
 int FFTGrid::domainFlag_        = IO::TIMEDOMAIN;
+double FFTGrid::chunkedQuantizationStep_ = 0.0;
 int FFTGrid::maxAllowedGrids_   = 1;   // One grid is allocated and deallocated before memory check.
 int FFTGrid::maxAllocatedGrids_ = 0;
 int FFTGrid::nGrids_            = 0;
 bool FFTGrid::terminateOnMaxGrid_ = false;
 float FFTGrid::maxFFTMemUse_    = 0;
 float FFTGrid::FFTMemUse_       = 0;
+int FFTGrid::nThreads_          = 1;
+int FFTGrid::nSpilled_          = 0;
@@ -8,6 +8,8 @@
 #include <assert.h>
 #include <complex>
 #include <string>
+#include <iosfwd>
+#include <vector>
 
 #include "fftw.h"
 #include "rfftw.h"
@@ -27,7 +29,7 @@ public:
   FFTGrid(FFTGrid * fftGrid, bool expTrans = false);
   FFTGrid(const NRLib::Grid<float> * grid, int nxp, int nyp, int nzp);
   FFTGrid(const StormContGrid * grid, int nxp, int nyp, int nzp);
-  FFTGrid() {} //Dummy constructor needed for FFTFileGrid
+  FFTGrid() : spillStream_(NULL), spillNextTrace_(0) {} //Dummy constructor needed for FFTFileGrid
   virtual ~FFTGrid();
 
   void setType(int cubeType) {cubetype_ = cubeType;}
@@ -106,6 +108,7 @@ public:
   virtual int          setNextComplex(fftw_complex);            // Accessmode write/readandwrite
   virtual int          SetNextComplex(std::complex<double> & v);// Accessmode write/readandwrite
   virtual int          setNextReal(float);                      // Accessmode write/readandwrite
+  virtual void         skipNextComplex(int n);                  // Accessmode read/readandwrite. Passes n values unchanged
   float                getRealValue(int i, int j, int k, bool extSimbox = false) const;  // Accessmode randomaccess
   float                getRealValueCyclic(int i, int j, int k) const;
   float                getRealValueInterpolated(int i, int j, float kindex, bool extSimbox = false);
@@ -116,12 +119,18 @@ public:
   float                getFirstRealValue();                     // No mode/randomaccess
   virtual int          square();                                // No mode/randomaccess
   virtual int          expTransf();                             // No mode/randomaccess
+  virtual int          expTransf(float shift, float offset, float scale); // scale*(exp(value+shift)+offset). No mode/randomaccess
   virtual int          logTransf();                             // No mode/randomaccess
+  virtual int          logTransf(float scale, float offset, float shift); // log(scale*value+offset)+shift. No mode/randomaccess
   virtual void         realAbs();
   virtual int          collapseAndAdd(float* grid);             // No mode/randomaccess
   virtual void         fftInPlace();                            // No mode/randomaccess
   virtual void         invFFTInPlace();                         // No mode/randomaccess
 
+  // Transforms a set of grids, several grids at a time when there are
+  // threads enough. File grids are loaded one at a time.
+  static void          fftInPlaceAll(const std::vector<FFTGrid *> & grids);
+  static void          invFFTInPlaceAll(const std::vector<FFTGrid *> & grids);
 
   virtual void         add(FFTGrid* fftGrid);                   // No mode/randomaccess
   virtual void         addScalar(float scalar);                 // No mode/randomaccess, only for real grids
@@ -129,6 +138,8 @@ public:
   virtual void         changeSign();                   // No mode/randomaccess
   virtual void         multiply(FFTGrid* fftGrid);              // pointwise multiplication!
   virtual void         conjugate();                             // No mode/randomaccess
+  virtual void         axpby(float a, float b, FFTGrid * y);    // a*this + b*y. No mode/randomaccess
+  virtual void         multiplyAdd(FFTGrid * x, FFTGrid * y, bool conjugateY = false); // this + x*y. No mode/randomaccess
   bool                 consistentSize(int nx,int ny, int nz, int nxp, int nyp, int nzp);
   int                  getCounterForGet() const {return(counterForGet_);}
   int                  getCounterForSet() const {return(counterForSet_);}
@@ -172,6 +183,7 @@ public:
   //Use this instead of the ones below.
   virtual void         writeStormFile(const std::string & fileName, const Simbox * simbox, bool ascii = false,
                                       bool padding = false, bool flat = false, bool scientific_format = false);//No mode/randomaccess
+  virtual void         writeChunkedFile(const std::string & fileName, const Simbox * simbox, bool padding = false);//No mode/randomaccess
   virtual int          writeSegyFile(const std::string & fileName, const Simbox * simbox, float z0,
                                      const TraceHeaderFormat &thf = TraceHeaderFormat(TraceHeaderFormat::SEISWORKS),
                                      const std::vector<std::string> & headerText = std::vector<std::string>());   //No mode/randomaccess
@@ -180,7 +192,7 @@ public:
   virtual void         writeAsciiRaw(const std::string & fileName);
   virtual void         writeResampledStormCube(const GridMapping *gridmapping, const std::string & fileName,
                                                const Simbox *simbox, const int format);
-  virtual void         writeCravaFile(const std::string & fileName, const Simbox * simbox);
+  virtual bool         writeCravaFile(const std::string & fileName, const Simbox * simbox);
   virtual void         readCravaFile(const std::string & fileName, std::string & errText, bool nopadding = false);
 
   virtual bool         isFile() {return(0);}    // indicates wether the grid is in memory or on disk
@@ -189,11 +201,14 @@ public:
   static void          setOutputFormat(int format) {formatFlag_ = format;}
   int                  getOutputFormat() {return(formatFlag_);}
   static void          setOutputDomain(int domain) {domainFlag_ = domain;}
+  static void          setChunkedQuantizationStep(double step) {chunkedQuantizationStep_ = step;}
   int                  getOutputDomain() {return(domainFlag_);}
   static void          setMaxAllowedGrids(int maxAllowedGrids) {maxAllowedGrids_ = maxAllowedGrids ;}
   static int           getMaxAllowedGrids()   { return maxAllowedGrids_   ;}
   static int           getMaxAllocatedGrids() { return maxAllocatedGrids_ ;}
   static void          setTerminateOnMaxGrid(bool terminate) {terminateOnMaxGrid_ = terminate ;}
+  static void          setNumberOfThreads(int nThreads) {nThreads_ = (nThreads > 0 ? nThreads : 1);}
+  static int           getNumberOfThreads()   { return nThreads_          ;}
   static int           findClosestFactorableNumber(int leastint);
 
   static fftw_complex* fft1DzInPlace(fftw_real*  in, int nzp);
@@ -211,6 +226,15 @@ public:
   virtual void         getRealTrace(float * value, int i, int j);
   virtual int          setRealTrace(int i, int j, float *value);
   std::vector<float>   getRealTrace(int i, int j, bool add_padding = false) const;
+  // Row (j, k) of the padded grid, nxp values.
+  virtual void         getRealRow(float * value, int j, int k);
+  virtual void         setRealRow(int j, int k, const float * value);
+
+  // Moves the real values to a temporary trace file and frees them. Afterwards
+  // the grid can only be read with getRealTrace(i, j), traces in i-j order
+  // being read sequentially from disk. The file is only open during a pass.
+  void                 spillToDisk();
+  bool                 getIsSpilled() const { return spillFile_ != "" ;}
 
 
   static void          reportFFTMemoryAndWait(const std::string & msg) {
@@ -222,6 +246,11 @@ public:
 
   void                 createGrid();
 protected:
+  bool                 useSlabFFT() const;
+  static void          transformAll(const std::vector<FFTGrid *> & grids,
+                                    bool                           forward);
+  void                 transformXYPlanes(bool forward, float scale); // Part of the slab decomposed 3D transform
+  void                 transformZColumns(bool forward);
   //int                setPaddingSize(int n, float p);
   int                  getFillNumber(int i, int n, int np );
 
@@ -271,15 +300,23 @@ protected:
 
   static int           formatFlag_;        // Decides format of output (see ModelSettings).
   static int           domainFlag_;        // Decides domain of output (see ModelSettings).
+  static double        chunkedQuantizationStep_; // Rounding of values in chunked STORM files. Lossless if zero.
 
   static int           maxAllowedGrids_;   // The maximum number of grids we are allowed to allocate.
   static int           maxAllocatedGrids_; // The maximum number of grids that has actually been allocated.
   static int           nGrids_;            // The actually number of grids allocated (varies as crava runs).
   static bool          terminateOnMaxGrid_; // If true, terminate when we try to allocate more than maxAllowedGrids.
+  static int           nThreads_;          // Number of threads used in element-wise operations (when compiled with PARALLEL).
+  static const int     minParallelSize_ = 1 << 16; // Smaller grids are not worth splitting between threads.
   bool                 add_;                // Tells whether we should change nGrids_ or not
 
   static float         maxFFTMemUse_;
   static float         FFTMemUse_;
 
+  std::string          spillFile_;         // Trace file holding the values after spillToDisk()
+  mutable std::ifstream * spillStream_;
+  mutable int          spillNextTrace_;    // Trace at the current stream position
+  static int           nSpilled_;          // Used for generating spill file names
+
 };
 #endif
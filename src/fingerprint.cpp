@@ -0,0 +1,87 @@
+/***************************************************************************
+*      Copyright (C) 2008 by Norwegian Computing Center and Statoil        *
+***************************************************************************/
+
+#include <stdio.h>
+
+#if defined(__WIN32__) || defined(WIN32) || defined(_WINDOWS)
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+
+#include "nrlib/exception/exception.hpp"
+#include "nrlib/iotools/fileio.hpp"
+#include "nrlib/iotools/stringtools.hpp"
+
+#include "src/fingerprint.h"
+
+namespace {
+  const unsigned long long fnv_offset_basis = 14695981039346656037ULL;
+  const unsigned long long fnv_prime        = 1099511628211ULL;
+
+  int GetProcessId()
+  {
+#if defined(__WIN32__) || defined(WIN32) || defined(_WINDOWS)
+    return _getpid();
+#else
+    return static_cast<int>(getpid());
+#endif
+  }
+}
+
+Fingerprint::Fingerprint(void)
+  : hash_(fnv_offset_basis)
+{
+}
+
+void
+Fingerprint::Reset(void)
+{
+  hash_ = fnv_offset_basis;
+}
+
+void
+Fingerprint::Add(const void * data,
+                 size_t       n_bytes)
+{
+  const unsigned char * bytes = static_cast<const unsigned char *>(data);
+  for (size_t i = 0 ; i < n_bytes ; i++) {
+    hash_ ^= bytes[i];
+    hash_ *= fnv_prime;
+  }
+}
+
+std::string
+Fingerprint::GetHexString(void) const
+{
+  char buffer[17];
+  sprintf(buffer, "%016llx", hash_);
+  return std::string(buffer);
+}
+
+TemporaryFile::TemporaryFile(const std::string & file_name)
+  : file_name_(file_name),
+    tmp_name_(file_name + ".tmp" + NRLib::ToString(GetProcessId())),
+    committed_(false)
+{
+}
+
+TemporaryFile::~TemporaryFile(void)
+{
+  if (!committed_)
+    remove(tmp_name_.c_str());
+}
+
+void
+TemporaryFile::Commit(void)
+{
+#if defined(__WIN32__) || defined(WIN32) || defined(_WINDOWS)
+  // Windows does not rename onto an existing file.
+  if (NRLib::FileExists(file_name_))
+    NRLib::RemoveFile(file_name_);
+#endif
+  if (rename(tmp_name_.c_str(), file_name_.c_str()) != 0)
+    throw NRLib::IOError("Could not rename " + tmp_name_ + " to " + file_name_);
+  committed_ = true;
+}
@@ -0,0 +1,60 @@
+/***************************************************************************
+*      Copyright (C) 2008 by Norwegian Computing Center and Statoil        *
+***************************************************************************/
+
+#ifndef FINGERPRINT_H
+#define FINGERPRINT_H
+
+#include <string>
+
+//
+// FNV-1a hash of the input a stored result is computed from. Used to
+// decide whether checkpoints and cached preprocessing can be reused.
+//
+class Fingerprint
+{
+public:
+  Fingerprint(void);
+
+  void                     Reset(void);
+
+  void                     Add(const void * data,
+                               size_t       n_bytes);
+
+  template <class T>
+  void                     Add(const T & value) { Add(&value, sizeof(T)) ;}
+
+  // The hash as 16 hexadecimal digits.
+  std::string              GetHexString(void) const;
+
+private:
+  unsigned long long       hash_;
+};
+
+//
+// A file that is written under a temporary name and renamed into place
+// when complete, so that a run killed while writing, or another run
+// reading the same file, never sees it half-written. The temporary name
+// includes the process id, so concurrent runs do not write to the same
+// temporary file.
+//
+class TemporaryFile
+{
+public:
+  TemporaryFile(const std::string & file_name);
+
+  // Removes the temporary file if it was not committed.
+  ~TemporaryFile(void);
+
+  const std::string      & GetName(void) const { return tmp_name_ ;}
+
+  // Replaces the file by the temporary file.
+  void                     Commit(void);
+
+private:
+  std::string              file_name_;
+  std::string              tmp_name_;
+  bool                     committed_;
+};
+
+#endif
@@ -488,8 +488,7 @@ void
 {
   assert(log_mean->getIsTransformed() == false);
 
-  log_mean->addScalar(0.5f*sigma_squared);  // \mu_{log rho^c} + 0.5*\sigma^2
-  log_mean->expTransf();  //exp{\mu_{log rho^c} + 0.5*\sigma^2}. Finished transformation.
+  log_mean->expTransf(0.5f*sigma_squared, 0.0f, 1.0f);  //exp{\mu_{log rho^c} + 0.5*\sigma^2}. Finished transformation.
 }
 
 void
@@ -497,9 +496,7 @@ void
 {
   assert(log_cov->getIsTransformed() == false);
 
-  log_cov->expTransf();
-  log_cov->addScalar(-1);
-  log_cov->multiplyByScalar(mean*mean);
+  log_cov->expTransf(0.0f, -1.0f, mean*mean);  // mean^2*(exp{log_cov} - 1)
 }
 
 void
@@ -507,9 +504,7 @@ void
 {
   assert(log_cov->getIsTransformed() == false);
 
-  log_cov->expTransf();
-  log_cov->addScalar(-1);
-  log_cov->multiplyByScalar(mean_a*mean_b);
+  log_cov->expTransf(0.0f, -1.0f, mean_a*mean_b);  // mean_a*mean_b*(exp{log_cov} - 1)
 }
 
 void
@@ -517,8 +512,7 @@ void
 {
   assert(mean->getIsTransformed() == false);
 
-  mean->logTransf();
-  mean->addScalar(-0.5f*sigma_squared);
+  mean->logTransf(1.0f, 0.0f, -0.5f*sigma_squared);  // log{mean} - 0.5*\sigma^2
 }
 
 void
@@ -526,9 +520,7 @@ void
 {
   assert(cov->getIsTransformed() == false);
 
-  cov->multiplyByScalar(1.0f/(mean*mean));
-  cov->addScalar(1);
-  cov->logTransf();
+  cov->logTransf(1.0f/(mean*mean), 1.0f, 0.0f);  // log{cov/mean^2 + 1}
 }
 
 void
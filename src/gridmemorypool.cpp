@@ -0,0 +1,173 @@
+/***************************************************************************
+*      Copyright (C) 2008 by Norwegian Computing Center and Statoil        *
+***************************************************************************/
+
+#include <stdlib.h>
+#include <algorithm>
+#include <limits>
+
+#if defined(__WIN32__) || defined(WIN32) || defined(_WINDOWS)
+#include <malloc.h>
+#else
+#include <sys/mman.h>
+#endif
+
+#ifdef PARALLEL
+#include <omp.h>
+#endif
+
+#include "nrlib/exception/exception.hpp"
+
+#include "src/gridmemorypool.h"
+#include "src/profiler.h"
+
+namespace {
+  const size_t huge_page_size = 2*1024*1024;
+  const size_t cache_line     = 64;
+}
+
+float *
+GridMemoryPool::Allocate(int n_values, int n_threads)
+{
+  size_t  bytes  = static_cast<size_t>(n_values)*sizeof(float);
+  float * buffer = NULL;
+
+#ifdef PARALLEL
+#pragma omp critical(gridmemorypool)
+#endif
+  {
+    std::map<size_t, std::vector<float *> >::iterator it = free_buffers_.find(bytes);
+    if (it != free_buffers_.end() && it->second.size() > 0) {
+      buffer = it->second.back();
+      it->second.pop_back();
+      cached_bytes_ -= static_cast<double>(bytes);
+    }
+    else {
+      // Keep allocated plus cached memory within the peak seen so far.
+      EvictUntil(std::max(peak_bytes_ - used_bytes_ - bytes, 0.0));
+    }
+    used_bytes_ += static_cast<double>(bytes);
+    peak_bytes_  = std::max(peak_bytes_, used_bytes_);
+  }
+
+  if (buffer != NULL) {
+    Profiler::AddCount("grid_pool_hits", 1.0);
+    return buffer;
+  }
+
+  buffer = NewBuffer(bytes);
+  FirstTouch(buffer, n_values, n_threads);
+  Profiler::AddCount("grid_pool_misses", 1.0);
+  return buffer;
+}
+
+void
+GridMemoryPool::Release(float * buffer, int n_values)
+{
+  if (buffer == NULL)
+    return;
+
+  size_t bytes = static_cast<size_t>(n_values)*sizeof(float);
+
+#ifdef PARALLEL
+#pragma omp critical(gridmemorypool)
+#endif
+  {
+    free_buffers_[bytes].push_back(buffer);
+    cached_bytes_ += static_cast<double>(bytes);
+    used_bytes_   -= static_cast<double>(bytes);
+    EvictUntil(max_cached_bytes_);
+  }
+}
+
+void
+GridMemoryPool::SetMaxCachedBytes(double bytes)
+{
+#ifdef PARALLEL
+#pragma omp critical(gridmemorypool)
+#endif
+  {
+    max_cached_bytes_ = bytes;
+    EvictUntil(max_cached_bytes_);
+  }
+}
+
+void
+GridMemoryPool::Clear()
+{
+#ifdef PARALLEL
+#pragma omp critical(gridmemorypool)
+#endif
+  {
+    EvictUntil(0.0);
+    free_buffers_.clear();
+  }
+}
+
+void
+GridMemoryPool::EvictUntil(double limit)
+{
+  // Largest buffers go first. Must be called inside the critical section.
+  std::map<size_t, std::vector<float *> >::reverse_iterator it = free_buffers_.rbegin();
+  while (cached_bytes_ > limit && it != free_buffers_.rend()) {
+    std::vector<float *> & buffers = it->second;
+    while (cached_bytes_ > limit && buffers.size() > 0) {
+      DeleteBuffer(buffers.back());
+      buffers.pop_back();
+      cached_bytes_ -= static_cast<double>(it->first);
+    }
+    ++it;
+  }
+}
+
+float *
+GridMemoryPool::NewBuffer(size_t bytes)
+{
+  bool   huge      = use_huge_pages_ && bytes >= huge_page_size;
+  size_t alignment = (huge ? huge_page_size : cache_line);
+  void * buffer    = NULL;
+
+#if defined(__WIN32__) || defined(WIN32) || defined(_WINDOWS)
+  buffer = _aligned_malloc(bytes, alignment);
+#else
+  if (posix_memalign(&buffer, alignment, bytes) != 0)
+    buffer = NULL;
+#if defined(MADV_HUGEPAGE)
+  if (buffer != NULL && huge)
+    madvise(buffer, bytes, MADV_HUGEPAGE);
+#endif
+#endif
+
+  if (buffer == NULL)
+    throw NRLib::Exception("Could not allocate memory for grid.");
+
+  return static_cast<float *>(buffer);
+}
+
+void
+GridMemoryPool::DeleteBuffer(float * buffer)
+{
+#if defined(__WIN32__) || defined(WIN32) || defined(_WINDOWS)
+  _aligned_free(buffer);
+#else
+  free(buffer);
+#endif
+}
+
+void
+GridMemoryPool::FirstTouch(float * buffer, int n_values, int n_threads)
+{
+  // Same schedule as the element-wise loops in FFTGrid.
+#ifdef PARALLEL
+#pragma omp parallel for schedule(static) num_threads(n_threads)
+#endif
+  for (int i = 0 ; i < n_values ; i++)
+    buffer[i] = 0.0f;
+}
+
+std::map<size_t, std::vector<float *> > GridMemoryPool::free_buffers_;
+double GridMemoryPool::cached_bytes_     = 0.0;
+double GridMemoryPool::used_bytes_       = 0.0;
+double GridMemoryPool::peak_bytes_       = 0.0;
+double GridMemoryPool::max_cached_bytes_ = std::numeric_limits<double>::max();
+bool   GridMemoryPool::use_huge_pages_   = true;
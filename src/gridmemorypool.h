@@ -0,0 +1,56 @@
+/***************************************************************************
+*      Copyright (C) 2008 by Norwegian Computing Center and Statoil        *
+***************************************************************************/
+
+#ifndef GRIDMEMORYPOOL_H
+#define GRIDMEMORYPOOL_H
+
+#include <map>
+#include <vector>
+#include <cstddef>
+
+//
+// Pool of value buffers for FFTGrid.
+//
+// CRAVA creates and deletes many temporary grids of the same padded size.
+// Released buffers are kept in a free list per byte size and handed out
+// again, instead of going back to the system and being page faulted in on
+// the next allocation.
+//
+// New buffers are initialised in parallel with the same static schedule as
+// the element-wise FFTGrid loops, so that on NUMA machines each page ends up
+// on the node of the thread that will use it (first touch). Large buffers
+// are aligned to 2 MB and marked for transparent huge pages on Linux.
+//
+// The pool never lets allocated plus cached memory grow beyond the peak
+// memory that has actually been in use; cached buffers are freed first.
+// The cached memory is also kept within a budget, which is lowered to zero
+// once the inversion is done, so that freed grids go back to the system
+// while the results are combined and written.
+//
+class GridMemoryPool
+{
+public:
+  static float * Allocate(int n_values, int n_threads);              // Thread safe
+  static void    Release(float * buffer, int n_values);              // Thread safe
+  static void    Clear();                                             // Free all cached buffers
+  static void    SetMaxCachedBytes(double bytes);                     // Frees cached buffers above the new budget
+
+  static void    SetUseHugePages(bool use) { use_huge_pages_ = use ;}
+  static double  GetCachedBytes(void)      { return cached_bytes_  ;}
+
+private:
+  static float * NewBuffer(size_t bytes);
+  static void    DeleteBuffer(float * buffer);
+  static void    FirstTouch(float * buffer, int n_values, int n_threads);
+  static void    EvictUntil(double limit);
+
+  static std::map<size_t, std::vector<float *> > free_buffers_;   // Cached buffers by byte size
+  static double                                   cached_bytes_;
+  static double                                   used_bytes_;
+  static double                                   peak_bytes_;     // Peak of used_bytes_
+  static double                                   max_cached_bytes_;
+  static bool                                     use_huge_pages_;
+};
+
+#endif
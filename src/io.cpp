@@ -51,7 +51,7 @@ IO::writeSurfaceToFile(const Surface     & surface,
 
   // Ensure surfaces in STORM format when STORM grids are requested. Otherwise
   // STORM cubes cannot be imported to RMS.
-  if ((format & STORM) > 0 || (format & ASCII) == 0)
+  if ((format & (STORM | CHUNKED)) > 0 || (format & ASCII) == 0)
     surface.WriteToFile(fileName + SuffixStormBinary(), NRLib::SURF_STORM_BINARY);
 }
 
@@ -65,7 +65,7 @@ IO::findGridType(const std::string & fileName)
     return(CRAVA);
   else {
     int fType = NRLib::FindGridFileType(fileName);
-    if (fType == NRLib::STORM_PETRO_BINARY)
+    if (fType == NRLib::STORM_PETRO_BINARY || fType == NRLib::STORM_PETRO_CHUNKED)
       return(STORM);
     else if (fType == NRLib::SEGY)
       return(SEGY);
@@ -30,6 +30,7 @@ public:
   inline static  std::string    PathToCorrelations(void)           { return std::string("correlations/")            ;}
   inline static  std::string    PathToInversionResults(void)       { return std::string("inversionresults/")        ;}
   inline static  std::string    PathToRockPhysics()                { return std::string("rock_physics/")            ;}
+  inline static  std::string    PathToCheckpoints(void)            { return std::string("checkpoints/")             ;}
   inline static  std::string    PathToTmpFiles(void)               { return std::string("")                         ;}
   inline static  std::string    PathToDebug(void)                  { return std::string("")                         ;}
 
@@ -38,7 +39,10 @@ public:
   inline static  std::string    FileLog(void)                      { return std::string("logFile")                  ;}
   inline static  std::string    FileDebug(void)                    { return std::string("debug")                    ;}
   inline static  std::string    FileError(void)                    { return std::string("error")                    ;}
+  inline static  std::string    FileProfile(void)                  { return std::string("profile")                  ;}
   inline static  std::string    FileTasks(void)                    { return std::string("tasks")                    ;}
+  inline static  std::string    FileModelFile(void)                { return std::string("modelfile")                ;}
+  inline static  std::string    FileScreenLog(void)                { return std::string("screenLog")                ;}
   inline static  std::string    FileParameterAutoCov()             { return std::string("Parameter_Autocovariance") ;}
   inline static  std::string    FileParameterCov(void)             { return std::string("Parameter_Covariance")     ;}
   inline static  std::string    FileLateralCorr(void)              { return std::string("Lateral_Correlation")      ;}
@@ -91,9 +95,12 @@ public:
   inline static  std::string    SuffixGeneralData(void)            { return std::string(".dat")                     ;}
   inline static  std::string    SuffixTextFiles(void)              { return std::string(".txt")                     ;}
   inline static  std::string    SuffixCrava(void)                  { return std::string(".crava")                   ;}
+  inline static  std::string    SuffixJson(void)                   { return std::string(".json")                    ;}
+  inline static  std::string    SuffixXml(void)                    { return std::string(".xml")                     ;}
   inline static  std::string    SuffixAsciiFiles(void)             { return std::string(".ascii")                   ;}
   inline static  std::string    SuffixAsciiIrapClassic(void)       { return std::string(".irap")                    ;}
   inline static  std::string    SuffixStormBinary(void)            { return std::string(".storm")                   ;}
+  inline static  std::string    SuffixStormChunked(void)           { return std::string(".cstorm")                  ;}
   inline static  std::string    SuffixRmsWells(void)               { return std::string(".rmswell")                 ;}
   inline static  std::string    SuffixNorsarWells(void)            { return std::string(".nwh")                     ;}
   inline static  std::string    SuffixNorsarLog(void)              { return std::string(".n00")                     ;}
@@ -131,7 +138,8 @@ public:
                              STORM   =  2,
                              ASCII   =  4,
                              SGRI    =  8,
-                             CRAVA   = 16};
+                             CRAVA   = 16,
+                             CHUNKED = 32};
 
   enum           wellFormats{RMSWELL    = 1,
                              NORSARWELL = 2};
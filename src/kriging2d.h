@@ -5,6 +5,9 @@
 #ifndef KRIGING2D_H
 #define KRIGING2D_H
 
+#include <complex>
+#include <vector>
+
 #include "src/definitions.h"
 #include "src/covgrid2d.h"
 #include "src/krigingdata2d.h"
@@ -14,6 +17,7 @@
 class Vario;
 class Simbox;
 class CovGrid2D;
+class KrigingCache2D;
 
 class Kriging2D
 {
@@ -21,7 +25,9 @@ public:
   static void  krigSurface(Grid2D              & trend,
                            const KrigingData2D & krigingData,
                            const CovGrid2D     & cov,
-                           bool                  getResiduals = false);
+                           bool                  getResiduals = false,
+                           const KrigingCache2D* cache        = NULL,
+                           int                   layer        = 0);
 
 private:
   static void  subtractTrend(NRLib::Vector            & d,
@@ -41,5 +47,24 @@ private:
                                  const std::vector<int> & indexj,
                                  int i,
                                  int j);
+
+  static bool  useConvolution(int md,
+                              int nx,
+                              int ny);
+
+  static int   findPaddedSize(int n);
+
+  static void  predictByConvolution(Grid2D                 & prediction,
+                                    int                      nx,
+                                    int                      ny,
+                                    const CovGrid2D        & cov,
+                                    const NRLib::Vector    & x,
+                                    const std::vector<int> & indexi,
+                                    const std::vector<int> & indexj);
+
+  static void  fft2D(std::vector<std::complex<double> > & grid,
+                     int                                  nxp,
+                     int                                  nyp,
+                     bool                                 inverse);
 };
 #endif
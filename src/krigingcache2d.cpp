@@ -0,0 +1,270 @@
+/***************************************************************************
+*      Copyright (C) 2008 by Norwegian Computing Center and Statoil        *
+***************************************************************************/
+
+#include <string>
+
+#include "nrlib/exception/exception.hpp"
+
+#include "src/krigingcache2d.h"
+#include "src/krigingdata2d.h"
+#include "src/covgrid2d.h"
+
+namespace {
+  // Number of most recent bases a layer is compared against.
+  const int n_candidates = 8;
+}
+
+KrigingCache2D::KrigingCache2D(const std::vector<KrigingData2D> & kriging_data,
+                               const CovGrid2D                  & cov,
+                               int                                n_threads)
+  : kriging_data_(kriging_data),
+    cov_(cov),
+    layer_base_(kriging_data.size(), -1)
+{
+  //
+  // Group the layers around base location sets. A layer reuses a base if
+  // at most a sixth of its locations differ from it; the cost of a solve
+  // with a base factor grows with the number of changes, while a new
+  // factorization costs about md/6 solves.
+  //
+  int n_layers = static_cast<int>(kriging_data.size());
+  for (int k = 0 ; k < n_layers ; k++) {
+    int md = kriging_data[k].getNumberOfData();
+    if (md == 0)
+      continue;
+
+    const std::vector<int> & indexi = kriging_data[k].getIndexI();
+    const std::vector<int> & indexj = kriging_data[k].getIndexJ();
+
+    int n_bases      = static_cast<int>(bases_.size());
+    int best         = -1;
+    int best_changes = md/6;
+    for (int b = n_bases - 1 ; b >= 0 && b >= n_bases - n_candidates ; b--) {
+      int changes = CountChanges(bases_[b], indexi, indexj);
+      if (changes <= best_changes) {
+        best         = b;
+        best_changes = changes;
+        if (changes == 0)
+          break;
+      }
+    }
+
+    if (best < 0) {
+      Base base;
+      base.indexi = indexi;
+      base.indexj = indexj;
+      for (int m = 0 ; m < md ; m++)
+        base.position[std::make_pair(indexi[m], indexj[m])] = m;
+      bases_.push_back(base);
+      best = n_bases;
+    }
+    layer_base_[k] = best;
+  }
+
+  //
+  // Factorize the bases. Exceptions cannot leave a parallel region, so the
+  // first error is kept and thrown afterwards.
+  //
+  int         n_bases = static_cast<int>(bases_.size());
+  std::string error;
+
+#ifdef PARALLEL
+#pragma omp parallel for schedule(dynamic, 1) num_threads(n_threads)
+#endif
+  for (int b = 0 ; b < n_bases ; b++) {
+    Base & base = bases_[b];
+    int    n    = static_cast<int>(base.indexi.size());
+    base.factor.resize(n);
+    for (int i = 0 ; i < n ; i++) {
+      for (int j = 0 ; j <= i ; j++) {
+        int deltai = base.indexi[i] - base.indexi[j];
+        int deltaj = base.indexj[i] - base.indexj[j];
+        base.factor(j,i) = static_cast<double>(cov_.getCov(deltai, deltaj));
+      }
+    }
+    try {
+      NRLib::CholeskyFactorize(base.factor);
+    }
+    catch (NRLib::Exception & e) {
+#ifdef PARALLEL
+#pragma omp critical(krigingcache2d)
+#endif
+      if (error == "")
+        error = e.what();
+    }
+  }
+
+  if (error != "")
+    throw NRLib::Exception(error);
+}
+
+int
+KrigingCache2D::CountChanges(const Base             & base,
+                             const std::vector<int> & indexi,
+                             const std::vector<int> & indexj) const
+{
+  int n_found = 0;
+  int md      = static_cast<int>(indexi.size());
+  for (int m = 0 ; m < md ; m++) {
+    if (base.position.find(std::make_pair(indexi[m], indexj[m])) != base.position.end())
+      n_found++;
+  }
+  int n_added   = md - n_found;
+  int n_dropped = static_cast<int>(base.indexi.size()) - n_found;
+  return n_added + n_dropped;
+}
+
+void
+KrigingCache2D::Solve(int                   layer,
+                      const NRLib::Vector & residual,
+                      NRLib::Vector       & x) const
+{
+  //
+  // Let C be the base locations, A the locations added in this layer and
+  // D the base locations not in this layer. We solve the system for the
+  // locations C+A,
+  //
+  //   | K_CC  B    | y = b ,  B = K_CA ,
+  //   | B^T   K_AA |
+  //
+  // with the base factor of K_CC and the Schur complement of K_AA. Setting
+  // b to zero at D, the solution y is generally nonzero there; the weights
+  // of D are forced to zero by adding the columns of the inverse belonging
+  // to D (Lagrange multipliers). The remaining entries of y are then the
+  // solution for the layer locations.
+  //
+  const Base             & base   = bases_[layer_base_[layer]];
+  const std::vector<int> & indexi = kriging_data_[layer].getIndexI();
+  const std::vector<int> & indexj = kriging_data_[layer].getIndexJ();
+
+  int md = static_cast<int>(indexi.size());
+  int nc = static_cast<int>(base.indexi.size());
+
+  std::vector<int>  position(md);     // Position of layer datum in y
+  std::vector<int>  added;            // Layer index of added locations
+  std::vector<bool> kept(nc, false);
+
+  for (int m = 0 ; m < md ; m++) {
+    std::map<std::pair<int, int>, int>::const_iterator it = base.position.find(std::make_pair(indexi[m], indexj[m]));
+    if (it != base.position.end()) {
+      position[m]       = it->second;
+      kept[it->second]  = true;
+    }
+    else {
+      position[m] = nc + static_cast<int>(added.size());
+      added.push_back(m);
+    }
+  }
+
+  std::vector<int> dropped;
+  for (int p = 0 ; p < nc ; p++) {
+    if (!kept[p])
+      dropped.push_back(p);
+  }
+
+  int na = static_cast<int>(added.size());
+  int nd = static_cast<int>(dropped.size());
+
+  if (na == 0 && nd == 0) {
+    NRLib::Matrix rhs(nc, 1);
+    for (int m = 0 ; m < md ; m++)
+      rhs(position[m], 0) = residual(m);
+    flens::potrs(const_cast<NRLib::SymmetricMatrix &>(base.factor), rhs);
+    x.resize(md);
+    for (int m = 0 ; m < md ; m++)
+      x(m) = rhs(position[m], 0);
+    return;
+  }
+
+  //
+  // Right hand sides for the base factor: the columns of B, the residual
+  // and unit vectors at the dropped locations.
+  //
+  int ny   = 1 + nd;
+  int nrhs = na + ny;
+
+  NRLib::Matrix B(nc, na > 0 ? na : 1);
+  NRLib::Matrix rhs(nc, nrhs);
+  NRLib::InitializeMatrix(rhs, 0.0);
+
+  for (int a = 0 ; a < na ; a++) {
+    int ia = indexi[added[a]];
+    int ja = indexj[added[a]];
+    for (int p = 0 ; p < nc ; p++) {
+      B(p,a)   = static_cast<double>(cov_.getCov(base.indexi[p] - ia, base.indexj[p] - ja));
+      rhs(p,a) = B(p,a);
+    }
+  }
+  for (int m = 0 ; m < md ; m++) {
+    if (position[m] < nc)
+      rhs(position[m], na) = residual(m);
+  }
+  for (int q = 0 ; q < nd ; q++)
+    rhs(dropped[q], na + 1 + q) = 1.0;
+
+  flens::potrs(const_cast<NRLib::SymmetricMatrix &>(base.factor), rhs);
+
+  // Columns 0..na-1 of rhs now hold Z = K_CC^{-1} B, the rest u = K_CC^{-1} b.
+  NRLib::Matrix y(nc + na, ny);
+  for (int c = 0 ; c < ny ; c++) {
+    for (int p = 0 ; p < nc ; p++)
+      y(p,c) = rhs(p, na + c);
+  }
+
+  if (na > 0) {
+    NRLib::SymmetricMatrix S(na);
+    for (int a2 = 0 ; a2 < na ; a2++) {
+      for (int a1 = 0 ; a1 <= a2 ; a1++) {
+        double sum = static_cast<double>(cov_.getCov(indexi[added[a1]] - indexi[added[a2]],
+                                                      indexj[added[a1]] - indexj[added[a2]]));
+        for (int p = 0 ; p < nc ; p++)
+          sum -= B(p,a1)*rhs(p,a2);
+        S(a1,a2) = sum;
+      }
+    }
+
+    NRLib::Matrix yA(na, ny);
+    for (int c = 0 ; c < ny ; c++) {
+      for (int a = 0 ; a < na ; a++) {
+        double sum = (c == 0 ? residual(added[a]) : 0.0);
+        for (int p = 0 ; p < nc ; p++)
+          sum -= B(p,a)*y(p,c);
+        yA(a,c) = sum;
+      }
+    }
+    NRLib::CholeskySolve(S, yA);
+
+    for (int c = 0 ; c < ny ; c++) {
+      for (int p = 0 ; p < nc ; p++) {
+        double sum = 0.0;
+        for (int a = 0 ; a < na ; a++)
+          sum += rhs(p,a)*yA(a,c);
+        y(p,c) -= sum;
+      }
+      for (int a = 0 ; a < na ; a++)
+        y(nc + a, c) = yA(a,c);
+    }
+  }
+
+  if (nd > 0) {
+    NRLib::SymmetricMatrix G(nd);
+    NRLib::Vector          g(nd);
+    NRLib::Vector          lambda(nd);
+    for (int q2 = 0 ; q2 < nd ; q2++) {
+      for (int q1 = 0 ; q1 <= q2 ; q1++)
+        G(q1,q2) = y(dropped[q1], 1 + q2);
+      g(q2) = -y(dropped[q2], 0);
+    }
+    NRLib::CholeskySolve(G, g, lambda);
+
+    for (int p = 0 ; p < nc + na ; p++) {
+      for (int q = 0 ; q < nd ; q++)
+        y(p,0) += y(p, 1 + q)*lambda(q);
+    }
+  }
+
+  x.resize(md);
+  for (int m = 0 ; m < md ; m++)
+    x(m) = y(position[m], 0);
+}
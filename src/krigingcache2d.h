@@ -0,0 +1,66 @@
+/***************************************************************************
+*      Copyright (C) 2008 by Norwegian Computing Center and Statoil        *
+***************************************************************************/
+
+#ifndef KRIGINGCACHE2D_H
+#define KRIGINGCACHE2D_H
+
+#include <map>
+#include <vector>
+
+#include "nrlib/flens/nrlib_flens.hpp"
+
+class KrigingData2D;
+class CovGrid2D;
+
+//
+// Cholesky factorizations of kriging matrices shared between layers.
+//
+// When a stack of layers is kriged, the data locations are often the same
+// for many layers (vertical wells), or differ by a few wells dropping in or
+// out. The layers are grouped around a few base location sets, and only
+// the kriging matrices of these are factorized. A layer whose locations
+// differ from its base by a few points is solved with the base factor,
+// using the Schur complement for added points and Lagrange multipliers
+// forcing the weights of dropped points to zero.
+//
+// The grouping depends only on the data locations, so results do not
+// depend on the number of threads. Solve() may be called from several
+// threads at once.
+//
+class KrigingCache2D
+{
+public:
+  KrigingCache2D(const std::vector<KrigingData2D> & kriging_data,
+                 const CovGrid2D                  & cov,
+                 int                                n_threads = 1);
+
+  // Solves K x = residual for the data locations of layer. Only the data
+  // locations are taken from kriging_data, so the values may change after
+  // the cache has been made.
+  void                 Solve(int                   layer,
+                             const NRLib::Vector & residual,
+                             NRLib::Vector       & x) const;
+
+  int                  GetNumberOfFactorizations(void) const { return static_cast<int>(bases_.size()) ;}
+
+private:
+  struct Base
+  {
+    std::vector<int>                   indexi;
+    std::vector<int>                   indexj;
+    std::map<std::pair<int, int>, int> position;      // Location -> index in base
+    NRLib::SymmetricMatrix             factor;        // Cholesky factor of the kriging matrix
+  };
+
+  int                  CountChanges(const Base             & base,
+                                    const std::vector<int> & indexi,
+                                    const std::vector<int> & indexj) const;
+
+  const std::vector<KrigingData2D> & kriging_data_;
+  const CovGrid2D                  & cov_;
+  std::vector<Base>                  bases_;
+  std::vector<int>                   layer_base_;     // Base used by each layer (-1 if no data)
+};
+
+#endif
@@ -0,0 +1,618 @@
+/***************************************************************************
+*      Copyright (C) 2008 by Norwegian Computing Center and Statoil        *
+***************************************************************************/
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+#include <boost/filesystem.hpp>
+
+#include "nrlib/exception/exception.hpp"
+#include "nrlib/iotools/fileio.hpp"
+#include "nrlib/iotools/logkit.hpp"
+#include "nrlib/iotools/stringtools.hpp"
+#include "nrlib/math/constants.hpp"
+#include "nrlib/segy/segygeometry.hpp"
+#include "nrlib/stormgrid/chunkedgrid.hpp"
+#include "nrlib/stormgrid/stormcontgrid.hpp"
+#include "nrlib/tinyxml/tinyxml.h"
+
+#include "src/lateraltiles.h"
+#include "src/modelsettings.h"
+#include "src/definitions.h"
+#include "src/vario.h"
+#include "src/io.h"
+
+LateralTiles::LateralTiles(const ModelSettings * model_settings)
+  : model_settings_(model_settings),
+    n_tiles_x_(model_settings->getNumberOfLateralTilesX()),
+    n_tiles_y_(model_settings->getNumberOfLateralTilesY())
+{
+  const SegyGeometry * geometry = model_settings->getAreaParameters();
+  x0_      = geometry->GetX0();
+  y0_      = geometry->GetY0();
+  dx_      = geometry->GetDx();
+  dy_      = geometry->GetDy();
+  nx_      = static_cast<int>(geometry->GetNx());
+  ny_      = static_cast<int>(geometry->GetNy());
+  rot_     = geometry->GetAngle();
+  cos_rot_ = geometry->GetCosRot();
+  sin_rot_ = geometry->GetSinRot();
+
+  //
+  // The overlap is the lateral padding of a tile, found as in
+  // CommonData::EstimateXYPaddingSizes(). A given padding fraction is
+  // taken relative to the tile.
+  //
+  double x_pad = model_settings->getXPadFac()*nx_*dx_/n_tiles_x_;
+  double y_pad = model_settings->getYPadFac()*ny_*dy_/n_tiles_y_;
+
+  if (model_settings->getEstimateXYPadding()) {
+    float  range1 = model_settings->getLateralCorr()->getRange();
+    float  range2 = model_settings->getLateralCorr()->getSubRange();
+    float  angle  = model_settings->getLateralCorr()->getAngle();
+    double factor = 0.5;
+
+    x_pad = factor * std::max(std::abs(range1*cos(angle)), std::abs(range2*sin(angle)));
+    y_pad = factor * std::max(std::abs(range1*sin(angle)), std::abs(range2*cos(angle)));
+  }
+
+  overlap_x_ = std::max(1, static_cast<int>(std::ceil(x_pad/dx_)));
+  overlap_y_ = std::max(1, static_cast<int>(std::ceil(y_pad/dy_)));
+}
+
+bool
+LateralTiles::Run(const std::string & executable,
+                  const std::string & model_file)
+{
+  LogKit::WriteHeader("Lateral tiles");
+
+  try {
+    FindTiles(nx_, n_tiles_x_, overlap_x_, "x", bounds_x_);
+    FindTiles(ny_, n_tiles_y_, overlap_y_, "y", bounds_y_);
+
+    LogKit::LogFormatted(LogKit::Low,"\nThe area of %d x %d cells is split into %d x %d tiles. Neighbouring tiles overlap",
+                         nx_, ny_, n_tiles_x_, n_tiles_y_);
+    LogKit::LogFormatted(LogKit::Low,"\nby %d cells in x direction and %d cells in y direction.\n", 4*overlap_x_, 4*overlap_y_);
+    LogKit::LogFormatted(LogKit::Low,"\nTile          i-range        j-range");
+    LogKit::LogFormatted(LogKit::Low,"\n--------------------------------------");
+    for (int j = 0 ; j < n_tiles_y_ ; j++) {
+      for (int i = 0 ; i < n_tiles_x_ ; i++) {
+        LogKit::LogFormatted(LogKit::Low,"\n%-10s  %5d -%5d   %5d -%5d", GetTileName(i, j).c_str(),
+                             GetExtendedStart(bounds_x_, overlap_x_, i), GetExtendedEnd(bounds_x_, overlap_x_, nx_, i) - 1,
+                             GetExtendedStart(bounds_y_, overlap_y_, j), GetExtendedEnd(bounds_y_, overlap_y_, ny_, j) - 1);
+        WriteModelFile(model_file, i, j);
+      }
+    }
+    LogKit::LogFormatted(LogKit::Low,"\n");
+
+    RunTiles(executable);
+
+    std::vector<std::string> cubes;
+    FindStormCubes(IO::getOutputPath() + GetTileName(0, 0) + "/", "", cubes);
+    if (cubes.size() == 0)
+      throw NRLib::Exception("No STORM cubes were found in the output of " + GetTileName(0, 0) + ".");
+
+    LogKit::LogFormatted(LogKit::Low,"\nBlending %d cubes from the tiles ...", static_cast<int>(cubes.size()));
+    std::set<std::string> written_surfaces;
+    for (size_t c = 0 ; c < cubes.size() ; c++)
+      BlendCube(cubes[c], written_surfaces);
+    LogKit::LogFormatted(LogKit::Low," done\n");
+  }
+  catch (NRLib::Exception & e) {
+    LogKit::LogMessage(LogKit::Error, "\nERROR: " + std::string(e.what()) + "\n");
+    LogKit::LogFormatted(LogKit::Error,"\nAborting\n");
+    return(true);
+  }
+  return(false);
+}
+
+void
+LateralTiles::FindTiles(int                 n_cells,
+                        int                 n_tiles,
+                        int                 overlap,
+                        const std::string & direction,
+                        std::vector<int>  & bounds) const
+{
+  bounds.resize(n_tiles + 1);
+  for (int t = 0 ; t <= n_tiles ; t++)
+    bounds[t] = (t*n_cells)/n_tiles;
+
+  // The tapers at the two sides of a tile must not overlap.
+  for (int t = 0 ; t < n_tiles ; t++) {
+    if (n_tiles > 1 && bounds[t + 1] - bounds[t] < 2*overlap)
+      throw NRLib::Exception("The tiles are only " + NRLib::ToString(bounds[t + 1] - bounds[t]) + " cells wide in "
+                             + direction + " direction, while at least " + NRLib::ToString(2*overlap)
+                             + " cells are needed for the blending. Use fewer tiles in " + direction + " direction.");
+  }
+}
+
+int
+LateralTiles::GetExtendedStart(const std::vector<int> & bounds,
+                               int                      overlap,
+                               int                      tile) const
+{
+  return std::max(0, bounds[tile] - 2*overlap);
+}
+
+int
+LateralTiles::GetExtendedEnd(const std::vector<int> & bounds,
+                             int                      overlap,
+                             int                      n_cells,
+                             int                      tile) const
+{
+  return std::min(n_cells, bounds[tile + 1] + 2*overlap);
+}
+
+double
+LateralTiles::FindTaperWeight(const std::vector<int> & bounds,
+                              int                      overlap,
+                              int                      tile,
+                              int                      index) const
+{
+  //
+  // Around each inner boundary b, the weight of the tile to the left goes
+  // from one to zero as cos^2 over the cells b-overlap to b+overlap-1, and
+  // the weight of the tile to the right as sin^2, so the weights sum to one.
+  //
+  int    n_tiles = static_cast<int>(bounds.size()) - 1;
+  double weight  = 1.0;
+
+  int start = bounds[tile];
+  if (tile > 0 && index < start + overlap) {
+    double t = (index - (start - overlap) + 0.5)/(2.0*overlap);
+    if (t <= 0.0)
+      return(0.0);
+    weight = std::pow(sin(0.5*NRLib::Pi*t), 2);
+  }
+
+  int end = bounds[tile + 1];
+  if (tile < n_tiles - 1 && index >= end - overlap) {
+    double t = (index - (end - overlap) + 0.5)/(2.0*overlap);
+    if (t >= 1.0)
+      return(0.0);
+    weight = std::pow(cos(0.5*NRLib::Pi*t), 2);
+  }
+
+  return(weight);
+}
+
+std::string
+LateralTiles::GetTileName(int i,
+                          int j) const
+{
+  return "tile_" + NRLib::ToString(i) + "_" + NRLib::ToString(j);
+}
+
+void
+LateralTiles::WriteModelFile(const std::string & model_file,
+                             int                 i,
+                             int                 j) const
+{
+  //
+  // Comments are removed as in XmlModelFile before the file is parsed.
+  //
+  std::ifstream file;
+  NRLib::OpenRead(file, model_file);
+  std::string line;
+  std::string clean;
+  while (std::getline(file, line))
+    clean += line.substr(0, line.find_first_of("#")) + "\n";
+  file.close();
+
+  TiXmlDocument doc;
+  doc.Parse(clean.c_str());
+
+  TiXmlNode * crava    = doc.FirstChildElement("crava");
+  TiXmlNode * project  = (crava   != 0 ? crava->FirstChildElement("project-settings") : 0);
+  TiXmlNode * volume   = (project != 0 ? project->FirstChildElement("output-volume")  : 0);
+  TiXmlNode * utm      = (volume  != 0 ? volume->FirstChildElement("utm-coordinates") : 0);
+  TiXmlNode * advanced = (project != 0 ? project->FirstChildElement("advanced-settings") : 0);
+  if (utm == 0 || advanced == 0)
+    throw NRLib::Exception("Could not find <utm-coordinates> and <advanced-settings> in " + model_file + ".");
+
+  int i_start = GetExtendedStart(bounds_x_, overlap_x_, i);
+  int j_start = GetExtendedStart(bounds_y_, overlap_y_, j);
+  int ni      = GetExtendedEnd(bounds_x_, overlap_x_, nx_, i) - i_start;
+  int nj      = GetExtendedEnd(bounds_y_, overlap_y_, ny_, j) - j_start;
+
+  double x_ref = x0_ + i_start*dx_*cos_rot_ - j_start*dy_*sin_rot_;
+  double y_ref = y0_ + i_start*dx_*sin_rot_ + j_start*dy_*cos_rot_;
+
+  // Half a cell is added to the lengths, so that the number of cells
+  // (lx/dx truncated) is not lost to rounding.
+  SetValue(utm, "reference-point-x", NRLib::ToString(x_ref, 6));
+  SetValue(utm, "reference-point-y", NRLib::ToString(y_ref, 6));
+  SetValue(utm, "length-x"         , NRLib::ToString((ni + 0.5)*dx_, 6));
+  SetValue(utm, "length-y"         , NRLib::ToString((nj + 0.5)*dy_, 6));
+
+  advanced->RemoveChild(advanced->FirstChildElement("lateral-tiles"));
+
+  TiXmlNode * io_settings = project->FirstChildElement("io-settings");
+  if (io_settings == 0)
+    io_settings = project->LinkEndChild(new TiXmlElement("io-settings"));
+
+  std::string output_dir = IO::OutputDirectory();
+  TiXmlElement * element = io_settings->FirstChildElement("output-directory");
+  if (element != 0 && element->GetText() != 0)
+    std::istringstream(element->GetText()) >> output_dir;
+  while (output_dir.size() > 1 && output_dir[output_dir.size() - 1] == '/')
+    output_dir.erase(output_dir.size() - 1);
+
+  SetValue(io_settings, "output-directory", output_dir + "/" + GetTileName(i, j));
+
+  std::string tile_file = IO::getOutputPath() + GetTileName(i, j) + "/" + IO::FileModelFile() + IO::SuffixXml();
+  NRLib::CreateDirIfNotExists(tile_file);
+  if (doc.SaveFile(tile_file) == false)
+    throw NRLib::Exception("Could not write the model file " + tile_file + ".");
+}
+
+void
+LateralTiles::SetValue(TiXmlNode         * node,
+                       const std::string & keyword,
+                       const std::string & value) const
+{
+  TiXmlNode * element = node->FirstChildElement(keyword.c_str());
+  if (element == 0)
+    element = node->LinkEndChild(new TiXmlElement(keyword.c_str()));
+  element->Clear();
+  element->LinkEndChild(new TiXmlText(" " + value + " "));
+}
+
+void
+LateralTiles::RunTiles(const std::string & executable) const
+{
+  int n_tiles     = n_tiles_x_*n_tiles_y_;
+  int n_processes = std::min(model_settings_->getNumberOfTileProcesses(), n_tiles);
+  int n_done      = 0;
+
+  LogKit::LogFormatted(LogKit::Low,"\nInverting %d tiles using %d process%s at a time.\n", n_tiles, n_processes, (n_processes > 1 ? "es" : ""));
+
+  std::string error;
+
+  //
+  // The tiles are separate runs of this program, so the threads only wait
+  // for the processes. Each tile logs to its own output directory.
+  //
+#ifdef PARALLEL
+#pragma omp parallel for schedule(dynamic, 1) num_threads(n_processes)
+#endif
+  for (int t = 0 ; t < n_tiles ; t++) {
+    std::string tile_name = GetTileName(t % n_tiles_x_, t / n_tiles_x_);
+    std::string tile_dir  = IO::getOutputPath() + tile_name + "/";
+    std::string command   = "\"" + executable + "\" \"" + tile_dir + IO::FileModelFile() + IO::SuffixXml() + "\" > \""
+                            + tile_dir + IO::FileScreenLog() + IO::SuffixTextFiles() + "\" 2>&1";
+
+    int status = std::system(command.c_str());
+
+#ifdef PARALLEL
+#pragma omp critical(lateral_tiles)
+#endif
+    {
+      n_done++;
+      if (status != 0) {
+        if (error == "")
+          error = "The inversion of " + tile_name + " failed. See " + tile_dir + IO::FileLog() + IO::SuffixTextFiles() + ".";
+      }
+      else {
+        LogKit::LogFormatted(LogKit::Low,"\n  %-10s finished (%d of %d)", tile_name.c_str(), n_done, n_tiles);
+      }
+    }
+  }
+
+  LogKit::LogFormatted(LogKit::Low,"\n");
+
+  if (error != "")
+    throw NRLib::Exception(error);
+}
+
+void
+LateralTiles::FindStormCubes(const std::string        & path,
+                             const std::string        & subdir,
+                             std::vector<std::string> & cubes) const
+{
+  namespace fs = boost::filesystem;
+
+  fs::directory_iterator end;
+  for (fs::directory_iterator it(fs::path(path + subdir)) ; it != end ; ++it) {
+    std::string name = NRLib::RemovePath(it->path().string());
+    if (fs::is_directory(it->path())) {
+      FindStormCubes(path, subdir + name + "/", cubes);
+    }
+    else {
+      int type = NRLib::FindGridFileType(path + subdir + name);
+      if (type == NRLib::STORM_PETRO_BINARY || type == NRLib::STORM_PETRO_ASCII || type == NRLib::STORM_PETRO_CHUNKED)
+        cubes.push_back(subdir + name);
+    }
+  }
+}
+
+void
+LateralTiles::BlendCube(const std::string     & cube,
+                        std::set<std::string> & written_surfaces) const
+{
+  //
+  // The header of the blended cube is that of the first tile, with the
+  // extent of the whole area. Top and base surfaces given as files are
+  // merged from the tiles and written next to the cube.
+  //
+  // The cube is blended and written in bands of rows, so only the band and
+  // the tiles overlapping it are held. As the taper weights of a cell sum
+  // to one, a cell is found from the at most 2 x 2 tiles covering it, and
+  // the weights are only renormalised where some of these tiles are missing.
+  //
+  int n_tiles = n_tiles_x_*n_tiles_y_;
+
+  std::vector<std::string> header(18);
+  double                   lz = 0.0;
+  for (int t = 0 ; t < n_tiles ; t++) {
+    int         ti        = t % n_tiles_x_;
+    int         tj        = t / n_tiles_x_;
+    std::string file_name = IO::getOutputPath() + GetTileName(ti, tj) + "/" + cube;
+
+    std::vector<std::string> tile_header(header.size());
+    try {
+      std::ifstream file;
+      NRLib::OpenRead(file, file_name, std::ios::in | std::ios::binary);
+      int line = 0;
+      for (size_t h = 0 ; h < tile_header.size() ; h++)
+        tile_header[h] = NRLib::ReadNext<std::string>(file, line);
+    }
+    catch (NRLib::Exception & e) {
+      throw NRLib::Exception("Could not read " + file_name + ": " + e.what());
+    }
+    if (t == 0)
+      header = tile_header;
+
+    int ni = GetExtendedEnd(bounds_x_, overlap_x_, nx_, ti) - GetExtendedStart(bounds_x_, overlap_x_, ti);
+    int nj = GetExtendedEnd(bounds_y_, overlap_y_, ny_, tj) - GetExtendedStart(bounds_y_, overlap_y_, tj);
+    if (!NRLib::IsType<int>(tile_header[15]) || !NRLib::IsType<int>(tile_header[16]) || !NRLib::IsType<double>(tile_header[13])
+        || NRLib::ParseType<int>(tile_header[15]) != ni || NRLib::ParseType<int>(tile_header[16]) != nj || tile_header[17] != header[17])
+      throw NRLib::Exception("The grid " + file_name + " has " + tile_header[15] + " x " + tile_header[16] + " x " + tile_header[17]
+                             + " cells, while the tile has " + NRLib::ToString(ni) + " x " + NRLib::ToString(nj) + " x "
+                             + header[17] + " cells.");
+    lz = std::max(lz, NRLib::ParseType<double>(tile_header[13]));
+  }
+
+  int   nk           = NRLib::ParseType<int>(header[17]);
+  float missing_code = NRLib::ParseType<float>(header[3]);
+
+  std::string path = IO::getOutputPath() + NRLib::GetPath(cube);
+  if (NRLib::GetPath(cube) != "")
+    path += "/";
+
+  std::string top_file  = path + header[9];
+  std::string bot_file  = path + header[10];
+  bool        merge_top = !NRLib::IsType<double>(header[9])  && written_surfaces.count(top_file) == 0;
+  bool        merge_bot = !NRLib::IsType<double>(header[10]) && written_surfaces.count(bot_file) == 0;
+
+  Surface top_surface(x0_, y0_, nx_*dx_, ny_*dy_, nx_ + 1, ny_ + 1, rot_, 0.0);
+  Surface bot_surface(x0_, y0_, nx_*dx_, ny_*dy_, nx_ + 1, ny_ + 1, rot_, 0.0);
+
+  std::string stormHeader = header[0] + "\n";
+  stormHeader += header[1] + " " + header[2] + " " + header[3] + "\n";
+  stormHeader += header[4] + "\n";
+  stormHeader += header[5] + " " + NRLib::ToString(nx_*dx_, 6) + " " + header[7] + " " + NRLib::ToString(ny_*dy_, 6) + " "
+                 + header[9] + " " + header[10] + " " + header[11] + " " + header[12] + "\n";
+  stormHeader += NRLib::ToString(lz, 6) + " " + header[14] + "\n\n";
+  stormHeader += NRLib::ToString(nx_) + " " + NRLib::ToString(ny_) + " " + NRLib::ToString(nk) + "\n";
+
+  NRLib::StormContGrid::FileFormat format = NRLib::StormContGrid::STORM_BINARY;
+  if (header[0] == "storm_petro_ascii")
+    format = NRLib::StormContGrid::STORM_ASCII;
+  else if (header[0] == "storm_petro_chunked")
+    format = NRLib::StormContGrid::STORM_CHUNKED;
+
+  std::string file_name = IO::getOutputPath() + cube;
+  NRLib::CreateDirIfNotExists(file_name);
+  std::ofstream file;
+  NRLib::OpenWrite(file, file_name, std::ios::out | std::ios::binary);
+  file << stormHeader;
+  std::streampos data_start = file.tellp();
+
+  // One row of chunks in the chunked format.
+  const int band_rows = 64;
+
+  NRLib::ChunkedGridWriter * chunked_writer = NULL;
+  if (format == NRLib::StormContGrid::STORM_CHUNKED)
+    chunked_writer = new NRLib::ChunkedGridWriter(file, nx_, ny_, nk, missing_code, 0.0, band_rows,
+                                                  model_settings_->getNumberOfThreads());
+
+  //
+  // The tiles covering a column i, and their weights. Likewise for rows,
+  // found band by band.
+  //
+  std::vector<std::vector<int> >    x_tiles(nx_);
+  std::vector<std::vector<double> > x_weights(nx_);
+  for (int i = 0 ; i < nx_ ; i++) {
+    for (int ti = 0 ; ti < n_tiles_x_ ; ti++) {
+      double w = FindTaperWeight(bounds_x_, overlap_x_, ti, i);
+      if (w > 0.0 && i >= GetExtendedStart(bounds_x_, overlap_x_, ti) && i < GetExtendedEnd(bounds_x_, overlap_x_, nx_, ti)) {
+        x_tiles[i].push_back(ti);
+        x_weights[i].push_back(w);
+      }
+    }
+  }
+
+  std::vector<NRLib::StormContGrid *> tiles(n_tiles, static_cast<NRLib::StormContGrid *>(NULL));
+
+  try {
+    for (int j0 = 0 ; j0 < ny_ ; j0 += band_rows) {
+      int j1 = std::min(ny_, j0 + band_rows);
+
+      //
+      // Each tile is read when the first band it overlaps is blended, and
+      // freed after the last one.
+      //
+      for (int tj = 0 ; tj < n_tiles_y_ ; tj++) {
+        if (GetExtendedStart(bounds_y_, overlap_y_, tj) >= j1 || GetExtendedEnd(bounds_y_, overlap_y_, ny_, tj) <= j0)
+          continue;
+        for (int ti = 0 ; ti < n_tiles_x_ ; ti++) {
+          if (tiles[tj*n_tiles_x_ + ti] != NULL)
+            continue;
+          std::string tile_file = IO::getOutputPath() + GetTileName(ti, tj) + "/" + cube;
+          NRLib::StormContGrid * tile = NULL;
+          try {
+            tile = new NRLib::StormContGrid(tile_file);
+          }
+          catch (NRLib::Exception & e) {
+            throw NRLib::Exception("Could not read " + tile_file + ": " + e.what());
+          }
+          tiles[tj*n_tiles_x_ + ti] = tile;
+
+          //
+          // Surface nodes are taken from the tile owning the cell they are the
+          // first corner of. The last row and column belong to the last tiles.
+          //
+          if (merge_top || merge_bot) {
+            int j_end = (tj == n_tiles_y_ - 1 ? ny_ + 1 : bounds_y_[tj + 1]);
+            int i_end = (ti == n_tiles_x_ - 1 ? nx_ + 1 : bounds_x_[ti + 1]);
+            for (int j = bounds_y_[tj] ; j < j_end ; j++) {
+              for (int i = bounds_x_[ti] ; i < i_end ; i++) {
+                double x = x0_ + i*dx_*cos_rot_ - j*dy_*sin_rot_;
+                double y = y0_ + i*dx_*sin_rot_ + j*dy_*cos_rot_;
+                if (merge_top) {
+                  double z = tile->GetTopSurface().GetZ(x, y);
+                  top_surface(i, j) = (tile->GetTopSurface().IsMissing(z) ? top_surface.GetMissingValue() : z);
+                }
+                if (merge_bot) {
+                  double z = tile->GetBotSurface().GetZ(x, y);
+                  bot_surface(i, j) = (tile->GetBotSurface().IsMissing(z) ? bot_surface.GetMissingValue() : z);
+                }
+              }
+            }
+          }
+        }
+      }
+
+      NRLib::Grid<float> band(nx_, j1 - j0, nk);
+      for (int j = j0 ; j < j1 ; j++) {
+        std::vector<int>    y_tiles;
+        std::vector<double> y_weights;
+        for (int tj = 0 ; tj < n_tiles_y_ ; tj++) {
+          double w = FindTaperWeight(bounds_y_, overlap_y_, tj, j);
+          if (w > 0.0 && j >= GetExtendedStart(bounds_y_, overlap_y_, tj) && j < GetExtendedEnd(bounds_y_, overlap_y_, ny_, tj)) {
+            y_tiles.push_back(tj);
+            y_weights.push_back(w);
+          }
+        }
+        for (int k = 0 ; k < nk ; k++) {
+          for (int i = 0 ; i < nx_ ; i++) {
+            double sum        = 0.0;
+            double weight_sum = 0.0;
+            for (size_t b = 0 ; b < y_tiles.size() ; b++) {
+              int tj = y_tiles[b];
+              int jt = j - GetExtendedStart(bounds_y_, overlap_y_, tj);
+              for (size_t a = 0 ; a < x_tiles[i].size() ; a++) {
+                int   ti    = x_tiles[i][a];
+                int   it    = i - GetExtendedStart(bounds_x_, overlap_x_, ti);
+                float value = (*tiles[tj*n_tiles_x_ + ti])(it, jt, k);
+                if (value != missing_code) {
+                  double w    = y_weights[b]*x_weights[i][a];
+                  sum        += w*value;
+                  weight_sum += w;
+                }
+              }
+            }
+            band(i, j - j0, k) = (weight_sum > 0.0 ? static_cast<float>(sum/weight_sum) : missing_code);
+          }
+        }
+      }
+
+      WriteBand(file, data_start, format, chunked_writer, band, j0, nk);
+
+      for (int tj = 0 ; tj < n_tiles_y_ ; tj++) {
+        if (GetExtendedEnd(bounds_y_, overlap_y_, ny_, tj) <= j1) {
+          for (int ti = 0 ; ti < n_tiles_x_ ; ti++) {
+            delete tiles[tj*n_tiles_x_ + ti];
+            tiles[tj*n_tiles_x_ + ti] = NULL;
+          }
+        }
+      }
+    }
+
+    // Final 0 (number of barriers), as in StormContGrid::WriteToFile().
+    if (chunked_writer != NULL)
+      chunked_writer->Finish();
+    else
+      file.seekp(data_start + static_cast<std::streamoff>(FindBandOffset(format, static_cast<size_t>(nx_)*ny_*nk)));
+    file << 0;
+    if (!file)
+      throw NRLib::Exception("Error writing " + file_name + ".");
+  }
+  catch (NRLib::Exception &) {
+    for (size_t t = 0 ; t < tiles.size() ; t++)
+      delete tiles[t];
+    delete chunked_writer;
+    throw;
+  }
+  delete chunked_writer;
+  file.close();
+
+  if (merge_top) {
+    top_surface.WriteToFile(top_file, NRLib::SURF_STORM_BINARY);
+    written_surfaces.insert(top_file);
+  }
+  if (merge_bot) {
+    bot_surface.WriteToFile(bot_file, NRLib::SURF_STORM_BINARY);
+    written_surfaces.insert(bot_file);
+  }
+}
+
+size_t
+LateralTiles::FindBandOffset(NRLib::StormContGrid::FileFormat format,
+                             size_t                           n) const
+{
+  //
+  // Offset of value n from the start of the data. ASCII values are written
+  // as "%15.8e " and ten on each line, so that a band can be written in
+  // place.
+  //
+  if (format == NRLib::StormContGrid::STORM_ASCII)
+    return n*16 + n/10;
+  return n*sizeof(float);
+}
+
+void
+LateralTiles::WriteBand(std::ofstream                    & file,
+                        std::streampos                     data_start,
+                        NRLib::StormContGrid::FileFormat   format,
+                        NRLib::ChunkedGridWriter         * chunked_writer,
+                        const NRLib::Grid<float>         & band,
+                        int                                j0,
+                        int                                nk) const
+{
+  if (chunked_writer != NULL) {
+    chunked_writer->WriteBand(band);
+    return;
+  }
+
+  //
+  // The rows of the band are consecutive within each layer.
+  //
+  size_t n_band = band.GetNI()*band.GetNJ();
+  for (int k = 0 ; k < nk ; k++) {
+    size_t n0    = (static_cast<size_t>(k)*ny_ + j0)*nx_;
+    size_t first = static_cast<size_t>(k)*n_band;
+    file.seekp(data_start + static_cast<std::streamoff>(FindBandOffset(format, n0)));
+    if (format == NRLib::StormContGrid::STORM_ASCII) {
+      std::string text;
+      text.reserve(FindBandOffset(format, n_band) + 1);
+      char buffer[32];
+      for (size_t n = 0 ; n < n_band ; n++) {
+        sprintf(buffer, "%15.8e ", band(first + n));
+        text += buffer;
+        if ((n0 + n + 1) % 10 == 0)
+          text += "\n";
+      }
+      file << text;
+    }
+    else {
+      NRLib::WriteBinaryFloatArray(file, band.begin() + first, band.begin() + first + n_band);
+    }
+  }
+}
@@ -0,0 +1,120 @@
+/***************************************************************************
+*      Copyright (C) 2008 by Norwegian Computing Center and Statoil        *
+***************************************************************************/
+
+#ifndef LATERALTILES_H
+#define LATERALTILES_H
+
+#include <fstream>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "nrlib/stormgrid/stormcontgrid.hpp"
+
+class ModelSettings;
+class TiXmlNode;
+
+namespace NRLib {
+  class ChunkedGridWriter;
+}
+
+//
+// Lateral decomposition of the inversion volume into overlapping tiles.
+//
+// Every FFTGrid of the inversion holds the whole padded volume, so the
+// memory needed grows with the lateral size of the survey. Instead, the
+// area is split into a number of tiles that are inverted one by one, or
+// by a few processes at a time, by running this program on a model file
+// where only the area and the output directory differ from the original.
+//
+// A tile is extended into its neighbours by twice the lateral padding that
+// an inversion of the tile would estimate from the correlation ranges. The
+// STORM cubes of the tiles are finally blended into cubes for the whole
+// area. Over the overlap, the weights go from one tile to the next as
+// cos^2/sin^2 tapers centred on the boundary, so the cells closest to the
+// edge of a tile are never used. The blended cubes are written band by
+// band, and never held in full.
+//
+class LateralTiles
+{
+public:
+  LateralTiles(const ModelSettings * model_settings);
+
+  // Inverts all tiles and blends the results. Returns true if failed.
+  bool                     Run(const std::string & executable,
+                               const std::string & model_file);
+
+private:
+  void                     FindTiles(int                n_cells,
+                                     int                n_tiles,
+                                     int                overlap,
+                                     const std::string & direction,
+                                     std::vector<int> & bounds) const;
+
+  int                      GetExtendedStart(const std::vector<int> & bounds,
+                                            int                      overlap,
+                                            int                      tile) const;
+
+  int                      GetExtendedEnd(const std::vector<int> & bounds,
+                                          int                      overlap,
+                                          int                      n_cells,
+                                          int                      tile) const;
+
+  double                   FindTaperWeight(const std::vector<int> & bounds,
+                                           int                      overlap,
+                                           int                      tile,
+                                           int                      index) const;
+
+  std::string              GetTileName(int i,
+                                       int j) const;
+
+  void                     WriteModelFile(const std::string & model_file,
+                                          int                 i,
+                                          int                 j) const;
+
+  void                     SetValue(TiXmlNode         * node,
+                                    const std::string & keyword,
+                                    const std::string & value) const;
+
+  void                     RunTiles(const std::string & executable) const;
+
+  void                     FindStormCubes(const std::string        & path,
+                                          const std::string        & subdir,
+                                          std::vector<std::string> & cubes) const;
+
+  void                     BlendCube(const std::string     & cube,
+                                     std::set<std::string> & written_surfaces) const;
+
+  size_t                   FindBandOffset(NRLib::StormContGrid::FileFormat format,
+                                          size_t                           n) const;
+
+  void                     WriteBand(std::ofstream                    & file,
+                                     std::streampos                     data_start,
+                                     NRLib::StormContGrid::FileFormat   format,
+                                     NRLib::ChunkedGridWriter         * chunked_writer,
+                                     const NRLib::Grid<float>         & band,
+                                     int                                j0,
+                                     int                                nk) const;
+
+  const ModelSettings    * model_settings_;
+
+  double                   x0_;
+  double                   y0_;
+  double                   dx_;
+  double                   dy_;
+  double                   cos_rot_;
+  double                   sin_rot_;
+  double                   rot_;
+  int                      nx_;
+  int                      ny_;
+
+  int                      n_tiles_x_;
+  int                      n_tiles_y_;
+  int                      overlap_x_;      ///< Half width of the blending zone in cells
+  int                      overlap_y_;
+  std::vector<int>         bounds_x_;       ///< First cell of each tile core, and nx_ last
+  std::vector<int>         bounds_y_;
+};
+
+#endif
@@ -28,6 +28,7 @@
 #include "src/tasklist.h"
 #include "src/seismicparametersholder.h"
 #include "src/commondata.h"
+#include "src/preprocessingcache.h"
 
 #include "lib/utils.h"
 #include "lib/random.h"
@@ -139,21 +140,63 @@ ModelAVODynamic::ModelAVODynamic(ModelSettings          *& model_settings,
       NRLib::Grid2D<bool> * dead_traces_map = new NRLib::Grid2D<bool>();
 
       seis_cubes_[i]->setAccessMode(FFTGrid::RANDOMACCESS);
-      common_data->FillInData(grid_tmp,
-                              seis_cubes_[i],
-                              simbox,
-                              storm,
-                              segy,
-                              model_settings->getSmoothLength(),
-                              missing_traces_simbox,
-                              missing_traces_padding,
-                              dead_traces_simbox,
-                              dead_traces_map,
-                              FFTGrid::DATA,
-                              scale,
-                              is_segy,
-                              is_storm,
-                              true);
+
+      //
+      // The resampled cube only depends on the seismic data and the grids,
+      // and is read from the cache if these are unchanged. The lateral
+      // padding repeats traces of the simbox and is made again, but the
+      // vertical padding holds data from above and below the interval and
+      // is cached with it.
+      //
+      bool                              from_cache = false;
+      PreprocessingCache                cache(model_settings);
+      std::vector<std::vector<double> > cached_counts(1);
+      if (cache.IsEnabled()) {
+        cache.StartKey("seismic");
+        cache.AddSeismicToKey(seismic_data[i]);
+        cache.AddSimboxToKey(simbox);
+        cache.AddToKey(nxp);
+        cache.AddToKey(nyp);
+        cache.AddToKey(nzp);
+        cache.AddSimboxToKey(&common_data->GetFullInversionSimbox());
+        cache.AddToKey(model_settings->getGuardZone());
+        cache.AddToKey(model_settings->getSmoothLength());
+
+        from_cache = (cache.LoadGrid(cached_counts, seis_cubes_[i]) && cached_counts[0].size() == 3);
+        if (from_cache) {
+          LogKit::LogFormatted(LogKit::Low,"\nResampled seismic data read from the cache file %s.\n", cache.GetFileName().c_str());
+          CommonData::FillInLateralPadding(seis_cubes_[i]);
+          missing_traces_simbox  = static_cast<int>(cached_counts[0][0]);
+          missing_traces_padding = static_cast<int>(cached_counts[0][1]);
+          dead_traces_simbox     = static_cast<int>(cached_counts[0][2]);
+        }
+      }
+
+      if (!from_cache) {
+        common_data->FillInData(grid_tmp,
+                                seis_cubes_[i],
+                                simbox,
+                                storm,
+                                segy,
+                                model_settings->getSmoothLength(),
+                                missing_traces_simbox,
+                                missing_traces_padding,
+                                dead_traces_simbox,
+                                dead_traces_map,
+                                FFTGrid::DATA,
+                                scale,
+                                is_segy,
+                                is_storm,
+                                true);
+
+        if (cache.IsEnabled()) {
+          cached_counts[0].resize(3);
+          cached_counts[0][0] = missing_traces_simbox;
+          cached_counts[0][1] = missing_traces_padding;
+          cached_counts[0][2] = dead_traces_simbox;
+          cache.SaveGrid(cached_counts, seis_cubes_[i]);
+        }
+      }
 
       seis_cubes_[i]->endAccess();
 
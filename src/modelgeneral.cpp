@@ -126,7 +126,7 @@ ModelGeneral::ModelGeneral(ModelSettings           *& model_settings,
 
         SetupState4D(seismic_parameters, simbox_, state4d_, initial_mean, initial_cov);
 
-        time_evolution_ = TimeEvolution(10000, *time_line_, rock_distributions_.begin()->second); //NBNB OK 10000->1000 for speed during testing
+        time_evolution_ = TimeEvolution(10000, *time_line_, rock_distributions_.begin()->second, model_settings->getNumberOfThreads()); //NBNB OK 10000->1000 for speed during testing
         time_evolution_.SetInitialMean(initial_mean);
         time_evolution_.SetInitialCov(initial_cov);
       }
@@ -387,7 +387,8 @@ ModelGeneral::updateState4DMu(FFTGrid * mu_vp_static,
 bool
 ModelGeneral::Do4DRockPhysicsInversion(ModelSettings* model_settings)
 {
-  std::vector<FFTGrid*> predictions = state4d_.doRockPhysicsInversion(*time_line_, rock_distributions_.begin()->second,  time_evolution_);
+  std::vector<FFTGrid*> predictions = state4d_.doRockPhysicsInversion(*time_line_, rock_distributions_.begin()->second,  time_evolution_,
+                                                                      model_settings->getNumberOfThreads());
   int nParamOut = static_cast<int>(predictions.size());
 
   std::vector<std::string> labels(nParamOut);
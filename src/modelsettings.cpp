@@ -151,6 +151,7 @@ ModelSettings::ModelSettings(void)
   outputGridsSeismic_      =        0;
   outputGridsDefault_      =     true;
   formatFlag_              = IO::STORM;
+  chunked_quantization_step_ = 0.0;
   domainFlag_              = IO::TIMEDOMAIN;
   wellFlag_                =        0;
   wellFormatFlag_          = IO::RMSWELL;
@@ -159,6 +160,10 @@ ModelSettings::ModelSettings(void)
   otherFlag_               =        0;
   debugFlag_               =        0;
   fileGrid_                =    false;
+  spill_interval_results_  =    false;
+  write_checkpoints_       =    false;
+  restart_from_checkpoints_=    false;
+  cache_directory_         =       "";
   waveletFormatManual_     =    false;
   useVerticalVariogram_    =    false;
   do4DInversion_           =    false;
@@ -207,6 +212,9 @@ ModelSettings::ModelSettings(void)
 
   seed_                    =        0;
   number_of_threads_       =        0;
+  n_lateral_tiles_x_       =        1;
+  n_lateral_tiles_y_       =        1;
+  n_tile_processes_        =        1;
 
   erosion_priority_top_surface_ = 1;
 
@@ -43,6 +43,9 @@ public:
   TraceHeaderFormat              * getTraceHeaderFormatBackground(int i)const { return traceHeaderFormatBackground_[i]            ;}
   TraceHeaderFormat              * getTraceHeaderFormat(int i, int j)   const { return timeLapseLocalTHF_[i][j]                   ;}
   int                              getNumberOfThreads(void)             const { return number_of_threads_                         ;}
+  int                              getNumberOfLateralTilesX(void)       const { return n_lateral_tiles_x_                         ;}
+  int                              getNumberOfLateralTilesY(void)       const { return n_lateral_tiles_y_                         ;}
+  int                              getNumberOfTileProcesses(void)       const { return n_tile_processes_                          ;}
   int                              getNumberOfTraceHeaderFormats(int i) const { return static_cast<int>(timeLapseLocalTHF_[i].size());}
   int                              getKrigingParameter(void)            const { return krigingParameter_                          ;}
   float                            getConstBackValue(int i)             const { return constBackValue_[i]                         ;}
@@ -170,6 +173,7 @@ public:
   int                              getOutputGridsOther(void)            const { return outputGridsOther_                          ;}
   int                              getOutputGridsSeismic(void)          const { return outputGridsSeismic_                        ;}
   int                              getOutputGridFormat(void)            const { return formatFlag_                                ;}
+  double                           getChunkedQuantizationStep(void)     const { return chunked_quantization_step_                 ;}
   int                              getOutputGridDomain(void)            const { return domainFlag_                                ;}
   bool                             getOutputGridsDefaultInd(void)       const { return outputGridsDefault_                        ;}
   int                              getWellOutputFlag(void)              const { return wellFlag_                                  ;}
@@ -181,6 +185,10 @@ public:
   int                              getDebugFlag(void)                   const { return debugFlag_                                 ;}
   static int                       getDebugLevel(void)                        { return debugFlag_                                 ;}
   bool                             getFileGrid(void)                    const { return fileGrid_                                  ;}
+  bool                             getSpillIntervalResults(void)        const { return spill_interval_results_                    ;}
+  bool                             getWriteCheckpoints(void)            const { return write_checkpoints_                         ;}
+  bool                             getRestartFromCheckpoints(void)      const { return restart_from_checkpoints_                  ;}
+  const std::string              & getCacheDirectory(void)              const { return cache_directory_                           ;}
   bool                             getEstimationMode(void)              const { return estimationMode_                            ;}
   bool                             getForwardModeling(void)             const { return forwardModeling_                           ;}
   bool                             getGenerateSeismicAfterInv(void)     const { return generateSeismicAfterInv_                   ;}
@@ -347,6 +355,9 @@ public:
   void addWellRelativeCoord(bool relative)                { wellRelativeCoord_.push_back(relative)               ;}
 
   void setNumberOfThreads(int n_threads)                  { number_of_threads_        = n_threads                ;}
+  void setNumberOfLateralTilesX(int n_tiles)              { n_lateral_tiles_x_        = n_tiles                  ;}
+  void setNumberOfLateralTilesY(int n_tiles)              { n_lateral_tiles_y_        = n_tiles                  ;}
+  void setNumberOfTileProcesses(int n_processes)          { n_tile_processes_         = n_processes              ;}
   void setNumberOfWells(int nWells)                       { nWells_                   = nWells                   ;}
   void setNumberOfSimulations(int nSimulations)           { nSimulations_             = nSimulations             ;}
   void setVpMin(float vp_min)                             { vp_min_                   = vp_min                   ;}
@@ -411,6 +422,7 @@ public:
   void setAreaSpecification(int areaSpecification)        { areaSpecification_        = areaSpecification        ;}
   void setWritePrediction(bool write)                     { writePrediction_          = write                    ;}
   void setOutputGridFormat(int formatFlag)                { formatFlag_               = formatFlag               ;}
+  void setChunkedQuantizationStep(double step)            { chunked_quantization_step_ = step                    ;}
   void setOutputGridDomain(int domainFlag)                { domainFlag_               = domainFlag               ;}
   void setOutputGridsElastic(int outputGridsElastic)      { outputGridsElastic_       = outputGridsElastic       ;}
   void setOutputGridsOther(int outputGridsOther)          { outputGridsOther_         = outputGridsOther         ;}
@@ -424,6 +436,10 @@ public:
   void setOtherOutputFlag(int otherFlag)                  { otherFlag_                = otherFlag                ;}
   void setDebugFlag(int debugFlag)                        { debugFlag_                = debugFlag                ;}
   void setFileGrid(bool fileGrid)                         { fileGrid_                 = fileGrid                 ;}
+  void setSpillIntervalResults(bool spill)                { spill_interval_results_   = spill                    ;}
+  void setWriteCheckpoints(bool write)                    { write_checkpoints_        = write                    ;}
+  void setRestartFromCheckpoints(bool restart)            { restart_from_checkpoints_ = restart                  ;}
+  void setCacheDirectory(const std::string & directory)   { cache_directory_          = directory                ;}
   void setEstimationMode(bool estimationMode)             { estimationMode_           = estimationMode           ;}
   void setForwardModeling(bool forwardModeling)           { forwardModeling_          = forwardModeling          ;}
   void setGenerateSeismicAfterInv( bool generateSeismic)  { generateSeismicAfterInv_  = generateSeismic          ;}
@@ -703,6 +719,9 @@ private:
   std::map<std::string, std::map<std::string, float> > volumeFraction_;  ///< map interval map facies name
 
   int                               number_of_threads_;
+  int                               n_lateral_tiles_x_;          ///< Number of lateral tiles in x direction (1 = no tiling)
+  int                               n_lateral_tiles_y_;          ///< Number of lateral tiles in y direction
+  int                               n_tile_processes_;           ///< Number of tiles inverted at the same time
   int                               nWells_;
   int                               nSimulations_;
 
@@ -793,12 +812,17 @@ private:
   int                               outputGridsSeismic_;         ///< Decides seismic grid output to be written to file.
   int                               domainFlag_;                 ///< Decides writing in time and/or depth.
   int                               formatFlag_;                 ///< Decides output format, see above.
+  double                            chunked_quantization_step_;  ///< Rounding of values in chunked grids. Lossless if zero
   int                               wellFlag_;                   ///< Decides well output.
   int                               wellFormatFlag_;             ///< Decides well output format.
   int                               waveletFlag_;                ///< Decides wavelet output
   int                               waveletFormatFlag_;          ///< Decides wavelet output format
   int                               otherFlag_;                  ///< Decides output beyond grids and wells.
   bool                              fileGrid_;                   ///< Indicator telling if grids are to be kept on file
+  bool                              spill_interval_results_;     ///< Keep finished interval results on file until they are combined
+  bool                              write_checkpoints_;          ///< Write the inversion state to file after each phase
+  bool                              restart_from_checkpoints_;   ///< Resume from the last phase found on file if the inputs are unchanged
+  std::string                       cache_directory_;            ///< Directory of cached preprocessing products. Empty if not used
   bool                              outputGridsDefault_;         ///< Indicator telling if grid output has been actively controlled
   bool                              waveletFormatManual_;        ///< True if wavelet format is decided in the model file
   bool                              useVerticalVariogram_;       ///< True if a vertical variogram is used to estimate temporal correlation
@@ -258,7 +258,7 @@ MultiIntervalGrid::MultiIntervalGrid(ModelSettings * model_settings,
             interval_simboxes_[i]->WriteTopBaseSurfaceGrids(top_surf, base_surf,
                                       IO::PathToInversionResults(), output_format);
         }
-        if ((output_format & IO::STORM) > 0) { // These copies are only needed with the STORM format
+        if ((output_format & (IO::STORM | IO::CHUNKED)) > 0) { // These copies are only needed with the STORM formats
           if ((output_grids_elastic & IO::BACKGROUND) > 0 ||
               (output_grids_elastic & IO::BACKGROUND_TREND) > 0 ||
               (estimation_mode && generate_background)) {
@@ -499,6 +499,17 @@ ParameterOutput::WriteFile(const ModelSettings     * model_settings,
         LogKit::LogFormatted(LogKit::Low,"done\n");
       }
 
+      if ((format_flag & IO::CHUNKED) > 0) {
+        const std::string header = simbox->getStormHeader(1, simbox->getnx(), simbox->getny(), simbox->getnz(), false, false);
+        output->SetFormat(NRLib::StormContGrid::STORM_CHUNKED);
+        output->SetQuantizationStep(model_settings->getChunkedQuantizationStep());
+        output->SetNumberOfThreads(model_settings->getNumberOfThreads());
+        std::string file_name_chunked = file_name + IO::SuffixStormChunked();
+        LogKit::LogFormatted(LogKit::Low," Writing chunked STORM file "+file_name_chunked+"...");
+        output->WriteToFile(file_name_chunked, header, false);
+        LogKit::LogFormatted(LogKit::Low,"done\n");
+      }
+
       if ((format_flag & IO::ASCII) > 0) {
         output->SetFormat(NRLib::StormContGrid::STORM_ASCII);
         const std::string header = simbox->getStormHeader(1, simbox->getnx(), simbox->getny(), simbox->getnz(), false, true);
@@ -567,6 +578,19 @@ ParameterOutput::WriteFile(const ModelSettings     * model_settings,
           output->WriteToFile(file_name_storm, header, false);
           LogKit::LogFormatted(LogKit::Low,"done\n");
         }
+        if ((format_flag & IO::CHUNKED) > 0) {
+          output->SetFormat(NRLib::StormContGrid::STORM_CHUNKED);
+          output->SetQuantizationStep(model_settings->getChunkedQuantizationStep());
+          output->SetNumberOfThreads(model_settings->getNumberOfThreads());
+          std::string file_name_chunked = depth_name + IO::SuffixStormChunked();
+          int nx = static_cast<int>(output->GetNI());
+          int ny = static_cast<int>(output->GetNJ());
+          int nz = static_cast<int>(output->GetNK());
+          std::string header = depth_map->getSimbox()->getStormHeader(FFTGrid::PARAMETER, nx, ny, nz, false, false);
+          LogKit::LogFormatted(LogKit::Low," Writing chunked STORM file "+file_name_chunked+"...");
+          output->WriteToFile(file_name_chunked, header, false);
+          LogKit::LogFormatted(LogKit::Low,"done\n");
+        }
         if ((format_flag & IO::ASCII) > 0) {
           output->SetFormat(NRLib::StormContGrid::STORM_ASCII);
           std::string file_name_ascii = depth_name + IO::SuffixGeneralData();
@@ -683,6 +707,18 @@ ParameterOutput::WriteResampledStormCube(const StormContGrid * storm_grid,
     outgrid->WriteToFile(gf_name,header);
     LogKit::LogFormatted(LogKit::Low,"done\n");
   }
+  if ((format & IO::CHUNKED) > 0) {
+    gf_name =  file_name + IO::SuffixStormChunked();
+    int nx = static_cast<int>(storm_grid->GetNI());
+    int ny = static_cast<int>(storm_grid->GetNJ());
+    header = gridmapping->getSimbox()->getStormHeader(FFTGrid::PARAMETER, nx, ny, nz, 0, 0);
+    outgrid->SetFormat(StormContGrid::STORM_CHUNKED);
+    outgrid->SetQuantizationStep(model_settings->getChunkedQuantizationStep());
+    outgrid->SetNumberOfThreads(model_settings->getNumberOfThreads());
+    LogKit::LogFormatted(LogKit::Low," Writing chunked STORM file "+gf_name+"...");
+    outgrid->WriteToFile(gf_name,header);
+    LogKit::LogFormatted(LogKit::Low,"done\n");
+  }
   if((format & IO::SEGY) > 0 && is_depth == false) {
     gf_name =  file_name + IO::SuffixSegy();
 
@@ -1,5 +1,6 @@
 #include "src/fftgrid.h"
 #include <math.h>
+#include <algorithm>
 #include <src/posteriorelasticpdf.h>
 #include <src/simbox.h>
 
@@ -218,3 +219,212 @@ void PosteriorElasticPDF::SetupSmoothingGaussian2D(FFTGrid                 * smo
 
   delete [] smooth;
 }
+
+void PosteriorElasticPDF::CountPoints(const std::vector<int> & cell,
+                                      int                      n_cells,
+                                      std::vector<int>       & counts) const
+{
+  counts.assign(n_cells, 0);
+
+  int n_points  = static_cast<int>(cell.size());
+  int n_threads = FFTGrid::getNumberOfThreads();
+
+  // Adding up a sub-histogram costs a pass over all cells, so each thread
+  // needs at least as many points as there are cells.
+  int n_chunks  = std::max(1, std::min(n_threads, n_points/std::max(n_cells, 1)));
+
+  if (n_chunks == 1) {
+    for (int i = 0; i < n_points; i++) {
+      if (cell[i] >= 0 && cell[i] < n_cells)
+        counts[cell[i]]++;
+    }
+    return;
+  }
+
+  int chunk_size = (n_points + n_chunks - 1)/n_chunks;
+  std::vector<std::vector<int> > sub_counts(n_chunks);
+
+#ifdef PARALLEL
+#pragma omp parallel for schedule(static, 1) num_threads(n_chunks)
+#endif
+  for (int c = 0; c < n_chunks; c++) {
+    std::vector<int> & sub = sub_counts[c];
+    sub.assign(n_cells, 0);
+    int last = std::min(n_points, (c + 1)*chunk_size);
+    for (int i = c*chunk_size; i < last; i++) {
+      if (cell[i] >= 0 && cell[i] < n_cells)
+        sub[cell[i]]++;
+    }
+  }
+
+#ifdef PARALLEL
+#pragma omp parallel for schedule(static) num_threads(n_threads)
+#endif
+  for (int i = 0; i < n_cells; i++) {
+    int sum = 0;
+    for (int c = 0; c < n_chunks; c++)
+      sum += sub_counts[c][i];
+    counts[i] = sum;
+  }
+}
+
+bool PosteriorElasticPDF::MakeSeparableKernels(const NRLib::Matrix              & sigma_inv,
+                                               const int                        * n,
+                                               const double                     * d,
+                                               std::vector<std::vector<float> > & kernels) const
+{
+  int n_dim = static_cast<int>(sigma_inv.numRows());
+  for (int i = 0; i < n_dim; i++) {
+    for (int j = 0; j < i; j++) {
+      if (sigma_inv(i,j) != 0.0)
+        return false;
+    }
+  }
+
+  //
+  // The kernels are cut where the Gaussian has dropped below 1e-7 of its
+  // peak, which is below float precision. A direct convolution with the
+  // kernels costs one multiply-add per kernel element and grid cell, while
+  // the FFT smoothing costs three transforms of the full grid.
+  //
+  int n_cells = 1;
+  for (int i = 0; i < n_dim; i++)
+    n_cells *= n[i];
+
+  kernels.resize(n_dim);
+  int n_taps = 0;
+  for (int i = 0; i < n_dim; i++) {
+    double a = sigma_inv(i,i)*d[i]*d[i];
+    if (!(a > 0.0))
+      return false;
+    int h = static_cast<int>(ceil(sqrt(2.0*log(1.0e7)/a)));
+    if (n[i] == 1)
+      h = 0;
+    else if (2*h + 1 > n[i])
+      return false;
+
+    std::vector<double> w(2*h + 1);
+    double sum = 0.0;
+    for (int k = -h; k <= h; k++) {
+      w[k + h] = exp(-0.5*a*k*k);
+      sum     += w[k + h];
+    }
+    kernels[i].resize(2*h + 1);
+    for (int k = 0; k < 2*h + 1; k++)
+      kernels[i][k] = static_cast<float>(w[k]/sum);
+
+    n_taps += 2*h + 1;
+  }
+
+  double log2_cells = log(static_cast<double>(n_cells))/log(2.0);
+  return n_taps <= 6.0*log2_cells;
+}
+
+void PosteriorElasticPDF::SmoothSeparable(std::vector<float>                     & density,
+                                          int                                      n1,
+                                          int                                      n2,
+                                          int                                      n3,
+                                          const std::vector<std::vector<float> > & kernels) const
+{
+  std::vector<float> tmp(density.size());
+
+  ConvolveCyclic(density, tmp, n2*n3, n1, 1, kernels[0]);
+  ConvolveCyclic(tmp, density, n3, n2, n1, kernels[1]);
+  if (kernels.size() > 2 && n3 > 1) {
+    tmp.swap(density);
+    ConvolveCyclic(tmp, density, 1, n3, n1*n2, kernels[2]);
+  }
+}
+
+void PosteriorElasticPDF::ConvolveCyclic(const std::vector<float> & src,
+                                         std::vector<float>       & dst,
+                                         int                        n_outer,
+                                         int                        n,
+                                         int                        n_inner,
+                                         const std::vector<float> & kernel) const
+{
+  //
+  // Convolves along the middle index of an n_outer x n x n_inner array. Along
+  // the first grid index (n_inner = 1) each line is copied to a buffer with
+  // the wrapped ends added, so that the inner loop runs over the line. Along
+  // the other indices the inner loop runs over the n_inner contiguous values.
+  // Output lines are independent, so they are shared between threads.
+  //
+  int h = static_cast<int>(kernel.size()/2);
+
+  if (n_inner == 1) {
+#ifdef PARALLEL
+    int n_threads = FFTGrid::getNumberOfThreads();
+#pragma omp parallel num_threads(n_threads)
+#endif
+    {
+      std::vector<float> buffer(n + 2*h);
+#ifdef PARALLEL
+#pragma omp for schedule(static)
+#endif
+      for (int o = 0; o < n_outer; o++) {
+        const float * in  = &src[o*n];
+        float       * out = &dst[o*n];
+        for (int t = 0; t < h; t++) {
+          buffer[t]         = in[n - h + t];
+          buffer[n + h + t] = in[t];
+        }
+        for (int t = 0; t < n; t++)
+          buffer[h + t] = in[t];
+
+        for (int t = 0; t < n; t++)
+          out[t] = 0.0f;
+        for (int k = 0; k < 2*h + 1; k++) {
+          float         w = kernel[k];
+          const float * b = &buffer[k];
+          for (int t = 0; t < n; t++)
+            out[t] += w*b[t];
+        }
+      }
+    }
+  }
+  else {
+    int n_lines = n_outer*n;
+#ifdef PARALLEL
+    int n_threads = FFTGrid::getNumberOfThreads();
+#pragma omp parallel for schedule(static) num_threads(n_threads)
+#endif
+    for (int line = 0; line < n_lines; line++) {
+      int     o   = line/n;
+      int     t   = line - o*n;
+      float * out = &dst[line*n_inner];
+      for (int i = 0; i < n_inner; i++)
+        out[i] = 0.0f;
+      for (int k = -h; k <= h; k++) {
+        int s = t + k;
+        if (s < 0)
+          s += n;
+        else if (s >= n)
+          s -= n;
+        const float * in = &src[(o*n + s)*n_inner];
+        float         w  = kernel[k + h];
+        for (int i = 0; i < n_inner; i++)
+          out[i] += w*in[i];
+      }
+    }
+  }
+}
+
+void PosteriorElasticPDF::FillInDensity(FFTGrid                  * grid,
+                                        const std::vector<float> & density) const
+{
+  int nx   = grid->getNx();
+  int ny   = grid->getNy();
+  int nz   = grid->getNz();
+  int rnxp = grid->getRNxp();
+
+  grid->setAccessMode(FFTGrid::WRITE);
+  for (int k = 0; k < nz; k++) {
+    for (int j = 0; j < ny; j++) {
+      const float * row = &density[(k*ny + j)*nx];
+      for (int i = 0; i < rnxp; i++)
+        grid->setNextReal(i < nx ? row[i] : 0.0f);
+    }
+  }
+  grid->endAccess();
+}
@@ -78,6 +78,43 @@ protected:
                                 int                         n3,
                                 double                      dx,
                                 double                      dy);
+
+  // Counts the data points in each of n_cells cells. Points with a cell index
+  // outside [0, n_cells) are not counted. Large point sets are split between
+  // threads, each counting into its own sub-histogram.
+  void CountPoints(const std::vector<int>    & cell,
+                   int                         n_cells,
+                   std::vector<int>          & counts) const;
+
+  // Makes the 1D kernels of a Gaussian smoother with inverse covariance sigma_inv
+  // (2x2 or 3x3) on a grid with n[i] cells of size d[i]. Returns false if the
+  // Gaussian is correlated in the grid axes, or too wide for a direct
+  // convolution to beat the FFT.
+  bool MakeSeparableKernels(const NRLib::Matrix               & sigma_inv,
+                            const int                         * n,
+                            const double                      * d,
+                            std::vector<std::vector<float> >  & kernels) const;
+
+  // Smooths an n1 x n2 x n3 density (first index fastest) with separable kernels,
+  // using the same circular boundary as the FFT smoothing.
+  void SmoothSeparable(std::vector<float>                     & density,
+                       int                                      n1,
+                       int                                      n2,
+                       int                                      n3,
+                       const std::vector<std::vector<float> > & kernels) const;
+
+  // Writes a density of the same size as the grid, with zeros in the padding.
+  void FillInDensity(FFTGrid                  * grid,
+                     const std::vector<float> & density) const;
+
+private:
+
+  void ConvolveCyclic(const std::vector<float> & src,
+                      std::vector<float>       & dst,
+                      int                        n_outer,
+                      int                        n,
+                      int                        n_inner,
+                      const std::vector<float> & kernel) const;
 };
 
 #endif
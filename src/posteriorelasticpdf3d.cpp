@@ -41,17 +41,7 @@ z_max_(d3_max)
 
   histogram_ = new FFTGrid(n1_, n2_, n3_, n1_, n2_, n3_);
   histogram_->createRealGrid(false);
-  int rnxp = histogram_->getRNxp();
   histogram_->setType(FFTGrid::PARAMETER);
-  histogram_->setAccessMode(FFTGrid::WRITE);
-
-  for(int l=0;l<n3_;l++){
-    for(int k=0;k<n2_;k++){
-      for(int j=0;j<rnxp;j++)
-        histogram_->setNextReal(0.0f);
-    }
-  }
-  histogram_->endAccess();
 
   // Spacing variables in the density grid
   dx_ = (x_max_ - x_min_)/n1_;
@@ -59,22 +49,32 @@ z_max_(d3_max)
   dz_ = (z_max_ - z_min_)/n3_;
 
   // Go through data points and place in bins in histogram
+  int n_cells = n1_*n2_*n3_;
+  std::vector<int> cell(dim);
 
+#ifdef PARALLEL
+  int n_threads = FFTGrid::getNumberOfThreads();
+#pragma omp parallel for schedule(static) num_threads(n_threads)
+#endif
   for (int i = 0; i < dim; i++){
-    //volume->getIndexes(d1[i], d2[i], d3[i], i_tmp, j_tmp, k_tmp);
     int i_tmp = static_cast<int>(floor((d1[i]-x_min_)/dx_));
     int j_tmp = static_cast<int>(floor((d2[i]-y_min_)/dy_));
     int k_tmp = static_cast<int>(floor((d3[i]-z_min_)/dz_));
-    // Counting data points in index (i,j,k)
-    histogram_->setAccessMode(FFTGrid::RANDOMACCESS);
-    histogram_->setRealValue(i_tmp,j_tmp,k_tmp, histogram_->getRealValue(i_tmp,j_tmp,k_tmp) + 1.0f);
-    histogram_->endAccess();
+    if (i_tmp >= 0 && i_tmp < n1_ && j_tmp >= 0 && j_tmp < n2_ && k_tmp >= 0 && k_tmp < n3_)
+      cell[i] = i_tmp + n1_*(j_tmp + n2_*k_tmp);
+    else
+      cell[i] = -1;
   }
 
+  std::vector<int> counts;
+  CountPoints(cell, n_cells, counts);
+
   //multiply by normalizing constant for the PDF - dim is the total number of entries
-  histogram_->setAccessMode(FFTGrid::READANDWRITE);
-  histogram_->multiplyByScalar(float(1.0f/dim));
-  histogram_->endAccess();
+  float scale = float(1.0f/dim);
+  std::vector<float> density(n_cells);
+  for (int i = 0; i < n_cells; i++)
+    density[i] = static_cast<float>(counts[i])*scale;
+  FillInDensity(histogram_, density);
 
   if(ModelSettings::getDebugLevel() >= 1){
     std::string baseName = "Hist_" + NRLib::ToString(ind) + IO::SuffixAsciiFiles();
@@ -82,30 +82,29 @@ z_max_(d3_max)
     histogram_->writeAsciiFile(fileName);
   }
 
-  histogram_->fftInPlace();
-
   NRLib::Matrix sigma_tmp(3,3);
 
-  /*
-  double **sigma_tmp = new double *[3];
-  for (int i=0;i<3;i++){
-    sigma_tmp[i] = new double[3];
-  }
-  */
   for(int i=0;i<3;i++){
     for(int j=0; j<3; j++)
       sigma_tmp(i,j) = sigma[i][j];
     }
   // Matrix inversion of the covariance matrix sigma
   NRLib::Matrix sigma_inv;
-  /*
-  double **sigma_inv = new double *[3];
-  for(int i=0; i<3; i++)
-    sigma_inv[i] = new double [3];
-  */
 
   InvertSquareMatrix(sigma_tmp,sigma_inv,3);
 
+  // A Gaussian along the grid axes is applied as three short 1D convolutions
+  int    n[3] = {n1_, n2_, n3_};
+  double d[3] = {dx_, dy_, dz_};
+  std::vector<std::vector<float> > kernels;
+  if (MakeSeparableKernels(sigma_inv, n, d, kernels)) {
+    SmoothSeparable(density, n1_, n2_, n3_, kernels);
+    FillInDensity(histogram_, density);
+    return;
+  }
+
+  histogram_->fftInPlace();
+
   FFTGrid *smoother = new FFTGrid(n1, n2, n3, n1, n2, n3);
 
   smoother->createRealGrid(false);
@@ -188,17 +187,7 @@ PosteriorElasticPDF3D::PosteriorElasticPDF3D(const std::vector<double>
 
   histogram_ = new FFTGrid(n1_, n2_, n3_, n1_, n2_, n3_);
   histogram_->createRealGrid(false);
-  int rnxp = histogram_->getRNxp();
   histogram_->setType(FFTGrid::PARAMETER);
-  histogram_->setAccessMode(FFTGrid::WRITE);
-
-  for(int l=0;l<n3_;l++){
-    for(int k=0;k<n2_;k++){
-      for(int j=0;j<rnxp;j++)
-        histogram_->setNextReal(0.0f);
-    }
-  }
-  histogram_->endAccess();
 
   // Spacing variables in the density grid
   dx_ = (x_max_ - x_min_)/n1_;
@@ -206,22 +195,32 @@ PosteriorElasticPDF3D::PosteriorElasticPDF3D(const std::vector<double>
   dz_ = (z_max_ - z_min_)/n3_;
 
   // Go through data points and place in bins in histogram
+  int n_cells = n1_*n2_*n3_;
+  std::vector<int> cell(dim);
 
+#ifdef PARALLEL
+  int n_threads = FFTGrid::getNumberOfThreads();
+#pragma omp parallel for schedule(static) num_threads(n_threads)
+#endif
   for (int i = 0; i < dim; i++){
-    //volume->getIndexes(d1[i], d2[i], d3[i], i_tmp, j_tmp, k_tmp);
     int i_tmp = static_cast<int>(floor((x[0][i]-x_min_)/dx_));
     int j_tmp = static_cast<int>(floor((x[1][i]-y_min_)/dy_));
     int k_tmp = t1[i];
-    // Counting data points in index (i,j,k)
-    histogram_->setAccessMode(FFTGrid::RANDOMACCESS);
-    histogram_->setRealValue(i_tmp, j_tmp, k_tmp, histogram_->getRealValue(i_tmp,j_tmp,k_tmp) + 1.0f);
-    histogram_->endAccess();
+    if (i_tmp >= 0 && i_tmp < n1_ && j_tmp >= 0 && j_tmp < n2_ && k_tmp >= 0 && k_tmp < n3_)
+      cell[i] = i_tmp + n1_*(j_tmp + n2_*k_tmp);
+    else
+      cell[i] = -1;
   }
 
+  std::vector<int> counts;
+  CountPoints(cell, n_cells, counts);
+
   //multiply by normalizing constant for the PDF - dim is the total number of entries
-  histogram_->setAccessMode(FFTGrid::READANDWRITE);
-  histogram_->multiplyByScalar(float(1.0f/dim));
-  histogram_->endAccess();
+  float scale = float(1.0f/dim);
+  std::vector<float> density(n_cells);
+  for (int i = 0; i < n_cells; i++)
+    density[i] = static_cast<float>(counts[i])*scale;
+  FillInDensity(histogram_, density);
 
   if(ModelSettings::getDebugLevel() >= 1){
     std::string baseName = "Hist_" + NRLib::ToString(ind) + IO::SuffixAsciiFiles();
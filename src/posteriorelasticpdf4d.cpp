@@ -56,7 +56,6 @@ t2_max_(t2_max)
 
   // set size of 2D grid to ni*nj
   histogram_.Resize(nt1_,nt2_,NULL);
-  int nData = 0;
 
   int dim = static_cast<int>(d1.size());
 
@@ -94,68 +93,105 @@ t2_max_(t2_max)
   dt2_ = (t2_max_ - t2_min_)/nt2_;
 
   // Loop over data points and place in bins in histogram_
-
+  int n_xy    = nx_*ny_;
+  int n_cells = n_xy*nt1_*nt2_;
+  std::vector<int> cell(dim);
+
+#ifdef PARALLEL
+  int n_threads = FFTGrid::getNumberOfThreads();
+#pragma omp parallel for schedule(static) num_threads(n_threads)
+#endif
   for (int l = 0; l < dim; l++){
     int i = t1[l];
     int j = t2[l];
     int m = static_cast<int>(floor((x[0][l]-x_min_)/dx_));
     int n = static_cast<int>(floor((x[1][l]-y_min_)/dy_));
+    if (i >= 0 && i < nt1_ && j >= 0 && j < nt2_ && m >= 0 && m < nx_ && n >= 0 && n < ny_)
+      cell[l] = m + nx_*n + n_xy*(i + nt1_*j);
+    else
+      cell[l] = -1;
+  }
+
+  std::vector<int> counts;
+  CountPoints(cell, n_cells, counts);
 
-    // Counting data points in index (i,j,k)
-    histogram_(i,j)->setAccessMode(FFTGrid::RANDOMACCESS);
-    histogram_(i,j)->setRealValue(m,n,0, histogram_(i,j)->getRealValue(m,n,0) + 1);
-    histogram_(i,j)->endAccess();
-    nData++;
+  NRLib::Matrix sigma_tmp(2,2);
+
+  for(int m=0;m<2;m++){
+    for(int n=0; n<2; n++)
+      sigma_tmp(m,n) = sigma[m][n];
   }
 
-  //multiply by normalizing constant for the PDF - dim is the total number of entries
-  for(int i=0; i<nt1_; i++){
-    for (int j=0; j<nt2_; j++){
-      histogram_(i,j)->setAccessMode(FFTGrid::READANDWRITE);
-      histogram_(i,j)->multiplyByScalar(float(1.0f/nData));
-      histogram_(i,j)->endAccess();
-      if(ModelSettings::getDebugLevel() >= 1){
-        std::string baseName = "Hist_" + NRLib::ToString(ind) + IO::SuffixAsciiFiles();
-        std::string fileName = IO::makeFullFileName(IO::PathToDebug(), baseName);
-        //histogram_(i,j)->writeAsciiFile(fileName);
-      }
-      histogram_(i,j)->fftInPlace();
+  // Matrix inversion of the covariance matrix sigma
+  NRLib::Matrix sigma_inv;
 
-      NRLib::Matrix sigma_tmp(2,2);
+  InvertSquareMatrix(sigma_tmp,sigma_inv,2);
 
-      for(int m=0;m<2;m++){
-        for(int n=0; n<2; n++)
-          sigma_tmp(m,n) = sigma[m][n];
-      }
+  // The smoother is the same for all trend cells, so it is set up once.
+  int    n[2] = {nx_, ny_};
+  double d[2] = {dx_, dy_};
+  std::vector<std::vector<float> > kernels;
+  bool separable = MakeSeparableKernels(sigma_inv, n, d, kernels);
 
-      // Matrix inversion of the covariance matrix sigma
-      NRLib::Matrix sigma_inv;
+  FFTGrid * smoother = NULL;
+  if (!separable) {
+    smoother = new FFTGrid(nx_, ny_, 1, nx_, ny_, 1);
 
-      InvertSquareMatrix(sigma_tmp,sigma_inv,2);
+    smoother->createRealGrid(false);
+    smoother->setType(FFTGrid::PARAMETER);
+    smoother->setAccessMode(FFTGrid::WRITE);
+    for(int k=0;k<ny_;k++){
+      for(int l=0;l<static_cast<int>(smoother->getRNxp());l++)
+        smoother->setNextReal(0.0f);
+    }
+    smoother->endAccess();
 
-      FFTGrid * smoother = new FFTGrid(nx_, ny_, 1, nx_, ny_, 1);
+    SetupSmoothingGaussian2D(smoother, sigma_inv, nx_, ny_, 1, dx_, dy_);
+    smoother->fftInPlace();
+  }
 
-      smoother->createRealGrid(false);
-      smoother->setType(FFTGrid::PARAMETER);
-      smoother->setAccessMode(FFTGrid::WRITE);
-      for(int k=0;k<ny_;k++){
-        for(int l=0;l<static_cast<int>(smoother->getRNxp());l++)
-          smoother->setNextReal(0.0f);
-      }
-      smoother->endAccess();
+  //
+  // The trend cells are independent. With the separable smoother they are
+  // smoothed in parallel; the FFT smoothing is threaded within each grid.
+  // A single cell gets the threads in the line loops of the smoother.
+  //
+  int n_trend = nt1_*nt2_;
+#ifdef PARALLEL
+#pragma omp parallel for schedule(dynamic, 1) num_threads(n_threads) if(separable && n_trend > 1)
+#endif
+  for(int c=0; c<n_trend; c++){
+    int i = c % nt1_;
+    int j = c / nt1_;
+
+    //multiply by normalizing constant for the PDF - dim is the total number of entries
+    float scale = float(1.0f/dim);
+    std::vector<float> density(n_xy);
+    for(int k=0; k<n_xy; k++)
+      density[k] = static_cast<float>(counts[c*n_xy + k])*scale;
+
+    if(ModelSettings::getDebugLevel() >= 1){
+      std::string baseName = "Hist_" + NRLib::ToString(ind) + IO::SuffixAsciiFiles();
+      std::string fileName = IO::makeFullFileName(IO::PathToDebug(), baseName);
+      //histogram_(i,j)->writeAsciiFile(fileName);
+    }
 
-      SetupSmoothingGaussian2D(smoother, sigma_inv, nx_, ny_, 1, dx_, dy_);
+    if (separable) {
+      SmoothSeparable(density, nx_, ny_, 1, kernels);
+      FillInDensity(histogram_(i,j), density);
+    }
+    else {
+      FillInDensity(histogram_(i,j), density);
+      histogram_(i,j)->fftInPlace();
 
       // Carry out multiplication of the smoother with the density grid (histogram) in the Fourier domain
-      smoother->fftInPlace();
       histogram_(i,j)->multiply(smoother);
       histogram_(i,j)->invFFTInPlace();
       histogram_(i,j)->multiplyByScalar(sqrt(float(nx_*ny_*1)));
       histogram_(i,j)->endAccess();
-
-      delete smoother;
     }
   }
+
+  delete smoother;
 }
 
 PosteriorElasticPDF4D::PosteriorElasticPDF4D(int nx,
@@ -0,0 +1,427 @@
+/***************************************************************************
+*      Copyright (C) 2008 by Norwegian Computing Center and Statoil        *
+***************************************************************************/
+
+#include <algorithm>
+#include <fstream>
+
+#include "nrlib/exception/exception.hpp"
+#include "nrlib/iotools/fileio.hpp"
+#include "nrlib/iotools/logkit.hpp"
+#include "nrlib/stormgrid/chunkedgrid.hpp"
+
+#include "src/preprocessingcache.h"
+#include "src/blockedlogscommon.h"
+#include "src/definitions.h"
+#include "src/fftgrid.h"
+#include "src/io.h"
+#include "src/modelsettings.h"
+#include "src/seismicstorage.h"
+#include "src/simbox.h"
+#include "src/vario.h"
+
+std::map<std::string, std::string> PreprocessingCache::file_hashes_;
+
+namespace {
+  // Rows in a band of a cached grid. One row of chunks.
+  const int band_rows = 64;
+}
+
+PreprocessingCache::PreprocessingCache(const ModelSettings * model_settings)
+  : directory_(FindDirectory(model_settings)),
+    n_threads_(model_settings->getNumberOfThreads())
+{
+  // Debug output is only made when the items are computed.
+  enabled_ = (directory_ != "" && model_settings->getDebugFlag() == 0);
+}
+
+std::string
+PreprocessingCache::FindDirectory(const ModelSettings * model_settings)
+{
+  if (model_settings->getCacheDirectory() != "")
+    return model_settings->getCacheDirectory();
+
+  // Checkpoints only hold the inversion. With a cache next to them, a
+  // restart does not make the background and wavelets again either.
+  if (model_settings->getWriteCheckpoints() || model_settings->getRestartFromCheckpoints())
+    return IO::makeFullFileName(IO::PathToCheckpoints(), "cache/");
+
+  return "";
+}
+
+void
+PreprocessingCache::StartKey(const std::string & item)
+{
+  item_ = item;
+  key_.Reset();
+  AddStringToKey(item);
+}
+
+void
+PreprocessingCache::AddToKey(const void * data,
+                             size_t       n_bytes)
+{
+  key_.Add(data, n_bytes);
+}
+
+void
+PreprocessingCache::AddStringToKey(const std::string & value)
+{
+  AddToKey(value.size());
+  AddToKey(value.c_str(), value.size());
+}
+
+void
+PreprocessingCache::AddGridToKey(const NRLib::Grid<float> * grid)
+{
+  AddToKey(grid->GetNI());
+  AddToKey(grid->GetNJ());
+  AddToKey(grid->GetNK());
+  if (grid->GetN() > 0)
+    AddToKey(&(*grid->begin()), grid->GetN()*sizeof(float));
+}
+
+void
+PreprocessingCache::AddSimboxToKey(const Simbox * simbox)
+{
+  // A missing simbox, like a background simbox that is not used, is also a key.
+  AddToKey(simbox != NULL);
+  if (simbox == NULL)
+    return;
+
+  int nx = simbox->getnx();
+  int ny = simbox->getny();
+  AddToKey(nx);
+  AddToKey(ny);
+  AddToKey(simbox->getnz());
+  AddToKey(simbox->getx0());
+  AddToKey(simbox->gety0());
+  AddToKey(simbox->getlx());
+  AddToKey(simbox->getly());
+  AddToKey(simbox->getAngle());
+  AddToKey(simbox->getdz());
+
+  std::vector<double> top(nx);
+  std::vector<double> bot(nx);
+  for (int j = 0 ; j < ny ; j++) {
+    for (int i = 0 ; i < nx ; i++) {
+      top[i] = simbox->getTop(i, j);
+      bot[i] = simbox->getBot(i, j);
+    }
+    AddVectorToKey(top);
+    AddVectorToKey(bot);
+  }
+}
+
+void
+PreprocessingCache::AddVarioToKey(const Vario * vario)
+{
+  AddToKey(vario != NULL);
+  if (vario == NULL)
+    return;
+
+  AddStringToKey(vario->getType());
+  AddToKey(vario->getRange());
+  AddToKey(vario->getSubRange());
+  AddToKey(vario->getAngle());
+
+  const GenExpVario * gen_exp = dynamic_cast<const GenExpVario *>(vario);
+  if (gen_exp != NULL)
+    AddToKey(gen_exp->getPower());
+}
+
+void
+PreprocessingCache::AddBlockedLogsToKey(const std::map<std::string, BlockedLogsCommon *> & blocked_logs)
+{
+  AddToKey(blocked_logs.size());
+
+  std::map<std::string, BlockedLogsCommon *>::const_iterator it;
+  for (it = blocked_logs.begin() ; it != blocked_logs.end() ; it++) {
+    const BlockedLogsCommon * blocked_log = it->second;
+    AddStringToKey(it->first);
+    AddStringToKey(blocked_log->GetWellName());
+    AddToKey(blocked_log->GetNumberOfBlocks());
+    AddToKey(blocked_log->GetUseForBackgroundTrend());
+    AddVectorToKey(blocked_log->GetIposVector());
+    AddVectorToKey(blocked_log->GetJposVector());
+    AddVectorToKey(blocked_log->GetKposVector());
+    AddVectorToKey(blocked_log->GetVpBlocked());
+    AddVectorToKey(blocked_log->GetVsBlocked());
+    AddVectorToKey(blocked_log->GetRhoBlocked());
+    AddVectorToKey(blocked_log->GetVpHighCutBackground());
+    AddVectorToKey(blocked_log->GetVsHighCutBackground());
+    AddVectorToKey(blocked_log->GetRhoHighCutBackground());
+  }
+}
+
+void
+PreprocessingCache::AddWaveletLogsToKey(const std::map<std::string, BlockedLogsCommon *> & blocked_logs)
+{
+  AddToKey(blocked_logs.size());
+
+  std::map<std::string, BlockedLogsCommon *>::const_iterator it;
+  for (it = blocked_logs.begin() ; it != blocked_logs.end() ; it++) {
+    const BlockedLogsCommon * blocked_log = it->second;
+    AddStringToKey(it->first);
+    AddStringToKey(blocked_log->GetWellName());
+    AddToKey(blocked_log->GetNumberOfBlocks());
+    AddToKey(blocked_log->GetUseForWaveletEstimation());
+    AddVectorToKey(blocked_log->GetIposVector());
+    AddVectorToKey(blocked_log->GetJposVector());
+    AddVectorToKey(blocked_log->GetKposVector());
+    AddVectorToKey(blocked_log->GetXposBlocked());
+    AddVectorToKey(blocked_log->GetYposBlocked());
+    AddVectorToKey(blocked_log->GetZposBlocked());
+    AddVectorToKey(blocked_log->GetVpBlocked());
+    AddVectorToKey(blocked_log->GetVsBlocked());
+    AddVectorToKey(blocked_log->GetRhoBlocked());
+  }
+}
+
+void
+PreprocessingCache::AddFileToKey(const std::string & file_name)
+{
+  AddToKey(NRLib::FileExists(file_name));
+  if (!NRLib::FileExists(file_name)) {
+    AddStringToKey(file_name);
+    return;
+  }
+
+  // Seismic files are large and used by several items, so each is only read once.
+  std::map<std::string, std::string>::const_iterator it = file_hashes_.find(file_name);
+  if (it == file_hashes_.end()) {
+    Fingerprint content;
+    std::ifstream file;
+    NRLib::OpenRead(file, file_name, std::ios::in | std::ios::binary);
+    std::vector<char> buffer(1 << 20);
+    while (file) {
+      file.read(&buffer[0], buffer.size());
+      content.Add(&buffer[0], static_cast<size_t>(file.gcount()));
+    }
+    file.close();
+    it = file_hashes_.insert(std::make_pair(file_name, content.GetHexString())).first;
+  }
+  AddStringToKey(it->second);
+}
+
+void
+PreprocessingCache::AddSeismicToKey(SeismicStorage * seismic)
+{
+  AddToKey(seismic->GetSeismicType());
+  AddToKey(seismic->GetAngle());
+  AddFileToKey(seismic->GetFileName());
+
+  // The traces read from a SegY file depend on the header format, the offset and the area.
+  if (seismic->GetSeismicType() == SeismicStorage::SEGY) {
+    NRLib::SegY             * segy     = seismic->GetSegY();
+    NRLib::TraceHeaderFormat  format   = segy->GetTraceHeaderFormat();
+    const SegyGeometry      * geometry = segy->GetGeometry();
+    AddToKey(format.GetUtmxLoc());
+    AddToKey(format.GetUtmyLoc());
+    AddToKey(format.GetInlineLoc());
+    AddToKey(format.GetCrosslineLoc());
+    AddToKey(format.GetScalCoLoc());
+    AddToKey(static_cast<int>(format.GetCoordSys()));
+    AddToKey(segy->GetNTraces());
+    AddToKey(segy->GetNz());
+    AddToKey(segy->GetDz());
+    AddToKey(segy->GetTop());
+    AddToKey(geometry->GetNx());
+    AddToKey(geometry->GetNy());
+    AddToKey(geometry->GetX0());
+    AddToKey(geometry->GetY0());
+    AddToKey(geometry->GetDx());
+    AddToKey(geometry->GetDy());
+    AddToKey(geometry->GetAngle());
+  }
+}
+
+std::string
+PreprocessingCache::GetFileName(void) const
+{
+  return directory_ + item_ + "_" + key_.GetHexString() + ".cache";
+}
+
+bool
+PreprocessingCache::Load(std::vector<NRLib::Grid<float> *>   & grids,
+                         std::vector<std::vector<double> > & vectors) const
+{
+  std::string file_name = GetFileName();
+  if (!NRLib::FileExists(file_name))
+    return false;
+
+  try {
+    std::ifstream file;
+    NRLib::OpenRead(file, file_name, std::ios::in | std::ios::binary);
+
+    int n_grids = NRLib::ReadBinaryInt(file);
+    if (n_grids != static_cast<int>(grids.size()))
+      throw NRLib::Exception("Wrong number of grids.");
+    for (size_t g = 0 ; g < grids.size() ; g++) {
+      int ni = NRLib::ReadBinaryInt(file);
+      int nj = NRLib::ReadBinaryInt(file);
+      int nk = NRLib::ReadBinaryInt(file);
+      grids[g]->Resize(ni, nj, nk);
+      if (grids[g]->GetN() > 0)
+        NRLib::ReadBinaryFloatArray(file, grids[g]->begin(), grids[g]->GetN());
+    }
+
+    ReadVectors(file, vectors);
+    file.close();
+  }
+  catch (NRLib::Exception & e) {
+    LogKit::LogFormatted(LogKit::Warning,"\nWARNING: Could not read the cache file %s: %s The item is computed again.\n",
+                         file_name.c_str(), e.what());
+    return false;
+  }
+  return true;
+}
+
+void
+PreprocessingCache::Save(const std::vector<NRLib::Grid<float> *>   & grids,
+                         const std::vector<std::vector<double> > & vectors) const
+{
+  // Runs sharing the cache never read a half-written item.
+  std::string file_name = GetFileName();
+
+  try {
+    TemporaryFile tmp_file(file_name);
+    std::ofstream file;
+    NRLib::OpenWrite(file, tmp_file.GetName(), std::ios::out | std::ios::binary);
+
+    NRLib::WriteBinaryInt(file, static_cast<int>(grids.size()));
+    for (size_t g = 0 ; g < grids.size() ; g++) {
+      NRLib::WriteBinaryInt(file, static_cast<int>(grids[g]->GetNI()));
+      NRLib::WriteBinaryInt(file, static_cast<int>(grids[g]->GetNJ()));
+      NRLib::WriteBinaryInt(file, static_cast<int>(grids[g]->GetNK()));
+      if (grids[g]->GetN() > 0)
+        NRLib::WriteBinaryFloatArray(file, grids[g]->begin(), grids[g]->end());
+    }
+
+    WriteVectors(file, vectors);
+    file.close();
+    if (!file)
+      throw NRLib::IOError("Error writing the file.");
+
+    tmp_file.Commit();
+  }
+  catch (NRLib::Exception & e) {
+    LogKit::LogFormatted(LogKit::Warning,"\nWARNING: Could not write the cache file %s: %s\n", file_name.c_str(), e.what());
+  }
+}
+
+bool
+PreprocessingCache::LoadGrid(std::vector<std::vector<double> > & vectors,
+                             FFTGrid                           * grid) const
+{
+  std::string file_name = GetFileName();
+  if (!NRLib::FileExists(file_name))
+    return false;
+
+  try {
+    std::ifstream file;
+    NRLib::OpenRead(file, file_name, std::ios::in | std::ios::binary);
+
+    ReadVectors(file, vectors);
+
+    int nx  = NRLib::ReadBinaryInt(file);
+    int ny  = NRLib::ReadBinaryInt(file);
+    int nzp = NRLib::ReadBinaryInt(file);
+    if (nx != grid->getNx() || ny != grid->getNy() || nzp != grid->getNzp())
+      throw NRLib::Exception("Wrong grid size.");
+
+    // Row r of the chunk section is row r % ny of layer r / ny.
+    NRLib::ChunkedGridReader reader(file);
+    NRLib::Grid<float>       band;
+    std::vector<float>       row(grid->getNxp());
+    int n_rows = ny*nzp;
+    for (int r0 = 0 ; r0 < n_rows ; r0 += band_rows) {
+      int n = std::min(band_rows, n_rows - r0);
+      reader.ReadSubGrid(0, r0, 0, nx, n, 1, band);
+      for (int r = 0 ; r < n ; r++) {
+        std::copy(band.begin() + r*nx, band.begin() + (r + 1)*nx, row.begin());
+        grid->setRealRow((r0 + r) % ny, (r0 + r) / ny, &row[0]);
+      }
+    }
+    file.close();
+  }
+  catch (NRLib::Exception & e) {
+    LogKit::LogFormatted(LogKit::Warning,"\nWARNING: Could not read the cache file %s: %s The item is computed again.\n",
+                         file_name.c_str(), e.what());
+    return false;
+  }
+  return true;
+}
+
+void
+PreprocessingCache::SaveGrid(const std::vector<std::vector<double> > & vectors,
+                             FFTGrid                                 * grid) const
+{
+  std::string file_name = GetFileName();
+
+  try {
+    TemporaryFile tmp_file(file_name);
+    std::ofstream file;
+    NRLib::OpenWrite(file, tmp_file.GetName(), std::ios::out | std::ios::binary);
+
+    WriteVectors(file, vectors);
+
+    int nx  = grid->getNx();
+    int ny  = grid->getNy();
+    int nzp = grid->getNzp();
+    NRLib::WriteBinaryInt(file, nx);
+    NRLib::WriteBinaryInt(file, ny);
+    NRLib::WriteBinaryInt(file, nzp);
+
+    // Lossless, since the inversion is to give the same result with and without the cache.
+    int                      n_rows = ny*nzp;
+    NRLib::ChunkedGridWriter writer(file, nx, n_rows, 1, RMISSING, 0.0, band_rows, n_threads_);
+    NRLib::Grid<float>       band;
+    std::vector<float>       row(grid->getNxp());
+    for (int r0 = 0 ; r0 < n_rows ; r0 += band_rows) {
+      int n = std::min(band_rows, n_rows - r0);
+      band.Resize(nx, n, 1);
+      for (int r = 0 ; r < n ; r++) {
+        grid->getRealRow(&row[0], (r0 + r) % ny, (r0 + r) / ny);
+        std::copy(row.begin(), row.begin() + nx, band.begin() + r*nx);
+      }
+      writer.WriteBand(band);
+    }
+    writer.Finish();
+    file.close();
+    if (!file)
+      throw NRLib::IOError("Error writing the file.");
+
+    tmp_file.Commit();
+  }
+  catch (NRLib::Exception & e) {
+    LogKit::LogFormatted(LogKit::Warning,"\nWARNING: Could not write the cache file %s: %s\n", file_name.c_str(), e.what());
+  }
+}
+
+void
+PreprocessingCache::ReadVectors(std::istream                      & file,
+                                std::vector<std::vector<double> > & vectors)
+{
+  int n_vectors = NRLib::ReadBinaryInt(file);
+  if (n_vectors != static_cast<int>(vectors.size()))
+    throw NRLib::Exception("Wrong number of vectors.");
+  for (size_t v = 0 ; v < vectors.size() ; v++) {
+    int n = NRLib::ReadBinaryInt(file);
+    vectors[v].resize(n);
+    if (n > 0)
+      NRLib::ReadBinaryDoubleArray(file, vectors[v].begin(), n);
+  }
+}
+
+void
+PreprocessingCache::WriteVectors(std::ostream                            & file,
+                                 const std::vector<std::vector<double> > & vectors)
+{
+  NRLib::WriteBinaryInt(file, static_cast<int>(vectors.size()));
+  for (size_t v = 0 ; v < vectors.size() ; v++) {
+    NRLib::WriteBinaryInt(file, static_cast<int>(vectors[v].size()));
+    if (vectors[v].size() > 0)
+      NRLib::WriteBinaryDoubleArray(file, vectors[v].begin(), vectors[v].end());
+  }
+}
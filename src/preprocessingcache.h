@@ -0,0 +1,131 @@
+/***************************************************************************
+*      Copyright (C) 2008 by Norwegian Computing Center and Statoil        *
+***************************************************************************/
+
+#ifndef PREPROCESSINGCACHE_H
+#define PREPROCESSINGCACHE_H
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "nrlib/grid/grid.hpp"
+
+#include "src/fingerprint.h"
+
+class BlockedLogsCommon;
+class FFTGrid;
+class ModelSettings;
+class SeismicStorage;
+class Simbox;
+class Vario;
+
+//
+// On-disk cache of products of the preprocessing done in CommonData.
+//
+// An item is addressed by its name and a key, which is an FNV-1a hash of
+// everything the item is computed from: the data read from the input
+// files and the model file settings that are used. The item is stored in
+// the cache directory in a file named by the item and the key, so runs
+// that differ only in settings the item does not depend on, like the
+// output options or the prior correlations, share the item. An item is
+// never updated; a changed input gives a new key and a new file.
+//
+// The kriged background model, the estimated 1D wavelets and the seismic
+// data resampled into each interval are cached. Wavelets and seismic
+// are keyed by the content of the seismic files, which is hashed once
+// per run, and the files and log lines made along the way, like the
+// wavelets of each well, are made again from the cached item. Blocked
+// logs are not cached: the wells are read anyway for trends, rock
+// physics and facies, and the blocked logs are changed later by well
+// position optimisation and added logs.
+//
+class PreprocessingCache
+{
+public:
+  PreprocessingCache(const ModelSettings * model_settings);
+
+  // False if no cache directory is given, or if a debug level is given.
+  bool                     IsEnabled(void) const { return enabled_ ;}
+
+  // Starts the key of a new item.
+  void                     StartKey(const std::string & item);
+
+  void                     AddToKey(const void * data,
+                                    size_t       n_bytes);
+
+  template <class T>
+  void                     AddToKey(const T & value) { AddToKey(&value, sizeof(T)) ;}
+
+  template <class T>
+  void                     AddVectorToKey(const std::vector<T> & values);
+
+  void                     AddStringToKey(const std::string & value);
+
+  void                     AddGridToKey(const NRLib::Grid<float> * grid);
+
+  void                     AddSimboxToKey(const Simbox * simbox);
+
+  void                     AddVarioToKey(const Vario * vario);
+
+  void                     AddBlockedLogsToKey(const std::map<std::string, BlockedLogsCommon *> & blocked_logs);
+
+  // The positions and logs of the blocked wells that are used in wavelet estimation.
+  void                     AddWaveletLogsToKey(const std::map<std::string, BlockedLogsCommon *> & blocked_logs);
+
+  // Adds the content of the file, or the text itself if it is not a file,
+  // like a constant given in place of a surface.
+  void                     AddFileToKey(const std::string & file_name);
+
+  // The seismic file content and how it was read.
+  void                     AddSeismicToKey(SeismicStorage * seismic);
+
+  // Reads the item into the given grids and vectors. Returns false if the item is not in the cache.
+  bool                     Load(std::vector<NRLib::Grid<float> *>   & grids,
+                                std::vector<std::vector<double> > & vectors) const;
+
+  // Stores the item. Failing to write the cache is not an error, only a warning.
+  void                     Save(const std::vector<NRLib::Grid<float> *>   & grids,
+                                const std::vector<std::vector<double> > & vectors) const;
+
+  // As Load, for an item that is the nx*ny*nzp part of an allocated grid,
+  // read from a chunked section a band of rows at a time. The lateral
+  // padding is not set.
+  bool                     LoadGrid(std::vector<std::vector<double> > & vectors,
+                                    FFTGrid                           * grid) const;
+
+  // As Save, for the nx*ny*nzp part of a grid, written as a lossless
+  // chunked section a band of rows at a time.
+  void                     SaveGrid(const std::vector<std::vector<double> > & vectors,
+                                    FFTGrid                                 * grid) const;
+
+  std::string              GetFileName(void) const;
+
+private:
+  static std::string       FindDirectory(const ModelSettings * model_settings);
+
+  static void              ReadVectors(std::istream                      & file,
+                                       std::vector<std::vector<double> > & vectors);
+
+  static void              WriteVectors(std::ostream                            & file,
+                                        const std::vector<std::vector<double> > & vectors);
+
+  std::string              directory_;
+  int                      n_threads_;       ///< Threads compressing the grids
+  bool                     enabled_;
+  std::string              item_;
+  Fingerprint              key_;             ///< Hash of the input added so far
+
+  static std::map<std::string, std::string> file_hashes_; ///< Content hash of each file hashed in this run
+};
+
+template <class T>
+void
+PreprocessingCache::AddVectorToKey(const std::vector<T> & values)
+{
+  AddToKey(values.size());
+  if (values.size() > 0)
+    AddToKey(&values[0], values.size()*sizeof(T));
+}
+
+#endif
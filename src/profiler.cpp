@@ -0,0 +1,254 @@
+/***************************************************************************
+*      Copyright (C) 2008 by Norwegian Computing Center and Statoil        *
+***************************************************************************/
+
+#include <fstream>
+#include <iomanip>
+#include <algorithm>
+
+#ifdef PARALLEL
+#include <omp.h>
+#endif
+
+#include "nrlib/exception/exception.hpp"
+#include "nrlib/iotools/fileio.hpp"
+#include "nrlib/iotools/logkit.hpp"
+
+#include "lib/timekit.hpp"
+#include "lib/systemcall.h"
+
+#include "src/profiler.h"
+
+Profiler::Region::Region(const std::string & name)
+  : active_(false),
+    wall_start_(0.0),
+    cpu_start_(0.0)
+{
+  if (InParallel())
+    return;
+  Enter(name);
+  active_     = true;
+  wall_start_ = TimeKit::getWallClock();
+  cpu_start_  = TimeKit::getCpuClock();
+}
+
+Profiler::Region::~Region()
+{
+  if (active_)
+    Leave(TimeKit::getWallClock() - wall_start_, TimeKit::getCpuClock() - cpu_start_);
+}
+
+void
+Profiler::AddCount(const std::string & counter, double value)
+{
+#ifdef PARALLEL
+#pragma omp critical(profiler)
+#endif
+  {
+    Node * node = (current_ != NULL ? current_ : Root());
+    node->counters[counter] += value;
+  }
+}
+
+void
+Profiler::UpdateFFTGridMemory(double bytes)
+{
+#ifdef PARALLEL
+#pragma omp critical(profiler)
+#endif
+  {
+    for (Node * node = (current_ != NULL ? current_ : Root()) ; node != NULL ; node = node->parent)
+      node->peak_fft_mem = std::max(node->peak_fft_mem, bytes);
+  }
+}
+
+void
+Profiler::RecordPhase(const std::string & phase, double wall, double cpu)
+{
+  // Phases are the classic Timings sections. Later calls for the same phase
+  // overwrite earlier ones, except for those Timings sums up itself.
+  for (size_t i = 0 ; i < phases_.size() ; i++) {
+    if (phases_[i].first == phase) {
+      phases_[i].second = std::make_pair(wall, cpu);
+      return;
+    }
+  }
+  phases_.push_back(std::make_pair(phase, std::make_pair(wall, cpu)));
+}
+
+Profiler::Node *
+Profiler::Root()
+{
+  if (root_ == NULL) {
+    root_               = new Node;
+    root_->name         = "CRAVA";
+    root_->parent       = NULL;
+    root_->calls        = 1;
+    root_->max_threads  = MaxThreads();
+    root_->wall         = 0.0;
+    root_->cpu          = 0.0;
+    root_->peak_rss     = 0.0;
+    root_->peak_fft_mem = 0.0;
+    current_            = root_;
+    wall_start_         = TimeKit::getWallClock();
+    cpu_start_          = TimeKit::getCpuClock();
+  }
+  return root_;
+}
+
+Profiler::Node *
+Profiler::Enter(const std::string & name)
+{
+  Node * parent = (current_ != NULL ? current_ : Root());
+  Node * node   = NULL;
+  for (size_t i = 0 ; i < parent->children.size() ; i++) {
+    if (parent->children[i]->name == name) {
+      node = parent->children[i];
+      break;
+    }
+  }
+  if (node == NULL) {
+    node               = new Node;
+    node->name         = name;
+    node->parent       = parent;
+    node->calls        = 0;
+    node->max_threads  = 1;
+    node->wall         = 0.0;
+    node->cpu          = 0.0;
+    node->peak_rss     = 0.0;
+    node->peak_fft_mem = 0.0;
+    parent->children.push_back(node);
+  }
+  node->calls      += 1;
+  node->max_threads = std::max(node->max_threads, MaxThreads());
+  current_          = node;
+  return node;
+}
+
+void
+Profiler::Leave(double wall, double cpu)
+{
+  Node * node   = current_;
+  node->wall   += wall;
+  node->cpu    += cpu;
+  node->peak_rss = std::max(node->peak_rss, SystemCall::getPeakMemoryUsage());
+  current_      = node->parent;
+}
+
+bool
+Profiler::InParallel()
+{
+#ifdef PARALLEL
+  return(omp_in_parallel() != 0);
+#else
+  return(false);
+#endif
+}
+
+int
+Profiler::MaxThreads()
+{
+#ifdef PARALLEL
+  return(omp_get_max_threads());
+#else
+  return(1);
+#endif
+}
+
+void
+Profiler::WriteJson(const std::string & file_name)
+{
+  Node * root   = Root();
+  root->wall     = TimeKit::getWallClock() - wall_start_;
+  root->cpu      = TimeKit::getCpuClock()  - cpu_start_;
+  root->peak_rss = SystemCall::getPeakMemoryUsage();
+
+  std::ofstream file;
+  try {
+    NRLib::OpenWrite(file, file_name);
+  }
+  catch (NRLib::Exception & e) {
+    NRLib::LogKit::LogFormatted(NRLib::LogKit::Warning, "\nWARNING: Could not write profile to file %s: %s\n", file_name.c_str(), e.what());
+    return;
+  }
+
+  file << std::setprecision(6) << std::fixed;
+  file << "{\n";
+  file << "  \"host\": \""   << SystemCall::getHostName() << "\",\n";
+  file << "  \"phases\": {";
+  for (size_t i = 0 ; i < phases_.size() ; i++) {
+    file << (i > 0 ? ",\n" : "\n")
+         << "    \"" << phases_[i].first << "\": {\"wall\": " << phases_[i].second.first
+         << ", \"cpu\": " << phases_[i].second.second << "}";
+  }
+  file << (phases_.size() > 0 ? "\n  },\n" : "},\n");
+  file << "  \"regions\":\n";
+  WriteNode(file, root, 2);
+  file << "\n}\n";
+  file.close();
+}
+
+void
+Profiler::WriteNode(std::ostream & file, const Node * node, int indent)
+{
+  std::string pad(indent, ' ');
+  std::string name;
+  for (size_t i = 0 ; i < node->name.size() ; i++) {
+    char c = node->name[i];
+    if (c == '"' || c == '\\')
+      name += '\\';
+    name += c;
+  }
+
+  file << pad << "{\n";
+  file << pad << "  \"name\": \""         << name               << "\",\n";
+  file << pad << "  \"calls\": "          << node->calls        << ",\n";
+  file << pad << "  \"threads\": "        << node->max_threads  << ",\n";
+  file << pad << "  \"wall\": "           << node->wall         << ",\n";
+  file << pad << "  \"cpu\": "            << node->cpu          << ",\n";
+  file << pad << "  \"peak_rss\": "       << node->peak_rss     << ",\n";
+  file << pad << "  \"peak_fft_mem\": "   << node->peak_fft_mem << ",\n";
+  file << pad << "  \"counters\": {";
+  std::map<std::string, double>::const_iterator it;
+  for (it = node->counters.begin() ; it != node->counters.end() ; ++it)
+    file << (it != node->counters.begin() ? ", " : "") << "\"" << it->first << "\": " << it->second;
+  file << "},\n";
+  file << pad << "  \"children\": [";
+  for (size_t i = 0 ; i < node->children.size() ; i++) {
+    file << (i > 0 ? ",\n" : "\n");
+    WriteNode(file, node->children[i], indent + 4);
+  }
+  file << (node->children.size() > 0 ? "\n" + pad + "  ]\n" : "]\n");
+  file << pad << "}";
+}
+
+void
+Profiler::Start()
+{
+  Clear();
+  Root();
+}
+
+void
+Profiler::Clear()
+{
+  if (root_ != NULL)
+    DeleteNode(root_);
+  root_    = NULL;
+  current_ = NULL;
+  phases_.clear();
+}
+
+void
+Profiler::DeleteNode(Node * node)
+{
+  for (size_t i = 0 ; i < node->children.size() ; i++)
+    DeleteNode(node->children[i]);
+  delete node;
+}
+
+Profiler::Node * Profiler::root_       = NULL;
+Profiler::Node * Profiler::current_    = NULL;
+double           Profiler::wall_start_ = 0.0;
+double           Profiler::cpu_start_  = 0.0;
+std::vector<std::pair<std::string, std::pair<double, double> > > Profiler::phases_;
@@ -0,0 +1,88 @@
+/***************************************************************************
+*      Copyright (C) 2008 by Norwegian Computing Center and Statoil        *
+***************************************************************************/
+
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <map>
+#include <string>
+#include <vector>
+
+//
+// Hierarchical profiling of a CRAVA run.
+//
+// Regions are opened and closed with the scoped Profiler::Region class and
+// form a tree (e.g. Interval -> Vintage -> Inversion). Entering a region with
+// the same name as an existing sibling accumulates into it. For each region
+// we keep wall and CPU time, number of calls, maximum number of threads,
+// peak resident memory, peak FFTGrid memory and a set of named counters
+// (bytes read/written, number of FFTs, ...).
+//
+// Regions must be opened from serial code. Regions opened inside an OpenMP
+// parallel section are ignored, whereas counters may be added from any thread.
+//
+// The tree is written as JSON next to the log file, so that performance can
+// be compared between versions and jobs can be sized.
+//
+class Profiler
+{
+public:
+  class Region
+  {
+  public:
+    Region(const std::string & name);
+    ~Region();
+
+  private:
+    Region(const Region &);
+    Region & operator=(const Region &);
+
+    bool         active_;
+    double       wall_start_;
+    double       cpu_start_;
+  };
+
+  static void    AddCount(const std::string & counter, double value);   // Thread safe
+  static void    AddBytesRead(double bytes)    { AddCount("bytes_read", bytes)    ;}
+  static void    AddBytesWritten(double bytes) { AddCount("bytes_written", bytes) ;}
+  static void    AddFFT(const std::string & type) { AddCount("fft_" + type, 1.0)    ;}
+
+  static void    UpdateFFTGridMemory(double bytes);                    // Called by FFTGrid when memory use changes
+  static void    RecordPhase(const std::string & phase, double wall, double cpu);
+
+  static void    Start();                                               // Resets the tree and starts the total clock
+  static void    WriteJson(const std::string & file_name);
+  static void    Clear();
+
+private:
+  struct Node
+  {
+    std::string                    name;
+    Node                         * parent;
+    std::vector<Node *>            children;
+    int                            calls;
+    int                            max_threads;
+    double                         wall;
+    double                         cpu;
+    double                         peak_rss;
+    double                         peak_fft_mem;
+    std::map<std::string, double>  counters;
+  };
+
+  static Node  * Root();
+  static Node  * Enter(const std::string & name);
+  static void    Leave(double wall, double cpu);
+  static void    DeleteNode(Node * node);
+  static void    WriteNode(std::ostream & file, const Node * node, int indent);
+  static bool    InParallel();
+  static int     MaxThreads();
+
+  static Node                                            * root_;
+  static Node                                            * current_;
+  static double                                            wall_start_;
+  static double                                            cpu_start_;
+  static std::vector<std::pair<std::string, std::pair<double, double> > > phases_;
+};
+
+#endif
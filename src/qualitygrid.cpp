@@ -9,6 +9,7 @@
 #include "src/modelsettings.h"
 #include "src/qualitygrid.h"
 #include "src/kriging2d.h"
+#include "src/krigingcache2d.h"
 #include "src/covgrid2d.h"
 #include "src/fftgrid.h"
 #include "src/simbox.h"
@@ -163,6 +164,9 @@ void QualityGrid::makeKrigedProbField(std::vector<KrigingData2D> & krigingData,
     << "\n | | | | | | | | | | | "
     << "\n ^";
 
+  KrigingCache2D cache(krigingData, cov);
+  LogKit::LogFormatted(LogKit::DebugLow,"\n  Kriging matrices factorized: %d of %d layers.", cache.GetNumberOfFactorizations(), nz);
+
   grid = ModelGeneral::CreateFFTGrid(nx, ny, nz, nxp, nyp, nzp, isFile);
   grid->createRealGrid();
   grid->setType(FFTGrid::PARAMETER);
@@ -174,7 +178,7 @@ void QualityGrid::makeKrigedProbField(std::vector<KrigingData2D> & krigingData,
     surface.Assign(value_);
 
     // Kriging of layer
-    Kriging2D::krigSurface(surface, krigingData[k], cov);
+    Kriging2D::krigSurface(surface, krigingData[k], cov, false, &cache, k);
 
     // Set layer in probability field from surface
     for (int j=0; j<nyp; j++){
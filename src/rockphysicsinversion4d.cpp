@@ -3,6 +3,7 @@
 #include "src/fftgrid.h"
 #include "lib/lib_matr.h"
 #include <vector>
+#include <algorithm>
 
 RockPhysicsInversion4D::RockPhysicsInversion4D()
 {
@@ -27,17 +28,22 @@ RockPhysicsInversion4D::~RockPhysicsInversion4D()
 RockPhysicsInversion4D::RockPhysicsInversion4D(NRLib::Vector                      priorMean,
                                                NRLib::Matrix                      priorCov,
                                                NRLib::Matrix                      posteriorCov,
-                                               std::vector<std::vector<double> >  mSamp)
+                                               std::vector<std::vector<double> >  mSamp,
+                                               int                                nThreads)
+  : nThreads_(nThreads)
 {
   nf_.resize(4);
   nf_[0] = 60;
   nf_[1] = 60;
   nf_[2] = 60;
   nf_[3] = 60;
-  nfp_= 135;
 
-  fftplan1_ = rfftwnd_create_plan(1, &nfp_, FFTW_REAL_TO_COMPLEX, FFTW_ESTIMATE | FFTW_IN_PLACE);
-  fftplan2_ = rfftwnd_create_plan(1, &nfp_, FFTW_COMPLEX_TO_REAL, FFTW_ESTIMATE | FFTW_IN_PLACE);
+  // Padding keeps the circular smoothing from wrapping around (135 for 60 bins)
+  int nfMax = *std::max_element(nf_.begin(), nf_.end());
+  nfp_= FFTGrid::findClosestFactorableNumber((9*nfMax + 3)/4);
+
+  fftplan1_ = rfftwnd_create_plan(1, &nfp_, FFTW_REAL_TO_COMPLEX, FFTW_ESTIMATE | FFTW_IN_PLACE | FFTW_THREADSAFE);
+  fftplan2_ = rfftwnd_create_plan(1, &nfp_, FFTW_COMPLEX_TO_REAL, FFTW_ESTIMATE | FFTW_IN_PLACE | FFTW_THREADSAFE);
 
   v_.resize(4,6);
   SolveGEVProblem(priorCov,posteriorCov, v_);
@@ -157,30 +163,61 @@ RockPhysicsInversion4D::makePredictions(std::vector<FFTGrid *> mu_static_,
 
   for(int i=0;i<3;i++)
   {
-    mu_static_[i]->setAccessMode(FFTGrid::READ);
-    mu_dynamic_[i]->setAccessMode(FFTGrid::READ);
+    mu_static_[i]->setAccessMode(FFTGrid::RANDOMACCESS);
+    mu_dynamic_[i]->setAccessMode(FFTGrid::RANDOMACCESS);
   }
 
-  prediction->setAccessMode(FFTGrid::WRITE);
+  prediction->setAccessMode(FFTGrid::RANDOMACCESS);
 
-  NRLib::Vector m(6);
+  //
+  // Predict one x-row at a time: gather the six parameters of the row into
+  // contiguous buffers, project them onto the four table variables and
+  // interpolate. The buffers are allocated once per thread.
+  //
+  double v[6][4];
+  for(int l=0;l<6;l++)
+    for(int c=0;c<4;c++)
+      v[l][c]=v_(l,c);
 
-  for(int k=0;k<nzp;k++)
-    for(int j=0;j<nyp;j++)
-      for(int i=0;i<rnxp;i++)
-      {
-        m(0)=mu_static_[0]->getNextReal();
-        m(1)=mu_static_[1]->getNextReal();
-        m(2)=mu_static_[2]->getNextReal();
-        m(3)=mu_dynamic_[0]->getNextReal();
-        m(4)=mu_dynamic_[1]->getNextReal();
-        m(5)=mu_dynamic_[2]->getNextReal();
-        float value;
-        NRLib::Vector f;
-        f=m*v_;
-        value = float( getPredictedValue(f) );
-        prediction->setNextReal(value);
-      }
+  int nRows    = nyp*nzp;
+
+#ifdef PARALLEL
+#pragma omp parallel num_threads(nThreads_)
+#endif
+  {
+    std::vector<double> m(6*nxp);
+    std::vector<double> f(4*nxp);
+
+#ifdef PARALLEL
+#pragma omp for schedule(static)
+#endif
+    for(int row=0;row<nRows;row++)
+    {
+      int j = row % nyp;
+      int k = row / nyp;
+
+      for(int l=0;l<3;l++)
+        for(int i=0;i<nxp;i++)
+        {
+          m[l*nxp+i]     = mu_static_[l]->getRealValue(i,j,k,true);
+          m[(l+3)*nxp+i] = mu_dynamic_[l]->getRealValue(i,j,k,true);
+        }
+
+      for(int i=0;i<nxp;i++)
+        for(int c=0;c<4;c++)
+        {
+          double sum=0.0;
+          for(int l=0;l<6;l++)
+            sum+=m[l*nxp+i]*v[l][c];
+          f[4*i+c]=sum;
+        }
+
+      for(int i=0;i<nxp;i++)
+        prediction->setRealValue(i,j,k,float(interpolateTable(&f[4*i])),true);
+      for(int i=nxp;i<rnxp;i++)
+        prediction->setRealValue(i,j,k,0.0f,true); // Dummy in padding
+    }
+  }
 
   for(int i=0;i<3;i++)
   {
@@ -195,7 +232,7 @@ RockPhysicsInversion4D::makePredictions(std::vector<FFTGrid *> mu_static_,
 
 
 void
-RockPhysicsInversion4D::GetLowerIndexAndW(double minValue,double maxValue,int nValue,double valueIn,int& index, double& w)
+RockPhysicsInversion4D::GetLowerIndexAndW(double minValue,double maxValue,int nValue,double valueIn,int& index, double& w) const
 {
   double dx    = (maxValue-minValue)/float(nValue);
   double value=valueIn+dx/2; // value of cell center NBNB OK check
@@ -236,46 +273,42 @@ RockPhysicsInversion4D::GetLowerIndex(double minValue,double maxValue,int nValue
 double
 RockPhysicsInversion4D::getPredictedValue(NRLib::Vector f)
 {
-  //interploates in a 4D table
-  double value;
-  std::vector<std::vector<int> > indLoHi(2,std::vector<int>(4));
-  std::vector<std::vector<double> > wLoHi(2,std::vector<double>(4));
-  double w;
-  int index;
-  GetLowerIndexAndW(minf_(0),maxf_(0),nf_[0],f(0),index, w);
-  wLoHi[0][0]=1-w;
-  wLoHi[1][0]=w;
-  indLoHi[0][0]=index;
-  indLoHi[1][0]=std::min(nf_[0]-1,index+1);
-
-  GetLowerIndexAndW(minf_(1),maxf_(1),nf_[1],f(1),index, w);
-  wLoHi[0][1]=1-w;
-  wLoHi[1][1]=w;
-  indLoHi[0][1]=index;
-  indLoHi[1][1]=std::min(nf_[1]-1,index+1);
-
-  GetLowerIndexAndW(minf_(2),maxf_(2),nf_[2],f(2),index, w);
-  wLoHi[0][2]=1-w;
-  wLoHi[1][2]=w;
-  indLoHi[0][2]=index;
-  indLoHi[1][2]=std::min(nf_[2]-1,index+1);
-
-  GetLowerIndexAndW(minf_(3),maxf_(3),nf_[3],f(3),index, w);
-  wLoHi[0][3]=1-w;
-  wLoHi[1][3]=w;
-  indLoHi[0][3]=index;
-  indLoHi[1][3]=std::min(nf_[3]-1,index+1);
-
-  value=0.0;
+  double g[4];
+  for(int c=0;c<4;c++)
+    g[c]=f(c);
+  return interpolateTable(g);
+}
+
+double
+RockPhysicsInversion4D::interpolateTable(const double * f) const
+{
+  //interploates in a 4D table. No allocations, as this is called for every cell.
+  int    indLoHi[2][4];
+  double wLoHi[2][4];
+  for(int c=0;c<4;c++)
+  {
+    double w;
+    int index;
+    GetLowerIndexAndW(minf_(c),maxf_(c),nf_[c],f[c],index, w);
+    wLoHi[0][c]=1-w;
+    wLoHi[1][c]=w;
+    indLoHi[0][c]=index;
+    indLoHi[1][c]=std::min(nf_[c]-1,index+1);
+  }
+
+  double value=0.0;
   for(int i0=0;i0<2;i0++)
+  {
+    const FFTGrid * table = meanRockPrediction_(1,indLoHi[i0][0]);
     for(int i1=0;i1<2;i1++)
       for(int i2=0;i2<2;i2++)
         for(int i3=0;i3<2;i3++)
         {
-          w=wLoHi[i0][0]*wLoHi[i1][1]*wLoHi[i2][2]*wLoHi[i3][3];
-          value+=w*GetGridValue(1,indLoHi[i0][0],indLoHi[i1][1],indLoHi[i2][2],indLoHi[i3][3]);
+          double w=wLoHi[i0][0]*wLoHi[i1][1]*wLoHi[i2][2]*wLoHi[i3][3];
+          value+=w*table->getRealValue(indLoHi[i1][1],indLoHi[i2][2],indLoHi[i3][3]);
         }
-return value;
+  }
+  return value;
 }
 
 double
@@ -445,6 +478,9 @@ RockPhysicsInversion4D::smoothAllDirectionsAndNormalize()
       meanRockPrediction_(i,j)->setAccessMode(FFTGrid::RANDOMACCESS);
    }
 
+#ifdef PARALLEL
+#pragma omp parallel for schedule(static) num_threads(nThreads_)
+#endif
   for(int i0=0;i0<nf_[0];i0++)
      for(int i1=0;i1<nf_[1];i1++)
         for(int i2=0;i2<nf_[2];i2++)
@@ -470,186 +506,142 @@ RockPhysicsInversion4D::smoothAllDirectionsAndNormalize()
 }
 
 void
-RockPhysicsInversion4D::DivideAndSmoothTable(int tableInd,std::vector<std::vector<double> > priorDistribution, std::vector<fftw_complex*> smoothingFilter)
+RockPhysicsInversion4D::DivideAndSmoothTable(int                                       tableInd,
+                                             const std::vector<std::vector<double> > & priorDistribution,
+                                             const std::vector<fftw_complex*>        & smoothingFilter)
 {
   for (int j=0; j<nf_[0]; j++){
       meanRockPrediction_(tableInd,j)->setAccessMode(FFTGrid::RANDOMACCESS);
    }
 
-  int cnfp=nfp_/2+1;
-  int rnfp=2*cnfp;
-
-  fftw_real*    rTemp = static_cast<fftw_real*>(fftw_malloc(sizeof(float)*rnfp));
-  fftw_complex* cTemp = reinterpret_cast<fftw_complex*>(rTemp);
+  for(int dir=0;dir<4;dir++)
+  {
+    LogKit::LogFormatted(LogKit::Low,"\n\n Smoothing direction %d of 4\n",dir+1);
+    DivideAndSmoothDirection(tableInd,dir,priorDistribution[dir],smoothingFilter[dir]);
+  }
 
-  double minDivisor = 1e-3;
+  for (int j=0; j<nf_[0]; j++){
+      meanRockPrediction_(tableInd,j)->endAccess();
+  }
+}
 
-  LogKit::LogFormatted(LogKit::Low,"\n Smoothing direction 1 of 4\n");
-  float monitorSize = std::max(1.0f, static_cast<float>(nf_[0]*nf_[1]*nf_[2]*nf_[3])*0.02f);
+void
+RockPhysicsInversion4D::DivideAndSmoothDirection(int                         tableInd,
+                                                 int                         dir,
+                                                 const std::vector<double> & priorDistribution,
+                                                 const fftw_complex        * smoothingFilter)
+{
+  //
+  // Divides all table lines along direction dir by the prior and convolves
+  // them with the smoothing filter. The lines are independent, so they are
+  // transformed in batches with one FFTW call per batch, and the batches
+  // are shared between threads. FFTW plans are thread safe.
+  //
+  const int    batchSize  = 32;
+  const double minDivisor = 1e-3;
+
+  int cnfp = nfp_/2+1;
+  int rnfp = 2*cnfp;
+  int nf   = nf_[dir];
+
+  // The three other directions span the lines, with the last one fastest.
+  int other[3];
+  int nOther = 0;
+  for(int d=0;d<4;d++)
+    if(d!=dir)
+      other[nOther++]=d;
+
+  int nLines   = nf_[other[0]]*nf_[other[1]]*nf_[other[2]];
+  int nBatches = (nLines + batchSize - 1)/batchSize;
+
+  std::vector<double> divisor(nf);
+  for(int t=0;t<nf;t++)
+    divisor[t]=std::max(minDivisor,priorDistribution[t]);
+
+  float monitorSize = std::max(1.0f, static_cast<float>(nBatches)*0.02f);
   float nextMonitor = monitorSize;
+  int   nDone       = 0;
   std::cout
     << "\n  0%       20%       40%       60%       80%      100%"
     << "\n  |    |    |    |    |    |    |    |    |    |    |  "
     << "\n  ^";
 
-  // divide and smooth direction1
-  for(int i1=0;i1<nf_[1];i1++)
-    for(int i2=0;i2<nf_[2];i2++)
-      for(int i3=0;i3<nf_[3];i3++)
-      {
-        for(int i0=0;i0<nf_[0];i0++)
-        {
-          double divisor=std::max(minDivisor,priorDistribution_[0][i0]);
-          rTemp[i0]=float(GetGridValue(tableInd,i0,i1,i2,i3)/ divisor);
-        }
-        for(int i0=nf_[0];i0<nfp_;i0++)
-          rTemp[i0]=0.0f;
-
-        rfftwnd_one_real_to_complex(fftplan1_,rTemp,cTemp);
+#ifdef PARALLEL
+#pragma omp parallel num_threads(nThreads_)
+#endif
+  {
+    fftw_real    * rTemp = static_cast<fftw_real*>(fftw_malloc(sizeof(fftw_real)*rnfp*batchSize));
+    fftw_complex * cTemp = reinterpret_cast<fftw_complex*>(rTemp);
+    int            index[4];
+
+#ifdef PARALLEL
+#pragma omp for schedule(dynamic, 1)
+#endif
+    for(int batch=0;batch<nBatches;batch++)
+    {
+      int first = batch*batchSize;
+      int n     = std::min(batchSize, nLines-first);
 
-        for(int i0=0;i0<cnfp;i0++)
-        {
-          cTemp[i0].re=cTemp[i0].re*smoothingFilter[0][i0].re;
-          cTemp[i0].im=cTemp[i0].im*smoothingFilter[0][i0].re;
-        }
+      for(int b=0;b<n;b++)
+      {
+        int line = first+b;
+        index[other[2]] = line % nf_[other[2]];
+        index[other[1]] = (line / nf_[other[2]]) % nf_[other[1]];
+        index[other[0]] = line / (nf_[other[2]]*nf_[other[1]]);
 
-        rfftwnd_one_complex_to_real(fftplan2_,cTemp,rTemp);
-        for(int i0=0;i0<nf_[0];i0++)
+        fftw_real * r = rTemp + b*rnfp;
+        for(int t=0;t<nf;t++)
         {
-          SetGridValue(tableInd,i0,i1,i2,i3, rTemp[i0]);
-          if ( i1*nf_[2]*nf_[3]*nf_[0] +i2*nf_[3]*nf_[0]+ i3*nf_[0] + i0 + 1 >= static_cast<int>(nextMonitor)) {
-            nextMonitor += monitorSize;
-            std::cout << "^";
-          }
+          index[dir]=t;
+          r[t]=float(GetGridValue(tableInd,index[0],index[1],index[2],index[3])/divisor[t]);
         }
+        for(int t=nf;t<rnfp;t++)
+          r[t]=0.0f;
       }
 
-  LogKit::LogFormatted(LogKit::Low,"\n\n Smoothing direction 2 of 4\n");
-  monitorSize = std::max(1.0f, static_cast<float>(nf_[0]*nf_[1]*nf_[2]*nf_[3])*0.02f);
-  nextMonitor = monitorSize;
-  std::cout
-    << "\n  0%       20%       40%       60%       80%      100%"
-    << "\n  |    |    |    |    |    |    |    |    |    |    |  "
-    << "\n  ^";
+      rfftwnd_real_to_complex(fftplan1_,n,rTemp,1,rnfp,NULL,0,0);
 
-  // divide and smoothdirection2
-  for(int i0=0;i0<nf_[0];i0++)
-    for(int i2=0;i2<nf_[2];i2++)
-      for(int i3=0;i3<nf_[3];i3++)
+      for(int b=0;b<n;b++)
       {
-        for(int i1=0;i1<nf_[1];i1++)
-        {
-          double divisor=std::max(minDivisor,priorDistribution_[1][i1]);
-          rTemp[i1]=float(GetGridValue(tableInd,i0,i1,i2,i3)/divisor);
-        }
-        for(int i1=nf_[1];i1<nfp_;i1++)
-          rTemp[i1]=0.0f;
-
-        rfftwnd_one_real_to_complex(fftplan1_,rTemp,cTemp);
-
-        for(int i1=0;i1<cnfp;i1++)
-        {
-          cTemp[i1].re=cTemp[i1].re*smoothingFilter[1][i1].re;
-          cTemp[i1].im=cTemp[i1].im*smoothingFilter[1][i1].re;
-        }
-
-        rfftwnd_one_complex_to_real(fftplan2_,cTemp,rTemp);
-        for(int i1=0;i1<nf_[1];i1++)
+        fftw_complex * c = cTemp + b*cnfp;
+        for(int t=0;t<cnfp;t++)
         {
-          SetGridValue(tableInd,i0,i1,i2,i3, rTemp[i1]);
-          if ( i0*nf_[2]*nf_[3]*nf_[1] +i2*nf_[3]*nf_[1]+ i3*nf_[1] + i1 + 1 >= static_cast<int>(nextMonitor)) {
-            nextMonitor += monitorSize;
-            std::cout << "^";
-          }
+          c[t].re=c[t].re*smoothingFilter[t].re;
+          c[t].im=c[t].im*smoothingFilter[t].re;
         }
       }
 
-  LogKit::LogFormatted(LogKit::Low,"\n\n Smoothing direction 3 of 4\n");
-  monitorSize = std::max(1.0f, static_cast<float>(nf_[0]*nf_[1]*nf_[2]*nf_[3])*0.02f);
-  nextMonitor = monitorSize;
-  std::cout
-    << "\n  0%       20%       40%       60%       80%      100%"
-    << "\n  |    |    |    |    |    |    |    |    |    |    |  "
-    << "\n  ^";
+      rfftwnd_complex_to_real(fftplan2_,n,cTemp,1,cnfp,NULL,0,0);
 
-  //  divide and smoothdirection 3
-  for(int i0=0;i0<nf_[0];i0++)
-    for(int i1=0;i1<nf_[1];i1++)
-      for(int i3=0;i3<nf_[3];i3++)
+      for(int b=0;b<n;b++)
       {
-        for(int i2=0;i2<nf_[2];i2++)
-        {
-          double divisor=std::max(minDivisor,priorDistribution_[2][i2]);
-          rTemp[i2]=float(GetGridValue(tableInd,i0,i1,i2,i3)/divisor);
-
-        }
-        for(int i2=nf_[2];i2<nfp_;i2++)
-          rTemp[i2]=0.0f;
-
-        rfftwnd_one_real_to_complex(fftplan1_,rTemp,cTemp);
-
-        for(int i2=0;i2<cnfp;i2++)
-        {
-          cTemp[i2].re=cTemp[i2].re*smoothingFilter[2][i2].re;
-          cTemp[i2].im=cTemp[i2].im*smoothingFilter[2][i2].re;
-        }
+        int line = first+b;
+        index[other[2]] = line % nf_[other[2]];
+        index[other[1]] = (line / nf_[other[2]]) % nf_[other[1]];
+        index[other[0]] = line / (nf_[other[2]]*nf_[other[1]]);
 
-        rfftwnd_one_complex_to_real(fftplan2_,cTemp,rTemp);
-        for(int i2=0;i2<nf_[2];i2++)
+        fftw_real * r = rTemp + b*rnfp;
+        for(int t=0;t<nf;t++)
         {
-          SetGridValue(tableInd,i0,i1,i2,i3, rTemp[i2]);
-          if ( i0*nf_[1]*nf_[3]*nf_[2] +i1*nf_[3]*nf_[2]+ i3*nf_[2] + i2 + 1 >= static_cast<int>(nextMonitor)) {
-            nextMonitor += monitorSize;
-            std::cout << "^";
-          }
+          index[dir]=t;
+          SetGridValue(tableInd,index[0],index[1],index[2],index[3],r[t]);
         }
       }
 
-  LogKit::LogFormatted(LogKit::Low,"\n Smoothing last direction \n");
-  monitorSize = std::max(1.0f, static_cast<float>(nf_[0]*nf_[1]*nf_[2]*nf_[3])*0.02f);
-  nextMonitor = monitorSize;
-  std::cout
-    << "\n  0%       20%       40%       60%       80%      100%"
-    << "\n  |    |    |    |    |    |    |    |    |    |    |  "
-    << "\n  ^";
- //  divide and smoothdirection 4
-   for(int i0=0;i0<nf_[0];i0++)
-    for(int i1=0;i1<nf_[1];i1++)
-      for(int i2=0;i2<nf_[2];i2++)
+#ifdef PARALLEL
+#pragma omp critical(rockphysicsinversion4d_monitor)
+#endif
       {
-        for(int i3=0;i3<nf_[3];i3++)
-        {
-          double divisor=std::max(minDivisor,priorDistribution_[3][i3]);
-          rTemp[i3]=float(GetGridValue(tableInd,i0,i1,i2,i3)/divisor);
-        }
-        for(int i3=nf_[3];i3<nfp_;i3++)
-          rTemp[i3]=0.0f;
-
-        rfftwnd_one_real_to_complex(fftplan1_,rTemp,cTemp);
-
-        for(int i3=0;i3<cnfp;i3++)
-        {
-          cTemp[i3].re=cTemp[i3].re*smoothingFilter[3][i3].re;
-          cTemp[i3].im=cTemp[i3].im*smoothingFilter[3][i3].re;
-        }
-
-        rfftwnd_one_complex_to_real(fftplan2_,cTemp,rTemp);
-        for(int i3=0;i3<nf_[3];i3++)
-        {
-          SetGridValue(tableInd,i0,i1,i2,i3, rTemp[i3]);
-          if ( i0*nf_[1]*nf_[2]*nf_[3] +i1*nf_[2]*nf_[3]+ i2*nf_[3] + i3 + 1 >= static_cast<int>(nextMonitor)) {
-            nextMonitor += monitorSize;
-            std::cout << "^";
-          }
+        nDone++;
+        while (nDone >= static_cast<int>(nextMonitor)) {
+          nextMonitor += monitorSize;
+          std::cout << "^";
         }
       }
+    }
 
-  for (int j=0; j<nf_[0]; j++){
-      meanRockPrediction_(tableInd,j)->endAccess();
+    fftw_free(rTemp);
   }
-
-  fftw_free(rTemp);
-
 }
 
 void
@@ -21,7 +21,8 @@ public:
   RockPhysicsInversion4D(NRLib::Vector                      priorMean,
                          NRLib::Matrix                      priorCov,
                          NRLib::Matrix                      posteriorCov,
-                         std::vector<std::vector<double> >  mSamp);
+                         std::vector<std::vector<double> >  mSamp,
+                         int                                nThreads);
 
   ~RockPhysicsInversion4D();
   void     makeNewPredictionTable(std::vector<std::vector<double> >  mSamp,std::vector<double>   rSamp);
@@ -33,7 +34,9 @@ public:
   void     allocatePredictionTables( );
   void     fillInTable( std::vector<std::vector<double> >  mSamp,std::vector<double>   rSamp,int tableInd);
   void     smoothAllDirectionsAndNormalize();
-  void     DivideAndSmoothTable(int tableInd,std::vector<std::vector<double> > priorDistribution, std::vector<fftw_complex*> smoothingFilter);
+  void     DivideAndSmoothTable(int                                       tableInd,
+                                const std::vector<std::vector<double> > & priorDistribution,
+                                const std::vector<fftw_complex*>        & smoothingFilter);
   fftw_complex*        MakeSmoothingFilter(double posteriorVariance,double  df);
   std::vector<double>  MakeGaussKernel(double mean, double variance, double minf, double  df,int nf);
   // another option is to use data reference
@@ -49,7 +52,12 @@ public:
 
 private:
 
-  void GetLowerIndexAndW(double minValue,double maxValue,int nValue,double value,int& index, double& w);
+  void GetLowerIndexAndW(double minValue,double maxValue,int nValue,double value,int& index, double& w) const;
+  double interpolateTable(const double * f) const; // f holds the four transformed variables
+  void DivideAndSmoothDirection(int                         tableInd,
+                                int                         dir,
+                                const std::vector<double> & priorDistribution,
+                                const fftw_complex        * smoothingFilter);
   int GetLowerIndex(double minValue,double maxValue,int nValue,double value);
 
   void ClearContentInPredictionTable( );
@@ -71,6 +79,8 @@ private:
   rfftwnd_plan fftplan1_;
   rfftwnd_plan fftplan2_;
 
+  int nThreads_; // Threads used for predictions and smoothing
+
 };
 #endif
 
@@ -392,39 +392,28 @@ SeismicParametersHolder::allocateGrids(const int nx, const int ny, const int nz,
 void
 SeismicParametersHolder::invFFTAllGrids()
 {
-  LogKit::LogFormatted(LogKit::High,"\nBacktransforming background grids from FFT domain to time domain...");
+  LogKit::LogFormatted(LogKit::High,"\nBacktransforming background and correlation grids from FFT domain to time domain...");
 
-  if(meanVp_->getIsTransformed())
-    meanVp_->invFFTInPlace();
+  std::vector<FFTGrid *> grids;
+  getBackgroundGrids(grids);
+  getCovGrids(grids);
+  transformGrids(grids, false);
 
-  if(meanVs_->getIsTransformed())
-    meanVs_->invFFTInPlace();
-
-  if(meanRho_->getIsTransformed())
-    meanRho_->invFFTInPlace();
   LogKit::LogFormatted(LogKit::High,"...done\n");
-
-  invFFTCovGrids();
 }
 
 //--------------------------------------------------------------------
 void
 SeismicParametersHolder::FFTAllGrids()
 {
-  LogKit::LogFormatted(LogKit::High,"\nTransforming background grids from time domain to FFT domain ...");
-
-  if(!meanVp_->getIsTransformed())
-    meanVp_->fftInPlace();
+  LogKit::LogFormatted(LogKit::High,"\nTransforming background and correlation grids from time domain to FFT domain ...");
 
-  if(!meanVs_->getIsTransformed())
-    meanVs_->fftInPlace();
+  std::vector<FFTGrid *> grids;
+  getBackgroundGrids(grids);
+  getCovGrids(grids);
+  transformGrids(grids, true);
 
-  if(!meanRho_->getIsTransformed())
-    meanRho_->fftInPlace();
   LogKit::LogFormatted(LogKit::High,"...done\n");
-
-  FFTCovGrids();
-
 }
 //-----------------------------------------------------------------------------------------
 
@@ -433,23 +422,9 @@ SeismicParametersHolder::invFFTCovGrids()
 {
   LogKit::LogFormatted(LogKit::High,"\nBacktransforming correlation grids from FFT domain to time domain...");
 
-  if (covVp_->getIsTransformed())
-    covVp_->invFFTInPlace();
-
-  if (covVs_->getIsTransformed())
-    covVs_->invFFTInPlace();
-
-  if (covRho_->getIsTransformed())
-    covRho_->invFFTInPlace();
-
-  if (crCovVpVs_->getIsTransformed())
-    crCovVpVs_->invFFTInPlace();
-
-  if (crCovVpRho_->getIsTransformed())
-    crCovVpRho_->invFFTInPlace();
-
-  if (crCovVsRho_->getIsTransformed())
-    crCovVsRho_->invFFTInPlace();
+  std::vector<FFTGrid *> grids;
+  getCovGrids(grids);
+  transformGrids(grids, false);
 
   LogKit::LogFormatted(LogKit::High,"...done\n");
 }
@@ -459,25 +434,51 @@ SeismicParametersHolder::FFTCovGrids()
 {
   LogKit::LogFormatted(LogKit::High,"\nTransforming correlation grids in seismic parameters holder from time domain to FFT domain...");
 
-  if (!covVp_->getIsTransformed())
-    covVp_->fftInPlace();
-
-  if (!covVs_->getIsTransformed())
-    covVs_->fftInPlace();
+  std::vector<FFTGrid *> grids;
+  getCovGrids(grids);
+  transformGrids(grids, true);
 
-  if (!covRho_->getIsTransformed())
-    covRho_->fftInPlace();
+  LogKit::LogFormatted(LogKit::High,"...done\n");
+}
 
-  if (!crCovVpVs_->getIsTransformed())
-    crCovVpVs_->fftInPlace();
+//--------------------------------------------------------------------
+void
+SeismicParametersHolder::getBackgroundGrids(std::vector<FFTGrid *> & grids) const
+{
+  grids.push_back(meanVp_);
+  grids.push_back(meanVs_);
+  grids.push_back(meanRho_);
+}
 
-  if (!crCovVpRho_->getIsTransformed())
-    crCovVpRho_->fftInPlace();
+//--------------------------------------------------------------------
+void
+SeismicParametersHolder::getCovGrids(std::vector<FFTGrid *> & grids) const
+{
+  grids.push_back(covVp_);
+  grids.push_back(covVs_);
+  grids.push_back(covRho_);
+  grids.push_back(crCovVpVs_);
+  grids.push_back(crCovVpRho_);
+  grids.push_back(crCovVsRho_);
+}
 
-  if (!crCovVsRho_->getIsTransformed())
-    crCovVsRho_->fftInPlace();
+//--------------------------------------------------------------------
+void
+SeismicParametersHolder::transformGrids(const std::vector<FFTGrid *> & grids,
+                                        bool                           forward)
+{
+  // Grids already in the requested domain are left alone. The others are
+  // independent and are transformed concurrently.
+  std::vector<FFTGrid *> to_transform;
+  for (size_t i = 0; i < grids.size(); i++) {
+    if (grids[i]->getIsTransformed() != forward)
+      to_transform.push_back(grids[i]);
+  }
 
-  LogKit::LogFormatted(LogKit::High,"...done\n");
+  if (forward)
+    FFTGrid::fftInPlaceAll(to_transform);
+  else
+    FFTGrid::invFFTInPlaceAll(to_transform);
 }
 
 //--------------------------------------------------------------------------------------------------
@@ -1172,3 +1173,47 @@ void SeismicParametersHolder::releaseExpGrids() const
   if (meanRho_ != NULL)
     delete meanRho_;
 }
+
+void SeismicParametersHolder::spillGridsToDisk()
+{
+  // Moves the grids that are combined at the end of the run to disk, so that
+  // only one interval is kept in memory. Grids in the Fourier domain and
+  // file grids are left as they are.
+  spillGrid(meanVp_);
+  spillGrid(meanVs_);
+  spillGrid(meanRho_);
+  spillGrid(covVp_);
+  spillGrid(covVs_);
+  spillGrid(covRho_);
+  spillGrid(crCovVpVs_);
+  spillGrid(crCovVpRho_);
+  spillGrid(crCovVsRho_);
+  spillGrid(postVp_);
+  spillGrid(postVs_);
+  spillGrid(postRho_);
+  spillGrid(postVpKriged_);
+  spillGrid(postVsKriged_);
+  spillGrid(postRhoKriged_);
+  spillGrid(block_grid_);
+  spillGrid(facies_prob_undef_);
+  spillGrid(quality_grid_);
+
+  for (size_t i = 0; i < simulations_seed0_.size(); i++)
+    spillGrid(simulations_seed0_[i]);
+  for (size_t i = 0; i < simulations_seed1_.size(); i++)
+    spillGrid(simulations_seed1_[i]);
+  for (size_t i = 0; i < simulations_seed2_.size(); i++)
+    spillGrid(simulations_seed2_[i]);
+  for (size_t i = 0; i < facies_prob_.size(); i++)
+    spillGrid(facies_prob_[i]);
+  for (size_t i = 0; i < facies_prob_geo_.size(); i++)
+    spillGrid(facies_prob_geo_[i]);
+  for (size_t i = 0; i < lh_cube_.size(); i++)
+    spillGrid(lh_cube_[i]);
+}
+
+void SeismicParametersHolder::spillGrid(FFTGrid * grid)
+{
+  if (grid != NULL && !grid->isFile() && !grid->getIsTransformed() && !grid->getIsSpilled())
+    grid->spillToDisk();
+}
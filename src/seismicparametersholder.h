@@ -182,7 +182,16 @@ public:
 
   void                          releaseExpGrids() const;
 
+  void                          spillGridsToDisk();
+
 private:
+  static void                   spillGrid(FFTGrid * grid);
+
+  void                          getBackgroundGrids(std::vector<FFTGrid *> & grids) const;
+  void                          getCovGrids(std::vector<FFTGrid *> & grids) const;
+  static void                   transformGrids(const std::vector<FFTGrid *> & grids,
+                                               bool                           forward);
+
   void                          createCorrGrids(int nx, int ny, int nz, int nxp, int nyp, int nzp, bool fileGrid);
 
   void                          InitializeCorrelations(bool                                  cov_estimated,
@@ -1083,7 +1083,8 @@ State4D::iFFTCov()
 std::vector<FFTGrid*>
 State4D::doRockPhysicsInversion(TimeLine                               & time_line,
                                 const std::vector<DistributionsRock *>   rock_distributions,
-                                TimeEvolution                          & timeEvolution)
+                                TimeEvolution                          & timeEvolution,
+                                int                                      n_threads)
 {
   LogKit::WriteHeader("Start 4D rock physics inversion");
   bool debug=true; // triggers printouts
@@ -1094,12 +1095,12 @@ State4D::doRockPhysicsInversion(TimeLine                               & time_li
   int nSim=10000; // NBNB OK 100000->10000 for speed during debug
 
   LogKit::LogFormatted(LogKit::Low,"\nSampling rock physics distribution...");
-  std::vector<std::vector<std::vector<double> > > rockSample = timeEvolution.returnCorrelatedSample(nSim,time_line, rock_distributions);
+  std::vector<double> rockSample = timeEvolution.returnCorrelatedSample(nSim,time_line, rock_distributions);
   LogKit::LogFormatted(LogKit::Low,"done\n\n");
 
-  int nTimeSteps = static_cast<int>(rockSample.size());
-  //nSim=rockSample[0].size();
-  int nParam = static_cast<int>(rockSample[0][0].size());
+  // Parameter p of sample i at time step j is rockSample[(j*nSim + i)*nParam + p].
+  int nTimeSteps = static_cast<int>(rock_distributions.size());
+  int nParam = static_cast<int>(rockSample.size()/(static_cast<size_t>(nTimeSteps)*nSim));
   int nM = 3;  // number of seismic parameters.
   int nRockProperties = nParam-nM; // number of rock parameters
 
@@ -1115,13 +1116,13 @@ State4D::doRockPhysicsInversion(TimeLine                               & time_li
         for(int k=0;k<nParam;k++)
         {
           int ind=k+j*nParam;
-          rockSamples(i,ind)=rockSample[j][i][k];
+          rockSamples(i,ind)=rockSample[(j*nSim + i)*nParam + k];
         }
 
     NRLib::WriteMatrixToFile("rockSample.dat", rockSamples);
   }
 
-  std::vector<std::vector<double> > mSamp = makeSeismicParamsFromrockSample(rockSample);
+  std::vector<std::vector<double> > mSamp = makeSeismicParamsFromrockSample(rockSample, nTimeSteps, nSim, nParam);
 
   //write seismic parameters to check ok
   if(debug)
@@ -1152,7 +1153,7 @@ State4D::doRockPhysicsInversion(TimeLine                               & time_li
 
   LogKit::LogFormatted(LogKit::Low,"\nMaking rock-physics lookup tables, table 1 of %d\n",nRockProperties+1);
 
-  RockPhysicsInversion4D* rockPhysicsInv = new RockPhysicsInversion4D(fullPriorMean,fullPriorCov,fullPosteriorCov,mSamp);
+  RockPhysicsInversion4D* rockPhysicsInv = new RockPhysicsInversion4D(fullPriorMean,fullPriorCov,fullPosteriorCov,mSamp,n_threads);
   //LogKit::LogFormatted(LogKit::Low,"done\n\n");
 
   std::vector<FFTGrid*> prediction(nRockProperties);
@@ -1162,7 +1163,7 @@ State4D::doRockPhysicsInversion(TimeLine                               & time_li
   for(int i=0;i<nRockProperties;i++)
   {
     LogKit::LogFormatted(LogKit::Low,"\nMaking rock-physics lookup tables, table %d of %d\n",i+2,nRockProperties+1);
-    std::vector<double> rSamp = getRockPropertiesFromRockSample(rockSample,i);
+    std::vector<double> rSamp = getRockPropertiesFromRockSample(rockSample, nTimeSteps, nSim, nParam, i);
     rockPhysicsInv->makeNewPredictionTable(mSamp,rSamp);
     prediction[i] = rockPhysicsInv->makePredictions(mu_static_, mu_dynamic_ );
   }
@@ -1251,38 +1252,38 @@ State4D::GetFullCov()
 
 
 std::vector<std::vector<double> >
-State4D::makeSeismicParamsFromrockSample(std::vector<std::vector<std::vector<double> > > rS)
+State4D::makeSeismicParamsFromrockSample(const std::vector<double> & rS,
+                                         int                         k_max, // number of surveys
+                                         int                         i_max, // number of samples
+                                         int                         dim)   // 3 + number of reservoir variables
 {
-  int k_max = int(rS.size());// number of surveys
-  int i_max = int(rS[0].size());// number of samples
-//  int dim   = int(rS[0][0].size());// 3 + number of reservoir variables
-
   std::vector<std::vector<double> > m(6, std::vector<double>(i_max));
 
   for(int i=0;i<i_max;i++)
   {
-    m[0][i]=rS[0][i][0];
-    m[1][i]=rS[0][i][1];
-    m[2][i]=rS[0][i][2];
-    m[3][i]=rS[k_max-1][i][0]-rS[0][i][0];
-    m[4][i]=rS[k_max-1][i][1]-rS[0][i][1];
-    m[5][i]=rS[k_max-1][i][2]-rS[0][i][2];
+    const double * first = &rS[i*dim];
+    const double * last  = &rS[((k_max-1)*i_max + i)*dim];
+    m[0][i]=first[0];
+    m[1][i]=first[1];
+    m[2][i]=first[2];
+    m[3][i]=last[0]-first[0];
+    m[4][i]=last[1]-first[1];
+    m[5][i]=last[2]-first[2];
   }
 
   return m;
 }
 
 std::vector<double>
-State4D::getRockPropertiesFromRockSample(std::vector<std::vector<std::vector<double> > > rS,int varNumber)
+State4D::getRockPropertiesFromRockSample(const std::vector<double> & rS,
+                                         int                         k_max, // number of surveys
+                                         int                         i_max, // number of samples
+                                         int                         dim,   // 3 + number of reservoir variables
+                                         int                         varNumber)
 {
-
-  int k_max = int(rS.size());// number of surveys
-  int i_max = int(rS[0].size());// number of samples
-  //int dim   = int(rS[0][0].size());// 3 + number of reservoir variables
-
   std::vector<double>  r(i_max);
   for(int i=0;i<i_max;i++)
-    r[i]=rS[k_max-1][i][3+varNumber];
+    r[i]=rS[((k_max-1)*i_max + i)*dim + 3+varNumber];
 
   return r;
 }
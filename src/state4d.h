@@ -52,7 +52,8 @@ public:
   void   evolve(int time_step, const TimeEvolution & timeEvolution );
   std::vector<FFTGrid*> doRockPhysicsInversion(TimeLine                               & time_line,
                                                const std::vector<DistributionsRock *>   rock_distributions,
-                                               TimeEvolution                          & timeEvolution);
+                                               TimeEvolution                          & timeEvolution,
+                                               int                                      n_threads);
 
 
   bool   isActive() const {return(mu_static_.size() > 0);}
@@ -107,8 +108,8 @@ private:
   std::vector<FFTGrid *> sigma_dynamic_dynamic_;// [0] = vp_vp, [1] = vp_vs, [2] = vp_rho ,[3] = vs_vs, [4] = vs_rho, [5] = rho_rho (all dynamix)
   std::vector<FFTGrid *> sigma_static_dynamic_; // [0] = vpStat_vpDyn, [1] = vpStat_vsDyn, [2] = vpStat_rhoDyn ,[3] = vsStat_vpDyn,
                                                 // [4] = vsStat_vsDyn, [5] = vsStat_rhoDyn, [6]= rhoStat_vpDyn, [7] = rhoStat_vsDyn, [8] = rhoStat_rhoDyn
-  std::vector<std::vector<double> >    makeSeismicParamsFromrockSample(std::vector<std::vector<std::vector<double> > > rS);
-  std::vector<double>                  getRockPropertiesFromRockSample(std::vector<std::vector<std::vector<double> > > rS,int varNumber);
+  std::vector<std::vector<double> >    makeSeismicParamsFromrockSample(const std::vector<double> & rS, int k_max, int i_max, int dim);
+  std::vector<double>                  getRockPropertiesFromRockSample(const std::vector<double> & rS, int k_max, int i_max, int dim, int varNumber);
 };
 
 #endif
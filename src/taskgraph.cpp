@@ -0,0 +1,204 @@
+/***************************************************************************
+*      Copyright (C) 2008 by Norwegian Computing Center and Statoil        *
+***************************************************************************/
+
+#include <algorithm>
+#include <exception>
+
+#if defined(__WIN32__) || defined(WIN32) || defined(_WINDOWS)
+#ifndef NOMINMAX
+#define NOMINMAX              // Keeps std::min usable
+#endif
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+#include "nrlib/exception/exception.hpp"
+#include "nrlib/iotools/stringtools.hpp"
+
+#include "src/taskgraph.h"
+
+namespace {
+  // Gives up the processor while a thread waits for a task to become ready.
+  // The tasks are coarse, so a short sleep costs little.
+  void WaitForTask()
+  {
+#if defined(__WIN32__) || defined(WIN32) || defined(_WINDOWS)
+    Sleep(1);
+#else
+    struct timespec wait = {0, 100000};   // 0.1 ms
+    nanosleep(&wait, NULL);
+#endif
+  }
+}
+
+TaskGraph::TaskGraph(int    n_threads,
+                     double memory_budget)
+  : n_threads_(n_threads > 0 ? n_threads : 1),
+    memory_budget_(memory_budget)
+{
+}
+
+TaskGraph::~TaskGraph()
+{
+  for (size_t i = 0 ; i < tasks_.size() ; i++)
+    delete tasks_[i].task;
+}
+
+int
+TaskGraph::AddTask(Task              * task,
+                   const std::string & name,
+                   double              memory)
+{
+  Node node;
+  node.task           = task;
+  node.name           = name;
+  node.memory         = memory;
+  node.n_dependencies = 0;
+  tasks_.push_back(node);
+  return static_cast<int>(tasks_.size()) - 1;
+}
+
+int
+TaskGraph::AddTask(Task              * task,
+                   const std::string & name,
+                   double              memory,
+                   int                 depends_on)
+{
+  int id = AddTask(task, name, memory);
+  AddDependency(id, depends_on);
+  return id;
+}
+
+void
+TaskGraph::AddDependency(int task,
+                         int depends_on)
+{
+  int n_tasks = static_cast<int>(tasks_.size());
+  if (task < 0 || task >= n_tasks || depends_on < 0 || depends_on >= n_tasks || task == depends_on)
+    throw NRLib::Exception("Invalid task dependency " + NRLib::ToString(task) + " -> " + NRLib::ToString(depends_on) + ".");
+
+  tasks_[depends_on].dependents.push_back(task);
+  tasks_[task].n_dependencies++;
+}
+
+void
+TaskGraph::CheckForCycles(void) const
+{
+  int              n_tasks = static_cast<int>(tasks_.size());
+  std::vector<int> n_waiting(n_tasks);
+  std::vector<int> ready;
+  for (int t = 0 ; t < n_tasks ; t++) {
+    n_waiting[t] = tasks_[t].n_dependencies;
+    if (n_waiting[t] == 0)
+      ready.push_back(t);
+  }
+
+  int n_visited = 0;
+  while (ready.size() > 0) {
+    int t = ready.back();
+    ready.pop_back();
+    n_visited++;
+    for (size_t d = 0 ; d < tasks_[t].dependents.size() ; d++) {
+      int dependent = tasks_[t].dependents[d];
+      if (--n_waiting[dependent] == 0)
+        ready.push_back(dependent);
+    }
+  }
+
+  if (n_visited < n_tasks)
+    throw NRLib::Exception("The task graph has cyclic dependencies.");
+}
+
+void
+TaskGraph::Run()
+{
+  int n_tasks = static_cast<int>(tasks_.size());
+  if (n_tasks == 0)
+    return;
+
+  CheckForCycles();
+
+  //
+  // Shared scheduling state, only touched inside the critical section.
+  // Ready tasks are started in the order they were added.
+  //
+  std::vector<int> n_waiting(n_tasks);
+  std::vector<int> ready;
+  for (int t = 0 ; t < n_tasks ; t++) {
+    n_waiting[t] = tasks_[t].n_dependencies;
+    if (n_waiting[t] == 0)
+      ready.push_back(t);
+  }
+
+  int         n_finished     = 0;
+  int         n_running      = 0;
+  double      running_memory = 0.0;
+  std::string error;
+
+#ifdef PARALLEL
+  int n_threads = std::min(n_threads_, n_tasks);
+#pragma omp parallel num_threads(n_threads)
+#endif
+  {
+    bool done = false;
+    while (!done) {
+      int task = -1;
+
+#ifdef PARALLEL
+#pragma omp critical(taskgraph)
+#endif
+      {
+        if (n_finished + n_running == n_tasks || error != "") {
+          done = true;
+        }
+        else {
+          for (size_t r = 0 ; r < ready.size() ; r++) {
+            double memory = tasks_[ready[r]].memory;
+            if (memory_budget_ <= 0.0 || n_running == 0 || running_memory + memory <= memory_budget_) {
+              task            = ready[r];
+              running_memory += memory;
+              n_running++;
+              ready.erase(ready.begin() + r);
+              break;
+            }
+          }
+        }
+      }
+
+      if (task < 0) {
+        if (!done)
+          WaitForTask();  // Waiting for a dependency or for memory
+        continue;
+      }
+
+      std::string task_error;
+      try {
+        tasks_[task].task->Run();
+      }
+      catch (std::exception & e) {
+        task_error = tasks_[task].name + ": " + e.what();
+      }
+
+#ifdef PARALLEL
+#pragma omp critical(taskgraph)
+#endif
+      {
+        if (task_error != "" && error == "")
+          error = task_error;
+        running_memory -= tasks_[task].memory;
+        n_running--;
+        n_finished++;
+        const std::vector<int> & dependents = tasks_[task].dependents;
+        for (size_t d = 0 ; d < dependents.size() ; d++) {
+          if (--n_waiting[dependents[d]] == 0)
+            ready.push_back(dependents[d]);
+        }
+      }
+    }
+  }
+
+  if (error != "")
+    throw NRLib::Exception(error);
+}
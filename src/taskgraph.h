@@ -0,0 +1,123 @@
+/***************************************************************************
+*      Copyright (C) 2008 by Norwegian Computing Center and Statoil        *
+***************************************************************************/
+
+#ifndef TASKGRAPH_H
+#define TASKGRAPH_H
+
+#include <string>
+#include <vector>
+
+//
+// Executor for a small graph of coarse, independent tasks.
+//
+// Tasks are typically whole-grid operations (FFT of a grid, filtering of a
+// cube) that do not depend on each other, but are written as sequential
+// calls. They are added with their dependencies and an estimate of the
+// extra memory they need while running, and are then run concurrently on
+// up to n_threads threads. A task is only started when all tasks it
+// depends on are finished and the memory of the running tasks stays within
+// the budget; a task needing more than the budget is run alone.
+//
+// Each task runs on one thread. OpenMP regions inside a task are not split
+// further (nested parallelism is off), so a graph pays off when there are
+// at least as many independent tasks as threads, or when the tasks are too
+// small to parallelise well by themselves.
+//
+// Only the standard OpenMP 2.0 constructs are used, so the executor also
+// builds with the Windows compilers.
+//
+class TaskGraph
+{
+public:
+  class Task
+  {
+  public:
+    virtual      ~Task() {}
+    virtual void Run() = 0;
+  };
+
+  // Calls a member function without arguments, e.g. &FFTGrid::fftInPlace.
+  template <class T>
+  class MemberTask : public Task
+  {
+  public:
+    MemberTask(T * object, void (T::*function)()) : object_(object), function_(function) {}
+    void Run() { (object_->*function_)() ;}
+
+  private:
+    T    * object_;
+    void (T::*function_)();
+  };
+
+  // Calls a member function with one argument.
+  template <class T, class A>
+  class MemberTask1 : public Task
+  {
+  public:
+    MemberTask1(T * object, void (T::*function)(A), A argument) : object_(object), function_(function), argument_(argument) {}
+    void Run() { (object_->*function_)(argument_) ;}
+
+  private:
+    T    * object_;
+    void (T::*function_)(A);
+    A      argument_;
+  };
+
+  TaskGraph(int    n_threads,
+            double memory_budget = 0.0);                         // Budget in bytes, zero means unlimited
+  ~TaskGraph();
+
+  // Adds a task and returns its id. The graph takes ownership of task.
+  int          AddTask(Task              * task,
+                       const std::string & name,
+                       double              memory = 0.0);
+
+  int          AddTask(Task              * task,
+                       const std::string & name,
+                       double              memory,
+                       int                 depends_on);
+
+  void         AddDependency(int task,
+                             int depends_on);
+
+  // Runs all tasks and blocks until they are finished. The first exception
+  // thrown by a task is rethrown as an NRLib::Exception after the running
+  // tasks have finished; tasks not yet started are then skipped.
+  void         Run();
+
+  int          GetNumberOfTasks(void) const { return static_cast<int>(tasks_.size()) ;}
+
+private:
+  TaskGraph(const TaskGraph &);
+  TaskGraph & operator=(const TaskGraph &);
+
+  void         CheckForCycles(void) const;
+
+  struct Node
+  {
+    Task             * task;
+    std::string        name;
+    double             memory;
+    std::vector<int>   dependents;        // Tasks waiting for this one
+    int                n_dependencies;
+  };
+
+  std::vector<Node>    tasks_;
+  int                  n_threads_;
+  double               memory_budget_;
+};
+
+template <class T>
+TaskGraph::Task * MakeTask(T * object, void (T::*function)())
+{
+  return new TaskGraph::MemberTask<T>(object, function);
+}
+
+template <class T, class A>
+TaskGraph::Task * MakeTask(T * object, void (T::*function)(A), A argument)
+{
+  return new TaskGraph::MemberTask1<T, A>(object, function, argument);
+}
+
+#endif
@@ -16,7 +16,9 @@
 
 TimeEvolution::TimeEvolution(int                                     i_max,
                              TimeLine                              & time_line,
-                             const std::vector<DistributionsRock*> & dist_rock)
+                             const std::vector<DistributionsRock*> & dist_rock,
+                             int                                     n_threads)
+  : n_threads_(n_threads)
 {
   LogKit::WriteHeader("Setting up matrices for time evolution");
   std::list<int> time;
@@ -26,15 +28,15 @@ TimeEvolution::TimeEvolution(int                                     i_max,
 }
 
 
-std::vector<std::vector<std::vector<double> > >
+std::vector<double>
 
   TimeEvolution::returnCorrelatedSample(int                                         i_max,
                                         TimeLine                                  & time_line,
                                         const std::vector<DistributionsRock*>     & dist_rock)
 {
-  CorrelatedRockSamples correlated_rock_samples;
-  std::vector<std::vector<std::vector<double> > > sample= correlated_rock_samples.CreateSamplesExtended(i_max, time_line, dist_rock);
-  // The dimension of m_ik[k][i] is expected to be equal to 3, in other words we do not return samples splitted into dynamic and static parts.
+  CorrelatedRockSamples correlated_rock_samples(n_threads_);
+  std::vector<double> sample= correlated_rock_samples.CreateSamplesExtended(i_max, time_line, dist_rock);
+  // The samples are not splitted into dynamic and static parts.
   return sample;
 }
 
@@ -61,8 +63,8 @@ void TimeEvolution::SetUpEvolutionMatrices(std::vector< NRLib::Matrix>
   // Cov_mkm1_mkm1: Denotes the covariance of m_{k-1} and m_{k-1}, Cov(m_{k-1}, m_{k-1})
   double adjustment_factor=1e-6;
 
-  CorrelatedRockSamples correlated_rock_samples;
-  std::vector<std::vector<std::vector<double> > > m_ik = correlated_rock_samples.CreateSamples(i_max, time_line, dist_rock);
+  CorrelatedRockSamples correlated_rock_samples(n_threads_);
+  std::vector<double> m_ik = correlated_rock_samples.CreateSamples(i_max, time_line, dist_rock);
 
   //write seismic parameters to check ok
    if(true)
@@ -74,20 +76,20 @@ void TimeEvolution::SetUpEvolutionMatrices(std::vector< NRLib::Matrix>
         for(int k=0;k<3;k++)
         {
           int ind=k+j*3;
-          rockSamples(i,ind)= m_ik[j][i][k];
+          rockSamples(i,ind)= m_ik[(j*i_max + i)*3 + k];
         }
 
     NRLib::WriteMatrixToFile("SeisParSampleEvolution.dat", rockSamples);
   }
 
 
-  // The dimension of m_ik[k][i] is expected to be equal to 3 (dim),
-  // Now do the separation, which expands m_ik[k][i] to size dim*number_of_timesteps_
+  // The dimension of each sample is expected to be equal to 3 (dim),
+  // Now do the separation, which expands the samples to size dim*number_of_timesteps_
 
-  int dim = static_cast<int>(m_ik[0][0].size());
+  int dim = 3;
   int K = number_of_timesteps_;
 
-  std::vector<std::vector<double> > vectorSample = SplitSamplesStaticDynamic(m_ik);
+  std::vector<std::vector<double> > vectorSample = SplitSamplesStaticDynamic(m_ik, K, i_max, dim);
 
   // computes covariance off all variables
   NRLib::Matrix Cov_all(dim*K,dim*K);
@@ -229,8 +231,8 @@ void TimeEvolution::SetUpEvolutionMatrices2(std::vector< NRLib::Matrix>
   // Cov_mk_mkm1:   Denotes the covariance of m_{k} and m_{k-1},   Cov(m_{k}, m_{k-1})
   // Cov_mkm1_mkm1: Denotes the covariance of m_{k-1} and m_{k-1}, Cov(m_{k-1}, m_{k-1})
 
-  CorrelatedRockSamples correlated_rock_samples;
-  std::vector<std::vector<std::vector<double> > > m_ik = correlated_rock_samples.CreateSamples(i_max, time_line, dist_rock);
+  CorrelatedRockSamples correlated_rock_samples(n_threads_);
+  std::vector<double> m_ik = correlated_rock_samples.CreateSamples(i_max, time_line, dist_rock);
 
   //write seismic parameters to check ok
    if(true)
@@ -242,22 +244,21 @@ void TimeEvolution::SetUpEvolutionMatrices2(std::vector< NRLib::Matrix>
         for(int k=0;k<3;k++)
         {
           int ind=k+j*3;
-          rockSamples(i,ind)= m_ik[j][i][k];
+          rockSamples(i,ind)= m_ik[(j*i_max + i)*3 + k];
         }
 
     NRLib::WriteMatrixToFile("SeisParSampleEvolution.dat", rockSamples);
   }
 
 
-  // The dimension of m_ik[k][i] is expected to be equal to 3, in other words we do not expect to receive samples splitted into dynamic and static parts.
-  // Now do the separation, which expands m_ik[k][i] to double size:
+  // The dimension of each sample is expected to be equal to 3, in other words we do not expect to receive samples splitted into dynamic and static parts.
+  // Now do the separation, which expands the samples to double size:
 
-
-  SplitSamplesStaticDynamic2(m_ik);
-
-  int dim = static_cast<int>(m_ik[0][0].size());
   int K = number_of_timesteps_;
 
+  int dim = 3;
+  SplitSamplesStaticDynamic2(m_ik, K, i_max, dim);
+
   // Data structures for evolution matrix and correction term
   NRLib::Matrix A_k(dim, dim);
   NRLib::Matrix delta_k(dim, dim);
@@ -285,8 +286,8 @@ void TimeEvolution::SetUpEvolutionMatrices2(std::vector< NRLib::Matrix>
     for (int d = 0; d < dim; d++)
     {
       for (int i = 0; i < i_max; ++i) {
-        temp_m_k(i)   = m_ik[k][i][d];
-        temp_m_km1(i) = m_ik[k-1][i][d];
+        temp_m_k(i)   = m_ik[(k*i_max + i)*dim + d];
+        temp_m_km1(i) = m_ik[((k-1)*i_max + i)*dim + d];
       }
       m_k[d]   = temp_m_k;
       m_km1[d] = temp_m_km1;
@@ -492,14 +493,13 @@ void TimeEvolution::AdjustMatrixDeltaForm(NRLib::Matrix & delta_k, int dim)
 }
 
 std::vector<std::vector<double> >
-TimeEvolution::SplitSamplesStaticDynamic(std::vector<std::vector<std::vector<double> > >  m_ik) const
+TimeEvolution::SplitSamplesStaticDynamic(const std::vector<double> & m_ik,
+                                         int                         k_max, // number of surveys
+                                         int                         i_max, // number of samples
+                                         int                         dim) const // 3 when vp, vs,rho
 {
   // Alligns Data by removing one dimension in the data,
   // Keeps the static in first three collumns, keeps the dynamic part in the remaining.
-  int k_max = int(m_ik.size());// number of surveys
-  int i_max = int(m_ik[0].size());// number of samples
-  int dim   = int(m_ik[0][0].size());// 3 when vp, vs,rho
-
   std::vector<std::vector<double> > vectorData(k_max*dim);
 
   for (int k = 0; k < k_max*dim; ++k){
@@ -508,39 +508,39 @@ TimeEvolution::SplitSamplesStaticDynamic(std::vector<std::vector<std::vector<dou
 
   for (int i = 0; i < i_max; ++i) {
     for(int d=0;d<dim;d++)
-      vectorData[d][i] = m_ik[0][i][d]; // static part in first three collumns
+      vectorData[d][i] = m_ik[i*dim + d]; // static part in first three collumns
 
     for(int k=1;k<k_max;k++)
       for(int d=0;d<dim;d++)
-        vectorData[k*3+d][i] =m_ik[k][i][d] -m_ik[0][i][d]; // dynamic part in remaining collumns
+        vectorData[k*3+d][i] =m_ik[(k*i_max + i)*dim + d] -m_ik[i*dim + d]; // dynamic part in remaining collumns
   }
   return vectorData;
 }
 
-void TimeEvolution::SplitSamplesStaticDynamic2(std::vector<std::vector<std::vector<double> > > & m_ik) const
+void TimeEvolution::SplitSamplesStaticDynamic2(std::vector<double> & m_ik,
+                                               int                   k_max, // number of surveys
+                                               int                   i_max, // number of samples
+                                               int                 & dim) const // 3 when vp, vs,rho
 {
   // Splits according to the convention that for a given set of time correlated seismic parameters.
   // the first time instance is considered static and all the rest deviates from this static part by a dynamic component.
-  // That is: m_ik[0][i] is the static component, m_ik[k][i] - m_ik[0][i] is the dynamic component for time instance k.
-
-  // Order of indices: m_ik[k][i][d]
-  int k_max = int(m_ik.size());// number of surveys
-  int i_max = int(m_ik[0].size());// number of samples
-  int dim   = int(m_ik[0][0].size());// 3 when vp, vs,rho
+  // That is: sample i at time 0 is the static component, sample i at time k minus the static component is the dynamic component for time instance k.
 
-  std::vector<double> m_static(dim), m_dynamic(dim);
+  // Order of indices: m_ik[(k*i_max + i)*dim + d]. On return dim is doubled.
+  std::vector<double> m_split(2*m_ik.size());
   for (int i = 0; i < i_max; ++i) {
-    m_static = m_ik[0][i];
+    const double * m_static = &m_ik[i*dim];
     for (int k = 0; k < k_max; ++k) {
-      for (int d = 0; d < dim; ++d)
-        m_dynamic[d] = m_ik[k][i][d] - m_static[d];
-      m_ik[k][i].resize(2*dim);                // Expanding the vector.
+      const double * m_ki   = &m_ik[(k*i_max + i)*dim];
+      double       * split  = &m_split[(k*i_max + i)*2*dim];   // Expanding the sample.
       for (int d = 0; d < dim; ++d) {
-        m_ik[k][i][d] = m_static[d];
-        m_ik[k][i][d + dim] = m_dynamic[d];
+        split[d]       = m_static[d];
+        split[d + dim] = m_ki[d] - m_static[d];
       }
     }
   }
+  m_ik.swap(m_split);
+  dim *= 2;
   return;
 }
 
@@ -15,10 +15,11 @@ class FFTGrid;
 class TimeEvolution
 {
 public:
-  TimeEvolution() {}
+  TimeEvolution() : n_threads_(1) {}
   TimeEvolution(int                                     i_max,
                 TimeLine                              & time_line,
-                const std::vector<DistributionsRock*> & dist_rock);
+                const std::vector<DistributionsRock*> & dist_rock,
+                int                                     n_threads);
   //void Split(const SeismicParametersHolder &m_combined, State4D & state4D);
   //void Evolve(int time_step, State4D & state4D);
   //void Merge(const State4D & state4D, SeismicParametersHolder &m_combined);
@@ -26,7 +27,7 @@ public:
   NRLib::Matrix getEvolutionMatrix(int time_step)          const { return evolution_matrix_[time_step]; }
   NRLib::Vector getMeanCorrectionTerm(int time_step)       const { return mean_correction_term_[time_step];}
   NRLib::Matrix getCovarianceCorrectionTerm(int time_step) const { return cov_correction_term_[time_step]; }
-  std::vector<std::vector<std::vector<double> > > returnCorrelatedSample(int                                      i_max,
+  std::vector<double>                             returnCorrelatedSample(int                                      i_max,
                                                                          TimeLine                               & time_line,
                                                                          const std::vector<DistributionsRock*>  & dist_rock);
   NRLib::Vector computePriorMeanStaticAndDynamicLastTimeStep();
@@ -37,6 +38,7 @@ public:
 
 private:
   int number_of_timesteps_;
+  int n_threads_;            // Threads used to sample the rock chains
 
   NRLib::Matrix initial_cov_;
   NRLib::Vector initial_mean_;
@@ -45,8 +47,8 @@ private:
   std::vector< NRLib::Matrix> cov_correction_term_;
 
   //Expand every 3-vector into a 6-vector of 3 static and 3 dynamic elements.
-  void SplitSamplesStaticDynamic2(std::vector<std::vector<std::vector<double> > > & m_ik) const;
-  std::vector<std::vector<double> >  SplitSamplesStaticDynamic(std::vector<std::vector<std::vector<double> > >  m_ik) const;
+  void SplitSamplesStaticDynamic2(std::vector<double> & m_ik, int k_max, int i_max, int & dim) const;
+  std::vector<std::vector<double> >  SplitSamplesStaticDynamic(const std::vector<double> & m_ik, int k_max, int i_max, int dim) const;
 
   // Estimate time evolution matrices and correction term mean and covariance:
   void SetUpEvolutionMatrices(std::vector< NRLib::Matrix>          & evolution_matrix,
@@ -13,6 +13,7 @@
 
 #include "src/definitions.h"
 #include "src/timings.h"
+#include "src/profiler.h"
 
 void
 Timings::reportAll(LogKit::MessageLevels logLevel)
@@ -32,6 +33,7 @@ Timings::reportAll(LogKit::MessageLevels logLevel)
   double w_kriging_tot    = w_kriging_pred_ + w_kriging_sim_;
 
   calculateRest();
+  recordPhases();
 
   LogKit::LogFormatted(logLevel,"\nSection                              CPU time               Wall time");
   LogKit::LogFormatted(logLevel,"\n-----------------------------------------------------------------------\n");
@@ -77,6 +79,28 @@ Timings::reportOne(const std::string & text, double cpuThis, double wallThis,
   }
 }
 
+void
+Timings::recordPhases(void)
+{
+  //
+  // Make the classic sections available in the machine-readable profile
+  //
+  Profiler::RecordPhase("loading_seismic"     , w_seismic_ - w_resamplingSeismic_    , c_seismic_ - c_resamplingSeismic_);
+  Profiler::RecordPhase("resampling_seismic"  , w_resamplingSeismic_                 , c_resamplingSeismic_);
+  Profiler::RecordPhase("wells"               , w_wells_                             , c_wells_);
+  Profiler::RecordPhase("wavelets"            , w_wavelets_                          , c_wavelets_);
+  Profiler::RecordPhase("prior_expectation"   , w_priorExpectation_                  , c_priorExpectation_);
+  Profiler::RecordPhase("prior_correlation"   , w_priorCorrelation_                  , c_priorCorrelation_);
+  Profiler::RecordPhase("stochastic_model"    , w_stochasticModel_                   , c_stochasticModel_);
+  Profiler::RecordPhase("inversion"           , w_inversion_ - w_kriging_pred_       , c_inversion_ - c_kriging_pred_);
+  Profiler::RecordPhase("simulation"          , w_simulation_ - w_kriging_sim_       , c_simulation_ - c_kriging_sim_);
+  Profiler::RecordPhase("parameter_filter"    , w_filtering_                         , c_filtering_);
+  Profiler::RecordPhase("facies_probabilities", w_facies_                            , c_facies_);
+  Profiler::RecordPhase("kriging"             , w_kriging_pred_ + w_kriging_sim_     , c_kriging_pred_ + c_kriging_sim_);
+  Profiler::RecordPhase("miscellaneous"       , w_rest_                              , c_rest_);
+  Profiler::RecordPhase("total"               , w_total_                             , c_total_);
+}
+
 void
 Timings::calculateRest(void)
 {
@@ -33,6 +33,7 @@ private:
   static void    reportOne(const std::string & text, double cpuThis, double wallThis,
                            double cpuTot, double wallTot, LogKit::MessageLevels logLevel);
   static void    calculateRest(void);
+  static void    recordPhases(void);
 
   static double  w_total_;
   static double  c_total_;
@@ -46,28 +46,15 @@ Wavelet1D::Wavelet1D(const Simbox                                     * simbox,
                      std::vector<Wavelet1D *>                         & well_wavelet,
                      int                                              & errCode,
                      std::string                                      & errTxt,
-                     bool                                               writing)
+                     bool                                               writing,
+                     std::vector<std::vector<double> >                * estimate)
   : Wavelet(1)
 {
   if (writing)
     LogKit::LogFormatted(LogKit::Medium,"  Estimating 1D wavelet from seismic data and (nonfiltered) blocked wells\n");
 
-  coeff_[0]   = static_cast<float>(reflection_matrix(iAngle,0));
-  coeff_[1]   = static_cast<float>(reflection_matrix(iAngle,1));
-  coeff_[2]   = static_cast<float>(reflection_matrix(iAngle,2));
-  dz_         = static_cast<float>(simbox->getdz());
-  nz_         = simbox->getnz();
-  theta_      = seismic_data->GetAngle();
-  nzp_        = simbox->GetNZpad();
-  cnzp_       = nzp_/2+1;
-  rnzp_       = 2*cnzp_;
-  scale_      = 1.0f;
-  cz_         = 0;
-  inFFTorder_ = true;
-  isReal_     = true;
-  formats_    = modelSettings->getWaveletFormatFlag();
+  setupEstimate(simbox, seismic_data->GetAngle(), modelSettings, reflection_matrix, iAngle);
 
-  std::string fileName;
   int     nWells              = modelSettings->getNumberOfWells();
   float   waveletTaperLength  = modelSettings->getWaveletTaperingL();
 
@@ -123,10 +110,19 @@ Wavelet1D::Wavelet1D(const Simbox                                     * simbox,
   std::vector<int>   sampleStop(nWells,0);    // Needed to block syntSeis
   std::vector<float> wellWeight(nWells,0.0f);
   //
-  // Loop over wells and create a blocked well and blocked seismic
+  // Loop over wells and create a blocked well and blocked seismic. This
+  // reads the seismic storage and writes to the log, so it is done one
+  // well at a time. The correlations are found for all wells concurrently
+  // below.
   //
   int nUsedWells = 0;
 
+  std::vector<const BlockedLogsCommon *> wellBlockedLogs(nWells, static_cast<const BlockedLogsCommon *>(NULL));
+  std::vector<std::vector<double> >      wellSeisData(nWells);
+  std::vector<int>                       wellStart(nWells, 0);
+  std::vector<int>                       wellLength(nWells, 0);
+  std::vector<double>                    unusedLength(nWells, -1.0);
+
   int w = 0;
   for(std::map<std::string, BlockedLogsCommon *>::const_iterator it = mapped_blocked_logs.begin(); it != mapped_blocked_logs.end(); it++) {
     std::map<std::string, BlockedLogsCommon *>::const_iterator iter = mapped_blocked_logs.find(it->first);
@@ -188,49 +184,64 @@ Wavelet1D::Wavelet1D(const Simbox                                     * simbox,
       blocked_log->FindContinuousPartOfData(hasData, nz_, start, length);
 
       if(length*dz_ > waveletTaperLength ) { // must have enough data
-        bool shift = true;
-        if(seismic_data->GetSeismicType() == SeismicStorage::SEGY)
-          shift = false;
         nUsedWells++;
-        blocked_log->FillInCpp(coeff_, start, length, cpp_r[w], nzp_);
-        fileName = "cpp_1";
-        printVecToFile(fileName, cpp_r[w], nzp_);  // Debug
-        blocked_log->FillInSeismic(seisData, start, length, seis_r[w], nzp_, shift);
-        fileName = "seis_1";
-        printVecToFile(fileName, seis_r[w], nzp_); // Debug
-        Utils::fft(cpp_r[w], cpp_c[w], nzp_);
-        Utils::fft(seis_r[w], seis_c[w], nzp_);
-        blocked_log->EstimateCor(cpp_c[w], cpp_c[w], cor_cpp_c[w], cnzp_);
-        Utils::fftInv(cor_cpp_c[w], cor_cpp_r[w], nzp_);
-        blocked_log->EstimateCor(cpp_c[w], seis_c[w], ccor_seis_cpp_c[w], cnzp_);
-        Utils::fftInv(ccor_seis_cpp_c[w], ccor_seis_cpp_r[w], nzp_);
-        Utils::fftInv(cpp_c[w], cpp_r[w], nzp_);
-        Utils::fftInv(seis_c[w], seis_r[w], nzp_);
-        wellWeight[w] = length*dzWell[w]*(cor_cpp_r[w][0]+cor_cpp_r[w][1]);// Gives most weight to long datasets with
-                                                                           // large reflection coefficients
-        z0[w] = static_cast<float> (blocked_log->GetZposBlocked()[0]);
-        sampleStart[w] = start;
-        sampleStop[w]  = start + length;
+        wellBlockedLogs[w] = blocked_log;
+        wellSeisData[w].swap(seisData);
+        wellStart[w]       = start;
+        wellLength[w]      = length;
       }
       else {
-        std::string coarseWell;
-        if(blocked_log->GetNumberOfBlocks() < nz_)
-          coarseWell = "The reason for this may be that the well log has coarser sampling than the modelling grid.\n";
-        LogKit::LogMessage(LogKit::Warning, "\nWarning: Well " + blocked_log->GetWellName() +
-                                            " was not used in wavelet estimation. Longest continuous log interval was " +
-                                            NRLib::ToString(length*dz_) + " ms while a length of " +
-                                            NRLib::ToString(waveletTaperLength) + "ms is needed.\n"+coarseWell);
+        unusedLength[w] = length*dz_;
+        logUnusedWell(blocked_log, length*dz_, waveletTaperLength);
       }
     }
     w++;
   }
 
+  bool shiftSeismic = true;
+  if(seismic_data->GetSeismicType() == SeismicStorage::SEGY)
+    shiftSeismic = false;
+
+#ifdef PARALLEL
+  // The debug vectors are written to the same files for all wells.
+  int nThreads = (ModelSettings::getDebugLevel() > 0 ? 1 : modelSettings->getNumberOfThreads());
+#pragma omp parallel for schedule(dynamic, 1) num_threads(nThreads)
+#endif
+  for (int w = 0 ; w < nWells ; w++) {
+    const BlockedLogsCommon * blocked_log = wellBlockedLogs[w];
+    if (blocked_log != NULL) {
+      int         start  = wellStart[w];
+      int         length = wellLength[w];
+      std::string debugFileName;
+      blocked_log->FillInCpp(coeff_, start, length, cpp_r[w], nzp_);
+      debugFileName = "cpp_1";
+      printVecToFile(debugFileName, cpp_r[w], nzp_);  // Debug
+      blocked_log->FillInSeismic(wellSeisData[w], start, length, seis_r[w], nzp_, shiftSeismic);
+      debugFileName = "seis_1";
+      printVecToFile(debugFileName, seis_r[w], nzp_); // Debug
+      Utils::fft(cpp_r[w], cpp_c[w], nzp_);
+      Utils::fft(seis_r[w], seis_c[w], nzp_);
+      blocked_log->EstimateCor(cpp_c[w], cpp_c[w], cor_cpp_c[w], cnzp_);
+      Utils::fftInv(cor_cpp_c[w], cor_cpp_r[w], nzp_);
+      blocked_log->EstimateCor(cpp_c[w], seis_c[w], ccor_seis_cpp_c[w], cnzp_);
+      Utils::fftInv(ccor_seis_cpp_c[w], ccor_seis_cpp_r[w], nzp_);
+      Utils::fftInv(cpp_c[w], cpp_r[w], nzp_);
+      Utils::fftInv(seis_c[w], seis_r[w], nzp_);
+      wellWeight[w] = length*dzWell[w]*(cor_cpp_r[w][0]+cor_cpp_r[w][1]);// Gives most weight to long datasets with
+                                                                         // large reflection coefficients
+      z0[w] = static_cast<float> (blocked_log->GetZposBlocked()[0]);
+      sampleStart[w] = start;
+      sampleStop[w]  = start + length;
+    }
+  }
+
   if(nUsedWells == 0) {
     errCode = 1;
     errTxt  += "No wells left for wavelet estimation.\n";
   }
   else {
     std::vector<float> shiftWell(nWells);
+    std::vector<std::vector<fftw_real> > shiftedWellWavelets(nWells);
     float shiftAvg = shiftOptimal(ccor_seis_cpp_r, wellWeight, dzWell, nWells, nzp_, shiftWell, modelSettings->getMaxWaveletShift());
     multiplyPapolouis(ccor_seis_cpp_r, dzWell, nWells, nzp_, waveletTaperLength, wellWeight);
     for(int w=0; w < nWells;w++) {
@@ -272,27 +283,34 @@ Wavelet1D::Wavelet1D(const Simbox                                     * simbox,
       }
     }
 
-    // gets syntetic seismic with estimated wavelet
+    // gets syntetic seismic with estimated wavelet. The average wavelet is
+    // real here, so fillInnWavelet only reads it.
     well_wavelet.resize(nWells);
-    int w = 0;
-    for(std::map<std::string, BlockedLogsCommon *>::const_iterator it = mapped_blocked_logs.begin(); it != mapped_blocked_logs.end(); it++) {
+    int nMappedWells = std::min(nWells, static_cast<int>(mapped_blocked_logs.size()));
+#ifdef PARALLEL
+    int nThreads = (ModelSettings::getDebugLevel() > 0 ? 1 : modelSettings->getNumberOfThreads());
+#pragma omp parallel for schedule(dynamic, 1) num_threads(nThreads)
+#endif
+    for(int w = 0 ; w < nMappedWells ; w++) {
+      std::string debugFileName;
       fillInnWavelet(wavelet_r[w], nzp_, dzWell[w]);
       shiftReal(shiftWell[w]/dzWell[w], wavelet_r[w], nzp_);
+      if (estimate != NULL)
+        shiftedWellWavelets[w].assign(wavelet_r[w], wavelet_r[w] + nz_);
       well_wavelet[w] = new Wavelet1D(wavelet_r[w], nz_, nzp_, dzWell[w], true);
       well_wavelet[w]->shiftFromFFTOrder();
-      fileName = "waveletShift";
-      printVecToFile(fileName, wavelet_r[w], nzp_);
+      debugFileName = "waveletShift";
+      printVecToFile(debugFileName, wavelet_r[w], nzp_);
       Utils::fft(wavelet_r[w], wavelet_c[w], nzp_);
-      fileName = "cpp";
-      printVecToFile(fileName, cpp_r[w], nzp_);
+      debugFileName = "cpp";
+      printVecToFile(debugFileName, cpp_r[w], nzp_);
       Utils::fft(cpp_r[w], cpp_c[w], nzp_);
       convolve(cpp_c[w], wavelet_c[w], synt_seis_c[w], cnzp_);
       Utils::fftInv(synt_seis_c[w], synt_seis_r[w], nzp_); //
-      fileName = "syntSeis";
-      printVecToFile(fileName, synt_seis_r[w], nzp_);
-      fileName = "seis";
-      printVecToFile(fileName, seis_r[w], nzp_);
-      w++;
+      debugFileName = "syntSeis";
+      printVecToFile(debugFileName, synt_seis_r[w], nzp_);
+      debugFileName = "seis";
+      printVecToFile(debugFileName, seis_r[w], nzp_);
     }
 
     float scaleOpt = findOptimalWaveletScale(synt_seis_r, seis_r, nWells, nzp_, wellWeight);
@@ -300,18 +318,7 @@ Wavelet1D::Wavelet1D(const Simbox                                     * simbox,
     shiftAndScale(shiftAvg, scaleOpt);//shifts wavelet average from wells
     invFFT1DInPlace();
     waveletLength_ = findWaveletLength(modelSettings->getMinRelWaveletAmp(),modelSettings->getWaveletTaperingL());
-
-    if (writing)
-      LogKit::LogFormatted(LogKit::Low,"  Estimated wavelet length:  %.1fms\n",waveletLength_);
-
-    if (waveletLength_ < 50.0) {
-      LogKit::LogFormatted(LogKit::Warning,"\nWARNING: The estimated wavelet length is unusually small.\n");
-      TaskList::addTask("Check the estimated wavelet lengths. A small length of "+NRLib::ToString(waveletLength_,2)+" has been found.");
-    }
-    if (waveletLength_ > 400.0) {
-      LogKit::LogFormatted(LogKit::Warning,"\nWARNING: The estimated wavelet length is unusually large.\n");
-      TaskList::addTask("Check the estimated wavelet lengths. A large length of "+NRLib::ToString(waveletLength_,2)+" has been found.");
-    }
+    checkWaveletLength(writing);
 
     if( ModelSettings::getDebugLevel() > 0 ){
       writeWaveletToFile("estimated_wavelet_adjusted_", 1.0f,true);
@@ -320,37 +327,7 @@ Wavelet1D::Wavelet1D(const Simbox                                     * simbox,
 
     norm_ = findNorm();
 
-    //Writing well wavelets to file. Using writeWaveletToFile, so manipulating rAmpz_
-    fftw_real * trueAmp = rAmp_;
-    float       truedDz = dz_;
-    rAmp_               = static_cast<fftw_real*>(fftw_malloc(rnzp_*sizeof(fftw_real)));
-    cAmp_               = reinterpret_cast<fftw_complex *>(rAmp_);
-
-    w = 0;
-    for(std::map<std::string, BlockedLogsCommon *>::const_iterator it = mapped_blocked_logs.begin(); it != mapped_blocked_logs.end(); it++) {
-      std::map<std::string, BlockedLogsCommon *>::const_iterator iter = mapped_blocked_logs.find(it->first);
-      const BlockedLogsCommon * blocked_log = iter->second;
-
-      if(blocked_log->GetUseForWaveletEstimation() &&
-        ((modelSettings->getWaveletOutputFlag() & IO::WELL_WAVELETS)>0 || modelSettings->getEstimationMode())) {
-
-        dz_ = dzWell[w];
-        for(int i = 0 ; i < nzp_ ; i++)
-          rAmp_[i] = wellWavelets[w][i];
-        std::string wellname(blocked_log->GetWellName());
-        NRLib::Substitute(wellname,"/","_");
-        NRLib::Substitute(wellname," ","_");
-        fileName = IO::PrefixWellWavelet() + wellname + "_";
-        if (writing)
-          writeWaveletToFile(fileName, 1.0f,true);
-      }
-      w++;
-    }
-
-    fftw_free(rAmp_);
-    rAmp_ = trueAmp;
-    cAmp_ = reinterpret_cast<fftw_complex *>(rAmp_);
-    dz_   = truedDz;
+    writeWellWavelets(mapped_blocked_logs, modelSettings, wellWavelets, dzWell, writing);
 
     if(ModelSettings::getDebugLevel() > 1 && writing == true)
       writeDebugInfo(seis_r, cor_cpp_r, ccor_seis_cpp_r, cpp_r, nWells);
@@ -360,6 +337,17 @@ Wavelet1D::Wavelet1D(const Simbox                                     * simbox,
       LogKit::LogFormatted(LogKit::Error,"\nERROR: Could not estimate global wavelet scale\n");
       errTxt += "Could not estimate global wavelet scale for stack "+NRLib::ToString(iAngle)+".\n";
     }
+    else if (estimate != NULL) {
+      estimate->assign(4 + 2*nWells, std::vector<double>());
+      (*estimate)[0].assign(1, waveletLength_);
+      (*estimate)[1].assign(rAmp_, rAmp_ + rnzp_);
+      (*estimate)[2].assign(dzWell.begin(), dzWell.end());
+      (*estimate)[3] = unusedLength;
+      for (int w = 0 ; w < nWells ; w++) {
+        (*estimate)[4 + 2*w].assign(wellWavelets[w].begin(), wellWavelets[w].end());
+        (*estimate)[5 + 2*w].assign(shiftedWellWavelets[w].begin(), shiftedWellWavelets[w].end());
+      }
+    }
   }
 
   for(int i=0;i<nWells;i++) {
@@ -379,6 +367,151 @@ Wavelet1D::Wavelet1D(const Simbox                                     * simbox,
 }
 
 
+Wavelet1D::Wavelet1D(const Simbox                                     * simbox,
+                     float                                              theta,
+                     const std::map<std::string, BlockedLogsCommon *> & mapped_blocked_logs,
+                     const ModelSettings                              * modelSettings,
+                     const NRLib::Matrix                              & reflection_matrix,
+                     int                                                iAngle,
+                     const std::vector<std::vector<double> >          & estimate,
+                     std::vector<Wavelet1D *>                         & well_wavelet)
+  : Wavelet(1)
+{
+  setupEstimate(simbox, theta, modelSettings, reflection_matrix, iAngle);
+
+  int nWells = static_cast<int>(estimate.size() - 4)/2;
+
+  int w = 0;
+  for(std::map<std::string, BlockedLogsCommon *>::const_iterator it = mapped_blocked_logs.begin(); it != mapped_blocked_logs.end() && w < nWells; it++) {
+    if (estimate[3][w] >= 0.0)
+      logUnusedWell(it->second, static_cast<float>(estimate[3][w]), modelSettings->getWaveletTaperingL());
+    w++;
+  }
+
+  rAmp_ = static_cast<fftw_real*>(fftw_malloc(rnzp_*sizeof(fftw_real)));
+  cAmp_ = reinterpret_cast<fftw_complex *>(rAmp_);
+  for (int i = 0 ; i < rnzp_ ; i++)
+    rAmp_[i] = static_cast<fftw_real>(estimate[1][i]);
+
+  waveletLength_ = static_cast<float>(estimate[0][0]);
+  checkWaveletLength(true);
+  norm_ = findNorm();
+
+  std::vector<std::vector<fftw_real> > wellWavelets(nWells);
+  std::vector<float>                   dzWell(nWells);
+  for (w = 0 ; w < nWells ; w++) {
+    wellWavelets[w].assign(estimate[4 + 2*w].begin(), estimate[4 + 2*w].end());
+    dzWell[w] = static_cast<float>(estimate[2][w]);
+  }
+  writeWellWavelets(mapped_blocked_logs, modelSettings, wellWavelets, dzWell, true);
+
+  well_wavelet.resize(nWells);
+  for (w = 0 ; w < nWells ; w++) {
+    if (estimate[5 + 2*w].size() > 0) {
+      std::vector<fftw_real> shifted(estimate[5 + 2*w].begin(), estimate[5 + 2*w].end());
+      well_wavelet[w] = new Wavelet1D(&shifted[0], nz_, nzp_, dzWell[w], true);
+      well_wavelet[w]->shiftFromFFTOrder();
+    }
+  }
+}
+
+
+void
+Wavelet1D::setupEstimate(const Simbox        * simbox,
+                         float                 theta,
+                         const ModelSettings * modelSettings,
+                         const NRLib::Matrix & reflection_matrix,
+                         int                   iAngle)
+{
+  coeff_[0]   = static_cast<float>(reflection_matrix(iAngle,0));
+  coeff_[1]   = static_cast<float>(reflection_matrix(iAngle,1));
+  coeff_[2]   = static_cast<float>(reflection_matrix(iAngle,2));
+  dz_         = static_cast<float>(simbox->getdz());
+  nz_         = simbox->getnz();
+  theta_      = theta;
+  nzp_        = simbox->GetNZpad();
+  cnzp_       = nzp_/2+1;
+  rnzp_       = 2*cnzp_;
+  scale_      = 1.0f;
+  cz_         = 0;
+  inFFTorder_ = true;
+  isReal_     = true;
+  formats_    = modelSettings->getWaveletFormatFlag();
+}
+
+
+void
+Wavelet1D::logUnusedWell(const BlockedLogsCommon * blocked_log,
+                         float                     length,
+                         float                     waveletTaperLength) const
+{
+  std::string coarseWell;
+  if(blocked_log->GetNumberOfBlocks() < nz_)
+    coarseWell = "The reason for this may be that the well log has coarser sampling than the modelling grid.\n";
+  LogKit::LogMessage(LogKit::Warning, "\nWarning: Well " + blocked_log->GetWellName() +
+                                      " was not used in wavelet estimation. Longest continuous log interval was " +
+                                      NRLib::ToString(length) + " ms while a length of " +
+                                      NRLib::ToString(waveletTaperLength) + "ms is needed.\n"+coarseWell);
+}
+
+
+void
+Wavelet1D::checkWaveletLength(bool writing) const
+{
+  if (writing)
+    LogKit::LogFormatted(LogKit::Low,"  Estimated wavelet length:  %.1fms\n",waveletLength_);
+
+  if (waveletLength_ < 50.0) {
+    LogKit::LogFormatted(LogKit::Warning,"\nWARNING: The estimated wavelet length is unusually small.\n");
+    TaskList::addTask("Check the estimated wavelet lengths. A small length of "+NRLib::ToString(waveletLength_,2)+" has been found.");
+  }
+  if (waveletLength_ > 400.0) {
+    LogKit::LogFormatted(LogKit::Warning,"\nWARNING: The estimated wavelet length is unusually large.\n");
+    TaskList::addTask("Check the estimated wavelet lengths. A large length of "+NRLib::ToString(waveletLength_,2)+" has been found.");
+  }
+}
+
+
+void
+Wavelet1D::writeWellWavelets(const std::map<std::string, BlockedLogsCommon *> & mapped_blocked_logs,
+                             const ModelSettings                              * modelSettings,
+                             const std::vector<std::vector<fftw_real> >       & wellWavelets,
+                             const std::vector<float>                         & dzWell,
+                             bool                                               writing)
+{
+  //Writing well wavelets to file. Using writeWaveletToFile, so manipulating rAmpz_
+  fftw_real * trueAmp = rAmp_;
+  float       truedDz = dz_;
+  rAmp_               = static_cast<fftw_real*>(fftw_malloc(rnzp_*sizeof(fftw_real)));
+  cAmp_               = reinterpret_cast<fftw_complex *>(rAmp_);
+
+  int w = 0;
+  for(std::map<std::string, BlockedLogsCommon *>::const_iterator it = mapped_blocked_logs.begin(); it != mapped_blocked_logs.end(); it++) {
+    const BlockedLogsCommon * blocked_log = it->second;
+
+    if(blocked_log->GetUseForWaveletEstimation() &&
+      ((modelSettings->getWaveletOutputFlag() & IO::WELL_WAVELETS)>0 || modelSettings->getEstimationMode())) {
+
+      dz_ = dzWell[w];
+      for(int i = 0 ; i < nzp_ ; i++)
+        rAmp_[i] = wellWavelets[w][i];
+      std::string wellname(blocked_log->GetWellName());
+      NRLib::Substitute(wellname,"/","_");
+      NRLib::Substitute(wellname," ","_");
+      std::string fileName = IO::PrefixWellWavelet() + wellname + "_";
+      if (writing)
+        writeWaveletToFile(fileName, 1.0f,true);
+    }
+    w++;
+  }
+
+  fftw_free(rAmp_);
+  rAmp_ = trueAmp;
+  cAmp_ = reinterpret_cast<fftw_complex *>(rAmp_);
+  dz_   = truedDz;
+}
+
+
 Wavelet1D::Wavelet1D(const std::string   & fileName,
                      int                   fileFormat,
                      const ModelSettings * modelSettings,
@@ -801,26 +934,35 @@ Wavelet1D::calculateSNRatioAndLocalWavelet(const Simbox
     w++;
   }
   //
-  // Loop over wells and create a blocked well and blocked seismic
+  // Loop over wells and create a blocked well and blocked seismic. The
+  // wells are independent and are done concurrently. fillInnWavelet()
+  // reads the wavelet with getRAmp(), which transforms the wavelet back
+  // and forth if it is not real, so it is made real first.
   //
   std::vector<float> dataVarWell(nWells, 0.0f);
   std::vector<float> errVarWell (nWells, 0.0f);
   std::vector<float> shiftWell  (nWells, 0.0f);
   std::vector<int>   nActiveData(nWells, 0);
+  std::vector<int>   wellLength (nWells, -1);      // Continuous length of wells too short for estimation
 
-  w = 0;
-  for(std::map<std::string, BlockedLogsCommon *>::const_iterator it = mapped_blocked_logs.begin(); it != mapped_blocked_logs.end(); it++) {
-    std::map<std::string, BlockedLogsCommon *>::const_iterator iter = mapped_blocked_logs.find(it->first);
-    BlockedLogsCommon * blocked_log = iter->second;
+  std::vector<const BlockedLogsCommon *> wellBlockedLogs;
+  for(std::map<std::string, BlockedLogsCommon *>::const_iterator it = mapped_blocked_logs.begin(); it != mapped_blocked_logs.end(); it++)
+    wellBlockedLogs.push_back(it->second);
 
-    if(blocked_log->GetUseForWaveletEstimation()) {
-      //
-      // Block seismic data for this well
-      //
+  bool waveletWasReal = isReal_;
+  if (!waveletWasReal)
+    invFFT1DInPlace();
 
-      //std::vector<double> seisLog(blocked_log->GetNumberOfBlocks());
-      //blocked_log->GetBlockedGrid(seismic_data, simbox, seisLog);
+  int nMappedWells = std::min(nWells, static_cast<int>(wellBlockedLogs.size()));
 
+#ifdef PARALLEL
+  int nThreads = modelSettings->getNumberOfThreads();
+#pragma omp parallel for schedule(dynamic, 1) num_threads(nThreads)
+#endif
+  for (int w = 0 ; w < nMappedWells ; w++) {
+    const BlockedLogsCommon * blocked_log = wellBlockedLogs[w];
+
+    if(blocked_log->GetUseForWaveletEstimation()) {
       //
       // Extract a one-value-for-each-layer array of blocked logs
       //
@@ -876,11 +1018,18 @@ Wavelet1D::calculateSNRatioAndLocalWavelet(const Simbox
         nActiveData[w]=length;
       }
       else {
-        LogKit::LogFormatted(LogKit::Low, "\n  Not using vertical well %s for error estimation (length=%.1fms  required length=%.1fms).",
-                             blocked_log->GetWellName().c_str(), length*dz_, waveletLength_);
+        wellLength[w] = length;
       }
     }
-    w++;
+  }
+
+  if (!waveletWasReal)
+    fft1DInPlace();
+
+  for (int w = 0 ; w < nMappedWells ; w++) {
+    if (wellLength[w] >= 0)
+      LogKit::LogFormatted(LogKit::Low, "\n  Not using vertical well %s for error estimation (length=%.1fms  required length=%.1fms).",
+                           wellBlockedLogs[w]->GetWellName().c_str(), wellLength[w]*dz_, waveletLength_);
   }
   float globalScale = waveletScale;
 
@@ -1047,14 +1196,9 @@ Wavelet1D::calculateSNRatioAndLocalWavelet(const Simbox
       cov.writeToFile(fileName);
     }
 
-    if (doEstimateLocalShift)
-      estimateLocalShift(cov, shiftGrid, shiftWell, nActiveData, inversion_simbox, mapped_blocked_logs);
-
-    if (doEstimateLocalScale)
-      estimateLocalGain(cov, gainGrid, scaleOptWell, 1.0, nActiveData, inversion_simbox, mapped_blocked_logs);
-
+    float                      errStdLN  = 0.0f;
+    const std::vector<float> * noiseWell = NULL;
     if (doEstimateLocalNoise) {
-      float errStdLN;
       if (doEstimateSNRatio)
         errStdLN = errStd;
       else //SNRatio given in model file
@@ -1062,13 +1206,45 @@ Wavelet1D::calculateSNRatioAndLocalWavelet(const Simbox
       if(gainGrid == NULL && doEstimateLocalScale==false && doEstimateGlobalScale==false) { // No local wavelet scale
         for(int w=0 ; w < nWells ; w++)
           errVarWell[w] = sqrt(errVarWell[w]);
-        estimateLocalNoise(cov, noiseScaled, errStdLN, errVarWell, nActiveData, inversion_simbox, mapped_blocked_logs);
+        noiseWell = &errVarWell;
       }
       else if (doEstimateGlobalScale==true && doEstimateLocalScale==false) // global wavelet scale
-        estimateLocalNoise(cov, noiseScaled, errStdLN,errWell, nActiveData, inversion_simbox, mapped_blocked_logs);
+        noiseWell = &errWell;
       else
-        estimateLocalNoise(cov, noiseScaled, errStdLN, errWellOptScale, nActiveData, inversion_simbox, mapped_blocked_logs);
+        noiseWell = &errWellOptScale;
+    }
+
+    //
+    // The shift, gain and noise maps are kriged independently, so they are
+    // made concurrently. Exceptions cannot leave the parallel region, so
+    // the first error is kept and thrown afterwards.
+    //
+    std::string krigingError;
+
+#ifdef PARALLEL
+    int nThreads = modelSettings->getNumberOfThreads();
+#pragma omp parallel for schedule(dynamic, 1) num_threads(nThreads)
+#endif
+    for (int m = 0 ; m < 3 ; m++) {
+      try {
+        if (m == 0 && doEstimateLocalShift)
+          estimateLocalShift(cov, shiftGrid, shiftWell, nActiveData, inversion_simbox, mapped_blocked_logs);
+        else if (m == 1 && doEstimateLocalScale)
+          estimateLocalGain(cov, gainGrid, scaleOptWell, 1.0, nActiveData, inversion_simbox, mapped_blocked_logs);
+        else if (m == 2 && doEstimateLocalNoise)
+          estimateLocalNoise(cov, noiseScaled, errStdLN, *noiseWell, nActiveData, inversion_simbox, mapped_blocked_logs);
+      }
+      catch (NRLib::Exception & e) {
+#ifdef PARALLEL
+#pragma omp critical(wavelet1d_kriging)
+#endif
+        if (krigingError == "")
+          krigingError = e.what();
+      }
     }
+
+    if (krigingError != "")
+      throw NRLib::Exception(krigingError);
   }
 
   float empSNRatio = dataVar/(errStd*errStd);
@@ -28,7 +28,23 @@ public:
             std::vector<Wavelet1D *>                         & well_wavelet,
             int                                              & errCode,
             std::string                                      & errTxt,
-            bool                                               writing = true);
+            bool                                               writing  = true,
+            std::vector<std::vector<double> >                * estimate = NULL);
+
+  // An estimated wavelet given by the estimate of the constructor above,
+  // as kept in the preprocessing cache. The estimate holds the wavelet
+  // length, the amplitudes, the sampling of each well, the log length of
+  // each well that was too short to be used (or -1), and then for each
+  // well the wavelet written to file and the shifted well wavelet. The
+  // well wavelet files and warnings are made again.
+  Wavelet1D(const Simbox                                     * simbox,
+            float                                              theta,
+            const std::map<std::string, BlockedLogsCommon *> & mapped_blocked_logs,
+            const ModelSettings                              * modelSettings,
+            const NRLib::Matrix                              & reflCoef,
+            int                                                iAngle,
+            const std::vector<std::vector<double> >          & estimate,
+            std::vector<Wavelet1D *>                         & well_wavelet);
 
   Wavelet1D(const std::string & fileName,
             int                 fileFormat,
@@ -100,6 +116,24 @@ Wavelet1D(const ModelSettings * modelSettings,
                                                 bool                                               estimateWavelet);
 
 private:
+  void          setupEstimate(const Simbox        * simbox,
+                              float                 theta,
+                              const ModelSettings * modelSettings,
+                              const NRLib::Matrix & reflCoef,
+                              int                   iAngle);
+
+  void          logUnusedWell(const BlockedLogsCommon * blocked_log,
+                              float                     length,
+                              float                     waveletTaperLength) const;
+
+  void          checkWaveletLength(bool writing) const;
+
+  void          writeWellWavelets(const std::map<std::string, BlockedLogsCommon *> & mapped_blocked_logs,
+                                  const ModelSettings                              * modelSettings,
+                                  const std::vector<std::vector<fftw_real> >       & wellWavelets,
+                                  const std::vector<float>                         & dzWell,
+                                  bool                                               writing);
+
   float         findOptimalWaveletScale(fftw_real               ** synt_seis_r,
                                         fftw_real               ** seis_r,
                                         int                        nWells,
@@ -5308,6 +5308,8 @@ XmlModelFile::parseGridFormats(TiXmlNode * node, std::string & errTxt)
   legalCommands.push_back("ascii");
   legalCommands.push_back("sgri");
   legalCommands.push_back("crava");
+  legalCommands.push_back("chunked");
+  legalCommands.push_back("chunked-quantization-step");
   TraceHeaderFormat *thf = NULL;
   bool segyFormat = parseTraceHeaderFormat(root, "segy-format",thf, errTxt);
   if(segyFormat==true)
@@ -5328,6 +5330,15 @@ XmlModelFile::parseGridFormats(TiXmlNode * node, std::string & errTxt)
     formatFlag += IO::SGRI;
   if(parseBool(root, "crava", useFormat, errTxt) == true && useFormat == true)
     formatFlag += IO::CRAVA;
+  if(parseBool(root, "chunked", useFormat, errTxt) == true && useFormat == true)
+    formatFlag += IO::CHUNKED;
+
+  double step = 0.0;
+  if(parseValue(root, "chunked-quantization-step", step, errTxt) == true) {
+    if(step < 0.0)
+      errTxt += "The quantization step of chunked grids must be zero (lossless) or positive.\n";
+    modelSettings_->setChunkedQuantizationStep(step);
+  }
 
   if(formatFlag > 0 || stormSpecified == true)
     modelSettings_->setOutputGridFormat(formatFlag);
@@ -5688,9 +5699,14 @@ XmlModelFile::parseAdvancedSettings(TiXmlNode * node, std::string & errTxt)
   legalCommands.push_back("number-of-threads");
 #endif
   legalCommands.push_back("fft-grid-padding");
+  legalCommands.push_back("lateral-tiles");
   legalCommands.push_back("vp-vs-ratio");
   legalCommands.push_back("vp-vs-ratio-from-wells");
   legalCommands.push_back("use-intermediate-disk-storage");
+  legalCommands.push_back("spill-interval-results");
+  legalCommands.push_back("write-checkpoints");
+  legalCommands.push_back("restart-from-checkpoints");
+  legalCommands.push_back("cache-directory");
   legalCommands.push_back("maximum-relative-thickness-difference");
   legalCommands.push_back("frequency-band");
   legalCommands.push_back("energy-threshold");
@@ -5720,6 +5736,8 @@ XmlModelFile::parseAdvancedSettings(TiXmlNode * node, std::string & errTxt)
 
   parseFFTGridPadding(root, errTxt);
 
+  parseLateralTiles(root, errTxt);
+
   bool vp_vs_ratio_given = false;
 
   if(parseVpVsRatio(root, errTxt) == true)
@@ -5737,6 +5755,22 @@ XmlModelFile::parseAdvancedSettings(TiXmlNode * node, std::string & errTxt)
   if(parseBool(root, "use-intermediate-disk-storage", fileGrid, errTxt) == true)
     modelSettings_->setFileGrid(fileGrid);
 
+  bool spill;
+  if(parseBool(root, "spill-interval-results", spill, errTxt) == true)
+    modelSettings_->setSpillIntervalResults(spill);
+
+  bool checkpoints;
+  if(parseBool(root, "write-checkpoints", checkpoints, errTxt) == true)
+    modelSettings_->setWriteCheckpoints(checkpoints);
+  if(parseBool(root, "restart-from-checkpoints", checkpoints, errTxt) == true)
+    modelSettings_->setRestartFromCheckpoints(checkpoints);
+
+  std::string cacheDir;
+  if(parseValue(root, "cache-directory", cacheDir, errTxt) == true) {
+    ensureTrailingSlash(cacheDir);
+    modelSettings_->setCacheDirectory(cacheDir);
+  }
+
   double limit;
   if(parseValue(root,"maximum-relative-thickness-difference", limit, errTxt) == true)
     modelSettings_->setLzLimit(limit);
@@ -5849,6 +5883,39 @@ XmlModelFile::parseFFTGridPadding(TiXmlNode * node, std::string & errTxt)
   return(true);
 }
 
+bool
+XmlModelFile::parseLateralTiles(TiXmlNode * node, std::string & errTxt)
+{
+  TiXmlNode * root = node->FirstChildElement("lateral-tiles");
+  if(root == 0)
+    return(false);
+
+  std::vector<std::string> legalCommands;
+  legalCommands.push_back("number-of-tiles-x");
+  legalCommands.push_back("number-of-tiles-y");
+  legalCommands.push_back("number-of-processes");
+
+  int value;
+  if(parseValue(root, "number-of-tiles-x", value, errTxt) == true) {
+    if (value < 1)
+      errTxt += "The number of tiles in x direction must be at least 1 in command <number-of-tiles-x>.\n";
+    modelSettings_->setNumberOfLateralTilesX(value);
+  }
+  if(parseValue(root, "number-of-tiles-y", value, errTxt) == true) {
+    if (value < 1)
+      errTxt += "The number of tiles in y direction must be at least 1 in command <number-of-tiles-y>.\n";
+    modelSettings_->setNumberOfLateralTilesY(value);
+  }
+  if(parseValue(root, "number-of-processes", value, errTxt) == true) {
+    if (value < 1)
+      errTxt += "The number of processes must be at least 1 in command <number-of-processes>.\n";
+    modelSettings_->setNumberOfTileProcesses(value);
+  }
+
+  checkForJunk(root, errTxt, legalCommands);
+  return(true);
+}
+
 bool
 XmlModelFile::parseVpVsRatio(TiXmlNode * node, std::string & errTxt)
 {
@@ -6264,6 +6331,8 @@ XmlModelFile::checkConsistency(std::string & errTxt)
   if(modelSettings_->getOptimizeWellLocation()==true)
     checkAngleConsistency(errTxt);
   checkIOConsistency(errTxt);
+  if(modelSettings_->getNumberOfLateralTilesX()*modelSettings_->getNumberOfLateralTilesY() > 1)
+    checkLateralTilesConsistency(errTxt);
   if(modelSettings_->getDo4DInversion() && surveyFailed_ == false)
     checkTimeLapseConsistency(errTxt);
 
@@ -6914,3 +6983,16 @@ XmlModelFile::checkIOConsistency(std::string & errTxt)
     errTxt += " outputs <well-wavelets>, <global-wavelets> nor <local-wavelets>.\n";
   }
 }
+
+void
+XmlModelFile::checkLateralTilesConsistency(std::string & errTxt)
+{
+  if (modelSettings_->getForwardModeling() == true || modelSettings_->getEstimationMode() == true)
+    errTxt += "Lateral tiles can only be used for inversion, not for forward modelling or estimation.\n";
+
+  if (modelSettings_->getAreaParameters() == NULL || modelSettings_->getSnapGridToSeismicData() == true)
+    errTxt += "Lateral tiles require the inversion area to be given with <utm-coordinates>, without <snap-to-seismic-data>.\n";
+
+  if ((modelSettings_->getOutputGridFormat() & IO::STORM) == 0)
+    errTxt += "Lateral tiles are blended from STORM grids, so <storm> cannot be turned off in <grid-output><format>.\n";
+}
@@ -146,6 +146,7 @@ private:
   bool       parseOtherOutput(TiXmlNode * node, std::string & errTxt);
   bool   parseAdvancedSettings(TiXmlNode * node, std::string & errTxt);
   bool     parseFFTGridPadding(TiXmlNode * node, std::string & errTxt);
+  bool     parseLateralTiles(TiXmlNode * node, std::string & errTxt);
   bool     parseVpVsRatio(TiXmlNode * node, std::string & errTxt);
   bool       parseIntervalVpVs(TiXmlNode * node, std::string & errTxt);
   bool     parseFrequencyBand(TiXmlNode * node, std::string & errTxt);
@@ -187,6 +188,7 @@ private:
   void checkTimeLapseConsistency(std::string & errTxt);
   void checkRockPhysicsConsistency(std::string & errTxt);
   void checkIOConsistency(std::string & errTxt);
+  void checkLateralTilesConsistency(std::string & errTxt);
   //void checkMultizoneBackgroundConsistency(std::string & errTxt);
 
   void setMissing(int & value)         { value = IMISSING ;}